@@ -107,6 +107,9 @@ ManifoldError to_c(manifold::Manifold::Error error) {
     case Manifold::Error::InvalidConstruction:
       e = MANIFOLD_INVALID_CONSTRUCTION;
       break;
+    case Manifold::Error::Cancelled:
+      e = MANIFOLD_CANCELLED;
+      break;
   };
   return e;
 }
@@ -111,6 +111,19 @@ ManifoldManifold *manifold_trim_by_plane(void *mem, ManifoldManifold *m,
                                          float normal_x, float normal_y,
                                          float normal_z, float offset);
 
+// Batch Operations
+// These replace one call per object when assembling large scenes.
+// manifold_instances returns n copies of m, each transformed by the next 12
+// floats of transforms, ordered as the arguments of manifold_transform.
+// manifold_batch_boolean_array takes the n handles from ms directly, with no
+// need to build a ManifoldManifoldVec first.
+
+ManifoldManifoldVec *manifold_instances(void *mem, ManifoldManifold *m,
+                                        float *transforms, size_t n);
+ManifoldManifold *manifold_batch_boolean_array(void *mem,
+                                               ManifoldManifold **ms, size_t n,
+                                               ManifoldOpType op);
+
 // 3D to 2D
 
 ManifoldCrossSection *manifold_slice(void *mem, ManifoldManifold *m,
@@ -179,6 +192,8 @@ ManifoldError manifold_status(ManifoldManifold *m);
 int manifold_num_vert(ManifoldManifold *m);
 int manifold_num_edge(ManifoldManifold *m);
 int manifold_num_tri(ManifoldManifold *m);
+int manifold_num_prop(ManifoldManifold *m);
+int manifold_num_prop_vert(ManifoldManifold *m);
 ManifoldBox *manifold_bounding_box(void *mem, ManifoldManifold *m);
 float manifold_precision(ManifoldManifold *m);
 int manifold_genus(ManifoldManifold *m);
@@ -366,6 +381,13 @@ uint32_t *manifold_meshgl_run_original_id(void *mem, ManifoldMeshGL *m);
 float *manifold_meshgl_run_transform(void *mem, ManifoldMeshGL *m);
 uint32_t *manifold_meshgl_face_id(void *mem, ManifoldMeshGL *m);
 float *manifold_meshgl_halfedge_tangent(void *mem, ManifoldMeshGL *m);
+// Writes the vertex properties and triangles of m straight into caller
+// buffers, skipping the intermediate MeshGL. vert_props needs
+// (3 + num_prop) * num_prop_vert floats and tri_verts 3 * num_tri indices.
+// Returns 0, writing nothing, if either is too small.
+int manifold_get_meshgl_buffers(ManifoldManifold *m, float *vert_props,
+                                size_t vert_props_length, uint32_t *tri_verts,
+                                size_t tri_length);
 
 // memory size
 
@@ -385,6 +407,7 @@ size_t manifold_curvature_size();
 
 void manifold_destruct_manifold(ManifoldManifold *m);
 void manifold_destruct_manifold_vec(ManifoldManifoldVec *ms);
+void manifold_destruct_manifolds(ManifoldManifold **ms, size_t n);
 void manifold_destruct_cross_section(ManifoldCrossSection *m);
 void manifold_destruct_cross_section_vec(ManifoldCrossSectionVec *csv);
 void manifold_destruct_simple_polygon(ManifoldSimplePolygon *p);
@@ -397,6 +420,7 @@ void manifold_destruct_rect(ManifoldRect *b);
 
 void manifold_delete_manifold(ManifoldManifold *m);
 void manifold_delete_manifold_vec(ManifoldManifoldVec *ms);
+void manifold_delete_manifolds(ManifoldManifold **ms, size_t n);
 void manifold_delete_cross_section(ManifoldCrossSection *cs);
 void manifold_delete_cross_section_vec(ManifoldCrossSectionVec *csv);
 void manifold_delete_simple_polygon(ManifoldSimplePolygon *p);
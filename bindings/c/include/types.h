@@ -90,6 +90,7 @@ typedef enum ManifoldError {
   MANIFOLD_RUN_INDEX_WRONG_LENGTH,
   MANIFOLD_FACE_ID_WRONG_LENGTH,
   MANIFOLD_INVALID_CONSTRUCTION,
+  MANIFOLD_CANCELLED,
 } ManifoldError;
 
 typedef enum ManifoldFillRule {
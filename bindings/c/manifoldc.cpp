@@ -155,6 +155,29 @@ ManifoldManifold *manifold_batch_boolean(void *mem, ManifoldManifoldVec *ms,
   return to_c(new (mem) Manifold(m));
 }
 
+ManifoldManifoldVec *manifold_instances(void *mem, ManifoldManifold *m,
+                                        float *transforms, size_t n) {
+  auto vec = new (mem) ManifoldVec();
+  vec->reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    const float *t = transforms + 12 * i;
+    glm::mat4x3 mat;
+    for (int j = 0; j < 12; ++j) mat[j / 3][j % 3] = t[j];
+    vec->push_back(from_c(m)->Transform(mat));
+  }
+  return to_c(vec);
+}
+
+ManifoldManifold *manifold_batch_boolean_array(void *mem,
+                                               ManifoldManifold **ms, size_t n,
+                                               ManifoldOpType op) {
+  ManifoldVec vec;
+  vec.reserve(n);
+  for (size_t i = 0; i < n; ++i) vec.push_back(*from_c(ms[i]));
+  auto m = Manifold::BatchBoolean(vec, from_c(op));
+  return to_c(new (mem) Manifold(m));
+}
+
 ManifoldManifold *manifold_union(void *mem, ManifoldManifold *a,
                                  ManifoldManifold *b) {
   auto m = (*from_c(a)) + (*from_c(b));
@@ -427,6 +450,13 @@ ManifoldMeshGL *manifold_get_meshgl(void *mem, ManifoldManifold *m) {
   return to_c(new (mem) MeshGL(mesh));
 }
 
+int manifold_get_meshgl_buffers(ManifoldManifold *m, float *vert_props,
+                                size_t vert_props_length, uint32_t *tri_verts,
+                                size_t tri_length) {
+  return from_c(m)->GetMeshGL(VecView<float>(vert_props, vert_props_length),
+                              VecView<uint32_t>(tri_verts, tri_length));
+}
+
 ManifoldMeshGL *manifold_meshgl_copy(void *mem, ManifoldMeshGL *m) {
   return to_c(new (mem) MeshGL(*from_c(m)));
 }
@@ -522,6 +552,10 @@ ManifoldError manifold_status(ManifoldManifold *m) {
 int manifold_num_vert(ManifoldManifold *m) { return from_c(m)->NumVert(); }
 int manifold_num_edge(ManifoldManifold *m) { return from_c(m)->NumEdge(); }
 int manifold_num_tri(ManifoldManifold *m) { return from_c(m)->NumTri(); }
+int manifold_num_prop(ManifoldManifold *m) { return from_c(m)->NumProp(); }
+int manifold_num_prop_vert(ManifoldManifold *m) {
+  return from_c(m)->NumPropVert();
+}
 int manifold_genus(ManifoldManifold *m) { return from_c(m)->Genus(); }
 
 ManifoldProperties manifold_get_properties(ManifoldManifold *m) {
@@ -603,6 +637,9 @@ void manifold_delete_manifold(ManifoldManifold *m) { delete from_c(m); }
 void manifold_delete_manifold_vec(ManifoldManifoldVec *ms) {
   delete from_c(ms);
 }
+void manifold_delete_manifolds(ManifoldManifold **ms, size_t n) {
+  for (size_t i = 0; i < n; ++i) delete from_c(ms[i]);
+}
 void manifold_delete_meshgl(ManifoldMeshGL *m) { delete from_c(m); }
 void manifold_delete_box(ManifoldBox *b) { delete from_c(b); }
 void manifold_delete_rect(ManifoldRect *r) { delete from_c(r); }
@@ -622,6 +659,9 @@ void manifold_destruct_manifold(ManifoldManifold *m) { from_c(m)->~Manifold(); }
 void manifold_destruct_manifold_vec(ManifoldManifoldVec *ms) {
   from_c(ms)->~ManifoldVec();
 }
+void manifold_destruct_manifolds(ManifoldManifold **ms, size_t n) {
+  for (size_t i = 0; i < n; ++i) from_c(ms[i])->~Manifold();
+}
 void manifold_destruct_meshgl(ManifoldMeshGL *m) { from_c(m)->~MeshGL(); }
 void manifold_destruct_box(ManifoldBox *b) { from_c(b)->~Box(); }
 void manifold_destruct_rect(ManifoldRect *r) { from_c(r)->~Rect(); }
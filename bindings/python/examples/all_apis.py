@@ -56,6 +56,8 @@ def all_cross_section():
 def all_manifold():
     mesh = Manifold.sphere(1).to_mesh()
     m = Manifold(mesh)
+    verts, tris = m.to_arrays()
+    m = Manifold.from_arrays(verts, tris)
     m = Manifold() + m
     m = m.as_original()
     m = Manifold.batch_boolean(
@@ -76,6 +78,9 @@ def all_manifold():
     m = Manifold.extrude(CrossSection.circle(1), 1)
     m = Manifold.revolve(CrossSection.circle(1))
     g = m.genus()
+    f = m.evaluate_async()
+    f.wait()
+    assert f.ready()
     a = m.surface_area()
     v = m.volume()
     m = m.hull()
@@ -12,6 +12,9 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <chrono>
+#include <future>
 #include <optional>
 #include <string>
 
@@ -208,6 +211,16 @@ std::vector<T> toVector(const T *arr, size_t size) {
   return std::vector<T>(arr, arr + size);
 }
 
+// Drops the GIL while a call evaluates geometry, so other Python threads can
+// run meanwhile. Only for calls that never touch Python objects.
+using release_gil = nb::call_guard<nb::gil_scoped_release>;
+
+// Hands a new[] buffer to numpy, which frees it when the array is collected.
+template <typename T>
+nb::capsule arrayOwner(T *buffer) {
+  return nb::capsule(buffer, [](void *p) noexcept { delete[](T *) p; });
+}
+
 using namespace manifold_docstrings;
 
 // strip original :params: and replace with ours
@@ -236,29 +249,50 @@ NB_MODULE(manifold3d, m) {
         nb::arg("precision") = -1,  // TODO document
         triangulate__polygons__precision);
 
+  nb::class_<std::shared_future<void>>(
+      m, "Future", "Handle to a background evaluation from evaluate_async.")
+      .def(
+          "ready",
+          [](const std::shared_future<void> &self) {
+            return self.wait_for(std::chrono::seconds(0)) ==
+                   std::future_status::ready;
+          },
+          "Returns whether the evaluation has finished, without blocking.")
+      .def(
+          "wait", [](const std::shared_future<void> &self) { self.get(); },
+          release_gil(),
+          "Blocks until the evaluation has finished, raising anything it "
+          "raised.");
+
   nb::class_<Manifold>(m, "Manifold")
       .def(nb::init<>(), manifold__manifold)
       .def(nb::init<const MeshGL &, const std::vector<float> &>(),
-           nb::arg("mesh"), nb::arg("property_tolerance") = nb::list(),
+           release_gil(), nb::arg("mesh"),
+           nb::arg("property_tolerance") = nb::list(),
            manifold__manifold__mesh_gl__property_tolerance)
       .def(nb::self + nb::self, manifold__operator_plus__q)
       .def(nb::self - nb::self, manifold__operator_minus__q)
       .def(nb::self ^ nb::self, manifold__operator_xor__q)
       .def(
           "hull", [](const Manifold &self) { return self.Hull(); },
-          manifold__hull)
+          release_gil(), manifold__hull)
       .def_static(
           "batch_hull",
           [](std::vector<Manifold> ms) { return Manifold::Hull(ms); },
-          nb::arg("manifolds"), manifold__hull__manifolds)
+          release_gil(), nb::arg("manifolds"), manifold__hull__manifolds)
       .def_static(
           "hull_points",
           [](std::vector<glm::vec3> pts) { return Manifold::Hull(pts); },
-          nb::arg("pts"), manifold__hull__pts)
+          release_gil(), nb::arg("pts"), manifold__hull__pts)
       .def("transform", &Manifold::Transform, nb::arg("m"),
            manifold__transform__m)
-      .def_static("minkowski", &Manifold::Minkowski, nb::arg("a"), nb::arg("b"),
+      .def_static("minkowski",
+                  nb::overload_cast<const Manifold&, const Manifold&, bool>(
+                      &Manifold::Minkowski),
+                  release_gil(), nb::arg("a"), nb::arg("b"),
                   nb::arg("useNaive"))
+      .def("offset", &Manifold::Offset, release_gil(), nb::arg("delta"),
+           nb::arg("edgeLength") = 0)
       .def("translate", &Manifold::Translate, nb::arg("t"),
            manifold__translate__v)
       .def("scale", &Manifold::Scale, nb::arg("v"), manifold__scale__v)
@@ -320,44 +354,81 @@ NB_MODULE(manifold3d, m) {
           nb::arg("new_num_prop"), nb::arg("f"),
           manifold__set_properties__num_prop__prop_func)
       .def("calculate_curvature", &Manifold::CalculateCurvature,
-           nb::arg("gaussian_idx"), nb::arg("mean_idx"),
+           release_gil(), nb::arg("gaussian_idx"), nb::arg("mean_idx"),
            manifold__calculate_curvature__gaussian_idx__mean_idx)
-      .def("refine", &Manifold::Refine, nb::arg("n"), manifold__refine__n)
-      .def("to_mesh", &Manifold::GetMeshGL,
+      .def("refine", &Manifold::Refine, release_gil(), nb::arg("n"),
+           manifold__refine__n)
+      .def("to_mesh", &Manifold::GetMeshGL, release_gil(),
            nb::arg("normal_idx") = glm::ivec3(0),
            manifold__get_mesh_gl__normal_idx)
-      .def("num_vert", &Manifold::NumVert, manifold__num_vert)
-      .def("num_edge", &Manifold::NumEdge, manifold__num_edge)
-      .def("num_tri", &Manifold::NumTri, manifold__num_tri)
-      .def("num_prop", &Manifold::NumProp, manifold__num_prop)
-      .def("num_prop_vert", &Manifold::NumPropVert, manifold__num_prop_vert)
-      .def("precision", &Manifold::Precision, manifold__precision)
-      .def("genus", &Manifold::Genus, manifold__genus)
+      .def(
+          "to_arrays",
+          [](const Manifold &self) {
+            size_t numProp, numVert, numTri;
+            float *vertProp;
+            uint32_t *triVerts;
+            {
+              nb::gil_scoped_release release;
+              numProp = 3 + self.NumProp();
+              numVert = self.NumPropVert();
+              numTri = self.NumTri();
+              vertProp = new float[numProp * numVert]();
+              triVerts = new uint32_t[3 * numTri];
+              self.GetMeshGL(VecView<float>(vertProp, numProp * numVert),
+                             VecView<uint32_t>(triVerts, 3 * numTri));
+            }
+            return std::make_tuple(
+                nb::ndarray<nb::numpy, float, nb::shape<nb::any, nb::any>>(
+                    vertProp, {numVert, numProp}, arrayOwner(vertProp)),
+                nb::ndarray<nb::numpy, uint32_t, nb::shape<nb::any, 3>>(
+                    triVerts, {numTri, 3}, arrayOwner(triVerts)));
+          },
+          "Gets the vertex properties and triangles as a tuple of numpy "
+          "arrays (vert_properties[n, num_prop], tri_verts[m, 3]), written "
+          "directly into buffers that numpy then owns, so nothing is copied. "
+          "Unlike to_mesh, there is one vertex per property vertex and no "
+          "runs or merge vectors, so use to_mesh for a lossless round-trip.")
+      .def("num_vert", &Manifold::NumVert, release_gil(), manifold__num_vert)
+      .def("num_edge", &Manifold::NumEdge, release_gil(), manifold__num_edge)
+      .def("num_tri", &Manifold::NumTri, release_gil(), manifold__num_tri)
+      .def("num_prop", &Manifold::NumProp, release_gil(), manifold__num_prop)
+      .def("num_prop_vert", &Manifold::NumPropVert, release_gil(),
+           manifold__num_prop_vert)
+      .def("precision", &Manifold::Precision, release_gil(),
+           manifold__precision)
+      .def("genus", &Manifold::Genus, release_gil(), manifold__genus)
+      .def("evaluate_async", &Manifold::EvaluateAsync,
+           manifold__evaluate_async)
       .def(
           "volume",
           [](const Manifold &self) { return self.GetProperties().volume; },
+          release_gil(),
           "Get the volume of the manifold\n This is clamped to zero for a "
           "given face if they are within the Precision().")
       .def(
           "surface_area",
           [](const Manifold &self) { return self.GetProperties().surfaceArea; },
+          release_gil(),
           "Get the surface area of the manifold\n This is clamped to zero for "
           "a given face if they are within the Precision().")
-      .def("original_id", &Manifold::OriginalID, manifold__original_id)
-      .def("as_original", &Manifold::AsOriginal, manifold__as_original)
-      .def("is_empty", &Manifold::IsEmpty, manifold__is_empty)
-      .def("decompose", &Manifold::Decompose, manifold__decompose)
-      .def("split", &Manifold::Split, nb::arg("cutter"),
+      .def("original_id", &Manifold::OriginalID, release_gil(),
+           manifold__original_id)
+      .def("as_original", &Manifold::AsOriginal, release_gil(),
+           manifold__as_original)
+      .def("is_empty", &Manifold::IsEmpty, release_gil(), manifold__is_empty)
+      .def("decompose", &Manifold::Decompose, release_gil(),
+           manifold__decompose)
+      .def("split", &Manifold::Split, release_gil(), nb::arg("cutter"),
            manifold__split__cutter)
-      .def("split_by_plane", &Manifold::SplitByPlane, nb::arg("normal"),
-           nb::arg("origin_offset"),
+      .def("split_by_plane", &Manifold::SplitByPlane, release_gil(),
+           nb::arg("normal"), nb::arg("origin_offset"),
            manifold__split_by_plane__normal__origin_offset)
-      .def("trim_by_plane", &Manifold::TrimByPlane, nb::arg("normal"),
-           nb::arg("origin_offset"),
+      .def("trim_by_plane", &Manifold::TrimByPlane, release_gil(),
+           nb::arg("normal"), nb::arg("origin_offset"),
            manifold__trim_by_plane__normal__origin_offset)
-      .def("slice", &Manifold::Slice, nb::arg("height"),
+      .def("slice", &Manifold::Slice, release_gil(), nb::arg("height"),
            manifold__slice__height)
-      .def("project", &Manifold::Project, manifold__project)
+      .def("project", &Manifold::Project, release_gil(), manifold__project)
       .def(
           "fracture",
           [](Manifold &self,
@@ -379,12 +450,20 @@ NB_MODULE(manifold3d, m) {
             }
             return self.Fracture(pts_vec, weights_vec);
           }, nb::arg("pts"), nb::arg("weights"))
-      .def("convex_decomposition", &Manifold::ConvexDecomposition)
-      .def("status", &Manifold::Status, manifold__status)
+      .def("convex_decomposition", &Manifold::ConvexDecomposition,
+           release_gil(), nb::arg("tolerance") = 1e-9)
+      .def("approx_convex_decomposition",
+           &Manifold::ApproxConvexDecomposition, release_gil(),
+           nb::arg("concavity") = 0.05, nb::arg("maxParts") = 64)
+      .def("status", &Manifold::Status, release_gil(), manifold__status)
       .def(
           "bounding_box",
           [](const Manifold &self) {
-            Box b = self.BoundingBox();
+            Box b;
+            {
+              nb::gil_scoped_release release;
+              b = self.BoundingBox();
+            }
             return nb::make_tuple(b.min[0], b.min[1], b.min[2], b.max[0],
                                   b.max[1], b.max[2]);
           },
@@ -402,13 +481,14 @@ NB_MODULE(manifold3d, m) {
             for (int i = 0; i < vec.size(); i++) {
               vec[i] = {sharpened_edges[i], edge_smoothness[i]};
             }
+            nb::gil_scoped_release release;
             return Manifold::Smooth(mesh, vec);
           },
           nb::arg("mesh"), nb::arg("sharpened_edges") = nb::list(),
           nb::arg("edge_smoothness") = nb::list(),
           // todo params slightly diff
           manifold__smooth__mesh_gl__sharpened_edges)
-      .def_static("batch_boolean", &Manifold::BatchBoolean,
+      .def_static("batch_boolean", &Manifold::BatchBoolean, release_gil(),
                   nb::arg("manifolds"), nb::arg("op"),
                   manifold__batch_boolean__manifolds__op)
       .def_static("compose", &Manifold::Compose, nb::arg("manifolds"),
@@ -435,7 +515,43 @@ NB_MODULE(manifold3d, m) {
                   nb::arg("circular_segments") = 0,
                   manifold__sphere__radius__circular_segments)
       .def_static("reserve_ids", Manifold::ReserveIDs, nb::arg("n"),
-                  manifold__reserve_ids__n);
+                  manifold__reserve_ids__n)
+      .def_static(
+          "from_arrays",
+          [](const nb::ndarray<const float, nb::shape<nb::any, nb::any>,
+                               nb::c_contig> &vertProp,
+             const nb::ndarray<const uint32_t, nb::shape<nb::any, 3>,
+                               nb::c_contig> &triVerts,
+             const std::optional<nb::ndarray<const uint32_t,
+                                             nb::shape<nb::any>, nb::c_contig>>
+                 &mergeFromVert,
+             const std::optional<nb::ndarray<const uint32_t,
+                                             nb::shape<nb::any>, nb::c_contig>>
+                 &mergeToVert,
+             const std::vector<float> &propertyTolerance) {
+            // the arrays outlive this call, so read them in place
+            MeshGLView view;
+            view.numProp = vertProp.shape(1);
+            view.vertProperties =
+                VecView<const float>(vertProp.data(), vertProp.size());
+            view.triVerts =
+                VecView<const uint32_t>(triVerts.data(), triVerts.size());
+            if (mergeFromVert.has_value())
+              view.mergeFromVert = VecView<const uint32_t>(
+                  mergeFromVert->data(), mergeFromVert->size());
+            if (mergeToVert.has_value())
+              view.mergeToVert = VecView<const uint32_t>(
+                  mergeToVert->data(), mergeToVert->size());
+            nb::gil_scoped_release release;
+            return Manifold(view, propertyTolerance);
+          },
+          nb::arg("vert_properties"), nb::arg("tri_verts"),
+          nb::arg("merge_from_vert") = nb::none(),
+          nb::arg("merge_to_vert") = nb::none(),
+          nb::arg("property_tolerance") = nb::list(),
+          "Constructs a Manifold straight from numpy arrays, without copying "
+          "them into a Mesh first. The arguments are as for Mesh, and the "
+          "result is as for Manifold(mesh).");
 
   nb::class_<MeshGL>(m, "Mesh")
       .def(
@@ -567,7 +683,115 @@ NB_MODULE(manifold3d, m) {
           ":param level: You can inset your Mesh by using a positive value, or "
           "outset it with a negative value."
           ":return Mesh: This mesh is guaranteed to be manifold."
-          "Use Manifold.from_mesh(mesh) to create a Manifold");
+          "Use Manifold.from_mesh(mesh) to create a Manifold")
+      .def_static(
+          "level_set_batch",
+          [](const std::function<nb::object(
+                 nb::ndarray<nb::numpy, const float, nb::shape<nb::any, 3>>)>
+                 &f,
+             std::vector<float> bounds, float edgeLength, float level) {
+            // Same format as Manifold.bounding_box
+            Box bound = {glm::vec3(bounds[0], bounds[1], bounds[2]),
+                         glm::vec3(bounds[3], bounds[4], bounds[5])};
+            // always called from this thread, so the rest can be parallel and
+            // other Python threads can run between blocks
+            auto cppToPython = [&f](VecView<const glm::vec3> points,
+                                    VecView<float> values) {
+              const size_t n = points.size();
+              if (n == 0) return;
+              nb::gil_scoped_acquire acquire;
+              // the points are copied into an array numpy owns, so the
+              // callback may keep it past the call
+              float *buffer = new float[3 * n];
+              std::copy(&points[0].x, &points[0].x + 3 * n, buffer);
+              auto result =
+                  f(nb::ndarray<nb::numpy, const float, nb::shape<nb::any, 3>>(
+                      buffer, {n, size_t(3)}, arrayOwner(buffer)));
+              nb::ndarray<float, nb::shape<nb::any>> array;
+              nb::ndarray<double, nb::shape<nb::any>> arrayD;
+              if (nb::try_cast(result, array) && array.shape(0) == n) {
+                for (size_t i = 0; i < n; i++) values[i] = array(i);
+              } else if (nb::try_cast(result, arrayD) && arrayD.shape(0) == n) {
+                for (size_t i = 0; i < n; i++) values[i] = arrayD(i);
+              } else {
+                throw std::runtime_error(
+                    "Callback in level_set_batch should return an array of "
+                    "one value per point");
+              }
+            };
+            nb::gil_scoped_release release;
+            return MeshGL(LevelSet(cppToPython, bound, edgeLength, level));
+          },
+          nb::arg("f"), nb::arg("bounds"), nb::arg("edgeLength"),
+          nb::arg("level") = 0.0,
+          "Constructs a level-set Mesh like level_set, but calls f once per "
+          "block of grid points, so it can be vectorized with numpy."
+          "\n\n"
+          ":param f: The batch signed-distance function, with signature "
+          "`def sdf(points : ndarray[n, 3]) -> ndarray[n]:`, which returns "
+          "the signed distance of each point, as float32 or float64."
+          ":param bounds: An axis-aligned box that defines the extent of the "
+          "grid."
+          ":param edgeLength: Approximate maximum edge length of the triangles "
+          "in the final result."
+          ":param level: You can inset your Mesh by using a positive value, or "
+          "outset it with a negative value."
+          ":return Mesh: This mesh is guaranteed to be manifold.")
+      .def_static(
+          "level_set_expr",
+          [](const SDFExpr &sdf, std::vector<float> bounds, float edgeLength,
+             float level) {
+            // Same format as Manifold.bounding_box
+            Box bound = {glm::vec3(bounds[0], bounds[1], bounds[2]),
+                         glm::vec3(bounds[3], bounds[4], bounds[5])};
+            // no callbacks into Python, so it can all be parallel
+            nb::gil_scoped_release release;
+            return MeshGL(LevelSet(sdf, bound, edgeLength, level));
+          },
+          nb::arg("sdf"), nb::arg("bounds"), nb::arg("edgeLength"),
+          nb::arg("level") = 0.0,
+          "Constructs a level-set Mesh like level_set, from an SDFExpr, which "
+          "is evaluated natively and only where its bounds reach the surface."
+          "\n\n"
+          ":param sdf: The SDFExpr to mesh."
+          ":param bounds: An axis-aligned box that defines the extent of the "
+          "grid."
+          ":param edgeLength: Approximate maximum edge length of the triangles "
+          "in the final result."
+          ":param level: You can inset your Mesh by using a positive value, or "
+          "outset it with a negative value."
+          ":return Mesh: This mesh is guaranteed to be manifold.");
+
+  nb::class_<SDFExpr>(m, "SDFExpr",
+                      "A signed-distance function built from primitives, "
+                      "transforms and CSG, which level_set_expr evaluates "
+                      "without calling back into Python. Positive values are "
+                      "inside.")
+      .def_static("sphere", &SDFExpr::Sphere, nb::arg("radius"))
+      .def_static("cube", &SDFExpr::Cube, nb::arg("size"))
+      .def_static("cylinder", &SDFExpr::Cylinder, nb::arg("height"),
+                  nb::arg("radius"))
+      .def_static("torus", &SDFExpr::Torus, nb::arg("major_radius"),
+                  nb::arg("minor_radius"))
+      .def_static("half_space", &SDFExpr::HalfSpace, nb::arg("normal"),
+                  nb::arg("offset") = 0.0f)
+      .def("translate", &SDFExpr::Translate, nb::arg("v"))
+      .def(
+          "rotate",
+          [](const SDFExpr &self, glm::vec3 v) {
+            return self.Rotate(v.x, v.y, v.z);
+          },
+          nb::arg("v"))
+      .def("scale", &SDFExpr::Scale, nb::arg("factor"))
+      .def("repeat", &SDFExpr::Repeat, nb::arg("period"))
+      .def("union", &SDFExpr::Union, nb::arg("other"),
+           nb::arg("smoothness") = 0.0f)
+      .def("intersect", &SDFExpr::Intersect, nb::arg("other"),
+           nb::arg("smoothness") = 0.0f)
+      .def("subtract", &SDFExpr::Subtract, nb::arg("other"),
+           nb::arg("smoothness") = 0.0f)
+      .def("offset", &SDFExpr::Offset, nb::arg("delta"))
+      .def("__call__", &SDFExpr::operator(), nb::arg("point"));
 
   nb::enum_<Manifold::Error>(m, "Error")
       .value("NoError", Manifold::Error::NoError)
@@ -583,7 +807,8 @@ NB_MODULE(manifold3d, m) {
       .value("TransformWrongLength", Manifold::Error::TransformWrongLength)
       .value("RunIndexWrongLength", Manifold::Error::RunIndexWrongLength)
       .value("FaceIDWrongLength", Manifold::Error::FaceIDWrongLength)
-      .value("InvalidConstruction", Manifold::Error::InvalidConstruction);
+      .value("InvalidConstruction", Manifold::Error::InvalidConstruction)
+      .value("Cancelled", Manifold::Error::Cancelled);
 
   nb::enum_<CrossSection::FillRule>(m, "FillRule")
       .value("EvenOdd", CrossSection::FillRule::EvenOdd,
@@ -680,6 +905,11 @@ NB_MODULE(manifold3d, m) {
           nb::arg("join_type"), nb::arg("miter_limit") = 2.0,
           nb::arg("circular_segments") = 0,
           cross_section__offset__delta__jointype__miter_limit__circular_segments)
+      .def(
+          "offsets", &CrossSection::Offsets, nb::arg("deltas"),
+          nb::arg("join_type"), nb::arg("miter_limit") = 2.0,
+          nb::arg("circular_segments") = 0,
+          cross_section__offsets__deltas__jointype__miter_limit__circular_segments)
       .def(nb::self + nb::self, cross_section__operator_plus__q)
       .def(nb::self - nb::self, cross_section__operator_minus__q)
       .def(nb::self ^ nb::self, cross_section__operator_xor__q)
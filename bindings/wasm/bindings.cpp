@@ -61,7 +61,8 @@ EMSCRIPTEN_BINDINGS(whatever) {
       .value("TransformWrongLength", Manifold::Error::TransformWrongLength)
       .value("RunIndexWrongLength", Manifold::Error::RunIndexWrongLength)
       .value("FaceIDWrongLength", Manifold::Error::FaceIDWrongLength)
-      .value("InvalidConstruction", Manifold::Error::InvalidConstruction);
+      .value("InvalidConstruction", Manifold::Error::InvalidConstruction)
+      .value("Cancelled", Manifold::Error::Cancelled);
 
   enum_<CrossSection::FillRule>("fillrule")
       .value("EvenOdd", CrossSection::FillRule::EvenOdd)
@@ -156,6 +157,9 @@ EMSCRIPTEN_BINDINGS(whatever) {
                                   &Manifold::Decompose))
       .function("_Fracture", &Manifold::Fracture)
       .function("_ConvexDecomposition", &Manifold::ConvexDecomposition)
+      .function("_ApproxConvexDecomposition",
+                &Manifold::ApproxConvexDecomposition)
+      .function("_Offset", &Manifold::Offset)
       .function("isEmpty", &Manifold::IsEmpty)
       .function("status", &Manifold::Status)
       .function("numVert", &Manifold::NumVert)
@@ -169,7 +173,8 @@ EMSCRIPTEN_BINDINGS(whatever) {
       .function("getProperties", &Manifold::GetProperties)
       .function("calculateCurvature", &Manifold::CalculateCurvature)
       .function("originalID", &Manifold::OriginalID)
-      .function("asOriginal", &Manifold::AsOriginal);
+      .function("asOriginal", &Manifold::AsOriginal)
+      .function("_EvaluateAsync", &man_js::EvaluateAsync);
 
   // Manifold Static Methods
   function("_Cube", &Manifold::Cube);
@@ -328,8 +328,20 @@ Module.setup = function() {
     }
   };
 
-  Module.Manifold.prototype.convexDecomposition = function() {
-    const vec = this._ConvexDecomposition();
+  Module.Manifold.prototype.convexDecomposition = function(tolerance = 1e-9) {
+    const vec = this._ConvexDecomposition(tolerance);
+    const result = fromVec(vec);
+    vec.delete();
+    return result;
+  };
+
+  Module.Manifold.prototype.offset = function(delta, edgeLength = 0) {
+    return this._Offset(delta, edgeLength);
+  };
+
+  Module.Manifold.prototype.approxConvexDecomposition = function(
+      concavity = 0.05, maxParts = 64) {
+    const vec = this._ApproxConvexDecomposition(concavity, maxParts);
     const result = fromVec(vec);
     vec.delete();
     return result;
@@ -423,6 +435,35 @@ Module.setup = function() {
     return new Mesh(this._GetMeshJS(normalIdx));
   };
 
+  // async evaluation
+
+  const asyncJobs = new Map();
+  let nextJobID = 0;
+
+  Module._resolveJob = function(jobID) {
+    const {resolve} = asyncJobs.get(jobID);
+    asyncJobs.delete(jobID);
+    resolve();
+  };
+
+  Module._rejectJob = function(jobID, message) {
+    const {reject} = asyncJobs.get(jobID);
+    asyncJobs.delete(jobID);
+    reject(new Error(message));
+  };
+
+  Module.Manifold.prototype.evaluateAsync = function() {
+    return new Promise((resolve, reject) => {
+      const jobID = nextJobID++;
+      asyncJobs.set(jobID, {resolve: () => resolve(this), reject});
+      this._EvaluateAsync(jobID);
+    });
+  };
+
+  Module.Manifold.prototype.getMeshAsync = function(normalIdx = [0, 0, 0]) {
+    return this.evaluateAsync().then(manifold => manifold.getMesh(normalIdx));
+  };
+
   Module.ManifoldError = function ManifoldError(code, ...args) {
     let message = 'Unknown error';
     switch (code) {
@@ -457,6 +498,9 @@ Module.setup = function() {
         message = 'Face ID vector has wrong length';
       case Module.status.InvalidConstruction.value:
         message = 'Manifold constructed with invalid parameters';
+        break;
+      case Module.status.Cancelled.value:
+        message = 'Operation cancelled';
     }
 
     const base = Error.apply(this, [message, ...args]);
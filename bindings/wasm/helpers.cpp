@@ -1,8 +1,21 @@
 #include <emscripten/bind.h>
+#include <emscripten/em_asm.h>
 #include <emscripten/val.h>
 
+#include <cstdlib>
+#include <cstring>
+#include <exception>
 #include <vector>
 
+#ifdef __EMSCRIPTEN_PTHREADS__
+#include <emscripten/threading.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#endif
+
 #include "cross_section.h"
 #include "manifold.h"
 #include "polygon.h"
@@ -229,4 +242,98 @@ void CollectVertices(std::vector<glm::vec3>& verts, const Manifold& manifold) {
   Mesh mesh = manifold.GetMesh();
   verts.insert(verts.end(), mesh.vertPos.begin(), mesh.vertPos.end());
 }
+
+void ResolveJob(int jobID) {
+  EM_ASM({ Module._resolveJob($0); }, jobID);
+}
+
+// Takes ownership of what, which must come from strdup.
+void RejectJob(int jobID, char* what) {
+  EM_ASM({ Module._rejectJob($0, UTF8ToString($1)); }, jobID, what);
+  free(what);
+}
+
+// Evaluates the manifold, returning the message of anything thrown, or null
+// on success.
+char* Evaluate(const Manifold& manifold) {
+  try {
+    manifold.Status();
+  } catch (const std::exception& e) {
+    return strdup(e.what());
+  } catch (...) {
+    return strdup("Unknown error");
+  }
+  return nullptr;
+}
+
+#ifdef __EMSCRIPTEN_PTHREADS__
+// Runs evaluations one at a time on a single long-lived thread. Every thread
+// comes out of the fixed pthread pool, so a thread per call could take the
+// workers TBB needs and deadlock; this takes one, once, and each evaluation
+// still spreads over the TBB workers.
+class EvaluationQueue {
+ public:
+  static EvaluationQueue& Get() {
+    static EvaluationQueue* queue = new EvaluationQueue();
+    return *queue;
+  }
+
+  void Push(const Manifold& manifold, int jobID) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      jobs_.push_back({manifold, jobID});
+    }
+    ready_.notify_one();
+  }
+
+ private:
+  struct Job {
+    Manifold manifold;
+    int jobID;
+  };
+
+  EvaluationQueue() {
+    std::thread([this]() {
+      while (true) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_.wait(lock, [this]() { return !jobs_.empty(); });
+        Job job = std::move(jobs_.front());
+        jobs_.pop_front();
+        lock.unlock();
+        // an exception can't leave this thread, so it is posted back to
+        // reject the job instead
+        char* what = Evaluate(job.manifold);
+        if (what == nullptr) {
+          emscripten_async_run_in_main_runtime_thread(
+              EM_FUNC_SIG_VI, ResolveJob, job.jobID);
+        } else {
+          emscripten_async_run_in_main_runtime_thread(
+              EM_FUNC_SIG_VII, RejectJob, job.jobID, what);
+        }
+      }
+    }).detach();
+  }
+
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::deque<Job> jobs_;
+};
+#endif
+
+// Evaluates the lazy CSG tree, which is where the time of nearly every call
+// goes. With pthreads this is queued for the evaluation thread and settles
+// the job back on the main thread, which stays free meanwhile; otherwise it
+// settles in place. A failed evaluation rejects the job.
+void EvaluateAsync(const Manifold& manifold, int jobID) {
+#ifdef __EMSCRIPTEN_PTHREADS__
+  EvaluationQueue::Get().Push(manifold, jobID);
+#else
+  char* what = Evaluate(manifold);
+  if (what == nullptr) {
+    ResolveJob(jobID);
+  } else {
+    RejectJob(jobID, what);
+  }
+#endif
+}
 }  // namespace man_js
@@ -814,6 +814,24 @@ export class Manifold {
    */
   getMesh(normalIdx?: Vec3): Mesh;
 
+  /**
+   * Resolves once this manifold's pending operations have been evaluated, after
+   * which queries and getMesh() return quickly. In a build with threads the
+   * work runs in Web Workers, leaving the calling thread free, and jobs are
+   * evaluated one after another. Calling methods of this manifold before the
+   * promise resolves is safe: the call blocks on any operations the
+   * evaluation has already started rather than repeating them, but a pending
+   * transform of a leaf may be applied on both threads, with one copy
+   * discarded. If the evaluation throws, the promise rejects with its message.
+   */
+  evaluateAsync(): Promise<Manifold>;
+
+  /**
+   * Like getMesh(), but evaluates off the calling thread as evaluateAsync()
+   * does.
+   */
+  getMeshAsync(normalIdx?: Vec3): Promise<Mesh>;
+
   // ID Management
 
   /**
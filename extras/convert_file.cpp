@@ -31,7 +31,7 @@ int main(int argc, char** argv) {
 
   const std::string filename(argv[1]);
 
-  MeshGL input = ImportMesh(filename);
+  MeshGL input = ImportMeshGL(filename);
   std::cout << input.NumVert() << " vertices, " << input.NumTri()
             << " triangles" << std::endl;
 
@@ -0,0 +1,324 @@
+// Copyright 2024 The Manifold Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "collider.h"
+#include "cross_section.h"
+#include "manifold.h"
+#include "polygon.h"
+#include "sdf.h"
+
+#ifdef MANIFOLD_EXPORT
+#include "meshIO.h"
+#endif
+
+using namespace manifold;
+
+namespace {
+
+// Manifolds are lazy; this forces evaluation inside the timed region.
+void Evaluate(const Manifold& manifold) {
+  benchmark::DoNotOptimize(manifold.NumTri());
+}
+
+Manifold Evaluated(const Manifold& manifold) {
+  Evaluate(manifold);
+  return manifold;
+}
+
+std::vector<glm::vec3> RandomPoints(int n, int seed = 0) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<float> dist(-1, 1);
+  std::vector<glm::vec3> pts(n);
+  for (auto& p : pts) p = {dist(gen), dist(gen), dist(gen)};
+  return pts;
+}
+
+// ----------------------------------------------------------------------------
+//                                  Booleans
+// ----------------------------------------------------------------------------
+
+// Sphere minus sphere, sweeping resolution and how far the spheres overlap:
+// the offset is range(1) tenths of a radius, so smaller offsets mean more
+// intersecting edges per triangle.
+void BM_Boolean(benchmark::State& state) {
+  const int segments = state.range(0);
+  const float offset = state.range(1) / 10.0f;
+  const Manifold a = Evaluated(Manifold::Sphere(1, segments));
+  const Manifold b = Evaluated(a.Translate({offset, offset, offset}));
+  for (auto _ : state) Evaluate(a - b);
+  state.SetItemsProcessed(state.iterations() * 2 * a.NumTri());
+}
+BENCHMARK(BM_Boolean)
+    ->ArgsProduct({{64, 256, 1024}, {1, 5, 10}})
+    ->Unit(benchmark::kMillisecond);
+
+// Union of an n x n x n grid of overlapping spheres.
+void BM_BatchBoolean(benchmark::State& state) {
+  const int n = state.range(0);
+  const Manifold sphere = Evaluated(Manifold::Sphere(0.6, 32));
+  std::vector<Manifold> spheres;
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < n; ++j)
+      for (int k = 0; k < n; ++k)
+        spheres.push_back(Evaluated(sphere.Translate(glm::vec3(i, j, k))));
+  for (auto _ : state)
+    Evaluate(Manifold::BatchBoolean(spheres, OpType::Add));
+}
+BENCHMARK(BM_BatchBoolean)->DenseRange(2, 6, 2)->Unit(benchmark::kMillisecond);
+
+// Construction from a MeshGL: validation, Finish() and the spatial sort.
+void BM_Finish(benchmark::State& state) {
+  const MeshGL mesh = Manifold::Sphere(1, state.range(0)).GetMeshGL();
+  for (auto _ : state) Evaluate(Manifold(mesh));
+  state.SetItemsProcessed(state.iterations() * mesh.NumTri());
+}
+BENCHMARK(BM_Finish)->RangeMultiplier(4)->Range(64, 1024)->Unit(
+    benchmark::kMillisecond);
+
+// ----------------------------------------------------------------------------
+//                                  Collider
+// ----------------------------------------------------------------------------
+
+struct ColliderInput {
+  Vec<Box> boxes;
+  Vec<uint32_t> morton;
+};
+
+ColliderInput RandomBoxes(int n) {
+  const std::vector<glm::vec3> centers = RandomPoints(n);
+  const Box bBox(glm::vec3(-1), glm::vec3(1));
+  const float size = 2.0f / std::cbrt(static_cast<float>(n));
+  std::vector<std::pair<uint32_t, Box>> sorted(n);
+  for (int i = 0; i < n; ++i) {
+    sorted[i] = {Collider::MortonCode(centers[i], bBox),
+                 Box(centers[i] - size / 2, centers[i] + size / 2)};
+  }
+  std::sort(sorted.begin(), sorted.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; });
+  ColliderInput input;
+  for (const auto& [code, box] : sorted) {
+    input.morton.push_back(code);
+    input.boxes.push_back(box);
+  }
+  return input;
+}
+
+void BM_ColliderBuild(benchmark::State& state) {
+  const ColliderInput input = RandomBoxes(state.range(0));
+  for (auto _ : state) {
+    Collider collider(input.boxes, input.morton);
+    benchmark::DoNotOptimize(collider);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ColliderBuild)->RangeMultiplier(8)->Range(1 << 10, 1 << 20);
+
+void BM_ColliderQuery(benchmark::State& state) {
+  const ColliderInput input = RandomBoxes(state.range(0));
+  const Collider collider(input.boxes, input.morton);
+  for (auto _ : state) {
+    SparseIndices overlaps =
+        collider.Collisions<true>(input.boxes.cview());
+    benchmark::DoNotOptimize(overlaps.size());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ColliderQuery)->RangeMultiplier(8)->Range(1 << 10, 1 << 20);
+
+// ----------------------------------------------------------------------------
+//                                 Triangulate
+// ----------------------------------------------------------------------------
+
+// The polygon test corpus, collected with the same trick as the polygon fuzzer
+// uses for its seeds.
+struct TestCase {
+  Polygons polygons;
+  float precision;
+};
+
+#define TEST(_unused1, _unused2)
+std::vector<TestCase> PolygonCorpus() {
+  std::vector<TestCase> corpus;
+  auto TestPoly = [&corpus](Polygons polys, int _unused,
+                            float precision = -1.0f) {
+    corpus.push_back({polys, precision});
+  };
+
+#include "polygon_corpus.cpp"
+
+  return corpus;
+}
+#undef TEST
+
+void BM_TriangulateCorpus(benchmark::State& state) {
+  const std::vector<TestCase> corpus = PolygonCorpus();
+  size_t numVert = 0;
+  for (const TestCase& test : corpus)
+    for (const SimplePolygon& poly : test.polygons) numVert += poly.size();
+  for (auto _ : state) {
+    for (const TestCase& test : corpus) {
+      benchmark::DoNotOptimize(Triangulate(test.polygons, test.precision));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * numVert);
+}
+BENCHMARK(BM_TriangulateCorpus)->Unit(benchmark::kMillisecond);
+
+// A circle of range(0) points with range(0) / 4 circular holes, large enough
+// to exercise the sweep rather than the corpus' small cases.
+void BM_TriangulateCircles(benchmark::State& state) {
+  const int n = state.range(0);
+  Polygons polys = CrossSection::Circle(10, n).ToPolygons();
+  for (int i = 0; i < n / 4; ++i) {
+    const float angle = glm::two_pi<float>() * i / (n / 4);
+    const CrossSection hole = CrossSection::Circle(0.2, 8).Translate(
+        {7 * glm::cos(angle), 7 * glm::sin(angle)});
+    SimplePolygon poly = hole.ToPolygons()[0];
+    std::reverse(poly.begin(), poly.end());
+    polys.push_back(poly);
+  }
+  for (auto _ : state) benchmark::DoNotOptimize(Triangulate(polys));
+}
+BENCHMARK(BM_TriangulateCircles)
+    ->RangeMultiplier(8)
+    ->Range(64, 1 << 15)
+    ->Unit(benchmark::kMillisecond);
+
+// ----------------------------------------------------------------------------
+//                                  Geometry
+// ----------------------------------------------------------------------------
+
+void BM_LevelSet(benchmark::State& state) {
+  auto gyroid = [](glm::vec3 p) {
+    p *= glm::two_pi<float>();
+    return glm::sin(p.x) * glm::cos(p.y) + glm::sin(p.y) * glm::cos(p.z) +
+           glm::sin(p.z) * glm::cos(p.x);
+  };
+  const Box bounds(glm::vec3(-1), glm::vec3(1));
+  const float edgeLength = 1.0f / state.range(0);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(LevelSet(gyroid, bounds, edgeLength));
+}
+BENCHMARK(BM_LevelSet)->RangeMultiplier(2)->Range(8, 64)->Unit(
+    benchmark::kMillisecond);
+
+void BM_Slice(benchmark::State& state) {
+  const Manifold sphere = Evaluated(Manifold::Sphere(1, state.range(0)));
+  for (auto _ : state) benchmark::DoNotOptimize(sphere.Slice(0.3).Area());
+}
+BENCHMARK(BM_Slice)->RangeMultiplier(4)->Range(64, 4096)->Unit(
+    benchmark::kMillisecond);
+
+void BM_Hull(benchmark::State& state) {
+  const std::vector<glm::vec3> pts = RandomPoints(state.range(0));
+  for (auto _ : state) Evaluate(Manifold::Hull(pts));
+  state.SetItemsProcessed(state.iterations() * pts.size());
+}
+BENCHMARK(BM_Hull)->RangeMultiplier(8)->Range(1 << 10, 1 << 20)->Unit(
+    benchmark::kMillisecond);
+
+void BM_Fracture(benchmark::State& state) {
+  const Manifold cube = Evaluated(Manifold::Cube(glm::vec3(2), true));
+  const std::vector<glm::vec3> fpts = RandomPoints(state.range(0));
+  const std::vector<glm::dvec3> pts(fpts.begin(), fpts.end());
+  const std::vector<double> weights(pts.size(), 0.0);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(cube.Fracture(pts, weights).size());
+}
+BENCHMARK(BM_Fracture)->RangeMultiplier(4)->Range(16, 1024)->Unit(
+    benchmark::kMillisecond);
+
+// A sphere with a row of holes drilled through it, which has many reflex edges.
+Manifold Drilled(int holes) {
+  Manifold result = Manifold::Sphere(1, 64);
+  const Manifold drill = Manifold::Cylinder(3, 0.05, -1, 12, true);
+  for (int i = 0; i < holes; ++i)
+    result -= drill.Translate({-0.8f + 1.6f * i / holes, 0, 0});
+  return Evaluated(result);
+}
+
+void BM_ConvexDecomposition(benchmark::State& state) {
+  const Manifold drilled = Drilled(state.range(0));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(drilled.ConvexDecomposition().size());
+}
+BENCHMARK(BM_ConvexDecomposition)->DenseRange(2, 8, 3)->Unit(
+    benchmark::kMillisecond);
+
+void BM_Minkowski(benchmark::State& state) {
+  const Manifold drilled = Drilled(state.range(0));
+  const Manifold tool = Evaluated(Manifold::Sphere(0.05, 16));
+  for (auto _ : state) Evaluate(Manifold::Minkowski(drilled, tool));
+}
+BENCHMARK(BM_Minkowski)->DenseRange(2, 8, 3)->Unit(benchmark::kMillisecond);
+
+void BM_Refine(benchmark::State& state) {
+  const Manifold sphere = Evaluated(Manifold::Sphere(1, 64));
+  for (auto _ : state) Evaluate(sphere.Refine(state.range(0)));
+}
+BENCHMARK(BM_Refine)->RangeMultiplier(2)->Range(2, 16)->Unit(
+    benchmark::kMillisecond);
+
+// ----------------------------------------------------------------------------
+//                                   meshIO
+// ----------------------------------------------------------------------------
+
+#ifdef MANIFOLD_EXPORT
+void BM_MeshIO(benchmark::State& state, const std::string& ext) {
+  const Manifold sphere = Evaluated(Manifold::Sphere(1, state.range(0)));
+  const std::string filename = "manifold_bench." + ext;
+  for (auto _ : state) {
+    ExportMesh(filename, sphere.GetMeshGL(), {});
+    benchmark::DoNotOptimize(ImportMeshGL(filename, true).NumTri());
+  }
+  std::remove(filename.c_str());
+  state.SetItemsProcessed(state.iterations() * sphere.NumTri());
+}
+BENCHMARK_CAPTURE(BM_MeshIO, stl, std::string("stl"))
+    ->RangeMultiplier(4)
+    ->Range(64, 1024)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_MeshIO, ply, std::string("ply"))
+    ->RangeMultiplier(4)
+    ->Range(64, 1024)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_MeshIO, glb, std::string("glb"))
+    ->RangeMultiplier(4)
+    ->Range(64, 1024)
+    ->Unit(benchmark::kMillisecond);
+#endif
+}  // namespace
+
+// Defaults to JSON on stdout, so that results can be compared across releases;
+// any --benchmark_format given on the command line takes precedence.
+int main(int argc, char** argv) {
+  std::vector<char*> args(argv, argv + argc);
+  std::string json = "--benchmark_format=json";
+  args.insert(args.begin() + 1, json.data());
+  int numArgs = args.size();
+  benchmark::Initialize(&numArgs, args.data());
+  if (benchmark::ReportUnrecognizedArguments(numArgs, args.data())) return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -20,7 +20,7 @@
 namespace manifold {
 
 /** @defgroup MeshIO
- *  @brief 3D model file I/O based on Assimp
+ *  @brief 3D model file I/O based on Assimp, with native binary STL and PLY
  * @{
  */
 
@@ -60,10 +60,19 @@ struct ExportOptions {
 
 Mesh ImportMesh(const std::string& filename, bool forceCleanup = false);
 
+MeshGL ImportMeshGL(const std::string& filename, bool forceCleanup = false);
+
 void ExportMesh(const std::string& filename, const Mesh& mesh,
                 const ExportOptions& options);
 
 void ExportMesh(const std::string& filename, const MeshGL& mesh,
                 const ExportOptions& options);
+
+void ExportManifold(const std::string& filename, const Manifold& manifold);
+
+Manifold ImportManifold(const std::string& filename);
+
+void StreamExportMesh(const std::string& filename, const Manifold& manifold,
+                      int chunkTri = 1 << 16);
 /** @} */
 }  // namespace manifold
\ No newline at end of file
@@ -15,13 +15,17 @@
 #include "meshIO.h"
 
 #include <algorithm>
+#include <cctype>
+#include <fstream>
 #include <iostream>
+#include <memory>
 
 #include "assimp/Exporter.hpp"
 #include "assimp/Importer.hpp"
 #include "assimp/material.h"
 #include "assimp/postprocess.h"
 #include "assimp/scene.h"
+#include "native_io.h"
 #include "optional_assert.h"
 
 #ifndef AI_MATKEY_ROUGHNESS_FACTOR
@@ -70,49 +74,32 @@ std::string GetType(const std::string& filename) {
   return ext;
 }
 
-void ExportScene(aiScene* scene, const std::string& filename) {
-  Assimp::Exporter exporter;
-
-  // int n = exporter.GetExportFormatCount();
-  // for (int i = 0; i < n; ++i) {
-  //   auto desc = exporter.GetExportFormatDescription(i);
-  //   std::cout << i << ", id = " << desc->id << ", " << desc->description
-  //             << std::endl;
-  // }
-  auto ext = filename.substr(filename.length() - 4, 4);
-  if (ext == ".3mf") {
-    // Workaround https://github.com/assimp/assimp/issues/3816
-    aiNode* old_root = scene->mRootNode;
-    scene->mRootNode = new aiNode();
-    scene->mRootNode->addChildren(1, &old_root);
-  }
-
-  auto result = exporter.Export(scene, GetType(filename), filename);
-
-  delete scene;
-
-  ASSERT(result == AI_SUCCESS, userErr, exporter.GetErrorString());
+std::string LowerExt(const std::string& filename) {
+  std::string ext = filename.substr(filename.find_last_of(".") + 1);
+  std::transform(ext.begin(), ext.end(), ext.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return ext;
 }
-}  // namespace
 
-namespace manifold {
+/**
+ * Tries the native binary readers, returning false if the file is of another
+ * type or variant, which should then go through Assimp.
+ */
+bool ImportNative(const std::string& filename, bool forceCleanup,
+                  MeshGL& mesh) {
+  const std::string ext = LowerExt(filename);
+  if (ext != "stl" && ext != "ply") return false;
+  const MappedFile file(filename);
+  if (ext == "stl") return ReadBinarySTL(file.data(), file.size(), mesh);
+  if (!ReadBinaryPLY(file.data(), file.size(), mesh)) return false;
+  if (forceCleanup) WeldVerts(mesh);
+  return true;
+}
 
 /**
- * Imports the given file as a Mesh structure, which can be converted to a
- * Manifold if the mesh is a proper oriented 2-manifold. Any supported polygon
- * format will be automatically triangulated.
- *
- * This is a very simple import function and is intended primarily as a
- * demonstration. Generally users of this library will need to modify this to
- * read all the important properties for their application and set up any custom
- * data structures.
- *
- * @param filename Supports any format the Assimp library supports.
- * @param forceCleanup This merges identical vertices, which can break
- * manifoldness. However it is always done for STLs, as they cannot possibly be
- * manifold without this step.
+ * Reads any format Assimp supports, triangulating polygons.
  */
-Mesh ImportMesh(const std::string& filename, bool forceCleanup) {
+Mesh ImportAssimp(const std::string& filename, bool forceCleanup) {
   std::string ext = filename.substr(filename.find_last_of(".") + 1);
   const bool isYup = ext == "glb" || ext == "gltf";
 
@@ -162,9 +149,89 @@ Mesh ImportMesh(const std::string& filename, bool forceCleanup) {
   return mesh_out;
 }
 
+void ExportScene(aiScene* scene, const std::string& filename) {
+  Assimp::Exporter exporter;
+
+  // int n = exporter.GetExportFormatCount();
+  // for (int i = 0; i < n; ++i) {
+  //   auto desc = exporter.GetExportFormatDescription(i);
+  //   std::cout << i << ", id = " << desc->id << ", " << desc->description
+  //             << std::endl;
+  // }
+  auto ext = filename.substr(filename.length() - 4, 4);
+  if (ext == ".3mf") {
+    // Workaround https://github.com/assimp/assimp/issues/3816
+    aiNode* old_root = scene->mRootNode;
+    scene->mRootNode = new aiNode();
+    scene->mRootNode->addChildren(1, &old_root);
+  }
+
+  auto result = exporter.Export(scene, GetType(filename), filename);
+
+  delete scene;
+
+  ASSERT(result == AI_SUCCESS, userErr, exporter.GetErrorString());
+}
+}  // namespace
+
+namespace manifold {
+
+/**
+ * Imports the given file as a Mesh structure, which can be converted to a
+ * Manifold if the mesh is a proper oriented 2-manifold. Any supported polygon
+ * format will be automatically triangulated.
+ *
+ * This is a very simple import function and is intended primarily as a
+ * demonstration. Generally users of this library will need to modify this to
+ * read all the important properties for their application and set up any custom
+ * data structures.
+ *
+ * @param filename Supports any format the Assimp library supports. Binary STL
+ * and binary PLY are read natively, see ImportMeshGL().
+ * @param forceCleanup This merges identical vertices, which can break
+ * manifoldness. However it is always done for STLs, as they cannot possibly be
+ * manifold without this step.
+ */
+Mesh ImportMesh(const std::string& filename, bool forceCleanup) {
+  MeshGL native;
+  if (ImportNative(filename, forceCleanup, native)) {
+    Mesh mesh_out;
+    mesh_out.vertPos.resize(native.NumVert());
+    for (int i = 0; i < native.NumVert(); ++i)
+      for (int j : {0, 1, 2})
+        mesh_out.vertPos[i][j] = native.vertProperties[3 * i + j];
+    mesh_out.triVerts.resize(native.NumTri());
+    for (int i = 0; i < native.NumTri(); ++i)
+      for (int j : {0, 1, 2})
+        mesh_out.triVerts[i][j] = native.triVerts[3 * i + j];
+    return mesh_out;
+  }
+  return ImportAssimp(filename, forceCleanup);
+}
+
+/**
+ * Imports the given file directly as a MeshGL. Binary STL and binary PLY are
+ * parsed straight into its buffers without involving Assimp, with the STL's
+ * identical vertices welded in parallel; only positions and triangles are
+ * read. Other formats and variants go through Assimp, as in ImportMesh().
+ *
+ * @param filename Supports any format the Assimp library supports.
+ * @param forceCleanup This merges identical vertices, which can break
+ * manifoldness. However it is always done for STLs, as they cannot possibly be
+ * manifold without this step.
+ */
+MeshGL ImportMeshGL(const std::string& filename, bool forceCleanup) {
+  MeshGL mesh;
+  if (ImportNative(filename, forceCleanup, mesh)) return mesh;
+  // not ImportMesh, which would try the native readers again
+  return ImportAssimp(filename, forceCleanup);
+}
+
 /**
  * Saves the Mesh to the desired file type, determined from the extension
- * specified. In the case of .glb/.gltf, this will save in version 2.0.
+ * specified. In the case of .glb/.gltf, this will save in version 2.0. STL and
+ * PLY are written natively in their binary variants, and PLY keeps the normal
+ * and color channels.
  *
  * This is a very simple export function and is intended primarily as a
  * demonstration. Generally users of this library will need to modify this to
@@ -188,11 +255,6 @@ void ExportMesh(const std::string& filename, const MeshGL& mesh,
   std::string type = GetType(filename);
   const bool isYup = type == "glb2" || type == "gltf2";
 
-  aiScene* scene = CreateScene(options);
-  aiMesh* mesh_out = scene->mMeshes[0];
-
-  mesh_out->mNumVertices = mesh.NumVert();
-  mesh_out->mVertices = new aiVector3D[mesh_out->mNumVertices];
   if (!options.faceted) {
     bool validChannels = true;
     for (int i : {0, 1, 2}) {
@@ -201,7 +263,6 @@ void ExportMesh(const std::string& filename, const MeshGL& mesh,
     }
     ASSERT(validChannels, userErr,
            "When faceted is false, valid normalChannels must be supplied.");
-    mesh_out->mNormals = new aiVector3D[mesh_out->mNumVertices];
   }
 
   bool validChannels = true;
@@ -212,6 +273,24 @@ void ExportMesh(const std::string& filename, const MeshGL& mesh,
     hasColor |= c >= 0;
   }
   ASSERT(validChannels, userErr, "Invalid colorChannels.");
+
+  const std::string ext = LowerExt(filename);
+  if (ext == "stl") {
+    WriteBinarySTL(filename, mesh);
+    return;
+  }
+  if (ext == "ply") {
+    WriteBinaryPLY(filename, mesh, options);
+    return;
+  }
+
+  aiScene* scene = CreateScene(options);
+  aiMesh* mesh_out = scene->mMeshes[0];
+
+  mesh_out->mNumVertices = mesh.NumVert();
+  mesh_out->mVertices = new aiVector3D[mesh_out->mNumVertices];
+  if (!options.faceted)
+    mesh_out->mNormals = new aiVector3D[mesh_out->mNumVertices];
   if (hasColor) mesh_out->mColors[0] = new aiColor4D[mesh_out->mNumVertices];
 
   for (int i = 0; i < mesh_out->mNumVertices; ++i) {
@@ -263,7 +342,8 @@ void ExportMesh(const std::string& filename, const MeshGL& mesh,
  *
  * @param filename The file extension must be one that Assimp supports for
  * export. GLB & 3MF are recommended.
- * @param mesh The mesh to export, likely from Manifold.GetMesh().
+ * @param mesh The mesh to export, likely from Manifold.GetMesh(). STL and
+ * PLY go through the MeshGL export.
  * @param options The options currently only affect an exported GLB's material.
  * Pass {} for defaults.
  */
@@ -278,23 +358,52 @@ void ExportMesh(const std::string& filename, const Mesh& mesh,
   std::string type = GetType(filename);
   const bool isYup = type == "glb2" || type == "gltf2";
 
-  aiScene* scene = CreateScene(options);
-  aiMesh* mesh_out = scene->mMeshes[0];
-
-  mesh_out->mNumVertices = mesh.vertPos.size();
-  mesh_out->mVertices = new aiVector3D[mesh_out->mNumVertices];
   if (!options.faceted) {
     ASSERT(
         mesh.vertNormal.size() == mesh.vertPos.size(), userErr,
         "vertNormal must be the same length as vertPos when faceted is false.");
-    mesh_out->mNormals = new aiVector3D[mesh_out->mNumVertices];
   }
-  if (!options.mat.vertColor.empty()) {
+  const bool hasColor = !options.mat.vertColor.empty();
+  if (hasColor) {
     ASSERT(mesh.vertPos.size() == options.mat.vertColor.size(), userErr,
            "If present, vertColor must be the same length as vertPos.");
-    mesh_out->mColors[0] = new aiColor4D[mesh_out->mNumVertices];
   }
 
+  const std::string ext = LowerExt(filename);
+  if (ext == "stl" || ext == "ply") {
+    ExportOptions optionsGL = options;
+    MeshGL meshGL;
+    meshGL.numProp = 3 + (options.faceted ? 0 : 3) + (hasColor ? 4 : 0);
+    if (!options.faceted) optionsGL.mat.normalChannels = {3, 4, 5};
+    const int color = options.faceted ? 3 : 6;
+    if (hasColor)
+      optionsGL.mat.colorChannels = {color, color + 1, color + 2, color + 3};
+    meshGL.vertProperties.resize(meshGL.numProp * mesh.vertPos.size());
+    for (int i = 0; i < mesh.vertPos.size(); ++i) {
+      float* props = meshGL.vertProperties.data() + i * meshGL.numProp;
+      for (int j : {0, 1, 2}) props[j] = mesh.vertPos[i][j];
+      if (!options.faceted)
+        for (int j : {0, 1, 2}) props[3 + j] = mesh.vertNormal[i][j];
+      if (hasColor)
+        for (int j : {0, 1, 2, 3})
+          props[color + j] = options.mat.vertColor[i][j];
+    }
+    meshGL.triVerts.resize(3 * mesh.triVerts.size());
+    for (int i = 0; i < mesh.triVerts.size(); ++i)
+      for (int j : {0, 1, 2}) meshGL.triVerts[3 * i + j] = mesh.triVerts[i][j];
+    ExportMesh(filename, meshGL, optionsGL);
+    return;
+  }
+
+  aiScene* scene = CreateScene(options);
+  aiMesh* mesh_out = scene->mMeshes[0];
+
+  mesh_out->mNumVertices = mesh.vertPos.size();
+  mesh_out->mVertices = new aiVector3D[mesh_out->mNumVertices];
+  if (!options.faceted)
+    mesh_out->mNormals = new aiVector3D[mesh_out->mNumVertices];
+  if (hasColor) mesh_out->mColors[0] = new aiColor4D[mesh_out->mNumVertices];
+
   for (int i = 0; i < mesh_out->mNumVertices; ++i) {
     const glm::vec3& v = mesh.vertPos[i];
     mesh_out->mVertices[i] =
@@ -304,7 +413,7 @@ void ExportMesh(const std::string& filename, const Mesh& mesh,
       mesh_out->mNormals[i] =
           isYup ? aiVector3D(n.y, n.z, n.x) : aiVector3D(n.x, n.y, n.z);
     }
-    if (!options.mat.vertColor.empty()) {
+    if (hasColor) {
       const glm::vec4& c = options.mat.vertColor[i];
       mesh_out->mColors[0][i] = aiColor4D(c.r, c.g, c.b, c.a);
     }
@@ -323,4 +432,50 @@ void ExportMesh(const std::string& filename, const Mesh& mesh,
   ExportScene(scene, filename);
 }
 
+/**
+ * Saves the Manifold's internal representation with Manifold::Serialize(), for
+ * fast reloading by ImportManifold().
+ */
+void ExportManifold(const std::string& filename, const Manifold& manifold) {
+  const std::vector<char> buffer = manifold.Serialize();
+  std::ofstream file(filename, std::ios::binary);
+  file.write(buffer.data(), buffer.size());
+  ASSERT(file.good(), userErr, "Could not write " + filename);
+}
+
+/**
+ * Loads a file written by ExportManifold(), parsing it straight from a memory
+ * mapping without rebuilding anything. An unreadable or mismatched file gives
+ * an empty Manifold with status InvalidConstruction.
+ */
+Manifold ImportManifold(const std::string& filename) {
+  const MappedFile file(filename);
+  return Manifold::Deserialize(file.data(), file.size());
+}
+
+/**
+ * Saves the Manifold's positions and triangles without building a MeshGL or
+ * any intermediate scene: binary STL and PLY are written chunk by chunk
+ * straight from its internal data through Manifold::StreamMesh(), so the extra
+ * memory does not grow with the mesh. Other formats go through
+ * ExportMesh(filename, manifold.GetMeshGL(), {}).
+ *
+ * @param filename The extension determines the format, as in ExportMesh().
+ * @param manifold The manifold to export.
+ * @param chunkTri The number of triangles converted and written at a time.
+ */
+void StreamExportMesh(const std::string& filename, const Manifold& manifold,
+                      int chunkTri) {
+  if (manifold.IsEmpty()) {
+    std::cout << filename << " was not saved because the input mesh was empty."
+              << std::endl;
+    return;
+  }
+  std::unique_ptr<MeshSink> sink = BinaryFileSink(filename, LowerExt(filename));
+  if (sink == nullptr) {
+    ExportMesh(filename, manifold.GetMeshGL(), {});
+    return;
+  }
+  manifold.StreamMesh(*sink, chunkTri);
+}
 }  // namespace manifold
@@ -0,0 +1,706 @@
+// Copyright 2024 The Manifold Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "native_io.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+#include "optional_assert.h"
+#include "par.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MANIFOLD_MMAP
+#endif
+
+namespace {
+using namespace manifold;
+
+bool HostIsLittleEndian() {
+  const uint16_t one = 1;
+  char byte;
+  std::memcpy(&byte, &one, 1);
+  return byte == 1;
+}
+
+template <typename T>
+T Load(const char* ptr, bool swap) {
+  char bytes[sizeof(T)];
+  std::memcpy(bytes, ptr, sizeof(T));
+  if (swap) std::reverse(bytes, bytes + sizeof(T));
+  T value;
+  std::memcpy(&value, bytes, sizeof(T));
+  return value;
+}
+
+template <typename T>
+void Store(char* ptr, T value, bool swap) {
+  std::memcpy(ptr, &value, sizeof(T));
+  if (swap) std::reverse(ptr, ptr + sizeof(T));
+}
+
+void WriteFile(const std::string& filename, const std::vector<char>& buffer) {
+  std::ofstream file(filename, std::ios::binary);
+  ASSERT(file.good(), userErr, "Could not open " + filename);
+  file.write(buffer.data(), buffer.size());
+  ASSERT(file.good(), userErr, "Could not write " + filename);
+}
+
+glm::vec3 VertPos(const MeshGL& mesh, int vert) {
+  const float* props = mesh.vertProperties.data() + vert * mesh.numProp;
+  return glm::vec3(props[0], props[1], props[2]);
+}
+
+constexpr int kFacetBytes = 50;
+constexpr int kFaceBytes = 13;
+
+void StoreSTLHeader(char* header, uint32_t numTri, bool swap) {
+  const char kHeader[] = "binary STL written by Manifold";
+  std::fill(header, header + 80, 0);
+  std::copy(kHeader, kHeader + sizeof(kHeader) - 1, header);
+  Store(header + 80, numTri, swap);
+}
+
+void StoreFacet(char* facet, const glm::vec3 (&v)[3], bool swap) {
+  glm::vec3 normal = glm::cross(v[1] - v[0], v[2] - v[0]);
+  const float length = glm::length(normal);
+  normal = length > 0 ? normal / length : glm::vec3(0);
+  for (const int j : {0, 1, 2}) Store(facet + 4 * j, normal[j], swap);
+  for (const int i : {0, 1, 2})
+    for (const int j : {0, 1, 2})
+      Store(facet + 12 * (i + 1) + 4 * j, v[i][j], swap);
+  // attribute byte count
+  facet[48] = 0;
+  facet[49] = 0;
+}
+
+std::string PLYHeader(int numVert, int numTri, bool hasNormal, bool hasColor) {
+  std::ostringstream header;
+  header << "ply\nformat binary_little_endian 1.0\n"
+         << "comment written by Manifold\n"
+         << "element vertex " << numVert << "\n"
+         << "property float x\nproperty float y\nproperty float z\n";
+  if (hasNormal)
+    header << "property float nx\nproperty float ny\nproperty float nz\n";
+  if (hasColor)
+    header << "property uchar red\nproperty uchar green\n"
+           << "property uchar blue\nproperty uchar alpha\n";
+  header << "element face " << numTri << "\n"
+         << "property list uchar uint vertex_indices\nend_header\n";
+  return header.str();
+}
+
+void StoreFace(char* item, glm::ivec3 tri, bool swap) {
+  item[0] = 3;
+  for (const int j : {0, 1, 2})
+    Store<uint32_t>(item + 1 + 4 * j, tri[j], swap);
+}
+
+/**
+ * Streams binary STL, writing each chunk of facets as it arrives.
+ */
+class STLSink : public MeshSink {
+ public:
+  explicit STLSink(const std::string& filename)
+      : filename_(filename), file_(filename, std::ios::binary) {
+    ASSERT(file_.good(), userErr, "Could not open " + filename);
+  }
+
+  void Begin(VecView<const glm::vec3> vertPos, int numTri) override {
+    vertPos_ = vertPos;
+    char header[84];
+    StoreSTLHeader(header, numTri, swap_);
+    file_.write(header, sizeof(header));
+  }
+
+  void Tris(int firstTri, VecView<const glm::ivec3> triVerts,
+            int originalID) override {
+    const int numTri = triVerts.size();
+    buffer_.resize(static_cast<size_t>(numTri) * kFacetBytes);
+    for_each_n(autoPolicy(numTri), countAt(0), numTri, [&](int tri) {
+      const glm::vec3 v[3] = {vertPos_[triVerts[tri][0]],
+                              vertPos_[triVerts[tri][1]],
+                              vertPos_[triVerts[tri][2]]};
+      StoreFacet(buffer_.data() + static_cast<size_t>(tri) * kFacetBytes, v,
+                 swap_);
+    });
+    file_.write(buffer_.data(), buffer_.size());
+  }
+
+  void End() override {
+    file_.close();
+    ASSERT(!file_.fail(), userErr, "Could not write " + filename_);
+  }
+
+ private:
+  const bool swap_ = !HostIsLittleEndian();
+  const std::string filename_;
+  std::ofstream file_;
+  VecView<const glm::vec3> vertPos_ = {nullptr, 0};
+  std::vector<char> buffer_;
+};
+
+/**
+ * Streams binary PLY. Its vertices must precede its faces, so they are
+ * written in chunks from Begin(); faces follow as they arrive.
+ */
+class PLYSink : public MeshSink {
+ public:
+  explicit PLYSink(const std::string& filename)
+      : filename_(filename), file_(filename, std::ios::binary) {
+    ASSERT(file_.good(), userErr, "Could not open " + filename);
+  }
+
+  void Begin(VecView<const glm::vec3> vertPos, int numTri) override {
+    const int numVert = vertPos.size();
+    const std::string header = PLYHeader(numVert, numTri, false, false);
+    file_.write(header.data(), header.size());
+
+    constexpr int kChunk = 1 << 16;
+    for (int first = 0; first < numVert; first += kChunk) {
+      const int n = std::min(kChunk, numVert - first);
+      buffer_.resize(12 * static_cast<size_t>(n));
+      for_each_n(autoPolicy(n), countAt(0), n, [&](int i) {
+        for (const int j : {0, 1, 2})
+          Store(buffer_.data() + 12 * i + 4 * j, vertPos[first + i][j], swap_);
+      });
+      file_.write(buffer_.data(), buffer_.size());
+    }
+  }
+
+  void Tris(int firstTri, VecView<const glm::ivec3> triVerts,
+            int originalID) override {
+    const int numTri = triVerts.size();
+    buffer_.resize(static_cast<size_t>(numTri) * kFaceBytes);
+    for_each_n(autoPolicy(numTri), countAt(0), numTri, [&](int tri) {
+      StoreFace(buffer_.data() + static_cast<size_t>(tri) * kFaceBytes,
+                triVerts[tri], swap_);
+    });
+    file_.write(buffer_.data(), buffer_.size());
+  }
+
+  void End() override {
+    file_.close();
+    ASSERT(!file_.fail(), userErr, "Could not write " + filename_);
+  }
+
+ private:
+  const bool swap_ = !HostIsLittleEndian();
+  const std::string filename_;
+  std::ofstream file_;
+  std::vector<char> buffer_;
+};
+
+enum class PlyType {
+  Int8,
+  UInt8,
+  Int16,
+  UInt16,
+  Int32,
+  UInt32,
+  Float32,
+  Float64,
+  Invalid
+};
+
+PlyType ParsePlyType(const std::string& name) {
+  if (name == "char" || name == "int8") return PlyType::Int8;
+  if (name == "uchar" || name == "uint8") return PlyType::UInt8;
+  if (name == "short" || name == "int16") return PlyType::Int16;
+  if (name == "ushort" || name == "uint16") return PlyType::UInt16;
+  if (name == "int" || name == "int32") return PlyType::Int32;
+  if (name == "uint" || name == "uint32") return PlyType::UInt32;
+  if (name == "float" || name == "float32") return PlyType::Float32;
+  if (name == "double" || name == "float64") return PlyType::Float64;
+  return PlyType::Invalid;
+}
+
+int PlySize(PlyType type) {
+  switch (type) {
+    case PlyType::Int8:
+    case PlyType::UInt8:
+      return 1;
+    case PlyType::Int16:
+    case PlyType::UInt16:
+      return 2;
+    case PlyType::Int32:
+    case PlyType::UInt32:
+    case PlyType::Float32:
+      return 4;
+    case PlyType::Float64:
+      return 8;
+    default:
+      return 0;
+  }
+}
+
+double LoadPly(const char* ptr, PlyType type, bool swap) {
+  switch (type) {
+    case PlyType::Int8:
+      return Load<int8_t>(ptr, swap);
+    case PlyType::UInt8:
+      return Load<uint8_t>(ptr, swap);
+    case PlyType::Int16:
+      return Load<int16_t>(ptr, swap);
+    case PlyType::UInt16:
+      return Load<uint16_t>(ptr, swap);
+    case PlyType::Int32:
+      return Load<int32_t>(ptr, swap);
+    case PlyType::UInt32:
+      return Load<uint32_t>(ptr, swap);
+    case PlyType::Float32:
+      return Load<float>(ptr, swap);
+    case PlyType::Float64:
+      return Load<double>(ptr, swap);
+    default:
+      return 0;
+  }
+}
+
+struct PlyProperty {
+  std::string name;
+  PlyType type = PlyType::Invalid;
+  // only valid for list properties
+  PlyType countType = PlyType::Invalid;
+
+  bool IsList() const { return countType != PlyType::Invalid; }
+};
+
+struct PlyElement {
+  std::string name;
+  size_t count = 0;
+  std::vector<PlyProperty> properties;
+
+  // Bytes per item, or -1 if the items vary in length because of lists.
+  int Stride() const {
+    int stride = 0;
+    for (const PlyProperty& property : properties) {
+      if (property.IsList()) return -1;
+      stride += PlySize(property.type);
+    }
+    return stride;
+  }
+};
+
+/**
+ * Advances ptr past one item of the element, returning nullptr if the item
+ * runs past end.
+ */
+const char* SkipPlyItem(const PlyElement& element, const char* ptr,
+                        const char* end, bool swap) {
+  for (const PlyProperty& property : element.properties) {
+    if (property.IsList()) {
+      const int countSize = PlySize(property.countType);
+      if (end - ptr < countSize) return nullptr;
+      const double count = LoadPly(ptr, property.countType, swap);
+      ptr += countSize;
+      if (count < 0 || end - ptr < count * PlySize(property.type))
+        return nullptr;
+      ptr += static_cast<size_t>(count) * PlySize(property.type);
+    } else {
+      if (end - ptr < PlySize(property.type)) return nullptr;
+      ptr += PlySize(property.type);
+    }
+  }
+  return ptr;
+}
+
+const char* ReadPlyVerts(const PlyElement& element, const char* ptr,
+                         const char* end, bool swap, MeshGL& mesh) {
+  const int stride = element.Stride();
+  if (stride <= 0 || (size_t)(end - ptr) / stride < element.count)
+    return nullptr;
+
+  int offset[3] = {-1, -1, -1};
+  PlyType type[3];
+  int byte = 0;
+  for (const PlyProperty& property : element.properties) {
+    for (const int i : {0, 1, 2}) {
+      if (property.name == std::string(1, 'x' + i)) {
+        offset[i] = byte;
+        type[i] = property.type;
+      }
+    }
+    byte += PlySize(property.type);
+  }
+  if (offset[0] < 0 || offset[1] < 0 || offset[2] < 0) return nullptr;
+
+  const int numVert = element.count;
+  mesh.numProp = 3;
+  mesh.vertProperties.resize(3 * element.count);
+  for_each_n(autoPolicy(numVert), countAt(0), numVert, [&](int vert) {
+    const char* item = ptr + static_cast<size_t>(vert) * stride;
+    for (const int i : {0, 1, 2})
+      mesh.vertProperties[3 * vert + i] =
+          LoadPly(item + offset[i], type[i], swap);
+  });
+  return ptr + element.count * stride;
+}
+
+/**
+ * Faces are variable-length, so they are read serially; this is bound by
+ * memory bandwidth rather than parsing anyway. Only triangles are accepted,
+ * so that polygonal faces go to Assimp for proper triangulation.
+ */
+const char* ReadPlyFaces(const PlyElement& element, const char* ptr,
+                         const char* end, bool swap, MeshGL& mesh) {
+  int indices = -1;
+  for (int i = 0; i < element.properties.size(); ++i) {
+    const PlyProperty& property = element.properties[i];
+    if (property.IsList() &&
+        (property.name == "vertex_indices" || property.name == "vertex_index"))
+      indices = i;
+  }
+  if (indices < 0) return nullptr;
+
+  // the fewest bytes a triangle can take, to check the count in the header
+  // against the size of the file before allocating for it
+  size_t minBytes = 0;
+  for (int i = 0; i < element.properties.size(); ++i) {
+    const PlyProperty& property = element.properties[i];
+    if (!property.IsList()) {
+      minBytes += PlySize(property.type);
+      continue;
+    }
+    minBytes += PlySize(property.countType);
+    if (i == indices) minBytes += 3 * PlySize(property.type);
+  }
+  if ((size_t)(end - ptr) / minBytes < element.count) return nullptr;
+
+  const size_t numVert = mesh.NumVert();
+  mesh.triVerts.resize(3 * element.count);
+  for (size_t tri = 0; tri < element.count; ++tri) {
+    for (int i = 0; i < element.properties.size(); ++i) {
+      const PlyProperty& property = element.properties[i];
+      const int size = PlySize(property.type);
+      if (!property.IsList()) {
+        if (end - ptr < size) return nullptr;
+        ptr += size;
+        continue;
+      }
+      const int countSize = PlySize(property.countType);
+      if (end - ptr < countSize) return nullptr;
+      const double count = LoadPly(ptr, property.countType, swap);
+      ptr += countSize;
+      if (i == indices && count != 3) return nullptr;
+      if (count < 0 || end - ptr < count * size) return nullptr;
+      if (i == indices) {
+        for (const int j : {0, 1, 2}) {
+          const double vert = LoadPly(ptr + j * size, property.type, swap);
+          if (vert < 0 || vert >= numVert) return nullptr;
+          mesh.triVerts[3 * tri + j] = vert;
+        }
+      }
+      ptr += static_cast<size_t>(count) * size;
+    }
+  }
+  return ptr;
+}
+}  // namespace
+
+namespace manifold {
+
+MappedFile::MappedFile(const std::string& filename) {
+#if defined(_WIN32)
+  HANDLE handle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN,
+                              nullptr);
+  LARGE_INTEGER length;
+  if (handle != INVALID_HANDLE_VALUE && GetFileSizeEx(handle, &length) &&
+      length.QuadPart > 0) {
+    HANDLE mapping =
+        CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void* view = mapping == nullptr
+                           ? nullptr
+                           : MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view != nullptr) {
+      data_ = static_cast<const char*>(view);
+      size_ = length.QuadPart;
+      mapped_ = true;
+      file_ = handle;
+      mapping_ = mapping;
+      return;
+    }
+    if (mapping != nullptr) CloseHandle(mapping);
+  }
+  if (handle != INVALID_HANDLE_VALUE) CloseHandle(handle);
+#elif defined(MANIFOLD_MMAP)
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) return;
+  struct stat info;
+  if (fstat(fd, &info) == 0 && info.st_size > 0) {
+    void* view = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (view != MAP_FAILED) {
+      // the readers touch every page, mostly from several threads at once
+      madvise(view, info.st_size, MADV_WILLNEED);
+      data_ = static_cast<const char*>(view);
+      size_ = info.st_size;
+      mapped_ = true;
+    }
+  }
+  // the mapping keeps the file open
+  close(fd);
+  if (mapped_) return;
+#endif
+
+  std::ifstream file(filename, std::ios::binary | std::ios::ate);
+  if (!file.good()) return;
+  const std::streamsize size = file.tellg();
+  if (size <= 0) return;
+  buffer_.resize(size);
+  file.seekg(0);
+  if (!file.read(buffer_.data(), size)) {
+    buffer_.clear();
+    return;
+  }
+  data_ = buffer_.data();
+  size_ = buffer_.size();
+}
+
+MappedFile::~MappedFile() {
+  if (!mapped_) return;
+#if defined(_WIN32)
+  UnmapViewOfFile(data_);
+  CloseHandle(mapping_);
+  CloseHandle(file_);
+#elif defined(MANIFOLD_MMAP)
+  munmap(const_cast<char*>(data_), size_);
+#endif
+}
+
+/**
+ * Binary STL is recognized by its size matching the triangle count in its
+ * header, since many binary files also begin with "solid". Vertices are
+ * welded, as an STL cannot be manifold otherwise.
+ */
+bool ReadBinarySTL(const char* data, size_t size, MeshGL& mesh) {
+  if (size < 84) return false;
+  const bool swap = !HostIsLittleEndian();
+  const uint32_t numTri = Load<uint32_t>(data + 80, swap);
+  if (size != 84 + 50 * static_cast<size_t>(numTri)) return false;
+
+  mesh.numProp = 3;
+  mesh.vertProperties.resize(9 * static_cast<size_t>(numTri));
+  mesh.triVerts.resize(3 * static_cast<size_t>(numTri));
+  for_each_n(autoPolicy(numTri), countAt(0), numTri, [&](int tri) {
+    // skip the facet normal; it is recomputed from the vertices
+    const char* facet = data + 84 + 50 * static_cast<size_t>(tri) + 12;
+    for (int i = 0; i < 9; ++i)
+      mesh.vertProperties[9 * tri + i] = Load<float>(facet + 4 * i, swap);
+    for (const int i : {0, 1, 2}) mesh.triVerts[3 * tri + i] = 3 * tri + i;
+  });
+  WeldVerts(mesh);
+  return true;
+}
+
+/**
+ * Reads the positions and triangles of a binary PLY of either endianness;
+ * other vertex properties and elements are skipped.
+ */
+bool ReadBinaryPLY(const char* data, size_t size, MeshGL& mesh) {
+  const char* end = data + size;
+  if (size < 4 || std::strncmp(data, "ply", 3) != 0) return false;
+  const char kEndHeader[] = "end_header";
+  const char* headerEnd =
+      std::search(data, end, kEndHeader, kEndHeader + sizeof(kEndHeader) - 1);
+  const char* ptr = std::find(headerEnd, end, '\n');
+  if (ptr == end) return false;
+  ++ptr;
+
+  std::istringstream header(std::string(data, headerEnd));
+  std::string line;
+  std::string format;
+  std::vector<PlyElement> elements;
+  while (std::getline(header, line)) {
+    std::istringstream words(line);
+    std::string keyword;
+    words >> keyword;
+    if (keyword == "format") {
+      words >> format;
+    } else if (keyword == "element") {
+      elements.push_back({});
+      words >> elements.back().name >> elements.back().count;
+    } else if (keyword == "property") {
+      if (elements.empty()) return false;
+      PlyProperty property;
+      std::string type;
+      words >> type;
+      if (type == "list") {
+        std::string countType;
+        words >> countType >> type;
+        property.countType = ParsePlyType(countType);
+        if (property.countType == PlyType::Invalid) return false;
+      }
+      property.type = ParsePlyType(type);
+      if (property.type == PlyType::Invalid) return false;
+      words >> property.name;
+      elements.back().properties.push_back(property);
+    }
+  }
+  if (format != "binary_little_endian" && format != "binary_big_endian")
+    return false;
+  const bool swap = (format == "binary_little_endian") != HostIsLittleEndian();
+
+  bool hasFaces = false;
+  for (const PlyElement& element : elements) {
+    if (element.name == "vertex") {
+      ptr = ReadPlyVerts(element, ptr, end, swap, mesh);
+    } else if (element.name == "face") {
+      ptr = ReadPlyFaces(element, ptr, end, swap, mesh);
+      hasFaces = true;
+    } else {
+      for (size_t i = 0; i < element.count && ptr != nullptr; ++i)
+        ptr = SkipPlyItem(element, ptr, end, swap);
+    }
+    if (ptr == nullptr) return false;
+  }
+  return hasFaces;
+}
+
+/**
+ * Merges vertices with identical positions by sorting them, keeping the
+ * properties of the first of each group.
+ */
+void WeldVerts(MeshGL& mesh) {
+  const int numVert = mesh.NumVert();
+  if (numVert == 0) return;
+  const ExecutionPolicy policy = autoPolicy(numVert);
+
+  std::vector<int> order(numVert);
+  sequence(policy, order.data(), order.data() + numVert);
+  stable_sort(policy, order.begin(), order.end(), [&mesh](int a, int b) {
+    const glm::vec3 posA = VertPos(mesh, a);
+    const glm::vec3 posB = VertPos(mesh, b);
+    if (posA.x != posB.x) return posA.x < posB.x;
+    if (posA.y != posB.y) return posA.y < posB.y;
+    return posA.z < posB.z;
+  });
+
+  std::vector<int> newVert(numVert);
+  for_each_n(policy, countAt(0), numVert, [&](int i) {
+    newVert[i] =
+        i == 0 || VertPos(mesh, order[i]) != VertPos(mesh, order[i - 1]);
+  });
+  inclusive_scan(policy, newVert.begin(), newVert.end(), newVert.begin());
+
+  const int numProp = mesh.numProp;
+  std::vector<int> oldToNew(numVert);
+  std::vector<float> welded(numProp * newVert.back());
+  for_each_n(policy, countAt(0), numVert, [&](int i) {
+    const int vert = newVert[i] - 1;
+    oldToNew[order[i]] = vert;
+    if (i > 0 && newVert[i] == newVert[i - 1]) return;
+    std::copy_n(mesh.vertProperties.begin() + order[i] * numProp, numProp,
+                welded.begin() + vert * numProp);
+  });
+  for_each_n(policy, countAt(0), static_cast<int>(mesh.triVerts.size()),
+             [&](int i) { mesh.triVerts[i] = oldToNew[mesh.triVerts[i]]; });
+  mesh.vertProperties.swap(welded);
+}
+
+void WriteBinarySTL(const std::string& filename, const MeshGL& mesh) {
+  const bool swap = !HostIsLittleEndian();
+  const int numTri = mesh.NumTri();
+  std::vector<char> buffer(84 + kFacetBytes * static_cast<size_t>(numTri));
+  StoreSTLHeader(buffer.data(), numTri, swap);
+
+  for_each_n(autoPolicy(numTri), countAt(0), numTri, [&](int tri) {
+    glm::vec3 v[3];
+    for (const int i : {0, 1, 2})
+      v[i] = VertPos(mesh, mesh.triVerts[3 * tri + i]);
+    StoreFacet(buffer.data() + 84 + kFacetBytes * static_cast<size_t>(tri), v,
+               swap);
+  });
+  WriteFile(filename, buffer);
+}
+
+/**
+ * Writes a little-endian binary PLY of the positions, plus the normals when
+ * options.faceted is false and the colors when options.mat.colorChannels
+ * selects any; the channels are assumed to have been validated.
+ */
+void WriteBinaryPLY(const std::string& filename, const MeshGL& mesh,
+                    const ExportOptions& options) {
+  const bool swap = !HostIsLittleEndian();
+  const int numVert = mesh.NumVert();
+  const int numTri = mesh.NumTri();
+  const glm::ivec3 normalChannels = options.mat.normalChannels;
+  const glm::ivec4 colorChannels = options.mat.colorChannels;
+  const bool hasNormal = !options.faceted;
+  const bool hasColor =
+      glm::any(glm::greaterThanEqual(colorChannels, glm::ivec4(0)));
+
+  const std::string headerStr =
+      PLYHeader(numVert, numTri, hasNormal, hasColor);
+
+  const int vertBytes = 12 + (hasNormal ? 12 : 0) + (hasColor ? 4 : 0);
+  const size_t faceStart =
+      headerStr.size() + static_cast<size_t>(numVert) * vertBytes;
+  std::vector<char> buffer(faceStart +
+                           static_cast<size_t>(numTri) * kFaceBytes);
+  std::copy(headerStr.begin(), headerStr.end(), buffer.begin());
+
+  for_each_n(autoPolicy(numVert), countAt(0), numVert, [&](int vert) {
+    const float* props = mesh.vertProperties.data() + vert * mesh.numProp;
+    char* item = buffer.data() + headerStr.size() +
+                 static_cast<size_t>(vert) * vertBytes;
+    for (const int j : {0, 1, 2}) Store(item + 4 * j, props[j], swap);
+    item += 12;
+    if (hasNormal) {
+      for (const int j : {0, 1, 2})
+        Store(item + 4 * j, props[normalChannels[j]], swap);
+      item += 12;
+    }
+    if (hasColor) {
+      for (const int j : {0, 1, 2, 3}) {
+        const float c = colorChannels[j] < 0 ? 1 : props[colorChannels[j]];
+        item[j] = static_cast<uint8_t>(std::round(255 * glm::saturate(c)));
+      }
+    }
+  });
+  for_each_n(autoPolicy(numTri), countAt(0), numTri, [&](int tri) {
+    const glm::ivec3 triVerts(mesh.triVerts[3 * tri],
+                              mesh.triVerts[3 * tri + 1],
+                              mesh.triVerts[3 * tri + 2]);
+    StoreFace(buffer.data() + faceStart + static_cast<size_t>(tri) * kFaceBytes,
+              triVerts, swap);
+  });
+  WriteFile(filename, buffer);
+}
+
+/**
+ * Returns a sink that streams the binary STL or PLY named by filename's
+ * extension, or nullptr for other extensions.
+ */
+std::unique_ptr<MeshSink> BinaryFileSink(const std::string& filename,
+                                         const std::string& ext) {
+  if (ext == "stl") return std::make_unique<STLSink>(filename);
+  if (ext == "ply") return std::make_unique<PLYSink>(filename);
+  return nullptr;
+}
+}  // namespace manifold
@@ -0,0 +1,72 @@
+// Copyright 2024 The Manifold Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "meshIO.h"
+
+namespace manifold {
+
+/** @addtogroup Private
+ *  @{
+ */
+
+/**
+ * A read-only view of a whole file, memory-mapped where the platform allows so
+ * that parsing reads straight from the page cache instead of from a copy. On
+ * other platforms, or if mapping fails, the file is read into memory instead.
+ * An unreadable file is empty. Readers copy what they need out of it during
+ * the import; no mesh keeps a view of the mapping.
+ */
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& filename);
+  ~MappedFile();
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  bool mapped_ = false;
+  std::vector<char> buffer_;
+#ifdef _WIN32
+  void* file_ = nullptr;
+  void* mapping_ = nullptr;
+#endif
+};
+
+/**
+ * Dependency-free readers and writers for the binary mesh formats, which
+ * parse straight into MeshGL buffers without an intermediate scene. The
+ * readers return false for variants they don't handle (e.g. ASCII files or
+ * polygonal faces), so the caller can fall back to Assimp.
+ */
+bool ReadBinarySTL(const char* data, size_t size, MeshGL& mesh);
+bool ReadBinaryPLY(const char* data, size_t size, MeshGL& mesh);
+void WeldVerts(MeshGL& mesh);
+
+void WriteBinarySTL(const std::string& filename, const MeshGL& mesh);
+void WriteBinaryPLY(const std::string& filename, const MeshGL& mesh,
+                    const ExportOptions& options);
+std::unique_ptr<MeshSink> BinaryFileSink(const std::string& filename,
+                                         const std::string& ext);
+/** @} */
+}  // namespace manifold
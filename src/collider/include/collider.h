@@ -13,7 +13,11 @@
 // limitations under the License.
 
 #pragma once
+#include <limits>
+#include <utility>
+
 #include "public.h"
+#include "serialize.h"
 #include "sparse.h"
 #include "vec.h"
 
@@ -24,18 +28,155 @@ class Collider {
  public:
   Collider() {}
   Collider(const VecView<const Box>& leafBB,
-           const VecView<const uint32_t>& leafMorton);
+           const VecView<const uint32_t>& leafMorton, bool sah = false);
+  Collider(const VecView<const Box>& leafBB,
+           const VecView<const uint64_t>& leafMorton, bool sah = false);
   bool Transform(glm::mat4x3);
   void UpdateBoxes(const VecView<const Box>& leafBB);
+  void BuildWide();
+  void Serialize(SerialWriter& writer) const;
+  bool Deserialize(SerialReader& reader);
   template <const bool selfCollision = false, const bool inverted = false,
             typename T>
   SparseIndices Collisions(const VecView<const T>& queriesIn) const;
 
+  /**
+   * Nearest-first depth-first traversal for closest-hit queries, run on the
+   * calling thread. The query must provide float Bound(const Box&), a lower
+   * bound on the cost of anything inside the box (infinity to skip it), float
+   * Best(), the cost of the best leaf found so far, and void Leaf(int leaf),
+   * which tests a leaf and may lower Best(). Subtrees whose bound is not below
+   * Best() are pruned.
+   */
+  template <typename Query>
+  void Nearest(Query& query) const {
+    if (internalChildren_.empty()) {
+      if (!nodeBBox_.empty() && query.Bound(nodeBBox_[0]) < query.Best())
+        query.Leaf(0);
+      return;
+    }
+    // deep enough for both the radix and the SAH trees, as in Collisions
+    int stack[128];
+    float stackBound[128];
+    int top = -1;
+    int node = 1;  // root
+    while (1) {
+      const thrust::pair<int, int> children = internalChildren_[(node - 1) / 2];
+      int nearNode = children.first;
+      int farNode = children.second;
+      float nearBound = query.Bound(nodeBBox_[nearNode]);
+      float farBound = query.Bound(nodeBBox_[farNode]);
+      if (farBound < nearBound) {
+        std::swap(nearNode, farNode);
+        std::swap(nearBound, farBound);
+      }
+      // leaves (even nodes) are tested right away
+      if (nearNode % 2 == 0) {
+        if (nearBound < query.Best()) query.Leaf(nearNode / 2);
+        nearBound = std::numeric_limits<float>::infinity();
+      }
+      if (farNode % 2 == 0) {
+        if (farBound < query.Best()) query.Leaf(farNode / 2);
+        farBound = std::numeric_limits<float>::infinity();
+      }
+      if (farBound < query.Best()) {
+        stack[++top] = farNode;
+        stackBound[top] = farBound;
+      }
+      if (nearBound < query.Best()) {
+        node = nearNode;
+        continue;
+      }
+      while (top >= 0 && stackBound[top] >= query.Best()) --top;
+      if (top < 0) break;
+      node = stack[top--];
+    }
+  }
+
+  /**
+   * A node of the optional 4-wide hierarchy collapsed from the binary tree,
+   * with the child boxes stored as structure of arrays so one query can be
+   * tested against all four lanes at once. Unused lanes hold an empty box.
+   */
+  struct WideNode {
+    float minX[4], minY[4], minZ[4];
+    float maxX[4], maxY[4], maxZ[4];
+    // binary tree node of each lane, or -1
+    int node[4];
+    // wide node index of an internal lane, or the leaf index of a leaf lane
+    int child[4];
+  };
+
+  static constexpr uint32_t kNoCode = 0xFFFFFFFFu;
+  static constexpr uint64_t kNoCode64 = 0xFFFFFFFFFFFFFFFFull;
+
+  /**
+   * 30-bit Morton code of the position quantized to a 1024^3 grid over bBox.
+   * NaN positions, used to flag unreferenced elements, return kNoCode so they
+   * sort to the end.
+   */
+  static uint32_t MortonCode(glm::vec3 position, Box bBox) {
+    if (glm::isnan(position.x)) return kNoCode;
+
+    glm::vec3 xyz = (position - bBox.min) / (bBox.max - bBox.min);
+    xyz =
+        glm::min(glm::vec3(1023.0f), glm::max(glm::vec3(0.0f), 1024.0f * xyz));
+    uint32_t x = SpreadBits3(static_cast<uint32_t>(xyz.x));
+    uint32_t y = SpreadBits3(static_cast<uint32_t>(xyz.y));
+    uint32_t z = SpreadBits3(static_cast<uint32_t>(xyz.z));
+    return x * 4 + y * 2 + z;
+  }
+
+  /**
+   * 63-bit Morton code of the position quantized to a 2^21 grid per axis over
+   * bBox, for sets of boxes too clustered for the 30-bit code. NaN positions
+   * return kNoCode64.
+   */
+  static uint64_t MortonCode64(glm::vec3 position, Box bBox) {
+    if (glm::isnan(position.x)) return kNoCode64;
+
+    constexpr float kMax = (1 << 21) - 1;
+    glm::vec3 xyz = (position - bBox.min) / (bBox.max - bBox.min);
+    xyz = glm::min(glm::vec3(kMax),
+                   glm::max(glm::vec3(0.0f), float(1 << 21) * xyz));
+    uint64_t x = SpreadBits3(static_cast<uint64_t>(xyz.x));
+    uint64_t y = SpreadBits3(static_cast<uint64_t>(xyz.y));
+    uint64_t z = SpreadBits3(static_cast<uint64_t>(xyz.z));
+    return x * 4 + y * 2 + z;
+  }
+
  private:
-  Vec<Box> nodeBBox_;
-  Vec<int> nodeParent_;
+  Vec<Box> nodeBBox_{MemoryCategory::Collider};
+  Vec<int> nodeParent_{MemoryCategory::Collider};
   // even nodes are leaves, odd nodes are internal, root is 1
-  Vec<thrust::pair<int, int>> internalChildren_;
+  Vec<thrust::pair<int, int>> internalChildren_{MemoryCategory::Collider};
+  // empty unless BuildWide() was called; root is 0
+  Vec<WideNode> wideNodes_{MemoryCategory::Collider};
+
+  static uint32_t SpreadBits3(uint32_t v) {
+    v = 0xFF0000FFu & (v * 0x00010001u);
+    v = 0x0F00F00Fu & (v * 0x00000101u);
+    v = 0xC30C30C3u & (v * 0x00000011u);
+    v = 0x49249249u & (v * 0x00000005u);
+    return v;
+  }
+
+  static uint64_t SpreadBits3(uint64_t v) {
+    v &= 0x1FFFFFull;
+    v = 0x1F00000000FFFFull & (v | v << 32);
+    v = 0x1F0000FF0000FFull & (v | v << 16);
+    v = 0x100F00F00F00F00Full & (v | v << 8);
+    v = 0x10C30C30C30C30C3ull & (v | v << 4);
+    v = 0x1249249249249249ull & (v | v << 2);
+    return v;
+  }
+
+  template <typename Code>
+  void Build(const VecView<const Box>& leafBB,
+             const VecView<const Code>& leafMorton, bool sah);
+  void BuildSAH(const VecView<const Box>& leafBB);
+  int CollapseWide(int node);
+  void UpdateWide();
 
   int NumInternal() const { return internalChildren_.size(); };
   int NumLeaves() const {
@@ -14,6 +14,9 @@
 
 #include "collider.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "par.h"
 #include "utils.h"
 
@@ -25,6 +28,9 @@
 constexpr int kInitialLength = 128;
 constexpr int kLengthMultiple = 4;
 constexpr int kSequentialThreshold = 512;
+// past this depth the SAH build falls back to median splits, which bounds the
+// tree depth for the traversal stack
+constexpr int kMaxSAHDepth = 48;
 // Fundamental constants
 constexpr int kRoot = 1;
 
@@ -55,6 +61,11 @@ uint32_t __inline clz(uint32_t value) {
     return 32;
   }
 }
+
+uint32_t __inline clz(uint64_t value) {
+  const uint32_t high = static_cast<uint32_t>(value >> 32);
+  return high != 0 ? clz(high) : 32 + clz(static_cast<uint32_t>(value));
+}
 #endif
 
 namespace {
@@ -67,10 +78,11 @@ int Internal2Node(int internal) { return internal * 2 + 1; }
 int Node2Leaf(int node) { return node / 2; }
 int Leaf2Node(int leaf) { return leaf * 2; }
 
+template <typename Code>
 struct CreateRadixTree {
   VecView<int> nodeParent_;
   VecView<thrust::pair<int, int>> internalChildren_;
-  const VecView<const uint32_t> leafMorton_;
+  const VecView<const Code> leafMorton_;
 
   int PrefixLength(uint32_t a, uint32_t b) const {
 // count-leading-zeros is used to find the number of identical highest-order
@@ -83,6 +95,14 @@ struct CreateRadixTree {
 #endif
   }
 
+  int PrefixLength(uint64_t a, uint64_t b) const {
+#ifdef _MSC_VER
+    return clz(a ^ b);
+#else
+    return __builtin_clzll(a ^ b);
+#endif
+  }
+
   int PrefixLength(int i, int j) const {
     if (j < 0 || j >= leafMorton_.size()) {
       return -1;
@@ -90,7 +110,7 @@ struct CreateRadixTree {
       int out;
       if (leafMorton_[i] == leafMorton_[j])
         // use index to disambiguate
-        out = 32 +
+        out = 8 * sizeof(Code) +
               PrefixLength(static_cast<uint32_t>(i), static_cast<uint32_t>(j));
       else
         out = PrefixLength(leafMorton_[i], leafMorton_[j]);
@@ -152,12 +172,119 @@ struct CreateRadixTree {
   }
 };
 
+float HalfArea(const Box& box) {
+  const glm::vec3 size = glm::max(box.Size(), glm::vec3(0.0f));
+  return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+// Top-down build over the leaves in their given (Morton) order: each node
+// splits its contiguous range of leaves where the surface area heuristic is
+// lowest. Internal nodes are numbered in pre-order, so the root is internal 0
+// just like in the radix tree.
+struct CreateSAHTree {
+  VecView<int> nodeParent_;
+  VecView<thrust::pair<int, int>> internalChildren_;
+  const VecView<const Box> leafBB_;
+  // scratch for the boxes of leaf ranges [i, last]
+  VecView<Box> suffix_;
+  int numInternal_ = 0;
+
+  int operator()(int first, int last, int depth) {
+    if (first == last) return Leaf2Node(first);
+    const int internal = numInternal_++;
+    const int node = Internal2Node(internal);
+
+    int split = (first + last) / 2;
+    if (depth < kMaxSAHDepth && last - first > 1) {
+      suffix_[last] = leafBB_[last];
+      for (int i = last - 1; i > first; --i)
+        suffix_[i] = suffix_[i + 1].Union(leafBB_[i]);
+      Box prefix;
+      float bestCost = std::numeric_limits<float>::infinity();
+      for (int i = first; i < last; ++i) {
+        prefix = prefix.Union(leafBB_[i]);
+        const float cost = HalfArea(prefix) * (i - first + 1) +
+                           HalfArea(suffix_[i + 1]) * (last - i);
+        if (cost < bestCost) {
+          bestCost = cost;
+          split = i;
+        }
+      }
+    }
+
+    const int child1 = (*this)(first, split, depth + 1);
+    const int child2 = (*this)(split + 1, last, depth + 1);
+    internalChildren_[internal].first = child1;
+    internalChildren_[internal].second = child2;
+    nodeParent_[child1] = node;
+    nodeParent_[child2] = node;
+    return node;
+  }
+};
+
 template <typename T, const bool selfCollision, typename Recorder>
 struct FindCollisions {
   VecView<const Box> nodeBBox_;
   VecView<const thrust::pair<int, int>> internalChildren_;
+  VecView<const Collider::WideNode> wideNodes_;
   Recorder recorder;
 
+  // Bitmask of the lanes whose box overlaps the query. The lanes are tested
+  // with branch-free comparisons over the structure of arrays, which compilers
+  // vectorize to SSE or NEON.
+  static int LaneOverlaps(const Collider::WideNode& n, const Box& b) {
+    int mask = 0;
+    for (int i = 0; i < 4; ++i) {
+      mask |= ((n.minX[i] <= b.max.x) & (n.minY[i] <= b.max.y) &
+               (n.minZ[i] <= b.max.z) & (n.maxX[i] >= b.min.x) &
+               (n.maxY[i] >= b.min.y) & (n.maxZ[i] >= b.min.z))
+              << i;
+    }
+    return mask;
+  }
+
+  static int LaneOverlaps(const Collider::WideNode& n, const glm::vec3& p) {
+    int mask = 0;
+    for (int i = 0; i < 4; ++i) {
+      mask |= ((p.x <= n.maxX[i]) & (p.x >= n.minX[i]) & (p.y <= n.maxY[i]) &
+               (p.y >= n.minY[i]))
+              << i;
+    }
+    return mask;
+  }
+
+  void TraverseWide(thrust::tuple<T, int>& query) {
+    const T& queryObj = thrust::get<0>(query);
+    const int queryIdx = thrust::get<1>(query);
+    // each wide level pushes at most 3 nodes and is no deeper than the binary
+    // tree
+    int stack[384];
+    int top = -1;
+    int wide = 0;
+    while (1) {
+      const Collider::WideNode& n = wideNodes_[wide];
+      const int mask = LaneOverlaps(n, queryObj);
+      int next = -1;
+      for (int i = 0; i < 4; ++i) {
+        if (((mask >> i) & 1) == 0) continue;
+        if (IsLeaf(n.node[i])) {
+          if (!selfCollision || n.child[i] != queryIdx)
+            recorder.record(queryIdx, n.child[i]);
+        } else if (next < 0) {
+          next = n.child[i];
+        } else {
+          stack[++top] = n.child[i];
+        }
+      }
+      if (next >= 0) {
+        wide = next;
+      } else {
+        if (top < 0) break;
+        wide = stack[top--];
+      }
+    }
+  }
+
   int RecordCollision(int node, thrust::tuple<T, int>& query) {
     const T& queryObj = thrust::get<0>(query);
     const int queryIdx = thrust::get<1>(query);
@@ -173,15 +300,20 @@ struct FindCollisions {
   }
 
   void operator()(thrust::tuple<T, int> query) {
-    // stack cannot overflow because radix tree has max depth 30 (Morton code) +
-    // 32 (index).
-    int stack[64];
+    // stack cannot overflow because radix tree has max depth 63 (Morton code) +
+    // 32 (index), and the SAH tree kMaxSAHDepth + 32.
+    int stack[128];
     int top = -1;
     // Depth-first search
     int node = kRoot;
     const int queryIdx = thrust::get<1>(query);
     // same implies that this query do not have any collision
     if (recorder.earlyexit(queryIdx)) return;
+    if (!wideNodes_.empty()) {
+      TraverseWide(query);
+      recorder.end(queryIdx);
+      return;
+    }
     while (1) {
       int internal = Node2Internal(node);
       int child1 = internalChildren_[internal].first;
@@ -204,16 +336,6 @@ struct FindCollisions {
   }
 };
 
-struct CountCollisions {
-  VecView<int> counts;
-  VecView<char> empty;
-  void record(int queryIdx, int _leafIdx) { counts[queryIdx]++; }
-  bool earlyexit(int _queryIdx) { return false; }
-  void end(int queryIdx) {
-    if (counts[queryIdx] == 0) empty[queryIdx] = 1;
-  }
-};
-
 template <const bool inverted>
 struct SeqCollisionRecorder {
   SparseIndices& queryTri_;
@@ -228,18 +350,13 @@ struct SeqCollisionRecorder {
 };
 
 template <const bool inverted>
-struct ParCollisionRecorder {
-  SparseIndices& queryTri;
-  VecView<int> counts;
-  VecView<char> empty;
-  void record(int queryIdx, int leafIdx) {
-    int pos = counts[queryIdx]++;
-    if (inverted)
-      queryTri.Set(pos, leafIdx, queryIdx);
-    else
-      queryTri.Set(pos, queryIdx, leafIdx);
+struct BlockCollisionRecorder {
+  Vec<int64_t>& pairs_;
+  void record(int queryIdx, int leafIdx) const {
+    pairs_.push_back(inverted ? SparseIndices::EncodePQ(leafIdx, queryIdx)
+                              : SparseIndices::EncodePQ(queryIdx, leafIdx));
   }
-  bool earlyexit(int queryIdx) const { return empty[queryIdx] == 1; }
+  bool earlyexit(int queryIdx) const { return false; }
   void end(int queryIdx) const {}
 };
 
@@ -261,6 +378,22 @@ struct BuildInternalBoxes {
   }
 };
 
+struct UpdateWideNode {
+  VecView<const Box> nodeBBox_;
+
+  void operator()(Collider::WideNode& n) {
+    for (int i = 0; i < 4; ++i) {
+      const Box box = n.node[i] < 0 ? Box() : nodeBBox_[n.node[i]];
+      n.minX[i] = box.min.x;
+      n.minY[i] = box.min.y;
+      n.minZ[i] = box.min.z;
+      n.maxX[i] = box.max.x;
+      n.maxY[i] = box.max.y;
+      n.maxZ[i] = box.max.z;
+    }
+  }
+};
+
 struct TransformBox {
   const glm::mat4x3 transform;
   void operator()(Box& box) { box = box.Transform(transform); }
@@ -271,11 +404,27 @@ namespace manifold {
 
 /**
  * Creates a Bounding Volume Hierarchy (BVH) from an input set of axis-aligned
- * bounding boxes and corresponding Morton codes. It is assumed these vectors
- * are already sorted by increasing Morton code.
+ * bounding boxes and corresponding 32 or 64-bit Morton codes. It is assumed
+ * these vectors are already sorted by increasing Morton code.
+ *
+ * By default the hierarchy is a radix tree over the Morton codes, which is
+ * fast to build in parallel. With sah set, the tree is instead built top-down
+ * by the surface area heuristic over the same leaf order, which is slower to
+ * build but needs fewer node visits per query on unevenly distributed leaves.
  */
 Collider::Collider(const VecView<const Box>& leafBB,
-                   const VecView<const uint32_t>& leafMorton) {
+                   const VecView<const uint32_t>& leafMorton, bool sah) {
+  Build(leafBB, leafMorton, sah);
+}
+
+Collider::Collider(const VecView<const Box>& leafBB,
+                   const VecView<const uint64_t>& leafMorton, bool sah) {
+  Build(leafBB, leafMorton, sah);
+}
+
+template <typename Code>
+void Collider::Build(const VecView<const Box>& leafBB,
+                     const VecView<const Code>& leafMorton, bool sah) {
   ZoneScoped;
   ASSERT(leafBB.size() == leafMorton.size(), userErr,
          "vectors must be the same length");
@@ -285,11 +434,24 @@ Collider::Collider(const VecView<const Box>& leafBB,
   nodeParent_.resize(num_nodes, -1);
   internalChildren_.resize(leafBB.size() - 1, thrust::make_pair(-1, -1));
   // organize tree
-  for_each_n(autoPolicy(NumInternal()), countAt(0), NumInternal(),
-             CreateRadixTree({nodeParent_, internalChildren_, leafMorton}));
+  if (sah) {
+    BuildSAH(leafBB);
+  } else {
+    for_each_n(
+        autoPolicy(NumInternal()), countAt(0), NumInternal(),
+        CreateRadixTree<Code>({nodeParent_, internalChildren_, leafMorton}));
+  }
   UpdateBoxes(leafBB);
 }
 
+void Collider::BuildSAH(const VecView<const Box>& leafBB) {
+  ZoneScoped;
+  if (NumInternal() == 0) return;
+  Vec<Box> suffix(leafBB.size());
+  CreateSAHTree({nodeParent_, internalChildren_, leafBB, suffix})(
+      0, leafBB.size() - 1, 0);
+}
+
 /**
  * For a vector of query objects, this returns a sparse array of overlaps
  * between the queries and the bounding boxes of the collider. Queries are
@@ -301,34 +463,41 @@ Collider::Collider(const VecView<const Box>& leafBB,
 template <const bool selfCollision, const bool inverted, typename T>
 SparseIndices Collider::Collisions(const VecView<const T>& queriesIn) const {
   ZoneScoped;
-  // note that the length is 1 larger than the number of queries so the last
-  // element can store the sum when using exclusive scan
   if (queriesIn.size() < kSequentialThreshold) {
     SparseIndices queryTri;
     for_each_n(ExecutionPolicy::Seq, zip(queriesIn.cbegin(), countAt(0)),
                queriesIn.size(),
                FindCollisions<T, selfCollision, SeqCollisionRecorder<inverted>>{
-                   nodeBBox_, internalChildren_, {queryTri}});
+                   nodeBBox_, internalChildren_, wideNodes_, {queryTri}});
     return queryTri;
   } else {
-    // compute the number of collisions to determine the size for allocation and
-    // offset, this avoids the need for atomic
-    Vec<int> counts(queriesIn.size() + 1, 0);
-    Vec<char> empty(queriesIn.size(), 0);
-    for_each_n(ExecutionPolicy::Par, zip(queriesIn.cbegin(), countAt(0)),
-               queriesIn.size(),
-               FindCollisions<T, selfCollision, CountCollisions>{
-                   nodeBBox_, internalChildren_, {counts, empty}});
-    // compute start index for each query and total count
-    exclusive_scan(ExecutionPolicy::Par, counts.begin(), counts.end(),
-                   counts.begin(), 0, std::plus<int>());
-    if (counts.back() == 0) return SparseIndices(0);
-    SparseIndices queryTri(counts.back());
-    // actually recording collisions
-    for_each_n(ExecutionPolicy::Par, zip(queriesIn.cbegin(), countAt(0)),
-               queriesIn.size(),
-               FindCollisions<T, selfCollision, ParCollisionRecorder<inverted>>{
-                   nodeBBox_, internalChildren_, {queryTri, counts, empty}});
+    // a single traversal: each block of queries records into its own growable
+    // buffer, and the buffers are concatenated in query order, so the output
+    // matches the sequential one
+    const int numBlocks =
+        (queriesIn.size() + kSequentialThreshold - 1) / kSequentialThreshold;
+    std::vector<Vec<int64_t>> blocks(numBlocks);
+    for_each_n(ExecutionPolicy::Par, countAt(0), numBlocks, [&](int block) {
+      FindCollisions<T, selfCollision, BlockCollisionRecorder<inverted>> find{
+          nodeBBox_, internalChildren_, wideNodes_, {blocks[block]}};
+      const int end = std::min(queriesIn.size(),
+                               (block + 1) * kSequentialThreshold);
+      for (int i = block * kSequentialThreshold; i < end; ++i)
+        find(thrust::make_tuple(queriesIn[i], i));
+    });
+    // compute the start of each block and the total count; the length is 1
+    // larger than the number of blocks so the last element can store the sum
+    Vec<int> offsets(numBlocks + 1, 0);
+    for (int i = 0; i < numBlocks; ++i) offsets[i] = blocks[i].size();
+    exclusive_scan(ExecutionPolicy::Seq, offsets.begin(), offsets.end(),
+                   offsets.begin(), 0, std::plus<int>());
+    if (offsets.back() == 0) return SparseIndices(0);
+    SparseIndices queryTri(offsets.back());
+    VecView<int64_t> pairs = queryTri.AsVec64();
+    for_each_n(ExecutionPolicy::Par, countAt(0), numBlocks, [&](int block) {
+      std::copy(blocks[block].begin(), blocks[block].end(),
+                pairs.begin() + offsets[block]);
+    });
     return queryTri;
   }
 }
@@ -351,6 +520,65 @@ void Collider::UpdateBoxes(const VecView<const Box>& leafBB) {
   for_each_n(
       policy, countAt(0), NumLeaves(),
       BuildInternalBoxes({nodeBBox_, counter, nodeParent_, internalChildren_}));
+  if (!wideNodes_.empty()) UpdateWide();
+}
+
+/**
+ * Collapses the binary tree into a 4-wide hierarchy that Collisions then
+ * traverses instead: each wide node takes the children of a binary node and
+ * repeatedly opens its largest internal lane until four lanes are filled. This
+ * roughly halves the traversal depth and packs four child boxes per cache-
+ * friendly node. The wide boxes follow every later UpdateBoxes() and
+ * Transform().
+ */
+void Collider::BuildWide() {
+  ZoneScoped;
+  wideNodes_.resize(0);
+  if (NumInternal() == 0) return;
+  CollapseWide(kRoot);
+  UpdateWide();
+}
+
+int Collider::CollapseWide(int node) {
+  const int wide = wideNodes_.size();
+  wideNodes_.push_back({});
+  int lanes[4];
+  lanes[0] = internalChildren_[Node2Internal(node)].first;
+  lanes[1] = internalChildren_[Node2Internal(node)].second;
+  int numLanes = 2;
+  while (numLanes < 4) {
+    int open = -1;
+    float openArea = -1;
+    for (int i = 0; i < numLanes; ++i) {
+      if (!IsInternal(lanes[i])) continue;
+      const float area = HalfArea(nodeBBox_[lanes[i]]);
+      if (area > openArea) {
+        openArea = area;
+        open = i;
+      }
+    }
+    if (open < 0) break;
+    const thrust::pair<int, int> children =
+        internalChildren_[Node2Internal(lanes[open])];
+    lanes[open] = children.first;
+    lanes[numLanes++] = children.second;
+  }
+  for (int i = 0; i < 4; ++i) {
+    wideNodes_[wide].node[i] = i < numLanes ? lanes[i] : -1;
+    wideNodes_[wide].child[i] = -1;
+  }
+  for (int i = 0; i < numLanes; ++i) {
+    // recursion may reallocate wideNodes_, so index it afresh
+    const int child =
+        IsLeaf(lanes[i]) ? Node2Leaf(lanes[i]) : CollapseWide(lanes[i]);
+    wideNodes_[wide].child[i] = child;
+  }
+  return wide;
+}
+
+void Collider::UpdateWide() {
+  for_each_n(autoPolicy(wideNodes_.size()), wideNodes_.begin(),
+             wideNodes_.size(), UpdateWideNode({nodeBBox_}));
 }
 
 /**
@@ -370,10 +598,30 @@ bool Collider::Transform(glm::mat4x3 transform) {
   if (axisAligned) {
     for_each(autoPolicy(nodeBBox_.size()), nodeBBox_.begin(), nodeBBox_.end(),
              TransformBox({transform}));
+    if (!wideNodes_.empty()) UpdateWide();
   }
   return axisAligned;
 }
 
+/**
+ * Writes the hierarchy as-is, including the wide nodes if they were built, so
+ * that Deserialize() restores it without rebuilding.
+ */
+void Collider::Serialize(SerialWriter& writer) const {
+  writer.Array(nodeBBox_);
+  writer.Array(nodeParent_);
+  writer.Array(internalChildren_);
+  writer.Array(wideNodes_);
+}
+
+bool Collider::Deserialize(SerialReader& reader) {
+  reader.Array(nodeBBox_);
+  reader.Array(nodeParent_);
+  reader.Array(internalChildren_);
+  reader.Array(wideNodes_);
+  return reader.Ok();
+}
+
 template SparseIndices Collider::Collisions<true, false, Box>(
     const VecView<const Box>&) const;
 
@@ -87,6 +87,7 @@ class CrossSection {
   int NumContour() const;
   bool IsEmpty() const;
   Rect Bounds() const;
+  std::vector<char> Contains(VecView<const glm::vec2> points) const;
   ///@}
 
   /** @name Modification
@@ -127,6 +128,9 @@ class CrossSection {
 
   CrossSection Offset(double delta, JoinType jt, double miter_limit = 2.0,
                       int circularSegments = 0) const;
+  std::vector<CrossSection> Offsets(const std::vector<double>& deltas,
+                                    JoinType jt, double miter_limit = 2.0,
+                                    int circularSegments = 0) const;
   ///@}
 
   /** @name Boolean
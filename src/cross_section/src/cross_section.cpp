@@ -14,24 +14,126 @@
 
 #include "cross_section.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <numeric>
+
 #include "clipper2/clipper.core.h"
 #include "clipper2/clipper.h"
 #include "clipper2/clipper.offset.h"
+#include "collider.h"
+#include "par.h"
 
 namespace C2 = Clipper2Lib;
 
 using namespace manifold;
 
+namespace {
+constexpr double Pow10(int n) { return n == 0 ? 1 : 10 * Pow10(n - 1); }
+
+// the decimal places Clipper2 keeps
+constexpr int precision_ = 8;
+// the fixed-point units per unit length
+constexpr double kFixedScale = Pow10(precision_);
+}  // namespace
+
 namespace manifold {
+/**
+ * A bounding volume hierarchy over the edges of a set of paths, with the
+ * boxes in the z = 0 plane.
+ */
+struct EdgeIndex {
+  std::vector<glm::dvec2> start;
+  std::vector<glm::dvec2> end;
+  Collider collider;
+
+  EdgeIndex(const C2::PathsD& paths) {
+    for (const C2::PathD& path : paths) {
+      for (int i = 0; i < path.size(); ++i) {
+        const C2::PointD& a = path[i];
+        const C2::PointD& b = path[(i + 1) % path.size()];
+        start.push_back({a.x, a.y});
+        end.push_back({b.x, b.y});
+      }
+    }
+    const int n = start.size();
+    Vec<Box> boxes(n);
+    Box bBox;
+    for (int i = 0; i < n; ++i) {
+      boxes[i] = Box(glm::vec3(start[i], 0), glm::vec3(end[i], 0));
+      bBox.Union(boxes[i]);
+    }
+    Vec<uint32_t> codes(n);
+    for_each_n(autoPolicy(n), countAt(0), n, [&](int i) {
+      codes[i] = Collider::MortonCode(boxes[i].Center(), bBox);
+    });
+    std::vector<int> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](int a, int b) { return codes[a] < codes[b]; });
+    Vec<Box> sortedBoxes(n);
+    Vec<uint32_t> sortedCodes(n);
+    std::vector<glm::dvec2> sortedStart(n);
+    std::vector<glm::dvec2> sortedEnd(n);
+    for (int i = 0; i < n; ++i) {
+      sortedBoxes[i] = boxes[order[i]];
+      sortedCodes[i] = codes[order[i]];
+      sortedStart[i] = start[order[i]];
+      sortedEnd[i] = end[order[i]];
+    }
+    start = std::move(sortedStart);
+    end = std::move(sortedEnd);
+    collider = Collider(sortedBoxes, sortedCodes);
+  }
+};
+
+// The paths of a CrossSection, in doubles and in the fixed point that
+// Clipper2 computes in. The fixed-point form is rounded from the doubles the
+// first time it's needed and kept, and results of Clipper2 are stored in both
+// forms, so chained operations never convert the same paths twice.
 struct PathImpl {
   PathImpl(const C2::PathsD paths_) : paths_(paths_) {}
+  PathImpl(C2::Paths64 fixed)
+      : paths_(ToDouble(fixed)), fixedGiven_(true), fixed_(std::move(fixed)) {}
   operator const C2::PathsD&() const { return paths_; }
   const C2::PathsD paths_;
+
+  const EdgeIndex& Edges() const {
+    std::call_once(edgesOnce_, [this]() {
+      edges_ = std::make_unique<const EdgeIndex>(paths_);
+    });
+    return *edges_;
+  }
+
+  const C2::Paths64& Fixed() const {
+    if (fixedGiven_) return fixed_;
+    std::call_once(fixedOnce_, [this]() {
+      int error = 0;
+      fixed_ = C2::ScalePaths<int64_t, double>(paths_, kFixedScale, error);
+    });
+    return fixed_;
+  }
+
+ private:
+  // set when constructed from the fixed-point form, which is then never
+  // rounded again
+  const bool fixedGiven_ = false;
+  mutable std::once_flag fixedOnce_;
+  mutable C2::Paths64 fixed_;
+  mutable std::once_flag edgesOnce_;
+  mutable std::unique_ptr<const EdgeIndex> edges_;
+
+  static C2::PathsD ToDouble(const C2::Paths64& fixed) {
+    int error = 0;
+    return C2::ScalePaths<double, int64_t>(fixed, 1 / kFixedScale, error);
+  }
 };
 }  // namespace manifold
 
 namespace {
-const int precision_ = 8;
 
 C2::ClipType cliptype_of_op(OpType op) {
   C2::ClipType ct = C2::ClipType::Union;
@@ -114,6 +216,134 @@ std::shared_ptr<const PathImpl> shared_paths(const C2::PathsD& ps) {
   return std::make_shared<const PathImpl>(ps);
 }
 
+std::shared_ptr<const PathImpl> shared_paths(C2::Paths64 ps) {
+  return std::make_shared<const PathImpl>(std::move(ps));
+}
+
+// cross-sections per Clipper call at the leaves of union_tree
+constexpr size_t kUnionLeaf = 32;
+
+uint32_t spread_bits2(uint32_t v) {
+  v &= 0xFFFF;
+  v = (v | (v << 8)) & 0x00FF00FF;
+  v = (v | (v << 4)) & 0x0F0F0F0F;
+  v = (v | (v << 2)) & 0x33333333;
+  v = (v | (v << 1)) & 0x55555555;
+  return v;
+}
+
+/**
+ * The union of many sets of paths. They are sorted along a Morton curve by
+ * the centers of their bounds, so each run of kUnionLeaf is spatially
+ * compact, then each run is unioned in one Clipper call and the results are
+ * reduced pairwise in a tree. The calls of each level are independent and run
+ * in parallel, while the tree depends only on the input, so the result is
+ * reproducible.
+ */
+C2::Paths64 union_tree(const std::vector<const C2::Paths64*>& parts) {
+  const int n = parts.size();
+  std::vector<C2::Rect64> bounds(n);
+  for_each_n(autoPolicy(n), countAt(0), n,
+             [&](int i) { bounds[i] = C2::GetBounds(*parts[i]); });
+
+  glm::dvec2 min(std::numeric_limits<double>::infinity());
+  glm::dvec2 max(-std::numeric_limits<double>::infinity());
+  for (const C2::Rect64& r : bounds) {
+    if (r.IsEmpty()) continue;
+    min = glm::min(min, glm::dvec2(r.left, std::min(r.top, r.bottom)));
+    max = glm::max(max, glm::dvec2(r.right, std::max(r.top, r.bottom)));
+  }
+  const glm::dvec2 scale = 65535.0 / glm::max(max - min, glm::dvec2(1.0));
+  std::vector<uint32_t> codes(n, 0);
+  for (int i = 0; i < n; ++i) {
+    if (bounds[i].IsEmpty()) continue;
+    const glm::dvec2 center(bounds[i].MidPoint().x, bounds[i].MidPoint().y);
+    const glm::uvec2 cell((center - min) * scale);
+    codes[i] = spread_bits2(cell.x) | (spread_bits2(cell.y) << 1);
+  }
+  std::vector<int> order(n);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&](int a, int b) { return codes[a] < codes[b]; });
+
+  std::vector<C2::Paths64> level((n + kUnionLeaf - 1) / kUnionLeaf);
+  for_each_n(ExecutionPolicy::Par, countAt(0), level.size(), [&](int i) {
+    C2::Paths64 paths;
+    const int end = std::min<int>(n, (i + 1) * kUnionLeaf);
+    for (int j = i * kUnionLeaf; j < end; ++j)
+      paths.insert(paths.end(), parts[order[j]]->begin(),
+                   parts[order[j]]->end());
+    level[i] = C2::Union(paths, C2::FillRule::Positive);
+  });
+  while (level.size() > 1) {
+    std::vector<C2::Paths64> next((level.size() + 1) / 2);
+    for_each_n(ExecutionPolicy::Par, countAt(0), level.size() / 2, [&](int i) {
+      next[i] =
+          C2::Union(level[2 * i], level[2 * i + 1], C2::FillRule::Positive);
+    });
+    if (level.size() % 2 == 1) next.back() = std::move(level.back());
+    level = std::move(next);
+  }
+  return level.front();
+}
+
+// deltas per parallel round of Offsets, between checks for an empty result
+constexpr int kOffsetChunk = 8;
+
+/**
+ * The arc tolerance in fixed-point units that gets the same number of
+ * segments per circle out of Clipper2 as the given circularSegments, or the
+ * static Quality defaults: steps_per_360 = PI / acos(1 - arc_tol / abs_delta)
+ */
+double arc_tolerance(double delta, bool round, int circularSegments) {
+  if (!round) return 0.;
+  int n = circularSegments > 2 ? circularSegments
+                               : Quality::GetCircularSegments(delta);
+  const double scaled_delta = std::fabs(delta) * kFixedScale;
+  return (std::cos(Clipper2Lib::PI / n) - 1) * -scaled_delta;
+}
+
+C2::Paths64 inflate(const C2::Paths64& paths, double delta, C2::JoinType join,
+                    double miter_limit, double arc_tol) {
+  return C2::InflatePaths(paths, delta * kFixedScale, join,
+                          C2::EndType::Polygon, miter_limit, arc_tol);
+}
+
+/**
+ * The winding number of the paths around a point, counting the edges
+ * crossed by a ray from it in +x. Each edge covers the half-open range of y
+ * from its lower end, so a ray through a vert counts it once.
+ */
+struct WindingQuery {
+  const std::vector<glm::dvec2>& start;
+  const std::vector<glm::dvec2>& end;
+  const glm::dvec2 point;
+  int winding = 0;
+
+  // never prunes, as every edge the ray crosses counts
+  float Best() const { return std::numeric_limits<float>::infinity(); }
+
+  // edges whose box spans the point in y and reaches right of it
+  float Bound(const Box& box) const {
+    return point.y >= box.min.y && point.y <= box.max.y &&
+                   point.x <= box.max.x
+               ? 0
+               : std::numeric_limits<float>::infinity();
+  }
+
+  void Leaf(int edge) {
+    const glm::dvec2 a = start[edge];
+    const glm::dvec2 b = end[edge];
+    const bool up = a.y <= point.y && point.y < b.y;
+    const bool down = b.y <= point.y && point.y < a.y;
+    if (!up && !down) return;
+    const double side =
+        (b.x - a.x) * (point.y - a.y) - (b.y - a.y) * (point.x - a.x);
+    if (up && side > 0) ++winding;
+    if (down && side < 0) --winding;
+  }
+};
+
 // forward declaration for mutual recursion
 void decompose_hole(const C2::PolyTreeD* outline,
                     std::vector<C2::PathsD>& polys, C2::PathsD& poly,
@@ -303,6 +533,22 @@ std::shared_ptr<const PathImpl> CrossSection::GetPaths() const {
   if (transform_ == glm::mat3x2(1.0f)) {
     return paths_;
   }
+  if (glm::mat2(transform_) == glm::mat2(1.0f)) {
+    // a translation by whole units of the fixed-point grid moves the
+    // fixed-point form exactly, so it needn't be rounded again; any other
+    // offset is applied to the doubles, so it isn't snapped to the grid
+    const double dx = transform_[2].x * kFixedScale;
+    const double dy = transform_[2].y * kFixedScale;
+    if (dx == std::round(dx) && dy == std::round(dy)) {
+      paths_ = shared_paths(C2::TranslatePaths(
+          paths_->Fixed(), static_cast<int64_t>(dx), static_cast<int64_t>(dy)));
+    } else {
+      paths_ = shared_paths(C2::TranslatePaths<double>(
+          paths_->paths_, transform_[2].x, transform_[2].y));
+    }
+    transform_ = glm::mat3x2(1.0f);
+    return paths_;
+  }
   paths_ = shared_paths(::transform(paths_->paths_, transform_));
   transform_ = glm::mat3x2(1.0f);
   return paths_;
@@ -367,14 +613,16 @@ CrossSection CrossSection::Circle(float radius, int circularSegments) {
 CrossSection CrossSection::Boolean(const CrossSection& second,
                                    OpType op) const {
   auto ct = cliptype_of_op(op);
-  auto res = C2::BooleanOp(ct, C2::FillRule::Positive, GetPaths()->paths_,
-                           second.GetPaths()->paths_, precision_);
-  return CrossSection(shared_paths(res));
+  auto res = C2::BooleanOp(ct, C2::FillRule::Positive, GetPaths()->Fixed(),
+                           second.GetPaths()->Fixed());
+  return CrossSection(shared_paths(std::move(res)));
 }
 
 /**
  * Perform the given boolean operation on a list of CrossSections. In case of
- * Subtract, all CrossSections in the tail are differenced from the head.
+ * Subtract, all CrossSections in the tail are differenced from the head. Long
+ * lists are unioned in parallel, in spatially grouped subsets reduced as a
+ * tree.
  */
 CrossSection CrossSection::BatchBoolean(
     const std::vector<CrossSection>& crossSections, OpType op) {
@@ -384,21 +632,35 @@ CrossSection CrossSection::BatchBoolean(
     return crossSections[0];
 
   auto subjs = crossSections[0].GetPaths();
+  auto ct = cliptype_of_op(op);
+  if (crossSections.size() > kUnionLeaf) {
+    // Lazy transforms are applied serially, since the same CrossSection may
+    // appear more than once.
+    std::vector<std::shared_ptr<const PathImpl>> held;
+    std::vector<const C2::Paths64*> parts;
+    for (int i = op == OpType::Add ? 0 : 1; i < crossSections.size(); ++i) {
+      held.push_back(crossSections[i].GetPaths());
+      parts.push_back(&held.back()->Fixed());
+    }
+    auto clips = union_tree(parts);
+    if (op == OpType::Add) return CrossSection(shared_paths(std::move(clips)));
+    return CrossSection(shared_paths(
+        C2::BooleanOp(ct, C2::FillRule::Positive, subjs->Fixed(), clips)));
+  }
+
   int n_clips = 0;
   for (int i = 1; i < crossSections.size(); ++i) {
     n_clips += crossSections[i].GetPaths()->paths_.size();
   }
-  auto clips = C2::PathsD();
+  auto clips = C2::Paths64();
   clips.reserve(n_clips);
   for (int i = 1; i < crossSections.size(); ++i) {
-    auto ps = crossSections[i].GetPaths();
-    clips.insert(clips.end(), ps->paths_.begin(), ps->paths_.end());
+    const C2::Paths64& ps = crossSections[i].GetPaths()->Fixed();
+    clips.insert(clips.end(), ps.begin(), ps.end());
   }
 
-  auto ct = cliptype_of_op(op);
-  auto res = C2::BooleanOp(ct, C2::FillRule::Positive, subjs->paths_, clips,
-                           precision_);
-  return CrossSection(shared_paths(res));
+  auto res = C2::BooleanOp(ct, C2::FillRule::Positive, subjs->Fixed(), clips);
+  return CrossSection(shared_paths(std::move(res)));
 }
 
 /**
@@ -666,21 +928,50 @@ CrossSection CrossSection::Simplify(double epsilon) const {
 CrossSection CrossSection::Offset(double delta, JoinType jointype,
                                   double miter_limit,
                                   int circularSegments) const {
-  double arc_tol = 0.;
-  if (jointype == JoinType::Round) {
-    int n = circularSegments > 2 ? circularSegments
-                                 : Quality::GetCircularSegments(delta);
-    // This calculates tolerance as a function of circular segments and delta
-    // (radius) in order to get back the same number of segments in Clipper2:
-    // steps_per_360 = PI / acos(1 - arc_tol / abs_delta)
-    const double abs_delta = std::fabs(delta);
-    const double scaled_delta = abs_delta * std::pow(10, precision_);
-    arc_tol = (std::cos(Clipper2Lib::PI / n) - 1) * -scaled_delta;
-  }
-  auto ps =
-      C2::InflatePaths(GetPaths()->paths_, delta, jt(jointype),
-                       C2::EndType::Polygon, miter_limit, precision_, arc_tol);
-  return CrossSection(shared_paths(ps));
+  return CrossSection(shared_paths(inflate(
+      GetPaths()->Fixed(), delta, jt(jointype), miter_limit,
+      arc_tolerance(delta, jointype == JoinType::Round, circularSegments))));
+}
+
+/**
+ * Inflate the contours in CrossSection by each of the given deltas, as
+ * Offset does, but sharing the fixed-point paths among them and computing
+ * them in parallel. Each inset is contained in every larger one, so once an
+ * inset comes out empty, none of the smaller deltas are computed: their
+ * results are empty as well, which makes this suited to the rings of
+ * pocketing toolpaths.
+ *
+ * @param deltas The offsets to compute, in any order.
+ * @return One CrossSection per delta, in the same order.
+ */
+std::vector<CrossSection> CrossSection::Offsets(
+    const std::vector<double>& deltas, JoinType jointype, double miter_limit,
+    int circularSegments) const {
+  const int n = deltas.size();
+  std::vector<CrossSection> results(n);
+  const C2::Paths64& fixed = GetPaths()->Fixed();
+  if (fixed.empty()) return results;
+
+  std::vector<int> order(n);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&](int a, int b) { return deltas[a] > deltas[b]; });
+  // from the largest delta down, a chunk at a time, stopping at the first
+  // empty result
+  const int chunk = kOffsetChunk;
+  for (int start = 0; start < n; start += chunk) {
+    const int end = std::min(n, start + chunk);
+    for_each_n(ExecutionPolicy::Par, countAt(start), end - start, [&](int i) {
+      const double delta = deltas[order[i]];
+      results[order[i]] = CrossSection(shared_paths(inflate(
+          fixed, delta, jt(jointype), miter_limit,
+          arc_tolerance(delta, jointype == JoinType::Round,
+                        circularSegments))));
+    });
+    for (int i = start; i < end; ++i)
+      if (results[order[i]].IsEmpty()) return results;
+  }
+  return results;
 }
 
 /**
@@ -779,6 +1070,29 @@ Rect CrossSection::Bounds() const {
   return Rect({r.left, r.bottom}, {r.right, r.top});
 }
 
+/**
+ * Returns 1 for each point inside this CrossSection and 0 for each point
+ * outside, from its winding number, found in parallel on an edge hierarchy
+ * that is built on first use and kept with the paths. Construction already
+ * resolved the FillRule into non-overlapping, positively wound contours, so
+ * any nonzero winding is inside. Points on the boundary may go either way.
+ *
+ * @param points The points to test.
+ */
+std::vector<char> CrossSection::Contains(
+    VecView<const glm::vec2> points) const {
+  std::vector<char> inside(points.size(), 0);
+  auto paths = GetPaths();
+  if (paths->paths_.empty()) return inside;
+  const EdgeIndex& edges = paths->Edges();
+  for_each_n(autoPolicy(points.size()), countAt(0), points.size(), [&](int i) {
+    WindingQuery query{edges.start, edges.end, points[i]};
+    edges.collider.Nearest(query);
+    inside[i] = query.winding != 0;
+  });
+  return inside;
+}
+
 /**
  * Return the contours of this CrossSection as a Polygons.
  */
@@ -14,6 +14,7 @@
 
 #pragma once
 #include <functional>
+#include <future>
 #include <memory>
 
 #include "cross_section.h"
@@ -31,8 +32,92 @@ namespace manifold {
  */
 ExecutionParams& ManifoldParams();
 
+/**
+ * Returns the counters of the Boolean result cache. The cache is only used
+ * when ManifoldParams().booleanCacheSize is nonzero.
+ */
+BooleanCacheStats GetBooleanCacheStats();
+
+/**
+ * Drops all cached Boolean results and resets the cache counters.
+ */
+void ClearBooleanCache();
+
+/**
+ * Replaces the allocator behind all internal buffers and sets the size of the
+ * buffer pool. Buffers that are still alive are later freed through the
+ * allocator they came from, so its functions must stay callable until then.
+ */
+void SetBufferAllocator(const BufferAllocator& allocator);
+
+/**
+ * Returns all buffers held by the pool to the allocator.
+ */
+void ReleaseBufferPool();
+
+/**
+ * Runs f with the parallel work it starts confined as the context specifies.
+ * Manifolds are evaluated lazily, so f must force the evaluation itself, e.g.
+ * by calling NumTri() on the result. Exceptions thrown by f are rethrown.
+ */
+void RunInContext(const ExecutionContext& context,
+                  const std::function<void()>& f);
+
+/**
+ * Sets the element counts at or below which the parallel kernels of each cost
+ * class run serially. Only the TBB backend is affected.
+ */
+void SetParallelThresholds(const ParallelThresholds& thresholds);
+
+/**
+ * Returns the current serial cutoffs of the parallel kernels.
+ */
+ParallelThresholds GetParallelThresholds();
+
+/**
+ * Times a representative kernel of each cost class serially and in parallel
+ * over increasing sizes, applies the largest sizes at which the serial runs
+ * still win, and returns them. Takes on the order of a hundred milliseconds,
+ * so call it once at startup if the defaults do not suit the machine.
+ */
+ParallelThresholds CalibrateParallelThresholds();
+
+/**
+ * Returns the memory held by internal buffers of the given category, across
+ * all threads. Arena and pool overheads are not included.
+ */
+MemoryStats GetMemoryStats(MemoryCategory category);
+
+/**
+ * Returns the memory held by all internal buffers.
+ */
+MemoryStats GetMemoryStats();
+
+/**
+ * Restarts peak tracking from the current usage and zeroes the allocation
+ * counts, e.g. to measure a single Boolean operation.
+ */
+void ResetMemoryStats();
+
+/**
+ * Returns the stats of the last Boolean operation evaluated on the calling
+ * thread. Manifolds are evaluated lazily, so this is only meaningful right
+ * after forcing evaluation on this thread, and BatchBoolean() may evaluate
+ * its operations on other threads.
+ */
+BooleanStats GetLastBooleanStats();
+
+/**
+ * Sets a function to be called with the stats of every Boolean operation as
+ * it completes, on whichever thread evaluated it, so it must be thread-safe.
+ * Pass an empty function to stop reporting.
+ */
+void SetBooleanStatsCallback(
+    std::function<void(const BooleanStats&)> callback);
+
 class CsgNode;
 class CsgLeafNode;
+class ConvexParts;
 
 /** @ingroup Connections
  *  @{
@@ -106,6 +191,61 @@ struct MeshGL {
 
   bool Merge();
 };
+
+/**
+ * A MeshGL over caller-owned memory, e.g. a GPU staging buffer or an array
+ * from another language, so a Manifold can be built without first copying
+ * the data into a MeshGL's vectors. The fields mean the same as in MeshGL, and
+ * the memory only needs to outlive the Manifold constructor.
+ */
+struct MeshGLView {
+  uint32_t NumVert() const { return vertProperties.size() / numProp; };
+  uint32_t NumTri() const { return triVerts.size() / 3; };
+
+  uint32_t numProp = 3;
+  VecView<const float> vertProperties = {nullptr, 0};
+  VecView<const uint32_t> triVerts = {nullptr, 0};
+  VecView<const uint32_t> mergeFromVert = {nullptr, 0};
+  VecView<const uint32_t> mergeToVert = {nullptr, 0};
+  VecView<const uint32_t> runIndex = {nullptr, 0};
+  VecView<const uint32_t> runOriginalID = {nullptr, 0};
+  VecView<const float> runTransform = {nullptr, 0};
+  VecView<const uint32_t> faceID = {nullptr, 0};
+  VecView<const float> halfedgeTangent = {nullptr, 0};
+  float precision = 0;
+
+  MeshGLView() = default;
+  MeshGLView(const MeshGL& meshGL);
+};
+
+/**
+ * Receives a manifold's mesh in chunks from Manifold::StreamMesh(), for
+ * writing out results too large to copy whole into a MeshGL. Only positions
+ * and triangles are streamed, not properties.
+ */
+class MeshSink {
+ public:
+  virtual ~MeshSink() = default;
+  /// Called first. vertPos is a view of the manifold's own data, valid until
+  /// StreamMesh() returns, so it may be kept for lookups from Tris().
+  virtual void Begin(VecView<const glm::vec3> vertPos, int numTri) = 0;
+  /// Called with consecutive chunks of triangles, sorted into runs as in
+  /// MeshGL; a chunk never spans two runs. The view is only valid during the
+  /// call.
+  virtual void Tris(int firstTri, VecView<const glm::ivec3> triVerts,
+                    int originalID) = 0;
+  /// Called last.
+  virtual void End() {}
+};
+
+/**
+ * One unique mesh of a Manifold returned by Manifold::GetInstances(), with the
+ * transform placing each of its copies.
+ */
+struct MeshInstances {
+  MeshGL mesh;
+  std::vector<glm::mat4x3> transforms;
+};
 /** @} */
 
 /** @defgroup Core
@@ -126,6 +266,8 @@ class Manifold {
   Manifold& operator=(Manifold&&) noexcept;
 
   Manifold(const MeshGL&, const std::vector<float>& propertyTolerance = {});
+  Manifold(const MeshGLView&,
+           const std::vector<float>& propertyTolerance = {});
   Manifold(const Mesh&);
 
   static Manifold Smooth(const MeshGL&,
@@ -160,6 +302,11 @@ class Manifold {
   ///@{
   Mesh GetMesh() const;
   MeshGL GetMeshGL(glm::ivec3 normalIdx = glm::ivec3(0)) const;
+  bool GetMeshGL(VecView<float> vertProperties,
+                 VecView<uint32_t> triVerts) const;
+  void StreamMesh(MeshSink& sink, int chunkTri = 1 << 16) const;
+  std::vector<MeshInstances> GetInstances(
+      glm::ivec3 normalIdx = glm::ivec3(0)) const;
   bool IsEmpty() const;
   enum class Error {
     NoError,
@@ -174,6 +321,7 @@ class Manifold {
     RunIndexWrongLength,
     FaceIDWrongLength,
     InvalidConstruction,
+    Cancelled,
   };
   Error Status() const;
   int NumVert() const;
@@ -185,6 +333,7 @@ class Manifold {
   float Precision() const;
   int Genus() const;
   Properties GetProperties() const;
+  std::shared_future<void> EvaluateAsync() const;
   ///@}
 
   /** @name Mesh ID
@@ -207,13 +356,48 @@ class Manifold {
   Manifold Transform(const glm::mat4x3&) const;
   Manifold Mirror(glm::vec3) const;
   Manifold Warp(std::function<void(glm::vec3&)>) const;
+  /**
+   * Same as the std::function overload of Warp, but for any callable taking a
+   * glm::vec3&, which is compiled into the loop over the vertices so it can be
+   * inlined.
+   */
+  template <typename Func>
+  Manifold Warp(Func warpFunc) const {
+    return WarpBatch([&warpFunc](VecView<glm::vec3> vecs) {
+      for (glm::vec3& v : vecs) warpFunc(v);
+    });
+  }
   Manifold WarpBatch(std::function<void(VecView<glm::vec3>)>) const;
   Manifold SetProperties(
       int, std::function<void(float*, glm::vec3, const float*)>) const;
+  /**
+   * Same as the std::function overload of SetProperties, but for any callable
+   * with the same arguments, which is compiled into the loop over the
+   * property vertices so it can be inlined.
+   */
+  template <typename Func>
+  Manifold SetProperties(int numProp, Func propFunc) const {
+    const int oldNumProp = NumProp();
+    return SetPropertiesBatch(
+        numProp, [&propFunc, numProp, oldNumProp](
+                     VecView<float> newProp, VecView<const glm::vec3> position,
+                     VecView<const float> oldProp) {
+          for (int i = 0; i < position.size(); ++i) {
+            propFunc(newProp.begin() + numProp * i, position[i],
+                     oldProp.begin() + oldNumProp * i);
+          }
+        });
+  }
+  Manifold SetPropertiesBatch(
+      int, std::function<void(VecView<float>, VecView<const glm::vec3>,
+                              VecView<const float>)>) const;
   Manifold CalculateCurvature(int gaussianIdx, int meanIdx) const;
   Manifold Refine(int) const;
-  // Manifold RefineToLength(float);
-  // Manifold RefineToPrecision(float);
+  Manifold RefineToLength(float) const;
+  Manifold RefineToPrecision(float) const;
+  Manifold Simplify(
+      int targetTris,
+      float maxError = std::numeric_limits<float>::infinity()) const;
   ///@}
 
   /** @name Boolean
@@ -240,6 +424,7 @@ class Manifold {
    */
   ///@{
   CrossSection Slice(float height = 0) const;
+  std::vector<CrossSection> Slices(const std::vector<float>& heights) const;
   CrossSection Project() const;
   ///@}
 
@@ -261,7 +446,21 @@ class Manifold {
   //std::vector<Manifold> Fracture(const std::vector<glm::vec3>& pts,
   //                               const std::vector<float>& weights) const;
   std::vector<int> ReflexFaces(double tolerance = 1e-8) const;
-  std::vector<Manifold> ConvexDecomposition() const;
+  std::vector<Manifold> ConvexDecomposition(double tolerance = 1e-9) const;
+  std::vector<Manifold> ApproxConvexDecomposition(double concavity = 0.05,
+                                                  int maxParts = 64) const;
+  ///@}
+
+  /** @name Spatial queries
+   *  Batched queries against the surface, run in parallel on the existing face
+   * collider.
+   */
+  ///@{
+  std::vector<RayHit> RayCast(const std::vector<glm::vec3>& origins,
+                              const std::vector<glm::vec3>& directions) const;
+  std::vector<SurfacePoint> ClosestPoint(
+      const std::vector<glm::vec3>& points) const;
+  std::vector<char> Contains(VecView<const glm::vec3> points) const;
   ///@}
 
   /** @name Minkowski Functions
@@ -269,6 +468,16 @@ class Manifold {
   ///@{
   static Manifold Minkowski(const Manifold& a, const Manifold& b,
                             bool useNaive = false);
+  static Manifold Minkowski(const ConvexParts& a, const ConvexParts& b);
+  Manifold Offset(float delta, float edgeLength = 0) const;
+  ///@}
+
+  /** @name Serialization
+   *  A fast binary snapshot of the internal representation, for caching
+   */
+  ///@{
+  std::vector<char> Serialize() const;
+  static Manifold Deserialize(const char* data, size_t size);
   ///@}
 
   /** @name Testing hooks
@@ -288,7 +497,74 @@ class Manifold {
   static Manifold Invalid();
   mutable std::shared_ptr<CsgNode> pNode_;
 
+  std::shared_ptr<CsgNode> GetNode() const;
   CsgLeafNode& GetCsgLeafNode() const;
 };
+
+/**
+ * The convex decomposition of a Manifold, computed once so it can be stored
+ * and reused, e.g. to take the Minkowski sum of the same tool with many
+ * parts without decomposing it each time. Transforms apply lazily to every
+ * part, so they are cheap.
+ */
+class ConvexParts {
+ public:
+  ConvexParts() {}
+  explicit ConvexParts(const Manifold& manifold, double tolerance = 1e-9);
+  /// Wraps parts that are already convex, without checking.
+  static ConvexParts FromParts(const std::vector<Manifold>& parts);
+
+  const std::vector<Manifold>& Parts() const { return parts_; }
+  int NumParts() const { return parts_.size(); }
+  bool IsEmpty() const { return parts_.empty(); }
+  /// The union of the parts.
+  Manifold ToManifold() const;
+
+  ConvexParts Transform(const glm::mat4x3&) const;
+  ConvexParts Translate(glm::vec3) const;
+  ConvexParts Scale(glm::vec3) const;
+  ConvexParts Rotate(float xDegrees, float yDegrees = 0.0f,
+                     float zDegrees = 0.0f) const;
+
+ private:
+  std::vector<Manifold> parts_;
+};
+
+/**
+ * An editable CSG tree that keeps the result of every intermediate Boolean.
+ * Each op node reduces its operands with a balanced binary tree of Booleans,
+ * so replacing a leaf only recomputes the Booleans on the path from that leaf
+ * to the evaluated node, O(depth) instead of the whole tree. Nodes are
+ * referred to by the index returned when they are added, and may be shared
+ * by several parents.
+ */
+class CsgEditor {
+ public:
+  CsgEditor();
+  ~CsgEditor();
+  CsgEditor(CsgEditor&&);
+  CsgEditor& operator=(CsgEditor&&);
+
+  /// Adds a leaf holding the manifold, returning its node index.
+  int AddLeaf(const Manifold& manifold);
+  /// Adds a node applying op to the results of the given existing nodes,
+  /// returning its node index. Subtract removes the union of the tail from
+  /// the head, so it needs at least one child.
+  int AddOp(OpType op, const std::vector<int>& children);
+  /// Replaces the manifold of a leaf, invalidating its ancestors; nothing is
+  /// recomputed until one of them is evaluated.
+  void SetLeaf(int node, const Manifold& manifold);
+  /// The result of the node, recomputing only the Booleans invalidated by
+  /// SetLeaf() since its last evaluation.
+  Manifold Evaluate(int node);
+  /// The number of nodes added so far; node indices run from 0 to this.
+  int NumNodes() const;
+
+ private:
+  struct Node;
+  std::vector<std::unique_ptr<Node>> nodes_;
+
+  void MarkDirty(int node);
+};
 /** @} */
 }  // namespace manifold
@@ -27,34 +27,54 @@ namespace {
 // carefully designed to minimize rounding error and to eliminate it at edge
 // cases to ensure consistency.
 
-glm::vec2 Interpolate(glm::vec3 pL, glm::vec3 pR, float x) {
-  const float dxL = x - pL.x;
-  const float dxR = x - pR.x;
+// Both are templated on the scalar type of their arithmetic, and the Boolean
+// uses KernelReal, which the MANIFOLD_DOUBLE_KERNELS build option widens to
+// double. Positions are stored as float either way, so this only removes the
+// rounding of the intermediates, at no run-time branch.
+#ifdef MANIFOLD_DOUBLE_KERNELS
+using KernelReal = double;
+#else
+using KernelReal = float;
+#endif
+
+template <typename Real = KernelReal>
+glm::vec2 Interpolate(glm::vec3 left, glm::vec3 right, float x) {
+  using RealVec3 = glm::tvec3<Real>;
+  const RealVec3 pL(left);
+  const RealVec3 pR(right);
+  const Real dxL = x - pL.x;
+  const Real dxR = x - pR.x;
   ASSERT(dxL * dxR <= 0, logicErr, "Boolean manifold error: not in domain");
   const bool useL = fabs(dxL) < fabs(dxR);
-  const glm::vec3 dLR = pR - pL;
-  const float lambda = (useL ? dxL : dxR) / dLR.x;
+  const RealVec3 dLR = pR - pL;
+  const Real lambda = (useL ? dxL : dxR) / dLR.x;
   if (!isfinite(lambda) || !isfinite(dLR.y) || !isfinite(dLR.z))
-    return glm::vec2(pL.y, pL.z);
+    return glm::vec2(left.y, left.z);
   glm::vec2 yz;
   yz[0] = (useL ? pL.y : pR.y) + lambda * dLR.y;
   yz[1] = (useL ? pL.z : pR.z) + lambda * dLR.z;
   return yz;
 }
 
-glm::vec4 Intersect(const glm::vec3 &pL, const glm::vec3 &pR,
-                    const glm::vec3 &qL, const glm::vec3 &qR) {
-  const float dyL = qL.y - pL.y;
-  const float dyR = qR.y - pR.y;
+template <typename Real = KernelReal>
+glm::vec4 Intersect(const glm::vec3 &leftP, const glm::vec3 &rightP,
+                    const glm::vec3 &leftQ, const glm::vec3 &rightQ) {
+  using RealVec3 = glm::tvec3<Real>;
+  const RealVec3 pL(leftP);
+  const RealVec3 pR(rightP);
+  const RealVec3 qL(leftQ);
+  const RealVec3 qR(rightQ);
+  const Real dyL = qL.y - pL.y;
+  const Real dyR = qR.y - pR.y;
   ASSERT(dyL * dyR <= 0, logicErr, "Boolean manifold error: no intersection");
   const bool useL = fabs(dyL) < fabs(dyR);
-  const float dx = pR.x - pL.x;
-  float lambda = (useL ? dyL : dyR) / (dyL - dyR);
-  if (!isfinite(lambda)) lambda = 0.0f;
+  const Real dx = pR.x - pL.x;
+  Real lambda = (useL ? dyL : dyR) / (dyL - dyR);
+  if (!isfinite(lambda)) lambda = 0;
   glm::vec4 xyzz;
   xyzz.x = (useL ? pL.x : pR.x) + lambda * dx;
-  const float pDy = pR.y - pL.y;
-  const float qDy = qR.y - qL.y;
+  const Real pDy = pR.y - pL.y;
+  const Real qDy = qR.y - qL.y;
   const bool useP = fabs(pDy) < fabs(qDy);
   xyzz.y = (useL ? (useP ? pL.y : qL.y) : (useP ? pR.y : qR.y)) +
            lambda * (useP ? pDy : qDy);
@@ -63,13 +83,15 @@ glm::vec4 Intersect(const glm::vec3 &pL, const glm::vec3 &pR,
   return xyzz;
 }
 
-template <const bool inverted>
+// The kernels below are templated on Edges, which is either
+// VecView<const Halfedge> or CompactHalfedges::View.
+template <const bool inverted, typename Edges>
 struct CopyFaceEdges {
   const SparseIndices &p1q1;
   // const int *p1q1;
   // x can be either vert or edge (0 or 1).
   SparseIndices &pXq1;
-  VecView<const Halfedge> halfedgesQ;
+  Edges halfedgesQ;
 
   void operator()(thrust::tuple<int, int> in) {
     int idx = 3 * thrust::get<0>(in);
@@ -88,28 +110,32 @@ struct CopyFaceEdges {
   }
 };
 
-SparseIndices Filter11(const Manifold::Impl &inP, const Manifold::Impl &inQ,
+template <typename Edges>
+SparseIndices Filter11(const Edges &halfedgeP, const Edges &halfedgeQ,
                        const SparseIndices &p1q2, const SparseIndices &p2q1) {
   ZoneScoped;
   SparseIndices p1q1(3 * p1q2.size() + 3 * p2q1.size());
   for_each_n(autoPolicy(p1q2.size()), zip(countAt(0), countAt(0)), p1q2.size(),
-             CopyFaceEdges<false>({p1q2, p1q1, inQ.halfedge_}));
+             CopyFaceEdges<false, Edges>({p1q2, p1q1, halfedgeQ}));
   for_each_n(autoPolicy(p2q1.size()), zip(countAt(p1q2.size()), countAt(0)),
-             p2q1.size(), CopyFaceEdges<true>({p2q1, p1q1, inP.halfedge_}));
+             p2q1.size(), CopyFaceEdges<true, Edges>({p2q1, p1q1, halfedgeP}));
   p1q1.Unique();
   return p1q1;
 }
 
+// Written without a branch so that the kernels below compile to selects; the
+// result is the same as p == q ? dir < 0 : p < q.
 inline bool Shadows(float p, float q, float dir) {
-  return p == q ? dir < 0 : p < q;
+  return (p < q) | ((p == q) & (dir < 0));
 }
 
+// The shadow of vert p0 on the forward edge from q1s to q1e. The verts are
+// passed directly, so that callers gather each edge from the halfedges only
+// once.
 inline thrust::pair<int, glm::vec2> Shadow01(
-    const int p0, const int q1, VecView<const glm::vec3> vertPosP,
-    VecView<const glm::vec3> vertPosQ, VecView<const Halfedge> halfedgeQ,
+    const int p0, const int q1s, const int q1e,
+    VecView<const glm::vec3> vertPosP, VecView<const glm::vec3> vertPosQ,
     const float expandP, VecView<const glm::vec3> normalP, const bool reverse) {
-  const int q1s = halfedgeQ[q1].startVert;
-  const int q1e = halfedgeQ[q1].endVert;
   const float p0x = vertPosP[p0].x;
   const float q1sx = vertPosQ[q1s].x;
   const float q1ex = vertPosQ[q1e].x;
@@ -174,11 +200,12 @@ int monobound_quaternary_search(VecView<const int64_t> array, int64_t key) {
   return -1;
 }
 
+template <typename Edges>
 struct Kernel11 {
   VecView<const glm::vec3> vertPosP;
   VecView<const glm::vec3> vertPosQ;
-  VecView<const Halfedge> halfedgeP;
-  VecView<const Halfedge> halfedgeQ;
+  Edges halfedgeP;
+  Edges halfedgeQ;
   float expandP;
   VecView<const glm::vec3> normalP;
   const SparseIndices &p1q1;
@@ -197,10 +224,13 @@ struct Kernel11 {
     bool shadows = false;
     s11 = 0;
 
-    const int p0[2] = {halfedgeP[p1].startVert, halfedgeP[p1].endVert};
+    const Halfedge edgeP = halfedgeP[p1];
+    const Halfedge edgeQ = halfedgeQ[q1];
+    const int p0[2] = {edgeP.startVert, edgeP.endVert};
     for (int i : {0, 1}) {
-      const auto syz01 = Shadow01(p0[i], q1, vertPosP, vertPosQ, halfedgeQ,
-                                  expandP, normalP, false);
+      const auto syz01 =
+          Shadow01(p0[i], edgeQ.startVert, edgeQ.endVert, vertPosP, vertPosQ,
+                   expandP, normalP, false);
       const int s01 = syz01.first;
       const glm::vec2 yz01 = syz01.second;
       // If the value is NaN, then these do not overlap.
@@ -215,10 +245,11 @@ struct Kernel11 {
       }
     }
 
-    const int q0[2] = {halfedgeQ[q1].startVert, halfedgeQ[q1].endVert};
+    const int q0[2] = {edgeQ.startVert, edgeQ.endVert};
     for (int i : {0, 1}) {
-      const auto syz10 = Shadow01(q0[i], p1, vertPosQ, vertPosP, halfedgeP,
-                                  expandP, normalP, true);
+      const auto syz10 =
+          Shadow01(q0[i], edgeP.startVert, edgeP.endVert, vertPosQ, vertPosP,
+                   expandP, normalP, true);
       const int s10 = syz10.first;
       const glm::vec2 yz10 = syz10.second;
       // If the value is NaN, then these do not overlap.
@@ -239,8 +270,8 @@ struct Kernel11 {
       ASSERT(k == 2, logicErr, "Boolean manifold error: s11");
       xyzz11 = Intersect(pRL[0], pRL[1], qRL[0], qRL[1]);
 
-      const int p1s = halfedgeP[p1].startVert;
-      const int p1e = halfedgeP[p1].endVert;
+      const int p1s = edgeP.startVert;
+      const int p1e = edgeP.endVert;
       glm::vec3 diff = vertPosP[p1s] - glm::vec3(xyzz11);
       const float start2 = glm::dot(diff, diff);
       diff = vertPosP[p1e] - glm::vec3(xyzz11);
@@ -252,27 +283,28 @@ struct Kernel11 {
   }
 };
 
-std::tuple<Vec<int>, Vec<glm::vec4>> Shadow11(SparseIndices &p1q1,
-                                              const Manifold::Impl &inP,
-                                              const Manifold::Impl &inQ,
-                                              float expandP) {
+template <typename Edges>
+std::tuple<Vec<int>, Vec<glm::vec4>> Shadow11(
+    SparseIndices &p1q1, const Manifold::Impl &inP, const Manifold::Impl &inQ,
+    const Edges &halfedgeP, const Edges &halfedgeQ, float expandP) {
   ZoneScoped;
   Vec<int> s11(p1q1.size());
   Vec<glm::vec4> xyzz11(p1q1.size());
 
-  for_each_n(autoPolicy(p1q1.size()),
+  for_each_n(autoPolicy(p1q1.size(), KernelCost::Heavy),
              zip(countAt(0), xyzz11.begin(), s11.begin()), p1q1.size(),
-             Kernel11({inP.vertPos_, inQ.vertPos_, inP.halfedge_, inQ.halfedge_,
-                       expandP, inP.vertNormal_, p1q1}));
+             Kernel11<Edges>({inP.vertPos_, inQ.vertPos_, halfedgeP, halfedgeQ,
+                              expandP, inP.vertNormal_, p1q1}));
 
   p1q1.KeepFinite(xyzz11, s11);
 
   return std::make_tuple(s11, xyzz11);
 };
 
+template <typename Edges>
 struct Kernel02 {
   VecView<const glm::vec3> vertPosP;
-  VecView<const Halfedge> halfedgeQ;
+  Edges halfedgeQ;
   VecView<const glm::vec3> vertPosQ;
   const float expandP;
   VecView<const glm::vec3> vertNormalP;
@@ -299,10 +331,13 @@ struct Kernel02 {
     for (const int i : {0, 1, 2}) {
       const int q1 = 3 * q2 + i;
       const Halfedge edge = halfedgeQ[q1];
-      const int q1F = edge.IsForward() ? q1 : edge.pairedHalfedge;
+      // The verts of the forward halfedge of this edge, which is its pair
+      // reversed, so it need not be gathered.
+      const int q1s = edge.IsForward() ? edge.startVert : edge.endVert;
+      const int q1e = edge.IsForward() ? edge.endVert : edge.startVert;
 
       if (!forward) {
-        const int qVert = halfedgeQ[q1F].startVert;
+        const int qVert = q1s;
         const glm::vec3 diff = posP - vertPosQ[qVert];
         const float metric = glm::dot(diff, diff);
         if (metric < minMetric) {
@@ -311,8 +346,8 @@ struct Kernel02 {
         }
       }
 
-      const auto syz01 = Shadow01(p0, q1F, vertPosP, vertPosQ, halfedgeQ,
-                                  expandP, vertNormalP, !forward);
+      const auto syz01 = Shadow01(p0, q1s, q1e, vertPosP, vertPosQ, expandP,
+                                  vertNormalP, !forward);
       const int s01 = syz01.first;
       const glm::vec2 yz01 = syz01.second;
       // If the value is NaN, then these do not overlap.
@@ -342,8 +377,10 @@ struct Kernel02 {
   }
 };
 
+template <typename Edges>
 std::tuple<Vec<int>, Vec<float>> Shadow02(const Manifold::Impl &inP,
                                           const Manifold::Impl &inQ,
+                                          const Edges &halfedgeQ,
                                           SparseIndices &p0q2, bool forward,
                                           float expandP) {
   ZoneScoped;
@@ -351,16 +388,17 @@ std::tuple<Vec<int>, Vec<float>> Shadow02(const Manifold::Impl &inP,
   Vec<float> z02(p0q2.size());
 
   auto vertNormalP = forward ? inP.vertNormal_ : inQ.vertNormal_;
-  for_each_n(autoPolicy(p0q2.size()), zip(countAt(0), s02.begin(), z02.begin()),
-             p0q2.size(),
-             Kernel02({inP.vertPos_, inQ.halfedge_, inQ.vertPos_, expandP,
-                       vertNormalP, p0q2, forward}));
+  for_each_n(autoPolicy(p0q2.size(), KernelCost::Heavy),
+             zip(countAt(0), s02.begin(), z02.begin()), p0q2.size(),
+             Kernel02<Edges>({inP.vertPos_, halfedgeQ, inQ.vertPos_, expandP,
+                              vertNormalP, p0q2, forward}));
 
   p0q2.KeepFinite(z02, s02);
 
   return std::make_tuple(s02, z02);
 };
 
+template <typename Edges>
 struct Kernel12 {
   VecView<const int64_t> p0q2;
   VecView<const int> s02;
@@ -368,8 +406,8 @@ struct Kernel12 {
   VecView<const int64_t> p1q1;
   VecView<const int> s11;
   VecView<const glm::vec4> xyzz11;
-  VecView<const Halfedge> halfedgesP;
-  VecView<const Halfedge> halfedgesQ;
+  Edges halfedgesP;
+  Edges halfedgesQ;
   VecView<const glm::vec3> vertPosP;
   const bool forward;
   const SparseIndices &p1q2;
@@ -446,20 +484,22 @@ struct Kernel12 {
   }
 };
 
+template <typename Edges>
 std::tuple<Vec<int>, Vec<glm::vec3>> Intersect12(
-    const Manifold::Impl &inP, const Manifold::Impl &inQ, const Vec<int> &s02,
-    const SparseIndices &p0q2, const Vec<int> &s11, const SparseIndices &p1q1,
-    const Vec<float> &z02, const Vec<glm::vec4> &xyzz11, SparseIndices &p1q2,
-    bool forward) {
+    const Manifold::Impl &inP, const Edges &halfedgeP, const Edges &halfedgeQ,
+    const Vec<int> &s02, const SparseIndices &p0q2, const Vec<int> &s11,
+    const SparseIndices &p1q1, const Vec<float> &z02,
+    const Vec<glm::vec4> &xyzz11, SparseIndices &p1q2, bool forward) {
   ZoneScoped;
   Vec<int> x12(p1q2.size());
   Vec<glm::vec3> v12(p1q2.size());
 
   for_each_n(
-      autoPolicy(p1q2.size()), zip(countAt(0), x12.begin(), v12.begin()),
+      autoPolicy(p1q2.size(), KernelCost::Heavy),
+      zip(countAt(0), x12.begin(), v12.begin()),
       p1q2.size(),
-      Kernel12({p0q2.AsVec64(), s02, z02, p1q1.AsVec64(), s11, xyzz11,
-                inP.halfedge_, inQ.halfedge_, inP.vertPos_, forward, p1q2}));
+      Kernel12<Edges>({p0q2.AsVec64(), s02, z02, p1q1.AsVec64(), s11, xyzz11,
+                       halfedgeP, halfedgeQ, inP.vertPos_, forward, p1q2}));
 
   p1q2.KeepFinite(v12, x12);
 
@@ -493,6 +533,55 @@ Vec<int> Winding03(const Manifold::Impl &inP, Vec<int> &vertices, Vec<int> &s02,
               thrust::negate<int>());
   return w03;
 };
+
+/**
+ * Winding numbers of the verts of inP with respect to inQ, for the case where
+ * no edge of either mesh collides with a face of the other. The winding number
+ * is then constant over each connected component of inP, so only one vertex
+ * per component is shadow-tested and its value is copied to the rest.
+ */
+Vec<int> ComponentWinding03(const Manifold::Impl &inP,
+                            const Manifold::Impl &inQ, float expandP,
+                            bool forward) {
+  ZoneScoped;
+  UnionFind<> uf(inP.NumVert());
+  for (const Halfedge &edge : inP.halfedge_) {
+    if (edge.startVert < 0 || !edge.IsForward()) continue;
+    uf.unionXY(edge.startVert, edge.endVert);
+  }
+  std::vector<int> components;
+  const int numComponent = uf.connectedComponents(components);
+
+  std::vector<int> compVert(numComponent, -1);
+  Vec<int> repVert;
+  Vec<glm::vec3> repPos;
+  for (int vert = 0; vert < inP.NumVert(); ++vert) {
+    int &rep = compVert[components[vert]];
+    if (rep >= 0) continue;
+    rep = vert;
+    repVert.push_back(vert);
+    repPos.push_back(inP.vertPos_[vert]);
+  }
+
+  SparseIndices p0q2 = inQ.VertexCollisionsZ(repPos, !forward);
+  for (int i = 0; i < p0q2.size(); ++i) {
+    int &vert = p0q2.Get(i, !forward);
+    vert = repVert[vert];
+  }
+  p0q2.Sort();
+
+  Vec<int> s02;
+  Vec<float> z02;
+  std::tie(s02, z02) = Shadow02<VecView<const Halfedge>>(
+      inP, inQ, inQ.halfedge_, p0q2, forward, expandP);
+  Vec<int> p0 = p0q2.Copy(!forward);
+  Vec<int> w03 = Winding03(inP, p0, s02, !forward);
+
+  for (int vert = 0; vert < inP.NumVert(); ++vert) {
+    w03[vert] = w03[compVert[components[vert]]];
+  }
+  return w03;
+}
 }  // namespace
 
 namespace manifold {
@@ -503,15 +592,32 @@ Boolean3::Boolean3(const Manifold::Impl &inP, const Manifold::Impl &inQ,
   // Union -> expand inP
   // Difference, Intersection -> contract inP
 
-#ifdef MANIFOLD_DEBUG
-  Timer broad;
-  broad.Start();
+  // All Vecs allocated by this thread during Intersect(), i.e. the
+  // intermediates and the member arrays, come from arena_. The work is
+  // isolated so that this thread cannot pick up an unrelated task while it
+  // waits, whose long-lived allocations would otherwise land in arena_.
+  Arena::Scope arenaScope(&arena_);
+#if MANIFOLD_PAR == 'T'
+  tbb::this_task_arena::isolate([this]() { Intersect(); });
+#else
+  Intersect();
 #endif
+  PRINT("arena: " << arena_.InUse() << " bytes retained, " << arena_.Peak()
+                  << " peak, " << arena_.Total() << " total");
+}
+
+void Boolean3::Intersect() {
+  const Manifold::Impl &inP = inP_;
+  const Manifold::Impl &inQ = inQ_;
+
+  PhaseTimer timer;
+  if (Cancelled()) return;
 
   if (inP.IsEmpty() || inQ.IsEmpty() || !inP.bBox_.DoesOverlap(inQ.bBox_)) {
     PRINT("No overlap, early out");
     w03_.resize(inP.NumVert(), 0);
     w30_.resize(inQ.NumVert(), 0);
+    stats_.broadPhase = timer.Lap();
     return;
   }
 
@@ -525,6 +631,17 @@ Boolean3::Boolean3(const Manifold::Impl &inP, const Manifold::Impl &inQ,
 
   p2q1_.Sort();
   PRINT("p2q1 size = " << p2q1_.size());
+  stats_.edgeCollisions = p1q2_.size() + p2q1_.size();
+
+  if (p1q2_.size() == 0 && p2q1_.size() == 0) {
+    // No surface intersections, so each component of one mesh is entirely
+    // inside or outside of the other; skip straight to the winding numbers.
+    PRINT("No edge collisions, component winding only");
+    w03_ = ComponentWinding03(inP, inQ, expandP_, true);
+    w30_ = ComponentWinding03(inQ, inP, expandP_, false);
+    stats_.broadPhase = timer.Lap();
+    return;
+  }
 
   // Level 2
   // Find vertices that overlap faces in XY-projection
@@ -535,48 +652,75 @@ Boolean3::Boolean3(const Manifold::Impl &inP, const Manifold::Impl &inQ,
   SparseIndices p2q0 = inP.VertexCollisionsZ(inQ.vertPos_, true);  // inverted
   p2q0.Sort();
   PRINT("p2q0 size = " << p2q0.size());
+  stats_.vertCollisions = p0q2.size() + p2q0.size();
+  stats_.broadPhase = timer.Lap();
+  if (Cancelled()) return;
+
+  if (ManifoldParams().compactHalfedges) {
+    // The kernels gather halfedges at random, so on large meshes the copies
+    // pay for themselves by halving the bytes each gather pulls in.
+    const CompactHalfedges halfedgeP(inP.halfedge_);
+    const CompactHalfedges halfedgeQ(inQ.halfedge_);
+    Intersect(p0q2, p2q0, halfedgeP.view(), halfedgeQ.view());
+  } else {
+    Intersect<VecView<const Halfedge>>(p0q2, p2q0, inP.halfedge_,
+                                       inQ.halfedge_);
+  }
+}
+
+template <typename Edges>
+void Boolean3::Intersect(SparseIndices &p0q2, SparseIndices &p2q0,
+                         const Edges &halfedgeP, const Edges &halfedgeQ) {
+  const Manifold::Impl &inP = inP_;
+  const Manifold::Impl &inQ = inQ_;
+  PhaseTimer timer;
 
   // Find involved edge pairs from Level 3
-  SparseIndices p1q1 = Filter11(inP_, inQ_, p1q2_, p2q1_);
+  SparseIndices p1q1 = Filter11(halfedgeP, halfedgeQ, p1q2_, p2q1_);
   PRINT("p1q1 size = " << p1q1.size());
-
-#ifdef MANIFOLD_DEBUG
-  broad.Stop();
-  Timer intersections;
-  intersections.Start();
-#endif
+  stats_.edgeEdgePairs = p1q1.size();
+  stats_.filter11 = timer.Lap();
+  if (Cancelled()) return;
 
   // Level 2
   // Build up XY-projection intersection of two edges, including the z-value for
   // each edge, keeping only those whose intersection exists.
   Vec<int> s11;
   Vec<glm::vec4> xyzz11;
-  std::tie(s11, xyzz11) = Shadow11(p1q1, inP, inQ, expandP_);
+  std::tie(s11, xyzz11) =
+      Shadow11(p1q1, inP, inQ, halfedgeP, halfedgeQ, expandP_);
   PRINT("s11 size = " << s11.size());
+  stats_.shadow11 = timer.Lap();
+  if (Cancelled()) return;
 
   // Build up Z-projection of vertices onto triangles, keeping only those that
   // fall inside the triangle.
   Vec<int> s02;
   Vec<float> z02;
-  std::tie(s02, z02) = Shadow02(inP, inQ, p0q2, true, expandP_);
+  std::tie(s02, z02) = Shadow02(inP, inQ, halfedgeQ, p0q2, true, expandP_);
   PRINT("s02 size = " << s02.size());
 
   Vec<int> s20;
   Vec<float> z20;
-  std::tie(s20, z20) = Shadow02(inQ, inP, p2q0, false, expandP_);
+  std::tie(s20, z20) = Shadow02(inQ, inP, halfedgeP, p2q0, false, expandP_);
   PRINT("s20 size = " << s20.size());
+  stats_.shadow02 = timer.Lap();
+  if (Cancelled()) return;
 
   // Level 3
   // Build up the intersection of the edges and triangles, keeping only those
   // that intersect, and record the direction the edge is passing through the
   // triangle.
-  std::tie(x12_, v12_) =
-      Intersect12(inP, inQ, s02, p0q2, s11, p1q1, z02, xyzz11, p1q2_, true);
+  std::tie(x12_, v12_) = Intersect12(inP, halfedgeP, halfedgeQ, s02, p0q2, s11,
+                                     p1q1, z02, xyzz11, p1q2_, true);
   PRINT("x12 size = " << x12_.size());
 
-  std::tie(x21_, v21_) =
-      Intersect12(inQ, inP, s20, p2q0, s11, p1q1, z20, xyzz11, p2q1_, false);
+  std::tie(x21_, v21_) = Intersect12(inQ, halfedgeQ, halfedgeP, s20, p2q0, s11,
+                                     p1q1, z20, xyzz11, p2q1_, false);
   PRINT("x21 size = " << x21_.size());
+  stats_.intersections = x12_.size() + x21_.size();
+  stats_.intersect12 = timer.Lap();
+  if (Cancelled()) return;
 
   Vec<int> p0 = p0q2.Copy(false);
   p0q2.Resize(0);
@@ -586,14 +730,6 @@ Boolean3::Boolean3(const Manifold::Impl &inP, const Manifold::Impl &inQ,
   w03_ = Winding03(inP, p0, s02, false);
 
   w30_ = Winding03(inQ, q0, s20, true);
-
-#ifdef MANIFOLD_DEBUG
-  intersections.Stop();
-
-  if (ManifoldParams().verbose) {
-    broad.Print("Broad phase");
-    intersections.Print("Intersections");
-  }
-#endif
+  stats_.winding03 = timer.Lap();
 }
 }  // namespace manifold
@@ -13,6 +13,9 @@
 // limitations under the License.
 
 #pragma once
+#include <atomic>
+#include <chrono>
+
 #include "impl.h"
 
 #ifdef MANIFOLD_DEBUG
@@ -44,17 +47,58 @@
 
 namespace manifold {
 
+/** @ingroup Private */
+class PhaseTimer {
+ public:
+  PhaseTimer() : last_(std::chrono::steady_clock::now()) {}
+  /// Returns the milliseconds since construction or the previous Lap().
+  double Lap() {
+    const auto now = std::chrono::steady_clock::now();
+    const double ms =
+        std::chrono::duration<double, std::milli>(now - last_).count();
+    last_ = now;
+    return ms;
+  }
+
+ private:
+  std::chrono::steady_clock::time_point last_;
+};
+
 /** @ingroup Private */
 class Boolean3 {
  public:
   Boolean3(const Manifold::Impl& inP, const Manifold::Impl& inQ, OpType op);
   Manifold::Impl Result(OpType op) const;
+  // Result(OpType::Intersect) and Result(OpType::Subtract), assembled
+  // concurrently.
+  std::pair<Manifold::Impl, Manifold::Impl> Split() const;
 
  private:
+  // Backs the intermediate buffers below, which are all released together
+  // when Boolean3 is destroyed; declared first so that it is destroyed last.
+  Arena arena_;
   const Manifold::Impl &inP_, &inQ_;
   const float expandP_;
   SparseIndices p1q2_, p2q1_;
   Vec<int> x12_, x21_, w03_, w30_;
   Vec<glm::vec3> v12_, v21_;
+  // The intersection phases, shared by every Result().
+  BooleanStats stats_;
+  mutable std::atomic<bool> cancelled_{false};
+
+  // Polled between phases; once true, the remaining phases are skipped and
+  // Result() gives status Cancelled.
+  bool Cancelled() const {
+    if (!cancelled_.load(std::memory_order_relaxed) && Cancellation::Check())
+      cancelled_.store(true, std::memory_order_relaxed);
+    return cancelled_.load(std::memory_order_relaxed);
+  }
+
+  void Intersect();
+  Manifold::Impl Assemble(OpType op, BooleanStats& stats) const;
+  void Report(BooleanStats& stats, const Manifold::Impl& outR) const;
+  template <typename Edges>
+  void Intersect(SparseIndices& p0q2, SparseIndices& p2q0,
+                 const Edges& halfedgeP, const Edges& halfedgeQ);
 };
 }  // namespace manifold
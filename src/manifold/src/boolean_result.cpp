@@ -15,11 +15,14 @@
 #include <algorithm>
 #include <array>
 #include <map>
+#include <memory>
+#include <mutex>
 
 #if MANIFOLD_PAR == 'T' && __has_include(<tbb/concurrent_map.h>)
 #define TBB_PREVIEW_CONCURRENT_ORDERED_CONTAINERS 1
 #include <tbb/concurrent_map.h>
 #include <tbb/parallel_for.h>
+#include <tbb/task_group.h>
 
 template <typename K, typename V>
 using concurrent_map = tbb::concurrent_map<K, V>;
@@ -208,11 +211,13 @@ void AddNewEdgeVerts(
 #if MANIFOLD_PAR == 'T' && __has_include(<tbb/tbb.h>)
   // parallelize operations, requires concurrent_map so we can only enable this
   // with tbb
-  if (!ManifoldParams().deterministic && p1q2.size() > kParallelThreshold) {
+  if (!ManifoldParams().deterministic && !SerialScope::Active() &&
+      p1q2.size() > kParallelThreshold) {
     // ideally we should have 1 mutex per key, but kParallelThreshold is enough
     // to avoid contention for most of the cases
     std::array<std::mutex, kParallelThreshold> mutexes;
-    static tbb::affinity_partitioner ap;
+    // per thread, as Boolean3::Split() assembles two results at once
+    static thread_local tbb::affinity_partitioner ap;
     auto processFun = std::bind(
         process, [&](size_t hash) { mutexes[hash % mutexes.size()].lock(); },
         [&](size_t hash) { mutexes[hash % mutexes.size()].unlock(); },
@@ -452,6 +457,56 @@ void AppendWholeEdges(Manifold::Impl &outR, Vec<int> &facePtrR,
                                  inP.halfedge_, i03, vP2R, faceP2R, forward}));
 }
 
+/**
+ * Marks the verts of all output triangles that come from a face of P or Q that
+ * was cut by the other mesh. Every other triangle is a whole copy of an input
+ * triangle, so its neighborhood is already simplified. Returns an empty vector,
+ * meaning everything is touched, when that does not hold: when the inputs
+ * aren't known to be clean (ManifoldParams().cleanInputs), when the output
+ * precision is coarser than an input's, or when verts were duplicated.
+ * Must be called before UpdateReference, while triRef.tri is the input face.
+ */
+Vec<char> TouchedVerts(const Manifold::Impl &outR, const Manifold::Impl &inP,
+                       const Manifold::Impl &inQ, const SparseIndices &p1q2,
+                       const SparseIndices &p2q1, const Vec<int> &i03,
+                       const Vec<int> &i30) {
+  ZoneScoped;
+  Vec<char> touched;
+  if (!ManifoldParams().cleanInputs) return touched;
+  if (outR.precision_ > inP.precision_ || outR.precision_ > inQ.precision_)
+    return touched;
+  auto isSimple = [](int i) { return i >= -1 && i <= 1; };
+  if (!all_of(autoPolicy(i03.size()), i03.begin(), i03.end(), isSimple) ||
+      !all_of(autoPolicy(i30.size()), i30.begin(), i30.end(), isSimple))
+    return touched;
+
+  Vec<char> cutP(inP.NumTri(), 0);
+  Vec<char> cutQ(inQ.NumTri(), 0);
+  for (int i = 0; i < p1q2.size(); ++i) {
+    const int edgeP = p1q2.Get(i, false);
+    cutP[edgeP / 3] = 1;
+    cutP[inP.halfedge_[edgeP].pairedHalfedge / 3] = 1;
+    cutQ[p1q2.Get(i, true)] = 1;
+  }
+  for (int i = 0; i < p2q1.size(); ++i) {
+    const int edgeQ = p2q1.Get(i, true);
+    cutQ[edgeQ / 3] = 1;
+    cutQ[inQ.halfedge_[edgeQ].pairedHalfedge / 3] = 1;
+    cutP[p2q1.Get(i, false)] = 1;
+  }
+
+  touched.resize(outR.NumVert(), 0);
+  for (int tri = 0; tri < outR.NumTri(); ++tri) {
+    const TriRef ref = outR.meshRelation_.triRef[tri];
+    if (!(ref.meshID == 0 ? cutP[ref.tri] : cutQ[ref.tri])) continue;
+    for (const int i : {0, 1, 2}) {
+      const int vert = outR.halfedge_[3 * tri + i].startVert;
+      if (vert >= 0) touched[vert] = 1;
+    }
+  }
+  return touched;
+}
+
 struct MapTriRef {
   VecView<const TriRef> triRefP;
   VecView<const TriRef> triRefQ;
@@ -619,15 +674,37 @@ void CreateProperties(Manifold::Impl &outR, const Manifold::Impl &inP,
     }
   }
 }
+using StatsCallback = std::function<void(const BooleanStats &)>;
+
+Manifold::Impl CancelledImpl() {
+  Manifold::Impl impl;
+  impl.status_ = Manifold::Error::Cancelled;
+  return impl;
+}
+
+thread_local BooleanStats lastStats;
+// Copied out under the lock, so a callback can run while it is being replaced.
+std::mutex statsMutex;
+std::shared_ptr<const StatsCallback> statsCallback;
+
+void ReportStats(const BooleanStats &stats) {
+  lastStats = stats;
+  std::shared_ptr<const StatsCallback> callback;
+  {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    callback = statsCallback;
+  }
+  if (callback) (*callback)(stats);
+}
 }  // namespace
 
 namespace manifold {
 
-Manifold::Impl Boolean3::Result(OpType op) const {
-#ifdef MANIFOLD_DEBUG
-  Timer assemble;
-  assemble.Start();
-#endif
+Manifold::Impl Boolean3::Assemble(OpType op, BooleanStats &stats) const {
+  PhaseTimer timer;
+  if (inP_.status_ == Manifold::Error::Cancelled ||
+      inQ_.status_ == Manifold::Error::Cancelled || Cancelled())
+    return CancelledImpl();
 
   ASSERT((expandP_ > 0) == (op == OpType::Add), logicErr,
          "Result op type not compatible with constructor op type.");
@@ -647,6 +724,35 @@ Manifold::Impl Boolean3::Result(OpType op) const {
     return inP_;
   }
 
+  if (x12_.size() == 0 && x21_.size() == 0) {
+    // No surface intersections: when each mesh is uniformly inside or outside
+    // of the other, the result is one of the inputs (or nothing), so skip the
+    // assembly.
+    auto all = [](const Vec<int> &w, int val) {
+      return all_of(autoPolicy(w.size()), w.begin(), w.end(),
+                    [val](int x) { return x == val; });
+    };
+    const bool pInQ = all(w03_, 1);
+    const bool pOutQ = all(w03_, 0);
+    const bool qInP = all(w30_, 1);
+    const bool qOutP = all(w30_, 0);
+    switch (op) {
+      case OpType::Add:
+        if (pInQ && qOutP) return inQ_;
+        if (qInP && pOutQ) return inP_;
+        break;
+      case OpType::Intersect:
+        if (pInQ && qOutP) return inP_;
+        if (qInP && pOutQ) return inQ_;
+        if (pOutQ && qOutP) return Manifold::Impl();
+        break;
+      case OpType::Subtract:
+        if (pInQ && qOutP) return Manifold::Impl();
+        if (pOutQ && qOutP) return inP_;
+        break;
+    }
+  }
+
   const bool invertQ = op == OpType::Subtract;
 
   // Convert winding numbers to inclusion values based on operation type.
@@ -720,6 +826,8 @@ Manifold::Impl Boolean3::Result(OpType op) const {
   PRINT(nQv << " verts from inQ");
   PRINT(n12 << " new verts from edgesP -> facesQ");
   PRINT(n21 << " new verts from facesP -> edgesQ");
+  stats.newVerts = n12 + n21;
+  stats.sizeOutput = timer.Lap();
 
   // Build up new polygonal faces from triangle intersections. At this point the
   // calculation switches from parallel to serial.
@@ -734,12 +842,15 @@ Manifold::Impl Boolean3::Result(OpType op) const {
 
   AddNewEdgeVerts(edgesP, edgesNew, p1q2_, i12, v12R, inP_.halfedge_, true);
   AddNewEdgeVerts(edgesQ, edgesNew, p2q1_, i21, v21R, inQ_.halfedge_, false);
+  stats.assembleEdges = timer.Lap();
 
   // Level 4
   Vec<int> faceEdge;
   Vec<int> facePQ2R;
   std::tie(faceEdge, facePQ2R) =
       SizeOutput(outR, inP_, inQ_, i03, i30, i12, i21, p1q2_, p2q1_, invertQ);
+  stats.sizeOutput += timer.Lap();
+  if (Cancelled()) return CancelledImpl();
 
   // This gets incremented for each halfedge that's added to a face so that the
   // next one knows where to slot in.
@@ -763,12 +874,8 @@ Manifold::Impl Boolean3::Result(OpType op) const {
                    facePQ2R.cview(0, inP_.NumTri()), true);
   AppendWholeEdges(outR, facePtrR, halfedgeRef, inQ_, wholeHalfedgeQ, i30, vQ2R,
                    facePQ2R.cview(inP_.NumTri(), inQ_.NumTri()), false);
-
-#ifdef MANIFOLD_DEBUG
-  assemble.Stop();
-  Timer triangulate;
-  triangulate.Start();
-#endif
+  stats.assembleEdges += timer.Lap();
+  if (Cancelled()) return CancelledImpl();
 
   // Level 6
 
@@ -776,47 +883,100 @@ Manifold::Impl Boolean3::Result(OpType op) const {
     ASSERT(outR.IsManifold(), logicErr, "polygon mesh is not manifold!");
 
   outR.Face2Tri(faceEdge, halfedgeRef);
-
-#ifdef MANIFOLD_DEBUG
-  triangulate.Stop();
-  Timer simplify;
-  simplify.Start();
-#endif
+  stats.face2Tri = timer.Lap();
+  if (Cancelled()) return CancelledImpl();
 
   if (ManifoldParams().intermediateChecks)
     ASSERT(outR.IsManifold(), logicErr, "triangulated mesh is not manifold!");
 
   CreateProperties(outR, inP_, inQ_);
 
+  const Vec<char> touchedVert =
+      TouchedVerts(outR, inP_, inQ_, p1q2_, p2q1_, i03, i30);
+
   UpdateReference(outR, inP_, inQ_, invertQ);
 
-  outR.SimplifyTopology();
+  // With clean inputs, only the neighborhood of the intersection needs
+  // cleanup; the regions copied whole from the inputs are skipped.
+  outR.SimplifyTopology(touchedVert);
 
   if (ManifoldParams().intermediateChecks)
     ASSERT(outR.Is2Manifold(), logicErr, "simplified mesh is not 2-manifold!");
-
-#ifdef MANIFOLD_DEBUG
-  simplify.Stop();
-  Timer sort;
-  sort.Start();
-#endif
+  stats.simplifyTopology = timer.Lap();
+  if (Cancelled()) return CancelledImpl();
 
   outR.Finish();
   outR.IncrementMeshIDs();
+  stats.finish = timer.Lap();
+
+  return outR;
+}
+
+Manifold::Impl Boolean3::Result(OpType op) const {
+  BooleanStats stats = stats_;
+  stats.op = op;
+  Manifold::Impl outR = Assemble(op, stats);
+  Report(stats, outR);
+  return outR;
+}
+
+std::pair<Manifold::Impl, Manifold::Impl> Boolean3::Split() const {
+  BooleanStats statsI = stats_;
+  BooleanStats statsS = stats_;
+  statsI.op = OpType::Intersect;
+  statsS.op = OpType::Subtract;
+  Manifold::Impl outI, outS;
+#if MANIFOLD_PAR == 'T' && __has_include(<tbb/tbb.h>)
+  if (!ManifoldParams().deterministic && !SerialScope::Active()) {
+    // The two assemblies only read the shared intersection data.
+    tbb::task_group group;
+    const Cancellation *cancellation = Cancellation::Current();
+    group.run([&, cancellation]() {
+      Cancellation::Scope cancel(cancellation);
+      outS = Assemble(OpType::Subtract, statsS);
+    });
+    outI = Assemble(OpType::Intersect, statsI);
+    group.wait();
+  } else
+#endif
+  {
+    outI = Assemble(OpType::Intersect, statsI);
+    outS = Assemble(OpType::Subtract, statsS);
+  }
+  // Reported here so that both land on the calling thread, in order.
+  Report(statsI, outI);
+  Report(statsS, outS);
+  return std::make_pair(std::move(outI), std::move(outS));
+}
+
+void Boolean3::Report(BooleanStats &stats, const Manifold::Impl &outR) const {
+  stats.outputVerts = outR.NumVert();
+  stats.outputTris = outR.NumTri();
+  ReportStats(stats);
 
 #ifdef MANIFOLD_DEBUG
-  sort.Stop();
   if (ManifoldParams().verbose) {
-    assemble.Print("Assembly");
-    triangulate.Print("Triangulation");
-    simplify.Print("Simplification");
-    sort.Print("Sorting");
+    std::cout << "----------- Boolean phases (ms): broad " << stats.broadPhase
+              << ", intersect "
+              << stats.filter11 + stats.shadow11 + stats.shadow02 +
+                     stats.intersect12 + stats.winding03
+              << ", assemble " << stats.sizeOutput + stats.assembleEdges
+              << ", triangulate " << stats.face2Tri << ", simplify "
+              << stats.simplifyTopology << ", sort " << stats.finish
+              << std::endl;
     std::cout << outR.NumVert() << " verts and " << outR.NumTri() << " tris"
               << std::endl;
   }
 #endif
+}
 
-  return outR;
+BooleanStats GetLastBooleanStats() { return lastStats; }
+
+void SetBooleanStatsCallback(StatsCallback callback) {
+  std::shared_ptr<const StatsCallback> shared;
+  if (callback) shared = std::make_shared<const StatsCallback>(callback);
+  std::lock_guard<std::mutex> lock(statsMutex);
+  statsCallback = shared;
 }
 
 }  // namespace manifold
@@ -0,0 +1,439 @@
+// Copyright 2024 The Manifold Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "impl.h"
+#include "par.h"
+#include "polygon.h"
+
+namespace {
+using namespace manifold;
+
+// Planes are (normal, offset); the kept side is dot(normal, pos) >= offset.
+float Distance(glm::vec4 plane, glm::vec3 pos) {
+  return glm::dot(glm::vec3(plane), pos) - plane.w;
+}
+
+/**
+ * 1 if the box is entirely on the kept side of the plane, -1 if it is entirely
+ * removed, and 0 if it straddles the plane.
+ */
+int Side(glm::vec4 plane, const Box& box) {
+  const glm::bvec3 positive = glm::greaterThan(glm::vec3(plane), glm::vec3(0));
+  if (Distance(plane, glm::mix(box.max, box.min, positive)) >= 0) return 1;
+  if (Distance(plane, glm::mix(box.min, box.max, positive)) < 0) return -1;
+  return 0;
+}
+
+/**
+ * Cuts in by a single plane into out, closing the hole with faces referenced
+ * to capRef. Verts on the plane are kept, so every kept vert retains its
+ * whole fan of triangles and the result is manifold by construction; the
+ * slivers this leaves where verts lie on the plane are for SimplifyTopology to
+ * collapse. The touched flags are carried over to the new verts and set for
+ * the neighborhood of the cut. Returns false, leaving out alone, if nothing is
+ * removed.
+ */
+bool TrimStep(const Manifold::Impl& in, Manifold::Impl& out,
+              Vec<char>& touched, glm::vec4 plane, TriRef capRef) {
+  const int numVert = in.NumVert();
+  const int numTri = in.NumTri();
+  const int numHalfedge = in.halfedge_.size();
+  const int numProp = in.NumProp();
+  const int numPropVert = in.NumPropVert();
+  const bool hasRef = in.meshRelation_.triRef.size() == numTri;
+  const bool hasNormal = in.faceNormal_.size() == numTri;
+  VecView<const glm::vec3> vertPos = in.vertPos_;
+  VecView<const Halfedge> halfedge = in.halfedge_;
+  VecView<const glm::ivec3> triProp = in.meshRelation_.triProperties;
+  VecView<const float> prop = in.meshRelation_.properties;
+
+  Vec<float> dist(numVert);
+  // Kept verts are numbered first, followed by one new vert per cut edge.
+  Vec<int> vertNew(numVert);
+  for_each_n(autoPolicy(numVert), countAt(0), numVert, [&](int vert) {
+    dist[vert] = Distance(plane, vertPos[vert]);
+    vertNew[vert] = dist[vert] >= 0;
+  });
+  const int lastKept = vertNew[numVert - 1];
+  exclusive_scan(autoPolicy(numVert), vertNew.begin(), vertNew.end(),
+                 vertNew.begin(), 0);
+  const int numKept = vertNew[numVert - 1] + lastKept;
+  if (numKept == numVert) return false;
+  out = Manifold::Impl();
+  if (numKept == 0) return true;
+
+  auto kept = [&](int vert) { return dist[vert] >= 0; };
+  auto isCut = [&](int edge) {
+    const Halfedge& h = halfedge[edge];
+    return h.IsForward() && kept(h.startVert) != kept(h.endVert);
+  };
+
+  // Each cut edge makes one vert, and one propVert for each side unless both
+  // triangles share the propVerts at its ends.
+  auto sharesProps = [&](int edge) {
+    const int pair = halfedge[edge].pairedHalfedge;
+    const int i = edge % 3;
+    const int j = pair % 3;
+    return triProp[pair / 3][j] == triProp[edge / 3][Next3(i)] &&
+           triProp[pair / 3][Next3(j)] == triProp[edge / 3][i];
+  };
+  Vec<int> edgeVert(numHalfedge, -1);
+  Vec<int> cutOffset(numHalfedge);
+  Vec<int> propOffset(numProp > 0 ? numHalfedge : 0);
+  const auto policy = autoPolicy(numHalfedge);
+  for_each_n(policy, countAt(0), numHalfedge, [&](int edge) {
+    const bool cut = isCut(edge);
+    cutOffset[edge] = cut;
+    if (numProp > 0) propOffset[edge] = cut ? 2 - sharesProps(edge) : 0;
+  });
+  const int lastCut = cutOffset[numHalfedge - 1];
+  exclusive_scan(policy, cutOffset.begin(), cutOffset.end(), cutOffset.begin(),
+                 0);
+  const int numCut = cutOffset[numHalfedge - 1] + lastCut;
+  int numNewProp = 0;
+  if (numProp > 0) {
+    const int lastProp = propOffset[numHalfedge - 1];
+    exclusive_scan(policy, propOffset.begin(), propOffset.end(),
+                   propOffset.begin(), 0);
+    numNewProp = propOffset[numHalfedge - 1] + lastProp;
+  }
+
+  out.precision_ = in.precision_;
+  out.meshRelation_.numProp = numProp;
+  out.meshRelation_.meshIDtransform = in.meshRelation_.meshIDtransform;
+  out.vertPos_.resize(numKept + numCut);
+  Vec<char> outTouched(numKept + numCut, 0);
+  for_each_n(autoPolicy(numVert), countAt(0), numVert, [&](int vert) {
+    if (!kept(vert)) return;
+    out.vertPos_[vertNew[vert]] = vertPos[vert];
+    outTouched[vertNew[vert]] = touched.size() > 0 && touched[vert];
+  });
+
+  // propVert of each cut edge as seen from the triangle of each halfedge
+  Vec<int> edgeProp(numProp > 0 ? numHalfedge : 0, -1);
+  Vec<float>& outProp = out.meshRelation_.properties;
+  if (numProp > 0) {
+    // the last propVert is for the cap
+    outProp.resize((numPropVert + numNewProp + 1) * numProp, 0);
+    copy(autoPolicy(prop.size()), prop.begin(), prop.end(), outProp.begin());
+  }
+
+  for_each_n(policy, countAt(0), numHalfedge, [&](int edge) {
+    if (!isCut(edge)) return;
+    const Halfedge& h = halfedge[edge];
+    const int vert = numKept + cutOffset[edge];
+    edgeVert[edge] = vert;
+    edgeVert[h.pairedHalfedge] = vert;
+    const float t = dist[h.startVert] / (dist[h.startVert] - dist[h.endVert]);
+    out.vertPos_[vert] =
+        glm::mix(vertPos[h.startVert], vertPos[h.endVert], glm::vec3(t));
+    outTouched[vert] = 1;
+    if (numProp == 0) return;
+
+    const int pair = h.pairedHalfedge;
+    const int i = edge % 3;
+    const int j = pair % 3;
+    const int p0 = triProp[edge / 3][i];
+    const int p1 = triProp[edge / 3][Next3(i)];
+    const int newProp = numPropVert + propOffset[edge];
+    edgeProp[edge] = newProp;
+    for (int p = 0; p < numProp; ++p) {
+      outProp[newProp * numProp + p] =
+          glm::mix(prop[p0 * numProp + p], prop[p1 * numProp + p], t);
+    }
+    if (sharesProps(edge)) {
+      edgeProp[pair] = newProp;
+      return;
+    }
+    // the pair runs the opposite way
+    const int q0 = triProp[pair / 3][Next3(j)];
+    const int q1 = triProp[pair / 3][j];
+    edgeProp[pair] = newProp + 1;
+    for (int p = 0; p < numProp; ++p) {
+      outProp[(newProp + 1) * numProp + p] =
+          glm::mix(prop[q0 * numProp + p], prop[q1 * numProp + p], t);
+    }
+  });
+
+  // A triangle with k kept verts leaves a polygon of k verts, plus two on the
+  // plane if it is cut, which fans into this many triangles.
+  Vec<int> triOffset(numTri);
+  for_each_n(autoPolicy(numTri), countAt(0), numTri, [&](int tri) {
+    int numCorner = 0;
+    for (const int i : {0, 1, 2}) {
+      numCorner += kept(halfedge[3 * tri + i].startVert);
+    }
+    triOffset[tri] = numCorner == 0 ? 0 : numCorner == 3 ? 1 : numCorner;
+  });
+  const int lastTri = triOffset[numTri - 1];
+  exclusive_scan(autoPolicy(numTri), triOffset.begin(), triOffset.end(),
+                 triOffset.begin(), 0);
+  const int numSideTri = triOffset[numTri - 1] + lastTri;
+
+  Vec<glm::ivec3> triVerts(numSideTri);
+  Vec<TriRef>& triRef = out.meshRelation_.triRef;
+  triRef.resize(numSideTri);
+  out.faceNormal_.resize(numSideTri);
+  if (numProp > 0) out.meshRelation_.triProperties.resize(numSideTri);
+  // The cap boundary runs backwards along each cut triangle's boundary on the
+  // plane, so from the cut vert where it enters the kept side to the one
+  // where it leaves.
+  Vec<int> capNext(numCut, -1);
+  for_each_n(autoPolicy(numTri), countAt(0), numTri, [&](int tri) {
+    int polyVert[4];
+    int polyProp[4];
+    int numPoly = 0;
+    int enter = -1;
+    int exit = -1;
+    for (const int i : {0, 1, 2}) {
+      const int edge = 3 * tri + i;
+      const int vert = halfedge[edge].startVert;
+      const bool keep = kept(vert);
+      if (keep) {
+        polyVert[numPoly] = vertNew[vert];
+        polyProp[numPoly++] = numProp > 0 ? triProp[tri][i] : 0;
+      }
+      if (keep == kept(halfedge[edge].endVert)) continue;
+      polyVert[numPoly] = edgeVert[edge];
+      polyProp[numPoly++] = numProp > 0 ? edgeProp[edge] : 0;
+      (keep ? exit : enter) = edgeVert[edge];
+    }
+    if (enter >= 0) {
+      capNext[enter - numKept] = exit;
+      for (int i = 0; i < numPoly; ++i) outTouched[polyVert[i]] = 1;
+    }
+    const TriRef ref = hasRef ? in.meshRelation_.triRef[tri] : capRef;
+    const glm::vec3 normal = hasNormal ? in.faceNormal_[tri] : glm::vec3(0);
+    for (int i = 0; i + 2 < numPoly; ++i) {
+      const int outTri = triOffset[tri] + i;
+      triVerts[outTri] = {polyVert[0], polyVert[i + 1], polyVert[i + 2]};
+      triRef[outTri] = ref;
+      out.faceNormal_[outTri] = normal;
+      if (numProp > 0) {
+        out.meshRelation_.triProperties[outTri] = {polyProp[0], polyProp[i + 1],
+                                                   polyProp[i + 2]};
+      }
+    }
+  });
+
+  // Trace the cap loops and triangulate them in the plane.
+  const glm::vec3 capNormal = -glm::normalize(glm::vec3(plane));
+  const glm::mat3x2 projection = GetAxisAlignedProjection(capNormal);
+  PolygonsIdx polys;
+  std::vector<char> visited(numCut, 0);
+  for (int start = 0; start < numCut; ++start) {
+    if (visited[start]) continue;
+    polys.push_back({});
+    int vert = start;
+    while (!visited[vert]) {
+      visited[vert] = 1;
+      const glm::vec3 pos = out.vertPos_[numKept + vert];
+      polys.back().push_back({projection * pos, numKept + vert});
+      vert = capNext[vert] - numKept;
+    }
+  }
+  const std::vector<glm::ivec3> capTris = TriangulateIdx(polys, in.precision_);
+
+  const int numOutTri = numSideTri + capTris.size();
+  triVerts.resize(numOutTri);
+  triRef.resize(numOutTri);
+  out.faceNormal_.resize(numOutTri);
+  if (numProp > 0) out.meshRelation_.triProperties.resize(numOutTri);
+  const int capProp = numPropVert + numNewProp;
+  for (int i = 0; i < capTris.size(); ++i) {
+    triVerts[numSideTri + i] = capTris[i];
+    triRef[numSideTri + i] = capRef;
+    out.faceNormal_[numSideTri + i] = capNormal;
+    if (numProp > 0) {
+      out.meshRelation_.triProperties[numSideTri + i] = glm::ivec3(capProp);
+    }
+  }
+
+  // leave unknown normals for Finish to calculate
+  if (!hasNormal) out.faceNormal_.resize(0);
+  out.CreateHalfedges(triVerts);
+  out.CalculateBBox();
+  touched = std::move(outTouched);
+  return true;
+}
+
+/**
+ * The triangles of in whose boxes reach the kept side of an axis-aligned
+ * plane, sorted, found with its collider; every other triangle lies wholly
+ * on the removed side. Returns false for any other plane.
+ */
+bool KeptSideTris(const Manifold::Impl& in, glm::vec4 plane,
+                  std::vector<int>& tris) {
+  int axis = -1;
+  for (const int i : {0, 1, 2}) {
+    if (plane[i] == 0) continue;
+    if (axis >= 0 || glm::abs(plane[i]) != 1) return false;
+    axis = i;
+  }
+  if (axis < 0) return false;
+  // for a unit normal, Distance is exactly pos[axis] - w or -w - pos[axis]
+  Box kept = in.bBox_;
+  if (plane[axis] > 0) {
+    kept.min[axis] = glm::max(kept.min[axis], plane.w);
+  } else {
+    kept.max[axis] = glm::min(kept.max[axis], -plane.w);
+  }
+  Vec<Box> query;
+  query.push_back(kept);
+  const SparseIndices collisions =
+      in.collider_.Collisions<false, false>(query.cview());
+  tris.resize(collisions.size());
+  for (int i = 0; i < collisions.size(); ++i) tris[i] = collisions.Get(i, 1);
+  std::sort(tris.begin(), tris.end());
+  return true;
+}
+
+/**
+ * The given sorted triangles of in as a mesh of their own, with only the
+ * verts and propVerts they use, in their original order. Halfedges paired
+ * with a triangle that was left out are unpaired, which TrimStep allows as
+ * long as those edges are removed whole, as they are by the plane
+ * KeptSideTris chose them for.
+ */
+Manifold::Impl Submesh(const Manifold::Impl& in, const std::vector<int>& tris) {
+  const int numTri = tris.size();
+  const int numProp = in.NumProp();
+  auto compact = [](std::vector<int>& used) {
+    std::sort(used.begin(), used.end());
+    used.erase(std::unique(used.begin(), used.end()), used.end());
+  };
+  auto indexOf = [](const std::vector<int>& sorted, int value) {
+    const auto it = std::lower_bound(sorted.begin(), sorted.end(), value);
+    return it == sorted.end() || *it != value
+               ? -1
+               : static_cast<int>(it - sorted.begin());
+  };
+
+  std::vector<int> verts(3 * numTri);
+  std::vector<int> propVerts(numProp > 0 ? 3 * numTri : 0);
+  for (int t = 0; t < numTri; ++t) {
+    for (const int i : {0, 1, 2}) {
+      verts[3 * t + i] = in.halfedge_[3 * tris[t] + i].startVert;
+      if (numProp > 0)
+        propVerts[3 * t + i] = in.meshRelation_.triProperties[tris[t]][i];
+    }
+  }
+  compact(verts);
+  compact(propVerts);
+  const int numVert = verts.size();
+  const int numPropVert = propVerts.size();
+
+  Manifold::Impl out;
+  out.precision_ = in.precision_;
+  out.meshRelation_.numProp = numProp;
+  out.meshRelation_.meshIDtransform = in.meshRelation_.meshIDtransform;
+  out.vertPos_.resize(numVert);
+  for_each_n(autoPolicy(numVert), countAt(0), numVert,
+             [&](int v) { out.vertPos_[v] = in.vertPos_[verts[v]]; });
+  if (numProp > 0) {
+    out.meshRelation_.properties.resize(numPropVert * numProp);
+    for_each_n(autoPolicy(numPropVert), countAt(0), numPropVert,
+               [&](int v) {
+                 for (int p = 0; p < numProp; ++p) {
+                   out.meshRelation_.properties[v * numProp + p] =
+                       in.meshRelation_.properties[propVerts[v] * numProp + p];
+                 }
+               });
+    out.meshRelation_.triProperties.resize(numTri);
+  }
+  const bool hasRef = in.meshRelation_.triRef.size() == in.NumTri();
+  const bool hasNormal = in.faceNormal_.size() == in.NumTri();
+  if (hasRef) out.meshRelation_.triRef.resize(numTri);
+  if (hasNormal) out.faceNormal_.resize(numTri);
+  out.halfedge_.resize(3 * numTri);
+  for_each_n(autoPolicy(numTri), countAt(0), numTri, [&](int t) {
+    const int tri = tris[t];
+    for (const int i : {0, 1, 2}) {
+      const Halfedge& h = in.halfedge_[3 * tri + i];
+      const int pairTri = indexOf(tris, h.pairedHalfedge / 3);
+      out.halfedge_[3 * t + i] = {
+          indexOf(verts, h.startVert), indexOf(verts, h.endVert),
+          pairTri < 0 ? -1 : 3 * pairTri + h.pairedHalfedge % 3, t};
+      if (numProp > 0) {
+        out.meshRelation_.triProperties[t][i] =
+            indexOf(propVerts, in.meshRelation_.triProperties[tri][i]);
+      }
+    }
+    if (hasRef) out.meshRelation_.triRef[t] = in.meshRelation_.triRef[tri];
+    if (hasNormal) out.faceNormal_[t] = in.faceNormal_[tri];
+  });
+  out.CalculateBBox();
+  return out;
+}
+}  // namespace
+
+namespace manifold {
+
+/**
+ * Intersects this manifold with the convex polytope that is the intersection
+ * of the half-spaces dot(normal, pos) >= offset, with each plane given as
+ * (normal, offset). The planes are applied one at a time, so each trim only
+ * does per-vertex work on what the previous ones left; putting the most
+ * selective planes first keeps the rest cheap. The first cut by an
+ * axis-aligned plane queries the collider for the triangles on its kept side,
+ * so it doesn't read the rest of the mesh either. Planes that miss the
+ * remaining bounding box are skipped without touching the mesh. The cap faces
+ * of all the planes share one new mesh ID, like the faces of a Boolean
+ * operand, with the plane's index as their face.
+ */
+Manifold::Impl Manifold::Impl::TrimByPlanes(
+    const std::vector<glm::vec4>& planes) const {
+  ZoneScoped;
+  Impl result;
+  if (IsEmpty()) return result;
+  bool trimmed = false;
+  int capID = -1;
+  Vec<char> touched;
+
+  for (int k = 0; k < planes.size(); ++k) {
+    const Impl& current = trimmed ? result : *this;
+    const int side = Side(planes[k], current.bBox_);
+    if (side > 0) continue;
+    if (side < 0) return Impl();
+    if (capID < 0) capID = ReserveIDs(1);
+    Impl next;
+    std::vector<int> tris;
+    if (!trimmed && KeptSideTris(*this, planes[k], tris) &&
+        tris.size() < NumTri()) {
+      // The first cut only reads the triangles the collider finds on its
+      // kept side; those on the other side are dropped unread.
+      if (tris.empty()) return Impl();
+      Impl local = Submesh(*this, tris);
+      if (!TrimStep(local, next, touched, planes[k], {capID, capID, k})) {
+        // only whole components were dropped
+        touched = Vec<char>(local.NumVert(), 0);
+        next = std::move(local);
+      }
+    } else if (!TrimStep(current, next, touched, planes[k],
+                         {capID, capID, k})) {
+      continue;
+    }
+    result = std::move(next);
+    trimmed = true;
+    if (result.IsEmpty()) return result;
+  }
+  if (!trimmed) return *this;
+
+  result.meshRelation_.meshIDtransform[capID] = {capID};
+  result.SimplifyTopology(touched);
+  result.Finish();
+  result.IncrementMeshIDs();
+  return result;
+}
+}  // namespace manifold
@@ -12,6 +12,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
 #include <thrust/sequence.h>
 
 #include "cross_section.h"
@@ -19,6 +25,7 @@
 #include "impl.h"
 #include "par.h"
 #include "polygon.h"
+#include "radix_sort.h"
 
 namespace {
 using namespace manifold;
@@ -33,20 +40,159 @@ struct ToSphere {
   }
 };
 
-struct Equals {
-  int val;
-  bool operator()(int x) { return x == val; }
+// The triangulation of the cap of an Extrude or Revolve, indexing the verts
+// of its polygons in order. pairs[3 * tri + i] is the halfedge paired with
+// the one from tris[tri][i] to the next vert of that triangle, or -1 - v for
+// an edge of the polygons, ending at polygon vert v. If the triangulation
+// isn't manifold on its own, the pairs are left empty.
+struct Cap {
+  std::vector<glm::ivec3> tris;
+  std::vector<int> pairs;
 };
 
-struct RemoveFace {
-  VecView<const Halfedge> halfedge;
-  VecView<const int> vertLabel;
-  const int keepLabel;
+std::shared_ptr<const Cap> MakeCap(const Polygons& polygons, float precision) {
+  auto cap = std::make_shared<Cap>();
+  cap->tris = Triangulate(polygons, precision);
 
-  bool operator()(int face) {
-    return vertLabel[halfedge[3 * face].startVert] != keepLabel;
+  std::vector<int> next;
+  for (const auto& poly : polygons) {
+    const int start = next.size();
+    for (int i = 0; i < poly.size(); ++i)
+      next.push_back(start + (i + 1) % poly.size());
   }
-};
+  const int numEdge = 3 * cap->tris.size();
+  auto key = [](int a, int b) { return (uint64_t(a) << 32) | uint64_t(b); };
+  std::unordered_map<uint64_t, int> halfedges;
+  for (int i = 0; i < numEdge; ++i) {
+    const glm::ivec3& tri = cap->tris[i / 3];
+    if (!halfedges.insert({key(tri[i % 3], tri[(i + 1) % 3]), i}).second)
+      return cap;
+  }
+  std::vector<int> pairs(numEdge);
+  int numBoundary = 0;
+  for (int i = 0; i < numEdge; ++i) {
+    const glm::ivec3& tri = cap->tris[i / 3];
+    const int a = tri[i % 3];
+    const int b = tri[(i + 1) % 3];
+    auto pair = halfedges.find(key(b, a));
+    if (pair != halfedges.end()) {
+      pairs[i] = pair->second;
+    } else if (next[a] == b) {
+      pairs[i] = -1 - b;
+      ++numBoundary;
+    } else {
+      return cap;
+    }
+  }
+  if (numBoundary == static_cast<int>(next.size()))
+    cap->pairs = std::move(pairs);
+  return cap;
+}
+
+// caps kept, since the same profile tends to be extruded many times over
+constexpr int kCapCacheSize = 64;
+
+// The cap of these polygons, from a small cache of the most recent ones,
+// matched by value.
+std::shared_ptr<const Cap> GetCap(const Polygons& polygons, float precision) {
+  struct Entry {
+    size_t hash;
+    float precision;
+    Polygons polygons;
+    std::shared_ptr<const Cap> cap;
+  };
+  static std::mutex mutex;
+  static std::vector<Entry> cache;
+  static int nextEntry = 0;
+
+  size_t hash = polygons.size();
+  for (const auto& poly : polygons) {
+    for (const glm::vec2& v : poly) {
+      hash = hash * 31 + std::hash<float>()(v.x);
+      hash = hash * 31 + std::hash<float>()(v.y);
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const Entry& entry : cache)
+      if (entry.hash == hash && entry.precision == precision &&
+          entry.polygons == polygons)
+        return entry.cap;
+  }
+  std::shared_ptr<const Cap> cap = MakeCap(polygons, precision);
+  std::lock_guard<std::mutex> lock(mutex);
+  Entry entry = {hash, precision, polygons, cap};
+  if (cache.size() < kCapCacheSize) {
+    cache.push_back(std::move(entry));
+  } else {
+    cache[nextEntry] = std::move(entry);
+    nextEntry = (nextEntry + 1) % kCapCacheSize;
+  }
+  return cap;
+}
+
+/**
+ * Builds the halfedges of a non-conical Extrude directly from its layout,
+ * instead of sorting them into pairs: the side walls are a quad per ring edge
+ * and division, split into two triangles, followed by the bottom and top
+ * triangles of each cap triangle, interleaved.
+ */
+void ExtrudeHalfedges(Vec<Halfedge>& halfedge, const Vec<glm::ivec3>& triVerts,
+                      const std::vector<int>& next, int nDivisions,
+                      const Cap& cap) {
+  const int nCrossSection = next.size();
+  const int numQuad = nCrossSection * nDivisions;
+  const int numTri = triVerts.size();
+  const ExecutionPolicy policy = autoPolicy(numTri);
+  halfedge.resize(0);
+  halfedge.resize(3 * numTri);
+  for_each_n(policy, countAt(0), numTri, [&](int tri) {
+    for (const int i : {0, 1, 2})
+      halfedge[3 * tri + i] = {triVerts[tri][i], triVerts[tri][(i + 1) % 3],
+                               -1, tri};
+  });
+
+  // The first halfedge of the two triangles of the quad ending at ring vert
+  // g, between division - 1 and division. The first triangle runs along the
+  // top, down the diagonal and up at g; the second down at the previous
+  // vert, along the bottom and up the diagonal.
+  auto quad = [nCrossSection](int division, int g) {
+    return 6 * (nCrossSection * (division - 1) + g);
+  };
+  auto link = [&halfedge](int a, int b) {
+    halfedge[a].pairedHalfedge = b;
+    halfedge[b].pairedHalfedge = a;
+  };
+  for_each_n(policy, countAt(0), numQuad, [&](int q) {
+    const int division = q / nCrossSection + 1;
+    const int g = q % nCrossSection;
+    const int first = quad(division, g);
+    link(first + 1, first + 5);
+    link(first + 2, quad(division, next[g]) + 3);
+    if (division < nDivisions) link(first, quad(division + 1, g) + 4);
+  });
+
+  const int bottom = 2 * numQuad;
+  for_each_n(policy, countAt(0), cap.tris.size(), [&](int tri) {
+    for (const int i : {0, 1, 2}) {
+      // the bottom triangle is reversed, so its halfedge 2 - i runs back
+      // along the cap's halfedge i
+      const int topEdge = 3 * (bottom + 2 * tri + 1) + i;
+      const int bottomEdge = 3 * (bottom + 2 * tri) + 2 - i;
+      const int pair = cap.pairs[3 * tri + i];
+      if (pair >= 0) {
+        halfedge[topEdge].pairedHalfedge =
+            3 * (bottom + 2 * (pair / 3) + 1) + pair % 3;
+        halfedge[bottomEdge].pairedHalfedge =
+            3 * (bottom + 2 * (pair / 3)) + 2 - pair % 3;
+      } else {
+        const int g = -1 - pair;
+        link(topEdge, quad(nDivisions, g));
+        link(bottomEdge, quad(1, g) + 4);
+      }
+    }
+  });
+}
 }  // namespace
 
 namespace manifold {
@@ -208,7 +354,7 @@ Manifold Manifold::Sphere(float radius, int circularSegments) {
   int n = circularSegments > 0 ? (circularSegments + 3) / 4
                                : Quality::GetCircularSegments(radius) / 4;
   auto pImpl_ = std::make_shared<Impl>(Impl::Shape::Octahedron);
-  pImpl_->Subdivide(n);
+  pImpl_->Subdivide([n](int) { return n; });
   for_each_n(autoPolicy(pImpl_->NumVert()), pImpl_->vertPos_.begin(),
              pImpl_->NumVert(), ToSphere({radius}));
   pImpl_->Finish();
@@ -255,16 +401,11 @@ Manifold Manifold::Extrude(const CrossSection& crossSection, float height,
   auto& triVerts = triVertsDH;
   int nCrossSection = 0;
   bool isCone = scaleTop.x == 0.0 && scaleTop.y == 0.0;
-  int idx = 0;
-  PolygonsIdx polygonsIndexed;
   for (auto& poly : polygons) {
     nCrossSection += poly.size();
-    SimplePolygonIdx simpleIndexed;
     for (const glm::vec2& polyVert : poly) {
       vertPos.push_back({polyVert.x, polyVert.y, 0.0f});
-      simpleIndexed.push_back({polyVert, idx++});
     }
-    polygonsIndexed.push_back(simpleIndexed);
   }
   for (int i = 1; i < nDivisions + 1; ++i) {
     float alpha = i / float(nDivisions);
@@ -297,13 +438,23 @@ Manifold Manifold::Extrude(const CrossSection& crossSection, float height,
   if (isCone)
     for (int j = 0; j < polygons.size(); ++j)  // Duplicate vertex for Genus
       vertPos.push_back({0.0f, 0.0f, height});
-  std::vector<glm::ivec3> top = TriangulateIdx(polygonsIndexed);
-  for (const glm::ivec3& tri : top) {
+  std::shared_ptr<const Cap> cap = GetCap(polygons, -1);
+  for (const glm::ivec3& tri : cap->tris) {
     triVerts.push_back({tri[0], tri[2], tri[1]});
     if (!isCone) triVerts.push_back(tri + nCrossSection * nDivisions);
   }
 
-  pImpl_->CreateHalfedges(triVertsDH);
+  if (isCone || cap->pairs.empty()) {
+    pImpl_->CreateHalfedges(triVertsDH);
+  } else {
+    std::vector<int> next;
+    for (const auto& poly : polygons) {
+      const int start = next.size();
+      for (int i = 0; i < poly.size(); ++i)
+        next.push_back(start + (i + 1) % poly.size());
+    }
+    ExtrudeHalfedges(pImpl_->halfedge_, triVertsDH, next, nDivisions, *cap);
+  }
   pImpl_->Finish();
   pImpl_->meshRelation_.originalID = ReserveIDs(1);
   pImpl_->InitializeOriginal();
@@ -425,13 +576,12 @@ Manifold Manifold::Revolve(const CrossSection& crossSection,
 
   // Add front and back triangles if not a full revolution.
   if (!isFullRevolution) {
-    std::vector<glm::ivec3> frontTriangles =
-        Triangulate(polygons, pImpl_->precision_);
-    for (auto& t : frontTriangles) {
+    std::shared_ptr<const Cap> cap = GetCap(polygons, pImpl_->precision_);
+    for (auto& t : cap->tris) {
       triVerts.push_back({startPoses[t.x], startPoses[t.y], startPoses[t.z]});
     }
 
-    for (auto& t : frontTriangles) {
+    for (auto& t : cap->tris) {
       triVerts.push_back({endPoses[t.z], endPoses[t.y], endPoses[t.x]});
     }
   }
@@ -454,7 +604,7 @@ Manifold Manifold::Revolve(const CrossSection& crossSection,
 Manifold Manifold::Compose(const std::vector<Manifold>& manifolds) {
   std::vector<std::shared_ptr<CsgLeafNode>> children;
   for (const auto& manifold : manifolds) {
-    children.push_back(manifold.pNode_->ToLeafNode());
+    children.push_back(manifold.GetNode()->ToLeafNode());
   }
   return Manifold(std::make_shared<Impl>(CsgLeafNode::Compose(children)));
 }
@@ -466,55 +616,170 @@ Manifold Manifold::Compose(const std::vector<Manifold>& manifolds) {
  */
 std::vector<Manifold> Manifold::Decompose() const {
   ZoneScoped;
-  UnionFind<> uf(NumVert());
-  // Graph graph;
   auto pImpl_ = GetCsgLeafNode().GetImpl();
-  for (const Halfedge& halfedge : pImpl_->halfedge_) {
-    if (halfedge.IsForward()) uf.unionXY(halfedge.startVert, halfedge.endVert);
-  }
-  std::vector<int> componentIndices;
-  const int numComponents = uf.connectedComponents(componentIndices);
+  const Impl& old = *pImpl_;
+  const int numVert = NumVert();
+  const int numTri = NumTri();
+  auto policy = autoPolicy(old.halfedge_.size());
+
+  // Lock-free union-find: roots only ever hook under smaller roots, so there
+  // are no cycles and each component's root is its smallest vert.
+  Vec<int> parent(numVert);
+  sequence(policy, parent.begin(), parent.end());
+  auto Parent = [&parent](int vert) -> std::atomic<int>& {
+    return reinterpret_cast<std::atomic<int>&>(parent[vert]);
+  };
+  auto Find = [&Parent](int vert) {
+    int next;
+    while ((next = Parent(vert).load(std::memory_order_relaxed)) != vert) {
+      vert = next;
+    }
+    return vert;
+  };
+  for_each_n(policy, countAt(0), old.halfedge_.size(), [&](int edge) {
+    const Halfedge halfedge = old.halfedge_[edge];
+    if (!halfedge.IsForward()) return;
+    int a = halfedge.startVert;
+    int b = halfedge.endVert;
+    while (true) {
+      a = Find(a);
+      b = Find(b);
+      if (a == b) return;
+      if (a < b) std::swap(a, b);
+      int root = a;
+      if (Parent(a).compare_exchange_strong(root, b)) return;
+    }
+  });
+
+  // Number the components in order of their smallest vert, as a serial
+  // union-find labeling would.
+  Vec<int> vertLabel(numVert);
+  Vec<int> rootIdx(numVert + 1, 0);
+  for_each_n(policy, countAt(0), numVert, [&](int vert) {
+    vertLabel[vert] = Find(vert);
+    rootIdx[vert] = vertLabel[vert] == vert;
+  });
+  exclusive_scan(policy, rootIdx.begin(), rootIdx.end(), rootIdx.begin(), 0);
+  const int numComponents = rootIdx[numVert];
 
   if (numComponents == 1) {
     std::vector<Manifold> meshes(1);
     meshes[0] = *this;
     return meshes;
   }
-  Vec<int> vertLabel(componentIndices);
-
-  std::vector<Manifold> meshes;
-  for (int i = 0; i < numComponents; ++i) {
+  for_each_n(policy, countAt(0), numVert,
+             [&](int vert) { vertLabel[vert] = rootIdx[vertLabel[vert]]; });
+
+  // One stable bucketing pass over all verts and faces at once; each
+  // component's range is found by binary search over the sorted labels.
+  auto Bucket = [&](Vec<int>& labels, Vec<int>& new2Old, Vec<int>& old2Local,
+                    Vec<int>& start) {
+    const int size = labels.size();
+    new2Old.resize(size);
+    sequence(policy, new2Old.begin(), new2Old.end());
+    RadixSort(labels.view(), new2Old.view());
+    start.resize(numComponents + 1);
+    for_each_n(policy, countAt(0), numComponents + 1, [&](int comp) {
+      start[comp] =
+          std::lower_bound(labels.begin(), labels.end(), comp) - labels.begin();
+    });
+    old2Local.resize(size);
+    for_each_n(policy, countAt(0), size, [&](int i) {
+      old2Local[new2Old[i]] = i - start[labels[i]];
+    });
+  };
+
+  Vec<int> faceLabel(numTri);
+  for_each_n(policy, countAt(0), numTri, [&](int tri) {
+    faceLabel[tri] = vertLabel[old.halfedge_[3 * tri].startVert];
+  });
+  Vec<int> vertNew2Old, vertOld2Local, vertStart;
+  Bucket(vertLabel, vertNew2Old, vertOld2Local, vertStart);
+  Vec<int> faceNew2Old, faceOld2Local, faceStart;
+  Bucket(faceLabel, faceNew2Old, faceOld2Local, faceStart);
+
+  const auto& oldRelation = old.meshRelation_;
+  const bool hasProps = oldRelation.triProperties.size() > 0;
+  const bool hasNormals = old.faceNormal_.size() == numTri;
+  const bool hasTangents = old.halfedgeTangent_.size() > 0;
+
+  std::vector<Manifold> meshes(numComponents);
+  for_each_n(autoPolicy(numTri), countAt(0), numComponents, [&](int comp) {
     auto impl = std::make_shared<Impl>();
     // inherit original object's precision
-    impl->precision_ = pImpl_->precision_;
-    impl->vertPos_.resize(NumVert());
-    Vec<int> vertNew2Old(NumVert());
-    auto policy = autoPolicy(NumVert());
-    auto start = zip(impl->vertPos_.begin(), vertNew2Old.begin());
-    int nVert =
-        copy_if<decltype(start)>(
-            policy, zip(pImpl_->vertPos_.begin(), countAt(0)),
-            zip(pImpl_->vertPos_.end(), countAt(NumVert())), vertLabel.begin(),
-            zip(impl->vertPos_.begin(), vertNew2Old.begin()), Equals({i})) -
-        start;
-    impl->vertPos_.resize(nVert);
-
-    Vec<int> faceNew2Old(NumTri());
-    sequence(policy, faceNew2Old.begin(), faceNew2Old.end());
+    impl->precision_ = old.precision_;
 
-    int nFace = remove_if<decltype(faceNew2Old.begin())>(
-                    policy, faceNew2Old.begin(), faceNew2Old.end(),
-                    RemoveFace({pImpl_->halfedge_, vertLabel, i})) -
-                faceNew2Old.begin();
-    faceNew2Old.resize(nFace);
-
-    impl->GatherFaces(*pImpl_, faceNew2Old);
-    impl->ReindexVerts(vertNew2Old, pImpl_->NumVert());
+    const int firstVert = vertStart[comp];
+    const int nVert = vertStart[comp + 1] - firstVert;
+    impl->vertPos_.resize(nVert);
+    for_each_n(autoPolicy(nVert), countAt(0), nVert, [&](int vert) {
+      impl->vertPos_[vert] = old.vertPos_[vertNew2Old[firstVert + vert]];
+    });
+
+    const int firstFace = faceStart[comp];
+    const int nFace = faceStart[comp + 1] - firstFace;
+    impl->halfedge_.resize(3 * nFace);
+    if (hasTangents) impl->halfedgeTangent_.resize(3 * nFace);
+    if (hasNormals) impl->faceNormal_.resize(nFace);
+    auto& relation = impl->meshRelation_;
+    relation.triRef.resize(nFace);
+    relation.meshIDtransform = oldRelation.meshIDtransform;
+    for_each_n(autoPolicy(nFace), countAt(0), nFace, [&](int face) {
+      const int oldFace = faceNew2Old[firstFace + face];
+      for (const int i : {0, 1, 2}) {
+        Halfedge edge = old.halfedge_[3 * oldFace + i];
+        edge.startVert = vertOld2Local[edge.startVert];
+        edge.endVert = vertOld2Local[edge.endVert];
+        edge.pairedHalfedge = 3 * faceOld2Local[edge.pairedHalfedge / 3] +
+                              edge.pairedHalfedge % 3;
+        edge.face = face;
+        impl->halfedge_[3 * face + i] = edge;
+        if (hasTangents) {
+          impl->halfedgeTangent_[3 * face + i] =
+              old.halfedgeTangent_[3 * oldFace + i];
+        }
+      }
+      if (hasNormals) impl->faceNormal_[face] = old.faceNormal_[oldFace];
+      relation.triRef[face] = oldRelation.triRef[oldFace];
+    });
+
+    if (hasProps) {
+      // Keep only the property verts this component references.
+      const int numProp = oldRelation.numProp;
+      std::vector<int> propNew2Old(3 * nFace);
+      for (int face = 0; face < nFace; ++face) {
+        const int oldFace = faceNew2Old[firstFace + face];
+        for (const int i : {0, 1, 2}) {
+          propNew2Old[3 * face + i] = oldRelation.triProperties[oldFace][i];
+        }
+      }
+      std::sort(propNew2Old.begin(), propNew2Old.end());
+      propNew2Old.erase(std::unique(propNew2Old.begin(), propNew2Old.end()),
+                        propNew2Old.end());
+
+      relation.numProp = numProp;
+      relation.properties.resize(numProp * propNew2Old.size());
+      for (int prop = 0; prop < propNew2Old.size(); ++prop) {
+        for (int p = 0; p < numProp; ++p) {
+          relation.properties[numProp * prop + p] =
+              oldRelation.properties[numProp * propNew2Old[prop] + p];
+        }
+      }
+      relation.triProperties.resize(nFace);
+      for (int face = 0; face < nFace; ++face) {
+        const int oldFace = faceNew2Old[firstFace + face];
+        for (const int i : {0, 1, 2}) {
+          relation.triProperties[face][i] =
+              std::lower_bound(propNew2Old.begin(), propNew2Old.end(),
+                               oldRelation.triProperties[oldFace][i]) -
+              propNew2Old.begin();
+        }
+      }
+    }
 
     impl->Finish();
-
-    meshes.push_back(Manifold(impl));
-  }
+    meshes[comp] = Manifold(impl);
+  });
   return meshes;
 }
 }  // namespace manifold
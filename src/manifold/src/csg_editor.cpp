@@ -0,0 +1,163 @@
+// Copyright 2024 The Manifold Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <functional>
+#include <set>
+
+#include "manifold.h"
+#include "utils.h"
+
+namespace {
+using namespace manifold;
+
+Manifold Combine(const Manifold& a, const Manifold& b, OpType op) {
+  Manifold result = a.Boolean(b, op);
+  // force evaluation, so the result is stored as a leaf and the Booleans
+  // below it are never repeated.
+  result.NumTri();
+  return result;
+}
+}  // namespace
+
+namespace manifold {
+
+struct CsgEditor::Node {
+  bool isLeaf = true;
+  OpType op = OpType::Add;
+  bool dirty = true;
+  Manifold result;
+  std::vector<int> children;
+  std::vector<int> parents;
+  // Implicit binary tree over the operands: element m + i holds operand i and
+  // element j < m holds partial[2j] op partial[2j + 1], so partial[1] is the
+  // reduction of all m operands. For Subtract the operands are children[1..],
+  // reduced by union.
+  std::vector<Manifold> partial;
+  // indices into children that changed since the last evaluation
+  std::set<int> dirtyChildren;
+};
+
+CsgEditor::CsgEditor() = default;
+CsgEditor::~CsgEditor() = default;
+CsgEditor::CsgEditor(CsgEditor&&) = default;
+CsgEditor& CsgEditor::operator=(CsgEditor&&) = default;
+
+int CsgEditor::NumNodes() const { return nodes_.size(); }
+
+/**
+ * Add a leaf to the tree and return its node index.
+ */
+int CsgEditor::AddLeaf(const Manifold& manifold) {
+  auto node = std::make_unique<Node>();
+  node->result = manifold;
+  node->dirty = false;
+  nodes_.push_back(std::move(node));
+  return nodes_.size() - 1;
+}
+
+/**
+ * Add an op node over existing nodes and return its node index. In case of
+ * Subtract, all children in the tail are differenced from the head.
+ */
+int CsgEditor::AddOp(OpType op, const std::vector<int>& children) {
+  ASSERT(op != OpType::Subtract || !children.empty(), userErr,
+         "CsgEditor: Subtract needs at least one child.");
+  const int id = nodes_.size();
+  auto node = std::make_unique<Node>();
+  node->isLeaf = false;
+  node->op = op;
+  node->children = children;
+  for (int child : children) {
+    ASSERT(child >= 0 && child < id, userErr, "CsgEditor: invalid child.");
+    nodes_[child]->parents.push_back(id);
+  }
+  nodes_.push_back(std::move(node));
+  return id;
+}
+
+/**
+ * Replace the manifold of a leaf node. Nothing is evaluated until Evaluate()
+ * is called on one of its ancestors.
+ */
+void CsgEditor::SetLeaf(int node, const Manifold& manifold) {
+  ASSERT(node >= 0 && node < nodes_.size() && nodes_[node]->isLeaf, userErr,
+         "CsgEditor: SetLeaf requires a leaf node.");
+  nodes_[node]->result = manifold;
+  MarkDirty(node);
+}
+
+void CsgEditor::MarkDirty(int node) {
+  for (int parent : nodes_[node]->parents) {
+    Node& p = *nodes_[parent];
+    for (int i = 0; i < p.children.size(); ++i) {
+      if (p.children[i] == node) p.dirtyChildren.insert(i);
+    }
+    if (!p.dirty) {
+      p.dirty = true;
+      MarkDirty(parent);
+    }
+  }
+}
+
+/**
+ * Return the result of the given node, recomputing only what has been
+ * invalidated by SetLeaf() since the last evaluation.
+ */
+Manifold CsgEditor::Evaluate(int id) {
+  ASSERT(id >= 0 && id < nodes_.size(), userErr, "CsgEditor: invalid node.");
+  Node& node = *nodes_[id];
+  if (!node.dirty) return node.result;
+
+  const int offset = node.op == OpType::Subtract ? 1 : 0;
+  const OpType reduceOp = node.op == OpType::Subtract ? OpType::Add : node.op;
+  const int m = static_cast<int>(node.children.size()) - offset;
+
+  if (m > 0) {
+    // internal elements to recompute; std::greater puts children first
+    std::set<int, std::greater<int>> stale;
+    if (node.partial.empty()) {
+      node.partial.resize(2 * m);
+      for (int i = 0; i < m; ++i) {
+        node.partial[m + i] = Evaluate(node.children[offset + i]);
+      }
+      for (int j = m - 1; j >= 1; --j) stale.insert(j);
+    } else {
+      for (int i : node.dirtyChildren) {
+        if (i < offset) continue;
+        int j = m + i - offset;
+        node.partial[j] = Evaluate(node.children[i]);
+        while (j > 1) {
+          j /= 2;
+          stale.insert(j);
+        }
+      }
+    }
+    for (int j : stale) {
+      node.partial[j] =
+          Combine(node.partial[2 * j], node.partial[2 * j + 1], reduceOp);
+    }
+  }
+
+  if (offset == 1) {
+    const Manifold lhs = Evaluate(node.children[0]);
+    node.result = m > 0 ? Combine(lhs, node.partial[1], OpType::Subtract) : lhs;
+  } else {
+    node.result = m > 0 ? node.partial[1] : Manifold();
+  }
+  node.dirtyChildren.clear();
+  node.dirty = false;
+  return node.result;
+}
+
+}  // namespace manifold
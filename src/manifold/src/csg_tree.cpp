@@ -19,7 +19,10 @@
 #endif
 
 #include <algorithm>
-#include <variant>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <unordered_map>
 
 #include "boolean3.h"
 #include "csg_tree.h"
@@ -31,70 +34,225 @@ constexpr int kParallelThreshold = 4096;
 
 namespace {
 using namespace manifold;
-struct Transform4x3 {
-  const glm::mat4x3 transform;
+/**
+ * Bounding box of the leaf in its final position, without applying its
+ * transform to the mesh. Box::Transform is only valid for axis-aligned
+ * transforms, so the corners are transformed instead.
+ */
+Box TransformedBox(const CsgLeafNode &leaf) {
+  const Box bBox = leaf.GetBaseImpl()->bBox_;
+  const glm::mat4x3 transform = leaf.GetTransform();
+  if (transform == glm::mat4x3(1.0f) || !bBox.IsFinite()) return bBox;
+  Box out;
+  for (int i = 0; i < 8; ++i) {
+    const glm::vec3 corner(i & 1 ? bBox.max.x : bBox.min.x,
+                           i & 2 ? bBox.max.y : bBox.min.y,
+                           i & 4 ? bBox.max.z : bBox.min.z);
+    out.Union(transform * glm::vec4(corner, 1.0f));
+  }
+  return out;
+}
 
-  glm::vec3 operator()(glm::vec3 position) {
-    return transform * glm::vec4(position, 1.0f);
+// A result cut short by cancellation, which must not replace the tree it was
+// evaluated from.
+bool IsCancelled(const std::shared_ptr<CsgLeafNode> &leaf) {
+  return leaf != nullptr &&
+         leaf->GetBaseImpl()->status_ == Manifold::Error::Cancelled;
+}
+
+struct MeshCompare {
+  bool operator()(const std::shared_ptr<CsgLeafNode> &a,
+                  const std::shared_ptr<CsgLeafNode> &b) {
+    return a->GetBaseImpl()->NumVert() < b->GetBaseImpl()->NumVert();
   }
 };
 
-struct UpdateHalfedge {
-  const int nextVert;
-  const int nextEdge;
-  const int nextFace;
+/**
+ * Approximate heap footprint of a mesh, used to enforce the cache budget.
+ */
+size_t ImplBytes(const Manifold::Impl &impl) {
+  const auto &relation = impl.meshRelation_;
+  return sizeof(Manifold::Impl) + impl.vertPos_.size() * sizeof(glm::vec3) +
+         impl.halfedge_.size() * sizeof(Halfedge) +
+         impl.vertNormal_.size() * sizeof(glm::vec3) +
+         impl.faceNormal_.size() * sizeof(glm::vec3) +
+         impl.halfedgeTangent_.size() * sizeof(glm::vec4) +
+         relation.properties.size() * sizeof(float) +
+         relation.triRef.size() * sizeof(TriRef) +
+         relation.triProperties.size() * sizeof(glm::ivec3) +
+         // the collider stores two boxes and three indices per triangle
+         impl.NumTri() * (2 * sizeof(Box) + 3 * sizeof(int));
+}
+
+struct BooleanKey {
+  const Manifold::Impl *a;
+  const Manifold::Impl *b;
+  glm::mat4x3 relative;
+  OpType op;
 
-  Halfedge operator()(Halfedge edge) {
-    edge.startVert += nextVert;
-    edge.endVert += nextVert;
-    edge.pairedHalfedge += nextEdge;
-    edge.face += nextFace;
-    return edge;
+  bool operator==(const BooleanKey &other) const {
+    return a == other.a && b == other.b && relative == other.relative &&
+           op == other.op;
   }
 };
 
-struct UpdateTriProp {
-  const int nextProp;
-
-  glm::ivec3 operator()(glm::ivec3 tri) {
-    tri += nextProp;
-    return tri;
+struct BooleanKeyHash {
+  size_t operator()(const BooleanKey &key) const {
+    size_t hash = std::hash<const void *>()(key.a);
+    auto combine = [&hash](size_t value) {
+      hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    };
+    combine(std::hash<const void *>()(key.b));
+    combine(static_cast<size_t>(key.op));
+    for (int col : {0, 1, 2, 3}) {
+      for (int row : {0, 1, 2}) {
+        uint32_t bits;
+        std::memcpy(&bits, &key.relative[col][row], sizeof(bits));
+        combine(bits);
+      }
+    }
+    return hash;
   }
 };
 
-struct UpdateMeshIDs {
-  const int offset;
+/**
+ * Process-wide LRU cache of Boolean results. The inputs are identified by
+ * address, and weak references to them guard against a freed address being
+ * reused by an unrelated mesh.
+ */
+class BooleanCache {
+ public:
+  std::shared_ptr<const Manifold::Impl> Find(
+      const BooleanKey &key, const std::shared_ptr<const Manifold::Impl> &a,
+      const std::shared_ptr<const Manifold::Impl> &b) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = map_.find(key);
+    if (it == map_.end()) {
+      ++stats_.misses;
+      return nullptr;
+    }
+    auto entry = it->second;
+    if (entry->a.lock() != a || entry->b.lock() != b) {
+      Erase(it);
+      ++stats_.misses;
+      return nullptr;
+    }
+    ++stats_.hits;
+    lru_.splice(lru_.begin(), lru_, entry);
+    return entry->result;
+  }
 
-  TriRef operator()(TriRef ref) {
-    ref.meshID += offset;
-    return ref;
+  void Insert(const BooleanKey &key,
+              const std::shared_ptr<const Manifold::Impl> &a,
+              const std::shared_ptr<const Manifold::Impl> &b,
+              const std::shared_ptr<const Manifold::Impl> &result,
+              size_t budget) {
+    const size_t bytes = ImplBytes(*result);
+    std::lock_guard<std::mutex> lock(mutex_);
+    // another thread may have computed the same result concurrently
+    auto it = map_.find(key);
+    if (it != map_.end()) Erase(it);
+    if (bytes > budget) return;
+    lru_.push_front({key, a, b, result, bytes});
+    map_[key] = lru_.begin();
+    stats_.bytes += bytes;
+    while (stats_.bytes > budget) Erase(map_.find(lru_.back().key));
   }
-};
 
-struct CheckOverlap {
-  VecView<const Box> boxes;
-  const size_t i;
-  bool operator()(int j) { return boxes[i].DoesOverlap(boxes[j]); }
-};
+  BooleanCacheStats Stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    BooleanCacheStats stats = stats_;
+    stats.entries = lru_.size();
+    return stats;
+  }
 
-using SharedImpl = std::variant<std::shared_ptr<const Manifold::Impl>,
-                                std::shared_ptr<Manifold::Impl>>;
-struct GetImplPtr {
-  const Manifold::Impl *operator()(const SharedImpl &p) {
-    if (std::holds_alternative<std::shared_ptr<const Manifold::Impl>>(p)) {
-      return std::get_if<std::shared_ptr<const Manifold::Impl>>(&p)->get();
-    } else {
-      return std::get_if<std::shared_ptr<Manifold::Impl>>(&p)->get();
-    }
+  void Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    map_.clear();
+    lru_.clear();
+    stats_ = BooleanCacheStats();
+  }
+
+ private:
+  struct Entry {
+    BooleanKey key;
+    std::weak_ptr<const Manifold::Impl> a;
+    std::weak_ptr<const Manifold::Impl> b;
+    std::shared_ptr<const Manifold::Impl> result;
+    size_t bytes;
   };
-};
+  using EntryIter = std::list<Entry>::iterator;
 
-struct MeshCompare {
-  bool operator()(const SharedImpl &a, const SharedImpl &b) {
-    return GetImplPtr()(a)->NumVert() < GetImplPtr()(b)->NumVert();
+  void Erase(std::unordered_map<BooleanKey, EntryIter, BooleanKeyHash>::iterator
+                 it) {
+    stats_.bytes -= it->second->bytes;
+    lru_.erase(it->second);
+    map_.erase(it);
   }
+
+  std::mutex mutex_;
+  std::list<Entry> lru_;
+  std::unordered_map<BooleanKey, EntryIter, BooleanKeyHash> map_;
+  BooleanCacheStats stats_;
 };
 
+BooleanCache &GetBooleanCache() {
+  static BooleanCache cache;
+  return cache;
+}
+
+/**
+ * Boolean of two leaf nodes. When the result cache is enabled, the operation
+ * is performed in the frame of a, so that the result can be reused for any
+ * placement of the pair that keeps their relative transform. The input nodes
+ * are not modified in that case.
+ */
+std::shared_ptr<CsgLeafNode> SimpleBoolean(
+    const std::shared_ptr<CsgLeafNode> &a,
+    const std::shared_ptr<CsgLeafNode> &b, OpType op) {
+  // A transformed leaf is realized as a copy of its base mesh, which inherits
+  // the base's edge cache, so build it there once for every placement.
+  for (const auto &leaf : {a, b}) {
+    if (leaf->GetTransform() != glm::mat4x3(1.0f))
+      leaf->GetBaseImpl()->GetEdgeCache();
+  }
+  const size_t budget = ManifoldParams().booleanCacheSize;
+  if (budget > 0) {
+    const glm::mat4x3 aTransform = a->GetTransform();
+    glm::mat4x3 relative =
+        glm::inverse(glm::mat4(aTransform)) * glm::mat4(b->GetTransform());
+    bool finite = true;
+    for (int col : {0, 1, 2, 3}) {
+      for (int row : {0, 1, 2}) {
+        // map -0 to +0 so that equal keys hash equally
+        relative[col][row] += 0.0f;
+        finite &= glm::isfinite(relative[col][row]);
+      }
+    }
+    if (finite) {
+      const auto aImpl = a->GetBaseImpl();
+      const auto bImpl = b->GetBaseImpl();
+      const BooleanKey key{aImpl.get(), bImpl.get(), relative, op};
+      auto &cache = GetBooleanCache();
+      auto result = cache.Find(key, aImpl, bImpl);
+      if (result == nullptr) {
+        auto bLocal = bImpl;
+        if (relative != glm::mat4x3(1.0f))
+          bLocal =
+              std::make_shared<const Manifold::Impl>(bImpl->Transform(relative));
+        Boolean3 boolean(*aImpl, *bLocal, op);
+        result = std::make_shared<const Manifold::Impl>(boolean.Result(op));
+        if (result->status_ != Manifold::Error::Cancelled)
+          cache.Insert(key, aImpl, bImpl, result, budget);
+      }
+      return std::make_shared<CsgLeafNode>(result, aTransform);
+    }
+  }
+  Boolean3 boolean(*a->GetImpl(), *b->GetImpl(), op);
+  return std::make_shared<CsgLeafNode>(
+      std::make_shared<const Manifold::Impl>(boolean.Result(op)));
+}
+
 }  // namespace
 namespace manifold {
 
@@ -138,6 +296,39 @@ std::shared_ptr<CsgNode> CsgNode::Rotate(float xDegrees, float yDegrees,
   return Transform(transform);
 }
 
+std::vector<std::shared_ptr<CsgLeafNode>> CsgNode::DisjointLeaves() const {
+  std::vector<std::shared_ptr<CsgLeafNode>> leaves;
+  if (!GetLeaves(leaves, glm::mat4x3(1.0f))) return {};
+  leaves.erase(std::remove_if(leaves.begin(), leaves.end(),
+                              [](const std::shared_ptr<CsgLeafNode> &leaf) {
+                                return leaf->GetBaseImpl()->IsEmpty();
+                              }),
+               leaves.end());
+  const int numLeaf = leaves.size();
+  if (numLeaf <= 1) return leaves;
+
+  // the same test BatchUnion() uses to compose children without a Boolean
+  Vec<Box> boxes(numLeaf);
+  Vec<uint32_t> morton(numLeaf);
+  Box bBox;
+  for (int i = 0; i < numLeaf; i++) {
+    boxes[i] = TransformedBox(*leaves[i]);
+    bBox = bBox.Union(boxes[i]);
+  }
+  for (int i = 0; i < numLeaf; i++) {
+    morton[i] = Collider::MortonCode(boxes[i].Center(), bBox);
+  }
+  stable_sort(autoPolicy(numLeaf), zip(morton.begin(), boxes.begin()),
+              zip(morton.end(), boxes.end()),
+              [](const thrust::tuple<uint32_t, Box> &a,
+                 const thrust::tuple<uint32_t, Box> &b) {
+                return thrust::get<0>(a) < thrust::get<0>(b);
+              });
+  Collider collider(boxes, morton);
+  if (collider.Collisions<true>(boxes.cview()).size() > 0) return {};
+  return leaves;
+}
+
 CsgLeafNode::CsgLeafNode() : pImpl_(std::make_shared<Manifold::Impl>()) {}
 
 CsgLeafNode::CsgLeafNode(std::shared_ptr<const Manifold::Impl> pImpl_)
@@ -147,11 +338,29 @@ CsgLeafNode::CsgLeafNode(std::shared_ptr<const Manifold::Impl> pImpl_,
                          glm::mat4x3 transform_)
     : pImpl_(pImpl_), transform_(transform_) {}
 
+CsgLeafNode::CsgLeafNode(const CsgLeafNode &other)
+    : pImpl_(other.pImpl_),
+      transform_(other.transform_),
+      realized_(std::atomic_load(&other.realized_)) {}
+
+/**
+ * The mesh with transform_ applied. The transformed copy is built on first use
+ * and published once, so this may be called from several threads; a thread
+ * that loses the race discards its copy and returns the published one.
+ */
 std::shared_ptr<const Manifold::Impl> CsgLeafNode::GetImpl() const {
   if (transform_ == glm::mat4x3(1.0f)) return pImpl_;
-  pImpl_ =
+  std::shared_ptr<const Manifold::Impl> realized = std::atomic_load(&realized_);
+  if (realized != nullptr) return realized;
+  realized =
       std::make_shared<const Manifold::Impl>(pImpl_->Transform(transform_));
-  transform_ = glm::mat4x3(1.0f);
+  std::shared_ptr<const Manifold::Impl> published;
+  if (!std::atomic_compare_exchange_strong(&realized_, &published, realized))
+    return published;
+  return realized;
+}
+
+std::shared_ptr<const Manifold::Impl> CsgLeafNode::GetBaseImpl() const {
   return pImpl_;
 }
 
@@ -167,6 +376,13 @@ std::shared_ptr<CsgNode> CsgLeafNode::Transform(const glm::mat4x3 &m) const {
 
 CsgNodeType CsgLeafNode::GetNodeType() const { return CsgNodeType::Leaf; }
 
+bool CsgLeafNode::GetLeaves(std::vector<std::shared_ptr<CsgLeafNode>> &leaves,
+                            const glm::mat4x3 &transform) const {
+  leaves.push_back(
+      std::make_shared<CsgLeafNode>(pImpl_, transform * glm::mat4(transform_)));
+  return true;
+}
+
 /**
  * Efficient union of a set of pairwise disjoint meshes.
  */
@@ -182,7 +398,15 @@ Manifold::Impl CsgLeafNode::Compose(
   std::vector<int> edgeIndices;
   std::vector<int> triIndices;
   std::vector<int> propVertIndices;
+  // Since the nodes may be copies containing the same meshIDs, each node's
+  // meshIDs are renumbered into a range of its own, so that every node
+  // instance keeps unique meshIDs.
+  std::vector<Vec<int>> meshIDs;
+  std::vector<int> meshIDIndices;
+  int numMeshID = 0;
   int numPropOut = 0;
+  bool hasTangents = true;
+  meshIDs.reserve(nodes.size());
   for (auto &node : nodes) {
     float nodeOldScale = node->pImpl_->bBox_.Scale();
     float nodeNewScale =
@@ -197,6 +421,14 @@ Manifold::Impl CsgLeafNode::Compose(
     edgeIndices.push_back(numEdge * 2);
     triIndices.push_back(numTri);
     propVertIndices.push_back(numPropVert);
+    meshIDIndices.push_back(numMeshID);
+    const auto &meshIDtransform = node->pImpl_->meshRelation_.meshIDtransform;
+    meshIDs.emplace_back(meshIDtransform.size());
+    int j = 0;
+    for (const auto &pair : meshIDtransform) meshIDs.back()[j++] = pair.first;
+    numMeshID += meshIDtransform.size();
+    hasTangents = hasTangents && node->pImpl_->halfedgeTangent_.size() ==
+                                     node->pImpl_->halfedge_.size();
     numVert += node->pImpl_->NumVert();
     numEdge += node->pImpl_->NumEdge();
     numTri += node->pImpl_->NumTri();
@@ -212,7 +444,8 @@ Manifold::Impl CsgLeafNode::Compose(
   combined.vertPos_.resize(numVert);
   combined.halfedge_.resize(2 * numEdge);
   combined.faceNormal_.resize(numTri);
-  combined.halfedgeTangent_.resize(2 * numEdge);
+  // Tangents are kept only if every node has them.
+  if (hasTangents) combined.halfedgeTangent_.resize(2 * numEdge);
   combined.meshRelation_.triRef.resize(numTri);
   if (numPropOut > 0) {
     combined.meshRelation_.numProp = numPropOut;
@@ -226,105 +459,27 @@ Manifold::Impl CsgLeafNode::Compose(
   if (nodes.size() > 1 && policy == ExecutionPolicy::Par)
     policy = ExecutionPolicy::Seq;
 
-  for_each_n(
-      nodes.size() > 1 ? ExecutionPolicy::Par : ExecutionPolicy::Seq,
-      countAt(0), nodes.size(),
-      [&nodes, &vertIndices, &edgeIndices, &triIndices, &propVertIndices,
-       numPropOut, &combined, policy](int i) {
-        auto &node = nodes[i];
-        copy(policy, node->pImpl_->halfedgeTangent_.begin(),
-             node->pImpl_->halfedgeTangent_.end(),
-             combined.halfedgeTangent_.begin() + edgeIndices[i]);
-        transform(
-            policy, node->pImpl_->halfedge_.begin(),
-            node->pImpl_->halfedge_.end(),
-            combined.halfedge_.begin() + edgeIndices[i],
-            UpdateHalfedge({vertIndices[i], edgeIndices[i], triIndices[i]}));
-
-        if (numPropOut > 0) {
-          auto start =
-              combined.meshRelation_.triProperties.begin() + triIndices[i];
-          if (node->pImpl_->NumProp() > 0) {
-            auto &triProp = node->pImpl_->meshRelation_.triProperties;
-            transform(policy, triProp.begin(), triProp.end(), start,
-                      UpdateTriProp({propVertIndices[i]}));
-
-            const int numProp = node->pImpl_->NumProp();
-            auto &oldProp = node->pImpl_->meshRelation_.properties;
-            auto &newProp = combined.meshRelation_.properties;
-            for (int p = 0; p < numProp; ++p) {
-              strided_range<Vec<float>::IterC> oldRange(oldProp.begin() + p,
-                                                        oldProp.end(), numProp);
-              strided_range<Vec<float>::Iter> newRange(
-                  newProp.begin() + numPropOut * propVertIndices[i] + p,
-                  newProp.end(), numPropOut);
-              copy(policy, oldRange.begin(), oldRange.end(), newRange.begin());
-            }
-          } else {
-            // point all triangles at single new property of zeros.
-            fill(policy, start, start + node->pImpl_->NumTri(),
-                 glm::ivec3(propVertIndices[i]));
-          }
-        }
-
-        if (node->transform_ == glm::mat4x3(1.0f)) {
-          copy(policy, node->pImpl_->vertPos_.begin(),
-               node->pImpl_->vertPos_.end(),
-               combined.vertPos_.begin() + vertIndices[i]);
-          copy(policy, node->pImpl_->faceNormal_.begin(),
-               node->pImpl_->faceNormal_.end(),
-               combined.faceNormal_.begin() + triIndices[i]);
-        } else {
-          // no need to apply the transform to the node, just copy the vertices
-          // and face normals and apply transform on the fly
-          auto vertPosBegin = thrust::make_transform_iterator(
-              node->pImpl_->vertPos_.begin(), Transform4x3({node->transform_}));
-          glm::mat3 normalTransform =
-              glm::inverse(glm::transpose(glm::mat3(node->transform_)));
-          auto faceNormalBegin = thrust::make_transform_iterator(
-              node->pImpl_->faceNormal_.begin(),
-              TransformNormals({normalTransform}));
-          copy_n(policy, vertPosBegin, node->pImpl_->vertPos_.size(),
-                 combined.vertPos_.begin() + vertIndices[i]);
-          copy_n(policy, faceNormalBegin, node->pImpl_->faceNormal_.size(),
-                 combined.faceNormal_.begin() + triIndices[i]);
-
-          const bool invert = glm::determinant(glm::mat3(node->transform_)) < 0;
-          for_each_n(policy,
-                     zip(combined.halfedgeTangent_.begin() + edgeIndices[i],
-                         countAt(0)),
-                     node->pImpl_->halfedgeTangent_.size(),
-                     TransformTangents{glm::mat3(node->transform_), invert,
-                                       node->pImpl_->halfedgeTangent_,
-                                       node->pImpl_->halfedge_});
-          if (invert)
-            for_each_n(policy,
-                       zip(combined.meshRelation_.triRef.begin(),
-                           countAt(triIndices[i])),
-                       node->pImpl_->NumTri(), FlipTris({combined.halfedge_}));
-        }
-        // Since the nodes may be copies containing the same meshIDs, it is
-        // important to add an offset so that each node instance gets
-        // unique meshIDs.
-        const int offset = i * Manifold::Impl::meshIDCounter_;
-        transform(policy, node->pImpl_->meshRelation_.triRef.begin(),
-                  node->pImpl_->meshRelation_.triRef.end(),
-                  combined.meshRelation_.triRef.begin() + triIndices[i],
-                  UpdateMeshIDs({offset}));
-      });
+  for_each_n(nodes.size() > 1 ? ExecutionPolicy::Par : ExecutionPolicy::Seq,
+             countAt(0), nodes.size(), [&](int i) {
+               const MeshOffset offset{vertIndices[i], edgeIndices[i],
+                                       triIndices[i], propVertIndices[i],
+                                       meshIDIndices[i]};
+               AppendMesh(policy, *nodes[i]->pImpl_, nodes[i]->transform_,
+                          combined, offset, meshIDs[i].cview());
+             });
 
   for (int i = 0; i < nodes.size(); i++) {
-    auto &node = nodes[i];
-    const int offset = i * Manifold::Impl::meshIDCounter_;
-
-    for (const auto pair : node->pImpl_->meshRelation_.meshIDtransform) {
-      combined.meshRelation_.meshIDtransform[pair.first + offset] = pair.second;
+    int meshID = meshIDIndices[i];
+    for (const auto &pair : nodes[i]->pImpl_->meshRelation_.meshIDtransform) {
+      Manifold::Impl::Relation relation = pair.second;
+      relation.transform = nodes[i]->transform_ * glm::mat4(relation.transform);
+      combined.meshRelation_.meshIDtransform[meshID++] = relation;
     }
   }
 
   // required to remove parts that are smaller than the precision
   combined.SimplifyTopology();
-  combined.Finish();
+  combined.Finish(ManifoldParams().keepComposeOrder);
   combined.IncrementMeshIDs();
   return combined;
 }
@@ -400,222 +555,294 @@ std::shared_ptr<CsgNode> CsgOpNode::Transform(const glm::mat4x3 &m) const {
 }
 
 std::shared_ptr<CsgLeafNode> CsgOpNode::ToLeafNode() const {
-  if (cache_ != nullptr) return cache_;
-  // turn the children into leaf nodes
-  GetChildren();
-  auto impl = impl_.GetGuard();
-  auto &children_ = impl->children_;
-  if (children_.size() > 1) {
+  std::shared_ptr<CsgLeafNode> cache = std::atomic_load(&cache_);
+  if (cache != nullptr) return cache;
+  const std::shared_ptr<CsgLeafNode> leaf = Evaluate();
+  if (leaf == nullptr) return nullptr;
+  // the result is a CsgLeafNode, and its Transform will give CsgLeafNode as
+  // well
+  cache = std::dynamic_pointer_cast<CsgLeafNode>(leaf->Transform(transform_));
+  if (IsCancelled(leaf)) return cache;
+  // Publish exactly once; a thread that lost the race returns the winner's.
+  std::shared_ptr<CsgLeafNode> published;
+  if (!std::atomic_compare_exchange_strong(&cache_, &published, cache))
+    return published;
+  return cache;
+}
+
+/**
+ * Evaluates this node without its transform, in the state shared with its
+ * transformed copies. The first caller computes the result and later callers
+ * wait for it. No lock is held while computing, so that shared subtrees can be
+ * evaluated by other tasks meanwhile. The computation is isolated, so that
+ * while it waits this thread only picks up tasks of its own subtree, none of
+ * which can need this node's result. A cancelled result is handed to the
+ * waiting callers but not kept, and the children are left in place.
+ */
+std::shared_ptr<CsgLeafNode> CsgOpNode::Evaluate() const {
+  std::promise<std::shared_ptr<CsgLeafNode>> promise;
+  std::shared_future<std::shared_ptr<CsgLeafNode>> pending;
+  std::vector<std::shared_ptr<CsgNode>> children;
+  {
+    auto impl = impl_.GetGuard();
+    pending = impl->leaf_;
+    if (!pending.valid()) {
+      impl->leaf_ = promise.get_future().share();
+      children = impl->children_;
+    }
+  }
+  if (pending.valid()) {
+    const std::shared_ptr<CsgLeafNode> leaf = pending.get();
+    // the evaluation was cancelled in its caller's context, not this one
+    if (IsCancelled(leaf) && !Cancellation::Check()) return Evaluate();
+    return leaf;
+  }
+
+  std::shared_ptr<CsgLeafNode> leaf;
+  auto compute = [&]() {
+    std::vector<std::shared_ptr<CsgLeafNode>> leaves = ToLeafNodes(children);
+    if (leaves.size() == 0) return;
+    if (leaves.size() == 1) {
+      leaf = leaves.front();
+      return;
+    }
     switch (op_) {
       case CsgNodeType::Union:
-        BatchUnion();
+        leaf = BatchUnion(leaves);
         break;
-      case CsgNodeType::Intersection: {
-        std::vector<std::shared_ptr<const Manifold::Impl>> impls;
-        for (auto &child : children_) {
-          impls.push_back(
-              std::dynamic_pointer_cast<CsgLeafNode>(child)->GetImpl());
-        }
-        children_.clear();
-        children_.push_back(std::make_shared<CsgLeafNode>(
-            BatchBoolean(OpType::Intersect, impls)));
+      case CsgNodeType::Intersection:
+        leaf = BatchBoolean(OpType::Intersect, leaves);
         break;
-      };
       case CsgNodeType::Difference: {
         // take the lhs out and treat the remaining nodes as the rhs, perform
         // union optimization for them
-        auto lhs = std::dynamic_pointer_cast<CsgLeafNode>(children_.front());
-        children_.erase(children_.begin());
-        BatchUnion();
-        auto rhs = std::dynamic_pointer_cast<CsgLeafNode>(children_.front());
-        children_.clear();
-        Boolean3 boolean(*lhs->GetImpl(), *rhs->GetImpl(), OpType::Subtract);
-        children_.push_back(
-            std::make_shared<CsgLeafNode>(std::make_shared<Manifold::Impl>(
-                boolean.Result(OpType::Subtract))));
-      };
+        const std::shared_ptr<CsgLeafNode> lhs = leaves.front();
+        leaves.erase(leaves.begin());
+        leaf = SimpleBoolean(lhs, BatchUnion(leaves), OpType::Subtract);
+        break;
+      }
       case CsgNodeType::Leaf:
         // unreachable
         break;
     }
-  } else if (children_.size() == 0) {
-    return nullptr;
-  }
-  // children_ must contain only one CsgLeafNode now, and its Transform will
-  // give CsgLeafNode as well
-  cache_ = std::dynamic_pointer_cast<CsgLeafNode>(
-      children_.front()->Transform(transform_));
-  return cache_;
+  };
+  try {
+#if MANIFOLD_PAR == 'T' && __has_include(<tbb/tbb.h>)
+    tbb::this_task_arena::isolate(compute);
+#else
+    compute();
+#endif
+  } catch (...) {
+    // let a later call try again
+    impl_.GetGuard()->leaf_ = {};
+    promise.set_exception(std::current_exception());
+    throw;
+  }
+  if (IsCancelled(leaf)) {
+    // keep the children, so a later call can evaluate them in full
+    impl_.GetGuard()->leaf_ = {};
+  } else if (leaf != nullptr) {
+    impl_.GetGuard()->children_ = {leaf};
+  }
+  promise.set_value(leaf);
+  return leaf;
 }
 
 /**
  * Efficient boolean operation on a set of nodes utilizing commutativity of the
  * operation. Only supports union and intersection.
  */
-std::shared_ptr<Manifold::Impl> CsgOpNode::BatchBoolean(
-    OpType operation,
-    std::vector<std::shared_ptr<const Manifold::Impl>> &results) {
+std::shared_ptr<CsgLeafNode> CsgOpNode::BatchBoolean(
+    OpType operation, std::vector<std::shared_ptr<CsgLeafNode>> &results) {
   ZoneScoped;
-  auto getImplPtr = GetImplPtr();
   ASSERT(operation != OpType::Subtract, logicErr,
          "BatchBoolean doesn't support Difference.");
   // common cases
-  if (results.size() == 0) return std::make_shared<Manifold::Impl>();
-  if (results.size() == 1)
-    return std::make_shared<Manifold::Impl>(*results.front());
-  if (results.size() == 2) {
-    Boolean3 boolean(*results[0], *results[1], operation);
-    return std::make_shared<Manifold::Impl>(boolean.Result(operation));
+  if (results.size() == 0) return std::make_shared<CsgLeafNode>();
+  if (results.size() == 1) return results.front();
+  if (results.size() == 2)
+    return SimpleBoolean(results[0], results[1], operation);
+  // Without the cache, SimpleBoolean applies the transforms of its inputs; do
+  // it here since the same node may appear more than once in results.
+  if (ManifoldParams().booleanCacheSize == 0) {
+    for (auto &result : results) result->GetImpl();
   }
 #if MANIFOLD_PAR == 'T' && __has_include(<tbb/tbb.h>)
-  if (!ManifoldParams().deterministic) {
+  if (!ManifoldParams().deterministic && !SerialScope::Active()) {
     tbb::task_group group;
-    tbb::concurrent_priority_queue<SharedImpl, MeshCompare> queue(
-        results.size());
+    tbb::concurrent_priority_queue<std::shared_ptr<CsgLeafNode>, MeshCompare>
+        queue(results.size());
     for (auto result : results) {
       queue.emplace(result);
     }
     results.clear();
+    const Cancellation *cancellation = Cancellation::Current();
     std::function<void()> process = [&]() {
+      Cancellation::Scope cancel(cancellation);
       while (queue.size() > 1) {
-        SharedImpl a, b;
+        std::shared_ptr<CsgLeafNode> a, b;
         if (!queue.try_pop(a)) continue;
         if (!queue.try_pop(b)) {
           queue.push(a);
           continue;
         }
         group.run([&, a, b]() {
-          const Manifold::Impl *aImpl;
-          const Manifold::Impl *bImpl;
-          Boolean3 boolean(*getImplPtr(a), *getImplPtr(b), operation);
-          queue.emplace(
-              std::make_shared<Manifold::Impl>(boolean.Result(operation)));
+          Cancellation::Scope cancel(cancellation);
+          queue.emplace(SimpleBoolean(a, b, operation));
           return group.run(process);
         });
       }
     };
     group.run_and_wait(process);
-    SharedImpl r;
+    std::shared_ptr<CsgLeafNode> r;
     queue.try_pop(r);
-    return *std::get_if<std::shared_ptr<Manifold::Impl>>(&r);
+    return r;
   }
 #endif
-  // apply boolean operations starting from smaller meshes
-  // the assumption is that boolean operations on smaller meshes is faster,
-  // due to less data being copied and processed
+  // Fixed reduction tree: order the operands by size, with ties kept in input
+  // order, and combine neighbors level by level, starting from the smaller
+  // meshes. The Booleans of a level are independent and run in parallel, while
+  // the tree itself does not depend on scheduling, so the result is
+  // reproducible across runs and thread counts.
   auto cmpFn = MeshCompare();
-  std::make_heap(results.begin(), results.end(), cmpFn);
   while (results.size() > 1) {
-    std::pop_heap(results.begin(), results.end(), cmpFn);
-    auto a = std::move(results.back());
-    results.pop_back();
-    std::pop_heap(results.begin(), results.end(), cmpFn);
-    auto b = std::move(results.back());
-    results.pop_back();
-    // boolean operation
-    Boolean3 boolean(*a, *b, operation);
-    if (results.size() == 0) {
-      return std::make_shared<Manifold::Impl>(boolean.Result(operation));
-    }
-    results.push_back(
-        std::make_shared<const Manifold::Impl>(boolean.Result(operation)));
-    std::push_heap(results.begin(), results.end(), cmpFn);
+    std::stable_sort(results.begin(), results.end(), cmpFn);
+    const int numPairs = results.size() / 2;
+    std::vector<std::shared_ptr<CsgLeafNode>> next(numPairs +
+                                                   results.size() % 2);
+    const Cancellation *cancellation = Cancellation::Current();
+    for_each_n(numPairs > 1 ? ExecutionPolicy::Par : ExecutionPolicy::Seq,
+               countAt(0), numPairs, [&, operation](int i) {
+                 Cancellation::Scope cancel(cancellation);
+                 next[i] = SimpleBoolean(results[2 * i], results[2 * i + 1],
+                                         operation);
+               });
+    if (results.size() % 2 == 1) next.back() = results.back();
+    results = std::move(next);
   }
-  return std::make_shared<Manifold::Impl>(*results.front());
+  return results.front();
 }
 
 /**
  * Efficient union operation on a set of nodes by doing Compose as much as
- * possible.
- * Note: Due to some unknown issues with `Compose`, we are now doing
- * `BatchBoolean` instead of using `Compose` for non-intersecting manifolds.
+ * possible. The children are sorted by the Morton code of their bounding box
+ * centers and a self-collision of their boxes gives the overlap graph, which
+ * is greedily colored into sets of pairwise disjoint children. Each set is
+ * composed and the results are unioned, in spatial order.
  */
-void CsgOpNode::BatchUnion() const {
+std::shared_ptr<CsgLeafNode> CsgOpNode::BatchUnion(
+    const std::vector<std::shared_ptr<CsgLeafNode>> &children) {
   ZoneScoped;
-  // INVARIANT: children_ is a vector of leaf nodes
-  // this kMaxUnionSize is a heuristic to avoid the pairwise disjoint check
-  // with O(n^2) complexity to take too long.
-  // If the number of children exceeded this limit, we will operate on chunks
-  // with size kMaxUnionSize.
-  constexpr int kMaxUnionSize = 1000;
-  auto impl = impl_.GetGuard();
-  auto &children_ = impl->children_;
-  while (children_.size() > 1) {
-    const int start = (children_.size() > kMaxUnionSize)
-                          ? (children_.size() - kMaxUnionSize)
-                          : 0;
-    Vec<Box> boxes;
-    boxes.reserve(children_.size() - start);
-    for (int i = start; i < children_.size(); i++) {
-      boxes.push_back(std::dynamic_pointer_cast<CsgLeafNode>(children_[i])
-                          ->GetImpl()
-                          ->bBox_);
+  const int numChildren = children.size();
+  if (numChildren == 1) return children.front();
+
+  Vec<Box> boxes(numChildren);
+  Vec<uint32_t> morton(numChildren);
+  Vec<int> leafIdx(numChildren);
+  Box bBox;
+  for (int i = 0; i < numChildren; i++) {
+    boxes[i] = TransformedBox(*children[i]);
+    bBox = bBox.Union(boxes[i]);
+    leafIdx[i] = i;
+  }
+  for (int i = 0; i < numChildren; i++) {
+    morton[i] = Collider::MortonCode(boxes[i].Center(), bBox);
+  }
+  stable_sort(autoPolicy(numChildren),
+              zip(morton.begin(), boxes.begin(), leafIdx.begin()),
+              zip(morton.end(), boxes.end(), leafIdx.end()),
+              [](const thrust::tuple<uint32_t, Box, int> &a,
+                 const thrust::tuple<uint32_t, Box, int> &b) {
+                return thrust::get<0>(a) < thrust::get<0>(b);
+              });
+
+  Collider collider(boxes, morton);
+  SparseIndices overlaps = collider.Collisions<true>(boxes.cview());
+  overlaps.Sort();
+
+  // greedy coloring in Morton order: each child gets the first set that holds
+  // none of its overlapping neighbors.
+  std::vector<int> color(numChildren, -1);
+  std::vector<int> usedBy;
+  std::vector<std::vector<int>> disjointSets;
+  int k = 0;
+  for (int i = 0; i < numChildren; i++) {
+    for (; k < overlaps.size() && overlaps.Get(k, false) == i; ++k) {
+      const int j = overlaps.Get(k, true);
+      if (color[j] >= 0) usedBy[color[j]] = i;
     }
-    // partition the children into a set of disjoint sets
-    // each set contains a set of children that are pairwise disjoint
-    std::vector<Vec<size_t>> disjointSets;
-    for (size_t i = 0; i < boxes.size(); i++) {
-      auto lambda = [&boxes, i](const Vec<size_t> &set) {
-        return std::find_if(set.begin(), set.end(), CheckOverlap({boxes, i})) ==
-               set.end();
-      };
-      auto it = std::find_if(disjointSets.begin(), disjointSets.end(), lambda);
-      if (it == disjointSets.end()) {
-        disjointSets.push_back(std::vector<size_t>{i});
-      } else {
-        it->push_back(i);
-      }
+    int c = 0;
+    while (c < disjointSets.size() && usedBy[c] == i) ++c;
+    if (c == disjointSets.size()) {
+      disjointSets.emplace_back();
+      usedBy.push_back(-1);
     }
-    // compose each set of disjoint children
-    std::vector<std::shared_ptr<const Manifold::Impl>> impls;
-    for (auto &set : disjointSets) {
-      if (set.size() == 1) {
-        impls.push_back(
-            std::dynamic_pointer_cast<CsgLeafNode>(children_[start + set[0]])
-                ->GetImpl());
-      } else {
-        std::vector<std::shared_ptr<CsgLeafNode>> tmp;
-        for (size_t j : set) {
-          tmp.push_back(
-              std::dynamic_pointer_cast<CsgLeafNode>(children_[start + j]));
-        }
-        impls.push_back(
-            std::make_shared<const Manifold::Impl>(CsgLeafNode::Compose(tmp)));
+    color[i] = c;
+    disjointSets[c].push_back(leafIdx[i]);
+  }
+
+  // compose each set of disjoint children
+  std::vector<std::shared_ptr<CsgLeafNode>> impls;
+  for (auto &set : disjointSets) {
+    if (set.size() == 1) {
+      impls.push_back(children[set[0]]);
+    } else {
+      std::vector<std::shared_ptr<CsgLeafNode>> tmp;
+      for (int j : set) {
+        tmp.push_back(children[j]);
       }
+      impls.push_back(std::make_shared<CsgLeafNode>(
+          std::make_shared<const Manifold::Impl>(CsgLeafNode::Compose(tmp))));
     }
-
-    children_.erase(children_.begin() + start, children_.end());
-    children_.push_back(
-        std::make_shared<CsgLeafNode>(BatchBoolean(OpType::Add, impls)));
-    // move it to the front as we process from the back, and the newly added
-    // child should be quite complicated
-    std::swap(children_.front(), children_.back());
   }
+
+  return BatchBoolean(OpType::Add, impls);
 }
 
 /**
- * Flatten the children to a list of leaf nodes and return them.
- * If forceToLeafNodes is true, the list will be guaranteed to be a list of leaf
- * nodes (i.e. no ops). Otherwise, the list may contain ops. Note that this
+ * Returns a snapshot of the children, which may contain ops. Note that this
  * function will not apply the transform to children, as they may be shared with
  * other nodes.
  */
-std::vector<std::shared_ptr<CsgNode>> &CsgOpNode::GetChildren(
-    bool forceToLeafNodes) const {
+std::vector<std::shared_ptr<CsgNode>> CsgOpNode::GetChildren() const {
   auto impl = impl_.GetGuard();
+  return impl->children_;
+}
 
-  if (forceToLeafNodes && !impl->forcedToLeafNodes_) {
-    impl->forcedToLeafNodes_ = true;
-    for_each(impl->children_.size() > 1 && !ManifoldParams().deterministic
-                 ? ExecutionPolicy::Par
-                 : ExecutionPolicy::Seq,
-             impl->children_.begin(), impl->children_.end(), [](auto &child) {
-               if (child->GetNodeType() != CsgNodeType::Leaf) {
-                 child = child->ToLeafNode();
-               }
-             });
+/**
+ * Turns each child into a leaf node. Independent op children are evaluated
+ * concurrently.
+ */
+std::vector<std::shared_ptr<CsgLeafNode>> CsgOpNode::ToLeafNodes(
+    const std::vector<std::shared_ptr<CsgNode>> &children) {
+  std::vector<std::shared_ptr<CsgLeafNode>> leaves(children.size());
+  for (int i = 0; i < children.size(); ++i) {
+    if (children[i]->GetNodeType() == CsgNodeType::Leaf)
+      leaves[i] = std::static_pointer_cast<CsgLeafNode>(children[i]);
   }
-  return impl->children_;
+#if MANIFOLD_PAR == 'T' && __has_include(<tbb/tbb.h>)
+  if (!ManifoldParams().deterministic && !SerialScope::Active()) {
+    // Each op child becomes a task, which recursively spawns the tasks of
+    // its own subtree, so independent branches of any depth (Difference and
+    // Intersection included) are spread over the work-stealing scheduler.
+    // Waiting on the group lets this thread steal work instead of blocking.
+    tbb::task_group group;
+    const Cancellation *cancellation = Cancellation::Current();
+    for (int i = 0; i < children.size(); ++i) {
+      if (leaves[i] != nullptr) continue;
+      group.run([&children, &leaves, i, cancellation]() {
+        Cancellation::Scope cancel(cancellation);
+        leaves[i] = children[i]->ToLeafNode();
+      });
+    }
+    group.wait();
+    return leaves;
+  }
+#endif
+  for (int i = 0; i < children.size(); ++i) {
+    if (leaves[i] == nullptr) leaves[i] = children[i]->ToLeafNode();
+  }
+  return leaves;
 }
 
 void CsgOpNode::SetOp(OpType op) {
@@ -647,4 +874,22 @@ bool CsgOpNode::IsOp(OpType op) {
 
 glm::mat4x3 CsgOpNode::GetTransform() const { return transform_; }
 
+bool CsgOpNode::GetLeaves(std::vector<std::shared_ptr<CsgLeafNode>> &leaves,
+                          const glm::mat4x3 &transform) const {
+  // cache_ already includes transform_.
+  const std::shared_ptr<CsgLeafNode> cache = std::atomic_load(&cache_);
+  if (cache != nullptr) return cache->GetLeaves(leaves, transform);
+  if (op_ != CsgNodeType::Union) return false;
+  const glm::mat4x3 childTransform = transform * glm::mat4(transform_);
+  const std::vector<std::shared_ptr<CsgNode>> children = GetChildren();
+  for (const auto &child : children) {
+    if (!child->GetLeaves(leaves, childTransform)) return false;
+  }
+  return true;
+}
+
+BooleanCacheStats GetBooleanCacheStats() { return GetBooleanCache().Stats(); }
+
+void ClearBooleanCache() { GetBooleanCache().Clear(); }
+
 }  // namespace manifold
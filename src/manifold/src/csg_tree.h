@@ -13,6 +13,8 @@
 // limitations under the License.
 
 #pragma once
+#include <future>
+
 #include "manifold.h"
 #include "utils.h"
 
@@ -32,6 +34,16 @@ class CsgNode : public std::enable_shared_from_this<CsgNode> {
   virtual std::shared_ptr<CsgNode> Boolean(
       const std::shared_ptr<CsgNode> &second, OpType op);
 
+  // The leaves of this node in their final position, if it is a leaf or a
+  // union of leaves with pairwise disjoint bounding boxes; otherwise empty.
+  // Nothing is evaluated, and empty leaves are left out.
+  std::vector<std::shared_ptr<CsgLeafNode>> DisjointLeaves() const;
+
+  // Appends the leaves of this node, transformed by transform, without
+  // evaluating it. Returns false if it contains any op other than a union.
+  virtual bool GetLeaves(std::vector<std::shared_ptr<CsgLeafNode>> &leaves,
+                         const glm::mat4x3 &transform) const = 0;
+
   std::shared_ptr<CsgNode> Translate(const glm::vec3 &t) const;
   std::shared_ptr<CsgNode> Scale(const glm::vec3 &s) const;
   std::shared_ptr<CsgNode> Rotate(float xDegrees = 0, float yDegrees = 0,
@@ -44,9 +56,13 @@ class CsgLeafNode final : public CsgNode {
   CsgLeafNode(std::shared_ptr<const Manifold::Impl> pImpl_);
   CsgLeafNode(std::shared_ptr<const Manifold::Impl> pImpl_,
               glm::mat4x3 transform_);
+  CsgLeafNode(const CsgLeafNode &other);
 
   std::shared_ptr<const Manifold::Impl> GetImpl() const;
 
+  // The untransformed mesh; unlike GetImpl() this never applies transform_.
+  std::shared_ptr<const Manifold::Impl> GetBaseImpl() const;
+
   std::shared_ptr<CsgLeafNode> ToLeafNode() const override;
 
   std::shared_ptr<CsgNode> Transform(const glm::mat4x3 &m) const override;
@@ -55,12 +71,19 @@ class CsgLeafNode final : public CsgNode {
 
   glm::mat4x3 GetTransform() const override;
 
+  bool GetLeaves(std::vector<std::shared_ptr<CsgLeafNode>> &leaves,
+                 const glm::mat4x3 &transform) const override;
+
   static Manifold::Impl Compose(
       const std::vector<std::shared_ptr<CsgLeafNode>> &nodes);
 
  private:
-  mutable std::shared_ptr<const Manifold::Impl> pImpl_;
-  mutable glm::mat4x3 transform_ = glm::mat4x3(1.0f);
+  // pImpl_ and transform_ are fixed at construction, so they can be read from
+  // any thread. realized_ caches pImpl_ with transform_ applied and is only
+  // accessed through std::atomic_load/atomic_compare_exchange_strong.
+  std::shared_ptr<const Manifold::Impl> pImpl_;
+  glm::mat4x3 transform_ = glm::mat4x3(1.0f);
+  mutable std::shared_ptr<const Manifold::Impl> realized_;
 };
 
 class CsgOpNode final : public CsgNode {
@@ -82,28 +105,37 @@ class CsgOpNode final : public CsgNode {
 
   glm::mat4x3 GetTransform() const override;
 
+  bool GetLeaves(std::vector<std::shared_ptr<CsgLeafNode>> &leaves,
+                 const glm::mat4x3 &transform) const override;
+
  private:
   struct Impl {
     std::vector<std::shared_ptr<CsgNode>> children_;
-    bool forcedToLeafNodes_ = false;
+    // Set by the first evaluation; valid while or after it runs.
+    std::shared_future<std::shared_ptr<CsgLeafNode>> leaf_;
   };
   mutable ConcurrentSharedPtr<Impl> impl_ = ConcurrentSharedPtr<Impl>(Impl{});
   CsgNodeType op_;
   glm::mat4x3 transform_ = glm::mat4x3(1.0f);
-  // the following fields are for lazy evaluation, so they are mutable
+  // the following fields are for lazy evaluation, so they are mutable; access
+  // cache_ only through std::atomic_load/atomic_compare_exchange_strong.
   mutable std::shared_ptr<CsgLeafNode> cache_ = nullptr;
 
   void SetOp(OpType);
   bool IsOp(OpType op);
 
-  static std::shared_ptr<Manifold::Impl> BatchBoolean(
-      OpType operation,
-      std::vector<std::shared_ptr<const Manifold::Impl>> &results);
+  static std::shared_ptr<CsgLeafNode> BatchBoolean(
+      OpType operation, std::vector<std::shared_ptr<CsgLeafNode>> &results);
+
+  static std::shared_ptr<CsgLeafNode> BatchUnion(
+      const std::vector<std::shared_ptr<CsgLeafNode>> &children);
+
+  std::shared_ptr<CsgLeafNode> Evaluate() const;
 
-  void BatchUnion() const;
+  std::vector<std::shared_ptr<CsgNode>> GetChildren() const;
 
-  std::vector<std::shared_ptr<CsgNode>> &GetChildren(
-      bool forceToLeafNodes = true) const;
+  static std::vector<std::shared_ptr<CsgLeafNode>> ToLeafNodes(
+      const std::vector<std::shared_ptr<CsgNode>> &children);
 };
 
 }  // namespace manifold
@@ -12,6 +12,11 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <limits>
+
 #include "impl.h"
 #include "par.h"
 
@@ -111,6 +116,80 @@ struct SwappableEdge {
   }
 };
 
+// Returns the fundamental quadric of the plane of tri: the squared distance of
+// a homogeneous point p from that plane is dot(p, Q * p).
+glm::dmat4 PlaneQuadric(VecView<const Halfedge> halfedge,
+                        VecView<const glm::vec3> vertPos, int tri) {
+  glm::dvec3 v[3];
+  for (int i : {0, 1, 2}) v[i] = vertPos[halfedge[3 * tri + i].startVert];
+  const glm::dvec3 cross = glm::cross(v[1] - v[0], v[2] - v[0]);
+  const double area2 = glm::length(cross);
+  if (!(area2 > 0)) return glm::dmat4(0.0);
+  const glm::dvec3 normal = cross / area2;
+  const glm::dvec4 plane(normal, -glm::dot(normal, v[0]));
+  return glm::outerProduct(plane, plane);
+}
+
+struct CollapseCost {
+  VecView<const Halfedge> halfedge;
+  VecView<const glm::vec3> vertPos;
+  VecView<const TriRef> triRef;
+  VecView<const glm::ivec3> triProp;
+  VecView<const glm::dmat4> quadric;
+
+  // True if the triangles around the startVert of edge all belong to one run
+  // and share its property vert.
+  bool Interior(int edge, bool checkRun) const {
+    const int meshID = triRef[edge / 3].meshID;
+    const int prop = triProp.size() > 0 ? triProp[edge / 3][edge % 3] : 0;
+    int current = edge;
+    do {
+      if (checkRun && triRef[current / 3].meshID != meshID) return false;
+      if (triProp.size() > 0 && triProp[current / 3][current % 3] != prop)
+        return false;
+      current = NextHalfedge(halfedge[current].pairedHalfedge);
+    } while (current != edge);
+    return true;
+  }
+
+  // True if moving the startVert of edge onto its endVert would flip or
+  // flatten any of the triangles that remain around it.
+  bool Flips(int edge) const {
+    const int endVert = halfedge[edge].endVert;
+    const glm::vec3 pOld = vertPos[halfedge[edge].startVert];
+    const glm::vec3 pNew = vertPos[endVert];
+    int current = edge;
+    do {
+      const int vertA = halfedge[current].endVert;
+      const int vertB = halfedge[NextHalfedge(current)].endVert;
+      if (vertA != endVert && vertB != endVert) {
+        const glm::vec3 pA = vertPos[vertA];
+        const glm::vec3 pB = vertPos[vertB];
+        const glm::vec3 oldNormal = glm::cross(pA - pOld, pB - pOld);
+        const glm::vec3 newNormal = glm::cross(pA - pNew, pB - pNew);
+        if (!(glm::dot(oldNormal, newNormal) > 0)) return true;
+      }
+      current = NextHalfedge(halfedge[current].pairedHalfedge);
+    } while (current != edge);
+    return false;
+  }
+
+  // Returns the squared quadric error of removing the startVert of edge, or
+  // infinity if that collapse is not allowed.
+  double operator()(int edge) const {
+    constexpr double kInf = std::numeric_limits<double>::infinity();
+    const Halfedge he = halfedge[edge];
+    if (he.pairedHalfedge < 0) return kInf;
+    if (!Interior(edge, true)) return kInf;
+    if (triProp.size() > 0 && !Interior(he.pairedHalfedge, false))
+      return kInf;
+    if (Flips(edge)) return kInf;
+    const glm::dvec4 pNew(glm::dvec3(vertPos[he.endVert]), 1.0);
+    const glm::dmat4 q = quadric[he.startVert] + quadric[he.endVert];
+    return glm::max(0.0, glm::dot(pNew, q * pNew));
+  }
+};
+
 struct SortEntry {
   int start;
   int end;
@@ -141,8 +220,13 @@ namespace manifold {
  *
  * Rather than actually removing the edges, this step merely marks them for
  * removal, by setting vertPos to NaN and halfedge to {-1, -1, -1, -1}.
+ *
+ * If touchedVert is non-empty, only edges with at least one touched vert are
+ * considered; the rest of the mesh is assumed to be clean already, e.g. the
+ * regions of a Boolean result that were copied whole from its inputs. Verts
+ * beyond the end of touchedVert count as touched.
  */
-void Manifold::Impl::SimplifyTopology() {
+void Manifold::Impl::SimplifyTopology(VecView<const char> touchedVert) {
   if (!halfedge_.size()) return;
 
   const int nbEdges = halfedge_.size();
@@ -150,6 +234,15 @@ void Manifold::Impl::SimplifyTopology() {
   int numFlagged = 0;
   Vec<uint8_t> bflags(nbEdges);
 
+  const int numTouched = touchedVert.size();
+  auto isTouched = [&](int edge) {
+    if (numTouched == 0) return true;
+    const Halfedge &halfedge = halfedge_[edge];
+    if (halfedge.startVert < 0) return false;
+    return halfedge.startVert >= numTouched || halfedge.endVert >= numTouched ||
+           touchedVert[halfedge.startVert] || touchedVert[halfedge.endVert];
+  };
+
   // In the case of a very bad triangulation, it is possible to create pinched
   // verts. They must be removed before edge collapse.
   SplitPinchedVerts();
@@ -159,13 +252,13 @@ void Manifold::Impl::SimplifyTopology() {
     Vec<SortEntry> entries;
     entries.reserve(nbEdges / 2);
     for (int i = 0; i < nbEdges; ++i) {
-      if (halfedge_[i].IsForward()) {
+      if (halfedge_[i].IsForward() && isTouched(i)) {
         entries.push_back({halfedge_[i].startVert, halfedge_[i].endVert, i});
       }
     }
 
-    stable_sort(policy, entries.begin(), entries.end());
-    for (int i = 0; i < entries.size() - 1; ++i) {
+    stable_sort(autoPolicy(entries.size()), entries.begin(), entries.end());
+    for (int i = 0; i + 1 < entries.size(); ++i) {
       if (entries[i].start == entries[i + 1].start &&
           entries[i].end == entries[i + 1].end) {
         DedupeEdge(entries[i].index);
@@ -191,14 +284,9 @@ void Manifold::Impl::SimplifyTopology() {
     ZoneScopedN("CollapseShortEdge");
     numFlagged = 0;
     ShortEdge se{halfedge_, vertPos_, precision_};
-    for_each_n(policy, countAt(0), nbEdges, [&](int i) { bflags[i] = se(i); });
-    for (int i = 0; i < nbEdges; ++i) {
-      if (bflags[i]) {
-        CollapseEdge(i, scratchBuffer);
-        scratchBuffer.resize(0);
-        numFlagged++;
-      }
-    }
+    for_each_n(policy, countAt(0), nbEdges,
+               [&](int i) { bflags[i] = isTouched(i) && se(i); });
+    numFlagged = CollapseFlaggedEdges(bflags, scratchBuffer);
   }
 
 #ifdef MANIFOLD_DEBUG
@@ -212,14 +300,9 @@ void Manifold::Impl::SimplifyTopology() {
     ZoneScopedN("CollapseFlaggedEdge");
     numFlagged = 0;
     FlagEdge se{halfedge_, meshRelation_.triRef};
-    for_each_n(policy, countAt(0), nbEdges, [&](int i) { bflags[i] = se(i); });
-    for (int i = 0; i < nbEdges; ++i) {
-      if (bflags[i]) {
-        CollapseEdge(i, scratchBuffer);
-        scratchBuffer.resize(0);
-        numFlagged++;
-      }
-    }
+    for_each_n(policy, countAt(0), nbEdges,
+               [&](int i) { bflags[i] = isTouched(i) && se(i); });
+    numFlagged = CollapseFlaggedEdges(bflags, scratchBuffer);
   }
 
 #ifdef MANIFOLD_DEBUG
@@ -233,7 +316,8 @@ void Manifold::Impl::SimplifyTopology() {
     ZoneScopedN("RecursiveEdgeSwap");
     numFlagged = 0;
     SwappableEdge se{halfedge_, vertPos_, faceNormal_, precision_};
-    for_each_n(policy, countAt(0), nbEdges, [&](int i) { bflags[i] = se(i); });
+    for_each_n(policy, countAt(0), nbEdges,
+               [&](int i) { bflags[i] = isTouched(i) && se(i); });
     std::vector<int> edgeSwapStack;
     std::vector<int> visited(halfedge_.size(), -1);
     int tag = 0;
@@ -440,8 +524,12 @@ void Manifold::Impl::RemoveIfFolded(int edge) {
 // Collapses the given edge by removing startVert. May split the mesh
 // topologically if the collapse would have resulted in a 4-manifold edge. Do
 // not collapse an edge if startVert is pinched - the vert will be marked NaN,
-// but other edges may still be pointing to it.
-void Manifold::Impl::CollapseEdge(const int edge, std::vector<int>& edges) {
+// but other edges may still be pointing to it. If checked, the caller has
+// already verified the collapse, so the redundancy and inversion checks are
+// skipped and every triangle around startVert takes the property vert of
+// endVert.
+void Manifold::Impl::CollapseEdge(const int edge, std::vector<int>& edges,
+                                  bool checked) {
   Vec<TriRef>& triRef = meshRelation_.triRef;
   Vec<glm::ivec3>& triProp = meshRelation_.triProperties;
 
@@ -467,7 +555,7 @@ void Manifold::Impl::CollapseEdge(const int edge, std::vector<int>& edges) {
 
   // Orbit startVert
   int start = halfedge_[tri1edge[1]].pairedHalfedge;
-  if (!shortEdge) {
+  if (!shortEdge && !checked) {
     current = start;
     TriRef refCheck = triRef[toRemove.pairedHalfedge / 3];
     glm::vec3 pLast = vertPos_[halfedge_[tri1edge[1]].endVert];
@@ -519,7 +607,10 @@ void Manifold::Impl::CollapseEdge(const int edge, std::vector<int>& edges) {
       // Update the shifted triangles to the vertBary of endVert
       const int tri = current / 3;
       const int vIdx = current - 3 * tri;
-      if (triRef[tri].meshID == triRef[tri0].meshID &&
+      if (checked) {
+        // The caller has ensured both ends have a single property vert.
+        triProp[tri][vIdx] = triProp[tri0][triVert0];
+      } else if (triRef[tri].meshID == triRef[tri0].meshID &&
           triRef[tri].tri == triRef[tri0].tri) {
         triProp[tri][vIdx] = triProp[tri0][triVert0];
       } else if (triRef[tri].meshID == triRef[tri1].meshID &&
@@ -546,6 +637,114 @@ void Manifold::Impl::CollapseEdge(const int edge, std::vector<int>& edges) {
   RemoveIfFolded(start);
 }
 
+/**
+ * Collapses each flagged edge and returns the number flagged. Serially, the
+ * edges are collapsed in index order. With ExecutionParams::parallelSimplify
+ * they are instead collapsed in rounds of independent sets: every pending
+ * edge claims the verts of the one-rings of both its ends, and the edges that
+ * win all their claims touch disjoint triangles, so they collapse
+ * concurrently. Edges whose collapse would need FormLoop, which appends
+ * verts, are collapsed serially after each round.
+ */
+int Manifold::Impl::CollapseFlaggedEdges(VecView<const uint8_t> flags,
+                                         std::vector<int>& edges) {
+  Vec<int> pending;
+  for (int i = 0; i < flags.size(); ++i) {
+    if (flags[i]) pending.push_back(i);
+  }
+  const int numFlagged = pending.size();
+
+  if (!ManifoldParams().parallelSimplify) {
+    for (const int edge : pending) {
+      CollapseEdge(edge, edges);
+      edges.resize(0);
+    }
+    return numFlagged;
+  }
+
+  enum Status : uint8_t { kDone, kSerial, kClaimed, kWon, kLost };
+  // A claim is keyed on the round in the high bits, so that claims left from
+  // earlier rounds are always outbid without clearing, and on the inverted
+  // position in the low bits, so that earlier edges win within a round.
+  Vec<int64_t> claim(NumVert(), -1);
+  for (int64_t round = 0; !pending.empty(); ++round) {
+    claim.resize(NumVert(), -1);
+    const int n = pending.size();
+    const auto policy = autoPolicy(n);
+    auto key = [round](int i) { return (round << 32) | (INT_MAX - i); };
+    Vec<uint8_t> status(n);
+
+    for_each_n(policy, countAt(0), n, [&](int i) {
+      std::vector<int> verts;
+      if (!CollapseRing(pending[i], verts)) {
+        status[i] = halfedge_[pending[i]].pairedHalfedge < 0 ? kDone : kSerial;
+        return;
+      }
+      status[i] = kClaimed;
+      for (const int vert : verts) AtomicMax(claim[vert], key(i));
+    });
+    for_each_n(policy, countAt(0), n, [&](int i) {
+      if (status[i] != kClaimed) return;
+      std::vector<int> verts;
+      CollapseRing(pending[i], verts);
+      const bool won = std::all_of(verts.begin(), verts.end(), [&](int vert) {
+        return claim[vert] == key(i);
+      });
+      status[i] = won ? kWon : kLost;
+    });
+    for_each_n(policy, countAt(0), n, [&](int i) {
+      if (status[i] != kWon) return;
+      std::vector<int> scratch;
+      CollapseEdge(pending[i], scratch);
+    });
+
+    Vec<int> lost;
+    for (int i = 0; i < n; ++i) {
+      if (status[i] == kSerial) {
+        CollapseEdge(pending[i], edges);
+        edges.resize(0);
+      } else if (status[i] == kLost) {
+        lost.push_back(pending[i]);
+      }
+    }
+    pending = std::move(lost);
+  }
+  return numFlagged;
+}
+
+/**
+ * Fills verts with the verts of the one-rings of both ends of edge, which
+ * cover every triangle CollapseEdge may touch. Returns false if edge is
+ * already removed, or if its ends share neighbors other than the opposite
+ * verts of its two triangles, in which case collapsing it would need
+ * FormLoop.
+ */
+bool Manifold::Impl::CollapseRing(int edge, std::vector<int>& verts) const {
+  const int pair = halfedge_[edge].pairedHalfedge;
+  if (pair < 0) return false;
+  verts.clear();
+  int current = edge;
+  do {
+    verts.push_back(halfedge_[current].endVert);
+    current = NextHalfedge(halfedge_[current].pairedHalfedge);
+  } while (current != edge);
+  const int numStart = verts.size();
+
+  int numCommon = 0;
+  current = pair;
+  do {
+    const int vert = halfedge_[current].endVert;
+    const auto startRing = verts.begin() + numStart;
+    if (std::find(verts.begin(), startRing, vert) != startRing) ++numCommon;
+    verts.push_back(vert);
+    current = NextHalfedge(halfedge_[current].pairedHalfedge);
+  } while (current != pair);
+
+  const int opposite0 = halfedge_[NextHalfedge(edge)].endVert;
+  const int opposite1 = halfedge_[NextHalfedge(pair)].endVert;
+  return numCommon == 2 && opposite0 != opposite1;
+}
+
 void Manifold::Impl::RecursiveEdgeSwap(const int edge, int& tag,
                                        std::vector<int>& visited,
                                        std::vector<int>& edgeSwapStack,
@@ -683,4 +882,107 @@ void Manifold::Impl::SplitPinchedVerts() {
     } while (current != i);
   }
 }
+
+/**
+ * Decimates the mesh by collapsing edges in order of their quadric error until
+ * at most targetTris remain or every remaining collapse would exceed maxError.
+ * Each vert starts with the sum of the plane quadrics of its triangles, and
+ * a collapse adds the quadric of the removed vert onto the one it moves to.
+ * The collapses are scheduled in rounds like CollapseFlaggedEdges: the
+ * cheapest candidates claim the one-rings of both their ends, and those that
+ * win all their claims are independent, so they collapse concurrently.
+ */
+void Manifold::Impl::Simplify(int targetTris, float maxError) {
+  if (status_ != Error::NoError || NumTri() <= targetTris) return;
+  SplitPinchedVerts();
+
+  const int numVert = NumVert();
+  Vec<int> vertEdge(numVert, -1);
+  for_each_n(autoPolicy(halfedge_.size()), countAt(0), halfedge_.size(),
+             [&](int edge) {
+               const int vert = halfedge_[edge].startVert;
+               if (vert >= 0) AtomicMax(vertEdge[vert], edge);
+             });
+  Vec<glm::dmat4> quadric(numVert);
+  for_each_n(autoPolicy(numVert), countAt(0), numVert, [&](int vert) {
+    glm::dmat4 q(0.0);
+    const int start = vertEdge[vert];
+    if (start >= 0) {
+      int current = start;
+      do {
+        q += PlaneQuadric(halfedge_, vertPos_, current / 3);
+        current = NextHalfedge(halfedge_[current].pairedHalfedge);
+      } while (current != start);
+    }
+    quadric[vert] = q;
+  });
+
+  const double maxError2 = static_cast<double>(maxError) * maxError;
+  enum Status : uint8_t { kClaimed, kWon, kSkip };
+  // Claims are keyed as in CollapseFlaggedEdges.
+  Vec<int64_t> claim(numVert, -1);
+  int numTri = NumTri();
+  for (int64_t round = 0; numTri > targetTris; ++round) {
+    const int numEdge = halfedge_.size();
+    Vec<double> cost(numEdge);
+    const CollapseCost collapseCost{halfedge_, vertPos_, meshRelation_.triRef,
+                                    meshRelation_.triProperties, quadric};
+    for_each_n(autoPolicy(numEdge, KernelCost::Heavy), countAt(0), numEdge,
+               [&](int edge) { cost[edge] = collapseCost(edge); });
+
+    // Take the cheaper direction of each edge.
+    Vec<int> candidates;
+    for (int edge = 0; edge < numEdge; ++edge) {
+      const int pair = halfedge_[edge].pairedHalfedge;
+      if (pair < edge) continue;
+      const int best = cost[pair] < cost[edge] ? pair : edge;
+      if (cost[best] <= maxError2) candidates.push_back(best);
+    }
+    if (candidates.empty()) break;
+    stable_sort(autoPolicy(candidates.size()), candidates.begin(),
+                candidates.end(),
+                [&cost](int a, int b) { return cost[a] < cost[b]; });
+
+    // Each collapse removes two triangles.
+    const int n = std::min<int>(candidates.size(),
+                                (numTri - targetTris + 1) / 2);
+    const auto policy = autoPolicy(n);
+    auto key = [round](int i) { return (round << 32) | (INT_MAX - i); };
+    Vec<uint8_t> status(n);
+    for_each_n(policy, countAt(0), n, [&](int i) {
+      std::vector<int> verts;
+      if (!CollapseRing(candidates[i], verts)) {
+        status[i] = kSkip;
+        return;
+      }
+      status[i] = kClaimed;
+      for (const int vert : verts) AtomicMax(claim[vert], key(i));
+    });
+    for_each_n(policy, countAt(0), n, [&](int i) {
+      if (status[i] != kClaimed) return;
+      std::vector<int> verts;
+      CollapseRing(candidates[i], verts);
+      const bool won = std::all_of(verts.begin(), verts.end(), [&](int vert) {
+        return claim[vert] == key(i);
+      });
+      status[i] = won ? kWon : kSkip;
+    });
+    for_each_n(policy, countAt(0), n, [&](int i) {
+      if (status[i] != kWon) return;
+      const Halfedge he = halfedge_[candidates[i]];
+      quadric[he.endVert] += quadric[he.startVert];
+      std::vector<int> scratch;
+      CollapseEdge(candidates[i], scratch, true);
+    });
+
+    const int numWon = count_if(policy, status.begin(), status.end(),
+                                [](uint8_t s) { return s == kWon; });
+    if (numWon == 0) break;
+    numTri -= 2 * numWon;
+  }
+
+  halfedgeTangent_.resize(0);
+  faceNormal_.resize(0);
+  Finish();
+}
 }  // namespace manifold
@@ -12,20 +12,59 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#if MANIFOLD_PAR == 'T' && __has_include(<tbb/concurrent_map.h>)
-#include <tbb/tbb.h>
-#define TBB_PREVIEW_CONCURRENT_ORDERED_CONTAINERS 1
-#include <tbb/concurrent_map.h>
-#endif
-#include <unordered_set>
+#include <algorithm>
+#include <numeric>
 
 #include "impl.h"
 #include "polygon.h"
+#include "radix_sort.h"
 
-namespace manifold {
+namespace {
+using namespace manifold;
 
-using GeneralTriangulation = std::function<std::vector<glm::ivec3>(int)>;
-using AddTriangle = std::function<void(int, glm::ivec3, glm::vec3, TriRef)>;
+// Projected outlines with about this many verts per tile are unioned in
+// parallel tiles.
+constexpr int kProjectTileVerts = 1 << 14;
+constexpr int kMaxProjectTiles = 16;
+
+/**
+ * Clips a contour to an axis-aligned rectangle one side at a time
+ * (Sutherland-Hodgman). Wherever the contour leaves the rectangle it is
+ * replaced by a path along that side, so every point inside keeps its winding
+ * number, even for self-overlapping contours. Thus the union of clipped
+ * contours is exactly the union of the originals within the rectangle.
+ */
+SimplePolygon ClipToRect(const SimplePolygon& poly, const Rect& rect) {
+  SimplePolygon in = poly;
+  SimplePolygon out;
+  for (const int side : {0, 1, 2, 3}) {
+    const int axis = side % 2;
+    const bool isMax = side > 1;
+    const float bound = isMax ? rect.max[axis] : rect.min[axis];
+    auto Inside = [axis, isMax, bound](glm::vec2 p) {
+      return isMax ? p[axis] <= bound : p[axis] >= bound;
+    };
+
+    out.clear();
+    glm::vec2 prev = in.back();
+    for (const glm::vec2 pos : in) {
+      if (Inside(pos) != Inside(prev)) {
+        const float a = (bound - prev[axis]) / (pos[axis] - prev[axis]);
+        glm::vec2 cross = glm::mix(prev, pos, a);
+        cross[axis] = bound;
+        out.push_back(cross);
+      }
+      if (Inside(pos)) out.push_back(pos);
+      prev = pos;
+    }
+    std::swap(in, out);
+    if (in.empty()) break;
+  }
+  return in;
+}
+}  // namespace
+
+namespace manifold {
 
 /**
  * Triangulates the faces. In this case, the halfedge_ vector is not yet a set
@@ -36,26 +75,110 @@ using AddTriangle = std::function<void(int, glm::ivec3, glm::vec3, TriRef)>;
  * vector itself. Upon return, halfedge_ has been lengthened and properly
  * represents the mesh as a set of triangles as usual. In this process the
  * faceNormal_ values are retained, repeated as necessary.
+ *
+ * Faces of three or four edges, the vast majority after a Boolean, are
+ * emitted directly. The rest are bucketed and triangulated in parallel first,
+ * so that every face's triangle count is known; a prefix sum over the counts
+ * then gives each face its slot in the output, which is filled in parallel.
  */
 void Manifold::Impl::Face2Tri(const Vec<int>& faceEdge,
                               const Vec<TriRef>& halfedgeRef) {
   ZoneScoped;
-  Vec<glm::ivec3> triVerts;
-  Vec<glm::vec3> triNormal;
+  const int numFace = faceEdge.size() - 1;
+  const auto policy = autoPolicy(numFace);
+
+  Vec<int> triOffset(numFace + 1);
+  triOffset[numFace] = 0;
+  for_each_n(policy, countAt(0), numFace, [&](int face) {
+    triOffset[face] = faceEdge[face + 1] - faceEdge[face] - 2;
+    ASSERT(triOffset[face] >= 1, topologyErr,
+           "face has less than three edges.");
+  });
+
+  Vec<int> generalFace;
+  for (int face = 0; face < numFace; ++face) {
+    if (triOffset[face] > 2) generalFace.push_back(face);
+  }
+  // Each general face is expensive, so they are spread over threads even
+  // when there are few of them.
+  const int numGeneral = generalFace.size();
+  std::vector<std::vector<glm::ivec3>> generalTris(numGeneral);
+  for_each_n(numGeneral > 1 ? ExecutionPolicy::Par : ExecutionPolicy::Seq,
+             countAt(0), numGeneral, [&](int i) {
+               const int face = generalFace[i];
+               const glm::mat3x2 projection =
+                   GetAxisAlignedProjection(faceNormal_[face]);
+               const PolygonsIdx polys = Face2Polygons(
+                   halfedge_.cbegin() + faceEdge[face],
+                   halfedge_.cbegin() + faceEdge[face + 1], projection);
+               generalTris[i] = TriangulateIdx(polys, precision_);
+               triOffset[face] = generalTris[i].size();
+             });
+
+  exclusive_scan(policy, triOffset.begin(), triOffset.end(),
+                 triOffset.begin(), 0);
+  const int numTri = triOffset[numFace];
+  Vec<glm::ivec3> triVerts(numTri);
+  Vec<glm::vec3> triNormal(numTri);
   Vec<TriRef>& triRef = meshRelation_.triRef;
-  triRef.resize(0);
-  auto processFace = [&](GeneralTriangulation general, AddTriangle addTri,
-                         int face) {
+  triRef.resize(numTri);
+
+  auto triangulateQuad = [this](int firstEdge, glm::vec3 normal,
+                                glm::ivec3& tri0, glm::ivec3& tri1) {
+    const glm::mat3x2 projection = GetAxisAlignedProjection(normal);
+    auto triCCW = [&projection, this](const glm::ivec3 tri) {
+      return CCW(projection * this->vertPos_[tri[0]],
+                 projection * this->vertPos_[tri[1]],
+                 projection * this->vertPos_[tri[2]], precision_) >= 0;
+    };
+
+    tri0 = glm::ivec3(halfedge_[firstEdge].startVert,
+                      halfedge_[firstEdge].endVert, -1);
+    tri1 = glm::ivec3(-1, -1, tri0[0]);
+    for (const int i : {1, 2, 3}) {
+      if (halfedge_[firstEdge + i].startVert == tri0[1]) {
+        tri0[2] = halfedge_[firstEdge + i].endVert;
+        tri1[0] = tri0[2];
+      }
+      if (halfedge_[firstEdge + i].endVert == tri0[0]) {
+        tri1[1] = halfedge_[firstEdge + i].startVert;
+      }
+    }
+    ASSERT(glm::all(glm::greaterThanEqual(tri0, glm::ivec3(0))) &&
+               glm::all(glm::greaterThanEqual(tri1, glm::ivec3(0))),
+           topologyErr, "non-manifold quad!");
+    bool firstValid = triCCW(tri0) && triCCW(tri1);
+    tri0[2] = tri1[1];
+    tri1[2] = tri0[1];
+    bool secondValid = triCCW(tri0) && triCCW(tri1);
+
+    if (!secondValid) {
+      tri0[2] = tri1[0];
+      tri1[2] = tri0[0];
+    } else if (firstValid) {
+      glm::vec3 firstCross = vertPos_[tri0[0]] - vertPos_[tri1[0]];
+      glm::vec3 secondCross = vertPos_[tri0[1]] - vertPos_[tri1[1]];
+      if (glm::dot(firstCross, firstCross) <
+          glm::dot(secondCross, secondCross)) {
+        tri0[2] = tri1[0];
+        tri1[2] = tri0[0];
+      }
+    }
+  };
+
+  for_each_n(policy, countAt(0), numFace, [&](int face) {
     const int firstEdge = faceEdge[face];
-    const int lastEdge = faceEdge[face + 1];
-    const int numEdge = lastEdge - firstEdge;
-    ASSERT(numEdge >= 3, topologyErr, "face has less than three edges.");
+    const int numEdge = faceEdge[face + 1] - firstEdge;
     const glm::vec3 normal = faceNormal_[face];
+    int pos = triOffset[face];
+    auto addTri = [&](glm::ivec3 tri) {
+      triVerts[pos] = tri;
+      triNormal[pos] = normal;
+      triRef[pos] = halfedgeRef[firstEdge];
+      ++pos;
+    };
 
     if (numEdge == 3) {  // Single triangle
-      int mapping[3] = {halfedge_[firstEdge].startVert,
-                        halfedge_[firstEdge + 1].startVert,
-                        halfedge_[firstEdge + 2].startVert};
       glm::ivec3 tri(halfedge_[firstEdge].startVert,
                      halfedge_[firstEdge + 1].startVert,
                      halfedge_[firstEdge + 2].startVert);
@@ -68,126 +191,20 @@ void Manifold::Impl::Face2Tri(const Vec<int>& faceEdge,
       }
       ASSERT(ends[0] == tri[1] && ends[1] == tri[2] && ends[2] == tri[0],
              topologyErr, "These 3 edges do not form a triangle!");
-
-      addTri(face, tri, normal, halfedgeRef[firstEdge]);
+      addTri(tri);
     } else if (numEdge == 4) {  // Pair of triangles
-      int mapping[4] = {halfedge_[firstEdge].startVert,
-                        halfedge_[firstEdge + 1].startVert,
-                        halfedge_[firstEdge + 2].startVert,
-                        halfedge_[firstEdge + 3].startVert};
-      const glm::mat3x2 projection = GetAxisAlignedProjection(normal);
-      auto triCCW = [&projection, this](const glm::ivec3 tri) {
-        return CCW(projection * this->vertPos_[tri[0]],
-                   projection * this->vertPos_[tri[1]],
-                   projection * this->vertPos_[tri[2]], precision_) >= 0;
-      };
-
-      glm::ivec3 tri0(halfedge_[firstEdge].startVert,
-                      halfedge_[firstEdge].endVert, -1);
-      glm::ivec3 tri1(-1, -1, tri0[0]);
-      for (const int i : {1, 2, 3}) {
-        if (halfedge_[firstEdge + i].startVert == tri0[1]) {
-          tri0[2] = halfedge_[firstEdge + i].endVert;
-          tri1[0] = tri0[2];
-        }
-        if (halfedge_[firstEdge + i].endVert == tri0[0]) {
-          tri1[1] = halfedge_[firstEdge + i].startVert;
-        }
-      }
-      ASSERT(glm::all(glm::greaterThanEqual(tri0, glm::ivec3(0))) &&
-                 glm::all(glm::greaterThanEqual(tri1, glm::ivec3(0))),
-             topologyErr, "non-manifold quad!");
-      bool firstValid = triCCW(tri0) && triCCW(tri1);
-      tri0[2] = tri1[1];
-      tri1[2] = tri0[1];
-      bool secondValid = triCCW(tri0) && triCCW(tri1);
-
-      if (!secondValid) {
-        tri0[2] = tri1[0];
-        tri1[2] = tri0[0];
-      } else if (firstValid) {
-        glm::vec3 firstCross = vertPos_[tri0[0]] - vertPos_[tri1[0]];
-        glm::vec3 secondCross = vertPos_[tri0[1]] - vertPos_[tri1[1]];
-        if (glm::dot(firstCross, firstCross) <
-            glm::dot(secondCross, secondCross)) {
-          tri0[2] = tri1[0];
-          tri1[2] = tri0[0];
-        }
-      }
-
-      for (const auto& tri : {tri0, tri1}) {
-        addTri(face, tri, normal, halfedgeRef[firstEdge]);
-      }
+      glm::ivec3 tri0, tri1;
+      triangulateQuad(firstEdge, normal, tri0, tri1);
+      addTri(tri0);
+      addTri(tri1);
     } else {  // General triangulation
-      for (const auto& tri : general(face)) {
-        addTri(face, tri, normal, halfedgeRef[firstEdge]);
-      }
+      // generalFace is sorted, so a binary search finds the face's bucket
+      const int i = std::lower_bound(generalFace.begin(), generalFace.end(),
+                                     face) -
+                    generalFace.begin();
+      for (const glm::ivec3& tri : generalTris[i]) addTri(tri);
     }
-  };
-  auto generalTriangulation = [&](int face) {
-    const glm::vec3 normal = faceNormal_[face];
-    const glm::mat3x2 projection = GetAxisAlignedProjection(normal);
-    const PolygonsIdx polys =
-        Face2Polygons(halfedge_.cbegin() + faceEdge[face],
-                      halfedge_.cbegin() + faceEdge[face + 1], projection);
-    return TriangulateIdx(polys, precision_);
-  };
-#if MANIFOLD_PAR == 'T' && __has_include(<tbb/tbb.h>)
-  tbb::task_group group;
-  // map from face to triangle
-  tbb::concurrent_unordered_map<int, std::vector<glm::ivec3>> results;
-  Vec<int> triCount(faceEdge.size());
-  triCount.back() = 0;
-  // precompute number of triangles per face, and launch async tasks to
-  // triangulate complex faces
-  for_each(autoPolicy(faceEdge.size()), countAt(0),
-           countAt(faceEdge.size() - 1), [&](int face) {
-             triCount[face] = faceEdge[face + 1] - faceEdge[face] - 2;
-             ASSERT(triCount[face] >= 1, topologyErr,
-                    "face has less than three edges.");
-             if (triCount[face] > 2)
-               group.run([&, face] {
-                 std::vector<glm::ivec3> newTris = generalTriangulation(face);
-                 triCount[face] = newTris.size();
-                 results[face] = std::move(newTris);
-               });
-           });
-  group.wait();
-  // prefix sum computation (assign unique index to each face) and preallocation
-  exclusive_scan(autoPolicy(triCount.size()), triCount.begin(), triCount.end(),
-                 triCount.begin(), 0);
-  triVerts.resize(triCount.back());
-  triNormal.resize(triCount.back());
-  triRef.resize(triCount.back());
-
-  auto processFace2 = std::bind(
-      processFace, [&](int face) { return std::move(results[face]); },
-      [&](int face, glm::ivec3 tri, glm::vec3 normal, TriRef r) {
-        triVerts[triCount[face]] = tri;
-        triNormal[triCount[face]] = normal;
-        triRef[triCount[face]] = r;
-        triCount[face]++;
-      },
-      std::placeholders::_1);
-  // set triangles in parallel
-  for_each(autoPolicy(faceEdge.size()), countAt(0),
-           countAt(faceEdge.size() - 1), processFace2);
-#else
-  triVerts.reserve(faceEdge.size());
-  triNormal.reserve(faceEdge.size());
-  triRef.reserve(faceEdge.size());
-  auto processFace2 = std::bind(
-      processFace, generalTriangulation,
-      [&](int _face, glm::ivec3 tri, glm::vec3 normal, TriRef r) {
-        triVerts.push_back(tri);
-        triNormal.push_back(normal);
-        triRef.push_back(r);
-      },
-      std::placeholders::_1);
-  for (int face = 0; face < faceEdge.size() - 1; ++face) {
-    processFace2(face);
-  }
-#endif
+  });
 
   faceNormal_ = std::move(triNormal);
   CreateHalfedges(triVerts);
@@ -234,7 +251,7 @@ CrossSection Manifold::Impl::Slice(float height) const {
   const SparseIndices collisions =
       collider_.Collisions<false, false>(query.cview());
 
-  std::unordered_set<int> tris;
+  std::vector<int> tris;
   for (int i = 0; i < collisions.size(); ++i) {
     const int tri = collisions.Get(i, 1);
     float min = std::numeric_limits<float>::infinity();
@@ -246,13 +263,105 @@ CrossSection Manifold::Impl::Slice(float height) const {
     }
 
     if (min <= height && max > height) {
-      tris.insert(tri);
+      tris.push_back(tri);
     }
   }
+  std::sort(tris.begin(), tris.end());
+
+  return CrossSection(SliceLoops({tris.data(), (int)tris.size()}, height));
+}
+
+/**
+ * Slices at many heights in one pass over the triangles: each triangle's
+ * z-range is found once and binary-searched against the sorted heights, giving
+ * the contiguous run of layers it spans. The (layer, triangle) pairs are
+ * radix-sorted by layer, after which every layer's loops are traced and
+ * assembled into a CrossSection in parallel.
+ */
+std::vector<CrossSection> Manifold::Impl::Slices(
+    const std::vector<float>& heights) const {
+  const int numLayer = heights.size();
+  std::vector<CrossSection> sections(numLayer);
+  if (numLayer == 0 || IsEmpty()) return sections;
+
+  std::vector<int> layer2height(numLayer);
+  std::iota(layer2height.begin(), layer2height.end(), 0);
+  std::stable_sort(
+      layer2height.begin(), layer2height.end(),
+      [&heights](int a, int b) { return heights[a] < heights[b]; });
+  std::vector<float> sorted(numLayer);
+  for (int i = 0; i < numLayer; ++i) sorted[i] = heights[layer2height[i]];
+
+  const int numTri = NumTri();
+  auto policy = autoPolicy(numTri);
+  // The layers spanned by each triangle are lower_bound(min) up to, but not
+  // including, lower_bound(max), matching min <= height < max in Slice.
+  Vec<int> firstLayer(numTri);
+  Vec<int> triOffset(numTri + 1, 0);
+  for_each_n(policy, countAt(0), numTri, [&](int tri) {
+    float min = std::numeric_limits<float>::infinity();
+    float max = -std::numeric_limits<float>::infinity();
+    for (const int j : {0, 1, 2}) {
+      const float z = vertPos_[halfedge_[3 * tri + j].startVert].z;
+      min = glm::min(min, z);
+      max = glm::max(max, z);
+    }
+    const int first =
+        std::lower_bound(sorted.begin(), sorted.end(), min) - sorted.begin();
+    const int last =
+        std::lower_bound(sorted.begin(), sorted.end(), max) - sorted.begin();
+    firstLayer[tri] = first;
+    triOffset[tri] = glm::max(0, last - first);
+  });
+  exclusive_scan(policy, triOffset.begin(), triOffset.end(), triOffset.begin(),
+                 0);
+
+  const int numPair = triOffset[numTri];
+  Vec<int> pairLayer(numPair);
+  Vec<int> pairTri(numPair);
+  for_each_n(policy, countAt(0), numTri, [&](int tri) {
+    for (int i = triOffset[tri]; i < triOffset[tri + 1]; ++i) {
+      pairLayer[i] = firstLayer[tri] + i - triOffset[tri];
+      pairTri[i] = tri;
+    }
+  });
+  // stable, so each layer's triangles stay sorted
+  RadixSort(pairLayer.view(), pairTri.view());
+
+  Vec<int> layerStart(numLayer + 1);
+  for_each_n(autoPolicy(numLayer), countAt(0), numLayer + 1, [&](int layer) {
+    layerStart[layer] =
+        std::lower_bound(pairLayer.begin(), pairLayer.end(), layer) -
+        pairLayer.begin();
+  });
+
+  for_each_n(autoPolicy(numPair), countAt(0), numLayer, [&](int layer) {
+    const int start = layerStart[layer];
+    const VecView<const int> tris(pairTri.data() + start,
+                                  layerStart[layer + 1] - start);
+    sections[layer2height[layer]] =
+        CrossSection(SliceLoops(tris, sorted[layer]));
+  });
+  return sections;
+}
+
+/**
+ * Traces the loops where the plane at height cuts the given triangles, which
+ * must be sorted and be exactly those with min <= height < max of their vert
+ * z-values.
+ */
+Polygons Manifold::Impl::SliceLoops(VecView<const int> tris,
+                                    float height) const {
+  std::vector<bool> done(tris.size(), false);
+  auto Done = [&](int tri) {
+    return done.begin() +
+           (std::lower_bound(tris.begin(), tris.end(), tri) - tris.begin());
+  };
 
   Polygons polys;
-  while (!tris.empty()) {
-    const int startTri = *tris.begin();
+  for (int i = 0; i < tris.size(); ++i) {
+    if (done[i]) continue;
+    const int startTri = tris[i];
     SimplePolygon poly;
 
     int k = 0;
@@ -266,7 +375,7 @@ CrossSection Manifold::Impl::Slice(float height) const {
 
     int tri = startTri;
     do {
-      tris.erase(tris.find(tri));
+      *Done(tri) = true;
       if (vertPos_[halfedge_[3 * tri + k].endVert].z <= height) {
         k = Next3(k);
       }
@@ -284,8 +393,7 @@ CrossSection Manifold::Impl::Slice(float height) const {
 
     polys.push_back(poly);
   }
-
-  return CrossSection(polys);
+  return polys;
 }
 
 CrossSection Manifold::Impl::Project() const {
@@ -314,10 +422,52 @@ CrossSection Manifold::Impl::Project() const {
     polys.push_back(simple);
   }
 
-  return CrossSection(polys).Simplify(precision_);
+  int numVert = 0;
+  Rect bounds;
+  std::vector<Rect> polyBox(polys.size());
+  for (int i = 0; i < polys.size(); ++i) {
+    numVert += polys[i].size();
+    for (const glm::vec2 pos : polys[i]) polyBox[i].Union(pos);
+    bounds = bounds.Union(polyBox[i]);
+  }
+  const int numTile = glm::min(
+      kMaxProjectTiles,
+      static_cast<int>(glm::ceil(glm::sqrt(
+          static_cast<float>(numVert) / kProjectTileVerts))));
+  if (numTile < 2 || bounds.IsEmpty()) {
+    return CrossSection(polys).Simplify(precision_);
+  }
+
+  // Union each tile of the outline in parallel - the tiles only share their
+  // borders, so merging them is far cheaper than one big union.
+  const glm::vec2 tileSize = bounds.Size() / static_cast<float>(numTile);
+  // Neighboring tiles use the same expression, so they share borders exactly.
+  auto Border = [&](glm::ivec2 idx) {
+    return glm::mix(bounds.min + tileSize * glm::vec2(idx), bounds.max,
+                    glm::equal(idx, glm::ivec2(numTile)));
+  };
+  std::vector<CrossSection> tiles(numTile * numTile);
+  for_each_n(ExecutionPolicy::Par, countAt(0), tiles.size(), [&](int tile) {
+    const glm::ivec2 idx(tile % numTile, tile / numTile);
+    const Rect rect(Border(idx), Border(idx + 1));
+    Polygons clipped;
+    for (int i = 0; i < polys.size(); ++i) {
+      if (!rect.DoesOverlap(polyBox[i])) continue;
+      if (rect.Contains(polyBox[i])) {
+        clipped.push_back(polys[i]);
+        continue;
+      }
+      SimplePolygon poly = ClipToRect(polys[i], rect);
+      if (poly.size() > 2) clipped.push_back(std::move(poly));
+    }
+    tiles[tile] = CrossSection(clipped);
+  });
+
+  return CrossSection::Compose(tiles).Simplify(precision_);
 }
 
-glm::dvec4 Manifold::Impl::Circumcircle(Vec<glm::dvec3> verts, int face) const {
+glm::dvec4 Manifold::Impl::Circumcircle(VecView<const glm::dvec3> verts,
+                                        int face) const {
   glm::dvec3 va = verts[this->halfedge_[(face * 3) + 0].startVert];
   glm::dvec3 vb = verts[this->halfedge_[(face * 3) + 1].startVert];
   glm::dvec3 vc = verts[this->halfedge_[(face * 3) + 2].startVert];
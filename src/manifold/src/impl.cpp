@@ -43,14 +43,6 @@ struct Normalize {
   void operator()(glm::vec3& v) { v = SafeNormalize(v); }
 };
 
-struct Transform4x3 {
-  const glm::mat4x3 transform;
-
-  glm::vec3 operator()(glm::vec3 position) {
-    return transform * glm::vec4(position, 1.0f);
-  }
-};
-
 struct AssignNormals {
   VecView<glm::vec3> vertNormal;
   VecView<const glm::vec3> vertPos;
@@ -344,7 +336,7 @@ uint32_t Manifold::Impl::ReserveIDs(uint32_t n) {
   return Manifold::Impl::meshIDCounter_.fetch_add(n, std::memory_order_relaxed);
 }
 
-Manifold::Impl::Impl(const MeshGL& meshGL,
+Manifold::Impl::Impl(const MeshGLView& meshGL,
                      std::vector<float> propertyTolerance) {
   Mesh mesh;
   mesh.precision = meshGL.precision;
@@ -436,7 +428,8 @@ Manifold::Impl::Impl(const MeshGL& meshGL,
   if (meshGL.runOriginalID.empty()) {
     relation.originalID = Impl::ReserveIDs(1);
   } else {
-    std::vector<uint32_t> runIndex = meshGL.runIndex;
+    std::vector<uint32_t> runIndex(meshGL.runIndex.begin(),
+                                   meshGL.runIndex.end());
     if (runIndex.empty()) {
       runIndex = {0, 3 * meshGL.NumTri()};
     }
@@ -455,7 +448,7 @@ Manifold::Impl::Impl(const MeshGL& meshGL,
       if (meshGL.runTransform.empty()) {
         relation.meshIDtransform[meshID] = {originalID};
       } else {
-        const float* m = meshGL.runTransform.data() + 12 * i;
+        const float* m = meshGL.runTransform.begin() + 12 * i;
         relation.meshIDtransform[meshID] = {
             originalID,
             {m[0], m[1], m[2], m[3], m[4], m[5], m[6], m[7], m[8], m[9], m[10],
@@ -696,14 +689,17 @@ void Manifold::Impl::CreateHalfedges(const Vec<glm::ivec3>& triVerts) {
 }
 
 /**
- * Does a full recalculation of the face bounding boxes, including updating
- * the collider, but does not resort the faces.
+ * Does a full recalculation of the face bounding boxes, including refitting
+ * the collider bottom-up, but does not resort the faces or rebuild the
+ * hierarchy. This is linear in the number of faces and stays valid under any
+ * vertex motion, though the tree gets looser the further the faces move from
+ * their Morton order.
  */
 void Manifold::Impl::Update() {
+  edgeCache_.Store(nullptr);
   CalculateBBox();
   Vec<Box> faceBox;
-  Vec<uint32_t> faceMorton;
-  GetFaceBoxMorton(faceBox, faceMorton);
+  GetFaceBox(faceBox);
   collider_.UpdateBoxes(faceBox);
 }
 
@@ -714,6 +710,7 @@ void Manifold::Impl::MarkFailure(Error status) {
   vertNormal_.resize(0);
   faceNormal_.resize(0);
   halfedgeTangent_.resize(0);
+  edgeCache_.Store(nullptr);
   meshRelation_ = MeshRelationD();
   status_ = status;
 }
@@ -743,50 +740,58 @@ void Manifold::Impl::WarpBatch(
 Manifold::Impl Manifold::Impl::Transform(const glm::mat4x3& transform_) const {
   ZoneScoped;
   if (transform_ == glm::mat4x3(1.0f)) return *this;
-  auto policy = autoPolicy(NumVert());
   Impl result;
   result.collider_ = collider_;
-  result.meshRelation_ = meshRelation_;
   result.precision_ = precision_;
   result.bBox_ = bBox_;
-  result.halfedge_ = halfedge_;
-  result.halfedgeTangent_.resize(halfedgeTangent_.size());
-
-  result.meshRelation_.originalID = -1;
+  result.meshRelation_.numProp = meshRelation_.numProp;
+  result.meshRelation_.meshIDtransform = meshRelation_.meshIDtransform;
   for (auto& m : result.meshRelation_.meshIDtransform) {
     m.second.transform = transform_ * glm::mat4(m.second.transform);
   }
 
   result.vertPos_.resize(NumVert());
-  result.faceNormal_.resize(faceNormal_.size());
   result.vertNormal_.resize(vertNormal_.size());
-  transform(policy, vertPos_.begin(), vertPos_.end(), result.vertPos_.begin(),
-            Transform4x3({transform_}));
-
-  glm::mat3 normalTransform = NormalTransform(transform_);
-  transform(policy, faceNormal_.begin(), faceNormal_.end(),
-            result.faceNormal_.begin(), TransformNormals({normalTransform}));
-  transform(policy, vertNormal_.begin(), vertNormal_.end(),
-            result.vertNormal_.begin(), TransformNormals({normalTransform}));
-
-  const bool invert = glm::determinant(glm::mat3(transform_)) < 0;
-
-  if (halfedgeTangent_.size() > 0) {
-    for_each_n(policy, zip(result.halfedgeTangent_.begin(), countAt(0)),
-               halfedgeTangent_.size(),
-               TransformTangents({glm::mat3(transform_), invert,
-                                  halfedgeTangent_, halfedge_}));
-  }
-
-  if (invert) {
-    for_each_n(policy, zip(result.meshRelation_.triRef.begin(), countAt(0)),
-               result.NumTri(), FlipTris({result.halfedge_}));
+  result.halfedge_.resize(halfedge_.size());
+  result.faceNormal_.resize(faceNormal_.size());
+  result.halfedgeTangent_.resize(halfedgeTangent_.size());
+  result.meshRelation_.triProperties.resize(
+      meshRelation_.triProperties.size());
+  AppendMesh(autoPolicy(NumVert()), *this, transform_, result, {}, {});
+  // Neither the properties nor the triangle references change, so they are
+  // copied whole afterward instead of in the pass above.
+  result.meshRelation_.properties = meshRelation_.properties;
+  result.meshRelation_.triRef = meshRelation_.triRef;
+
+  // Axis-aligned transforms can be applied to the collider's boxes directly;
+  // anything else, e.g. a rotation, refits the same hierarchy to the new face
+  // boxes, which needs no sorting.
+  if (!result.collider_.Transform(transform_)) {
+    Vec<Box> faceBox;
+    result.GetFaceBox(faceBox);
+    result.collider_.UpdateBoxes(faceBox);
+  }
+
+  // The edge cache moves the same way. Reversed triangles change which
+  // halfedges are forward, so then it is left to be rebuilt.
+  const std::shared_ptr<const EdgeCache> edgeCache = edgeCache_.Load();
+  if (edgeCache != nullptr && glm::determinant(glm::mat3(transform_)) > 0) {
+    Arena::Scope heapScope(nullptr);
+    auto moved = std::make_shared<EdgeCache>(*edgeCache);
+    const int numEdge = moved->edges.size();
+    if (moved->collider.Transform(transform_)) {
+      for_each(autoPolicy(numEdge), moved->edgeBox.begin(),
+               moved->edgeBox.end(),
+               [&transform_](Box& box) { box = box.Transform(transform_); });
+    } else {
+      for_each_n(autoPolicy(numEdge),
+                 zip(moved->edgeBox.begin(), moved->edges.cbegin()), numEdge,
+                 EdgeBox({result.vertPos_}));
+      moved->collider.UpdateBoxes(moved->edgeBox);
+    }
+    result.edgeCache_.Store(moved);
   }
 
-  // This optimization does a cheap collider update if the transform is
-  // axis-aligned.
-  if (!result.collider_.Transform(transform_)) result.Update();
-
   result.CalculateBBox();
   // Scale the precision by the norm of the 3x3 portion of the transform.
   result.precision_ *= SpectralNorm(glm::mat3(transform_));
@@ -852,33 +857,90 @@ void Manifold::Impl::IncrementMeshIDs() {
              UpdateMeshID({meshIDold2new.D()}));
 }
 
+/**
+ * Returns the forward edges of this manifold with their bounding boxes and a
+ * collider over them. They are built on first use and kept until the mesh is
+ * changed, so that a mesh reused as an operand of many Booleans, like a cutter
+ * subtracted from many parts, skips this setup. Concurrent first calls may
+ * each build it, but they all store equivalent results.
+ */
+std::shared_ptr<const Manifold::Impl::EdgeCache>
+Manifold::Impl::GetEdgeCache() const {
+  std::shared_ptr<const EdgeCache> cache = edgeCache_.Load();
+  if (cache != nullptr) return cache;
+  ZoneScoped;
+  // The cache outlives the current operation, e.g. a Boolean whose arena is
+  // freed when it finishes, so it must come from the heap.
+  Arena::Scope heapScope(nullptr);
+
+  const Vec<TmpEdge> edges = CreateTmpEdges(halfedge_);
+  const int numEdge = edges.size();
+  auto policy = autoPolicy(numEdge);
+  Vec<Box> edgeBox(numEdge);
+  for_each_n(policy, zip(edgeBox.begin(), edges.cbegin()), numEdge,
+             EdgeBox({vertPos_}));
+  Vec<uint32_t> edgeMorton(numEdge);
+  for_each_n(policy, countAt(0), numEdge, [&](int i) {
+    edgeMorton[i] = Collider::MortonCode(edgeBox[i].Center(), bBox_);
+  });
+  Vec<int> new2Old(numEdge);
+  sequence(policy, new2Old.begin(), new2Old.end());
+  stable_sort(policy, new2Old.begin(), new2Old.end(),
+              [&edgeMorton](int a, int b) {
+                return edgeMorton[a] < edgeMorton[b];
+              });
+
+  auto built = std::make_shared<EdgeCache>();
+  built->edges.resize(numEdge);
+  built->edgeBox.resize(numEdge);
+  Vec<uint32_t> sortedMorton(numEdge);
+  for_each_n(policy, countAt(0), numEdge, [&](int i) {
+    built->edges[i] = edges[new2Old[i]];
+    built->edgeBox[i] = edgeBox[new2Old[i]];
+    sortedMorton[i] = edgeMorton[new2Old[i]];
+  });
+  built->collider = Collider(built->edgeBox, sortedMorton);
+  cache = built;
+  edgeCache_.Store(cache);
+  return cache;
+}
+
 /**
  * Returns a sparse array of the bounding box overlaps between the edges of
  * the input manifold, Q and the faces of this manifold. Returned indices only
- * point to forward halfedges.
+ * point to forward halfedges and are not sorted. When this has fewer faces
+ * than Q has edges, the faces are queried against Q's edge collider instead,
+ * which finds the same overlaps.
  */
 SparseIndices Manifold::Impl::EdgeCollisions(const Impl& Q,
                                              bool inverted) const {
   ZoneScoped;
-  Vec<TmpEdge> edges = CreateTmpEdges(Q.halfedge_);
-  const int numEdge = edges.size();
-  Vec<Box> QedgeBB(numEdge);
+  const std::shared_ptr<const EdgeCache> cache = Q.GetEdgeCache();
+  const int numEdge = cache->edges.size();
   auto policy = autoPolicy(numEdge);
-  for_each_n(policy, zip(QedgeBB.begin(), edges.cbegin()), numEdge,
-             EdgeBox({Q.vertPos_}));
 
   SparseIndices q1p2(0);
-  if (inverted)
-    q1p2 = collider_.Collisions<false, true>(QedgeBB.cview());
-  else
-    q1p2 = collider_.Collisions<false, false>(QedgeBB.cview());
+  if (NumTri() < numEdge) {
+    Vec<Box> faceBox;
+    GetFaceBox(faceBox);
+    // the faces are the queries now, so the order of each pair swaps
+    if (inverted)
+      q1p2 = cache->collider.Collisions<false, false>(faceBox.cview());
+    else
+      q1p2 = cache->collider.Collisions<false, true>(faceBox.cview());
+  } else {
+    if (inverted)
+      q1p2 = collider_.Collisions<false, true>(cache->edgeBox.cview());
+    else
+      q1p2 = collider_.Collisions<false, false>(cache->edgeBox.cview());
+  }
 
   if (inverted)
     for_each(policy, countAt(0), countAt(q1p2.size()),
-             ReindexEdge<true>({edges, q1p2}));
+             ReindexEdge<true>({cache->edges, q1p2}));
   else
     for_each(policy, countAt(0), countAt(q1p2.size()),
-             ReindexEdge<false>({edges, q1p2}));
+             ReindexEdge<false>({cache->edges, q1p2}));
   return q1p2;
 }
 
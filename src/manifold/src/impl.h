@@ -13,7 +13,9 @@
 // limitations under the License.
 
 #pragma once
+#include <atomic>
 #include <map>
+#include <memory>
 
 #include "collider.h"
 #include "manifold.h"
@@ -42,17 +44,52 @@ struct Manifold::Impl {
     Vec<TriRef> triRef;
     Vec<glm::ivec3> triProperties;
   };
+  /// The forward edges, sorted by the Morton codes of their bounding boxes,
+  /// with those boxes and a collider over them.
+  struct EdgeCache {
+    Vec<TmpEdge> edges;
+    Vec<Box> edgeBox;
+    Collider collider;
+  };
+  /// Holds the EdgeCache, which is filled lazily on otherwise const Impls.
+  /// Loads, stores and copies are atomic, so that an Impl may be copied while
+  /// another thread fills its cache.
+  class EdgeCacheRef {
+   public:
+    EdgeCacheRef() {}
+    EdgeCacheRef(const EdgeCacheRef& other) : ptr_(other.Load()) {}
+    EdgeCacheRef& operator=(const EdgeCacheRef& other) {
+      Store(other.Load());
+      return *this;
+    }
+    std::shared_ptr<const EdgeCache> Load() const {
+      return std::atomic_load(&ptr_);
+    }
+    void Store(std::shared_ptr<const EdgeCache> cache) const {
+      std::atomic_store(&ptr_, std::move(cache));
+    }
+
+   private:
+    mutable std::shared_ptr<const EdgeCache> ptr_;
+  };
+  /// Whole-mesh measures gathered in one pass by Analyze().
+  struct Stats {
+    float area = 0;
+    float volume = 0;
+    int numDegenerateTri = 0;
+  };
 
   Box bBox_;
   float precision_ = -1;
   Error status_ = Error::NoError;
-  Vec<glm::vec3> vertPos_;
-  Vec<Halfedge> halfedge_;
+  Vec<glm::vec3> vertPos_{MemoryCategory::VertPos};
+  Vec<Halfedge> halfedge_{MemoryCategory::Halfedge};
   Vec<glm::vec3> vertNormal_;
   Vec<glm::vec3> faceNormal_;
   Vec<glm::vec4> halfedgeTangent_;
   MeshRelationD meshRelation_;
   Collider collider_;
+  EdgeCacheRef edgeCache_;
 
   static std::atomic<uint32_t> meshIDCounter_;
   static uint32_t ReserveIDs(uint32_t);
@@ -61,7 +98,7 @@ struct Manifold::Impl {
   enum class Shape { Tetrahedron, Cube, Octahedron };
   Impl(Shape);
 
-  Impl(const MeshGL&, std::vector<float> propertyTolerance = {});
+  Impl(const MeshGLView&, std::vector<float> propertyTolerance = {});
   Impl(const Mesh&, const MeshRelationD& relation,
        const std::vector<float>& propertyTolerance = {},
        bool hasFaceIDs = false);
@@ -78,6 +115,7 @@ struct Manifold::Impl {
   void Warp(std::function<void(glm::vec3&)> warpFunc);
   void WarpBatch(std::function<void(VecView<glm::vec3>)> warpFunc);
   Impl Transform(const glm::mat4x3& transform) const;
+  std::shared_ptr<const EdgeCache> GetEdgeCache() const;
   SparseIndices EdgeCollisions(const Impl& B, bool inverted = false) const;
   SparseIndices VertexCollisionsZ(VecView<const glm::vec3> vertsIn,
                                   bool inverted = false) const;
@@ -93,6 +131,7 @@ struct Manifold::Impl {
   }
 
   // properties.cu
+  Stats Analyze(VecView<glm::vec4> vertCurvature = {nullptr, 0}) const;
   Properties GetProperties() const;
   void CalculateCurvature(int gaussianIdx, int meanIdx);
   void CalculateBBox();
@@ -104,13 +143,28 @@ struct Manifold::Impl {
   bool MatchesTriNormals() const;
   int NumDegenerateTris() const;
 
+  // query.cpp
+  std::vector<RayHit> RayCast(VecView<const glm::vec3> origins,
+                              VecView<const glm::vec3> directions) const;
+  std::vector<SurfacePoint> ClosestPoint(VecView<const glm::vec3> points) const;
+  std::vector<char> Contains(VecView<const glm::vec3> points) const;
+  float SignedDistance(glm::vec3 point, float band) const;
+
+  // serialize.cpp
+  void Serialize(SerialWriter& writer) const;
+  bool Deserialize(SerialReader& reader);
+
   // sort.cu
-  void Finish();
-  void SortVerts();
+  void Finish(bool keepOrder = false);
+  void SortVerts(bool keepOrder = false);
   void ReindexVerts(const Vec<int>& vertNew2Old, int numOldVert);
   void CompactProps();
-  void GetFaceBoxMorton(Vec<Box>& faceBox, Vec<uint32_t>& faceMorton) const;
-  void SortFaces(Vec<Box>& faceBox, Vec<uint32_t>& faceMorton);
+  template <typename Code>
+  void GetFaceBoxMorton(Vec<Box>& faceBox, Vec<Code>& faceMorton,
+                        bool keepOrder = false) const;
+  void GetFaceBox(Vec<Box>& faceBox) const;
+  template <typename Code>
+  void SortFaces(Vec<Box>& faceBox, Vec<Code>& faceMorton);
   void GatherFaces(const Vec<int>& faceNew2Old);
   void GatherFaces(const Impl& old, const Vec<int>& faceNew2Old);
 
@@ -120,13 +174,21 @@ struct Manifold::Impl {
                             VecView<Halfedge>::IterC end,
                             glm::mat3x2 projection) const;
   CrossSection Slice(float height) const;
+  std::vector<CrossSection> Slices(const std::vector<float>& heights) const;
+  Polygons SliceLoops(VecView<const int> tris, float height) const;
   CrossSection Project() const;
-  glm::dvec4 Circumcircle(Vec<glm::dvec3> verts, int face) const;
+  glm::dvec4 Circumcircle(VecView<const glm::dvec3> verts, int face) const;
+
+  // clip.cpp
+  Impl TrimByPlanes(const std::vector<glm::vec4>& planes) const;
 
   // edge_op.cu
-  void SimplifyTopology();
+  void SimplifyTopology(VecView<const char> touchedVert = {nullptr, 0});
   void DedupeEdge(int edge);
-  void CollapseEdge(int edge, std::vector<int>& edges);
+  void CollapseEdge(int edge, std::vector<int>& edges, bool checked = false);
+  int CollapseFlaggedEdges(VecView<const uint8_t> flags,
+                           std::vector<int>& edges);
+  bool CollapseRing(int edge, std::vector<int>& verts) const;
   void RecursiveEdgeSwap(int edge, int& tag, std::vector<int>& visited,
                          std::vector<int>& edgeSwapStack,
                          std::vector<int>& edges);
@@ -136,10 +198,13 @@ struct Manifold::Impl {
   void FormLoop(int current, int end);
   void CollapseTri(const glm::ivec3& triEdge);
   void SplitPinchedVerts();
+  void Simplify(int targetTris, float maxError);
 
   // smoothing.cu
   void CreateTangents(const std::vector<Smoothness>&);
-  Vec<Barycentric> Subdivide(int n);
-  void Refine(int n);
+  Vec<Barycentric> Subdivide(std::function<int(int)> edgeDivisions);
+  void Refine(std::function<int(int)> edgeDivisions);
+  void RefineToLength(float length);
+  void RefineToPrecision(float precision);
 };
 }  // namespace manifold
@@ -13,16 +13,25 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <atomic>
+#include <limits>
 #include <map>
 #include <numeric>
 #include <random>
+#include <thread>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "QuickHull.hpp"
 #include "boolean3.h"
+#include "buffer_pool.h"
 #include "csg_tree.h"
+#include "hashtable.h"
 #include "impl.h"
+#include "memory_counters.h"
 #include "par.h"
+#include "radix_sort.h"
+#include "sdf.h"
 #include "voro++.hh"
 
 namespace {
@@ -44,55 +53,126 @@ struct MakeTri {
   }
 };
 
-struct UpdateProperties {
-  float* properties;
-  const int numProp;
-  const float* oldProperties;
-  const int numOldProp;
-  const glm::vec3* vertPos;
-  const glm::ivec3* triProperties;
-  const Halfedge* halfedges;
-  std::function<void(float*, glm::vec3, const float*)> propFunc;
-
-  void operator()(int tri) {
-    for (int i : {0, 1, 2}) {
-      const int vert = halfedges[3 * tri + i].startVert;
-      const int propVert = triProperties[tri][i];
-      propFunc(properties + numProp * propVert, vertPos[vert],
-               oldProperties + numOldProp * propVert);
-    }
+// The half-spaces of a convex cell, for Impl::TrimByPlanes. The planes of the
+// cell's bounding box come first, most selective against the mesh box first,
+// so that the first trim, which the mesh's collider limits to the triangles
+// on its kept side, and those after it cheaply reduce the mesh to the cell's
+// neighborhood before its faces, one plane per coplanar face, cut the rest.
+std::vector<glm::vec4> CellPlanes(const Manifold::Impl& cell,
+                                  const Box& meshBox) {
+  std::vector<std::pair<float, glm::vec4>> boxPlanes;
+  const glm::vec3 size = glm::max(meshBox.Size(), glm::vec3(kTolerance));
+  for (const int axis : {0, 1, 2}) {
+    glm::vec3 normal(0);
+    normal[axis] = 1;
+    const float lo = cell.bBox_.min[axis];
+    const float hi = cell.bBox_.max[axis];
+    // the fraction of the mesh box each plane removes
+    boxPlanes.push_back({(lo - meshBox.min[axis]) / size[axis],
+                         glm::vec4(normal, lo)});
+    boxPlanes.push_back({(meshBox.max[axis] - hi) / size[axis],
+                         glm::vec4(-normal, -hi)});
   }
-};
-
-struct ComputeVoronoiCell {
-  voro::container_poly* container;
-  const Manifold* original;
-  std::vector<Manifold>* output;
-  void operator()(thrust::tuple<int, glm::ivec3&, glm::dvec4&> inOut) {
-    const int idx = thrust::get<0>(inOut);
-    glm::ivec3& cell_idx = thrust::get<1>(inOut);
-    glm::dvec4& cell_pos = thrust::get<2>(inOut);
-    voro::voronoicell_neighbor c(*container);
-
-    if (container->compute_cell(c, cell_idx.y, cell_idx.z)) {
-      std::vector<glm::vec3> verts;
-      verts.reserve(c.p);
-      for (size_t i = 0; i < c.p; i++) {
-        verts.push_back(glm::vec3(cell_pos.x + 0.5 * c.pts[(4 * i) + 0],
-                                  cell_pos.y + 0.5 * c.pts[(4 * i) + 1],
-                                  cell_pos.z + 0.5 * c.pts[(4 * i) + 2]));
-      }
+  std::stable_sort(boxPlanes.begin(), boxPlanes.end(),
+                   [](const std::pair<float, glm::vec4>& a,
+                      const std::pair<float, glm::vec4>& b) {
+                     return a.first > b.first;
+                   });
+
+  std::vector<glm::vec4> planes;
+  for (const auto& plane : boxPlanes) planes.push_back(plane.second);
+  std::unordered_set<int> faces;
+  for (int tri = 0; tri < cell.NumTri(); ++tri) {
+    if (!faces.insert(cell.meshRelation_.triRef[tri].tri).second) continue;
+    const glm::vec3 normal = cell.faceNormal_[tri];
+    const glm::vec3 pos = cell.vertPos_[cell.halfedge_[3 * tri].startVert];
+    // keep the inside of the outward normal
+    planes.push_back(glm::vec4(-normal, -glm::dot(normal, pos)));
+  }
+  return planes;
+}
 
-      // c.neighbors - Check neighbors for Mergeability...
+/**
+ * The indices of the circles to fracture at: those with a non-negative
+ * radius and no earlier kept center within tolerance. The centers are binned
+ * on a grid of tolerance spacing, so each only searches the 27 cells around
+ * it.
+ */
+std::vector<int> DedupeCircumcenters(const std::vector<glm::dvec4>& circles,
+                                     double tolerance) {
+  const int n = circles.size();
+  Vec<char> keep(n);
+  for_each_n(autoPolicy(n), countAt(0), n,
+             [&](int i) { keep[i] = circles[i].w >= 0.0; });
+
+  if (tolerance > 0) {
+    constexpr double kMaxCell = 1ll << 62;
+    auto cellOf = [&](int i) {
+      return glm::i64vec3(glm::clamp(glm::floor(glm::dvec3(circles[i]) /
+                                                tolerance),
+                                     -kMaxCell, kMaxCell));
+    };
+    auto cellKey = [](glm::i64vec3 cell) {
+      Uint64 key = hash64bit(cell.x);
+      key = hash64bit(key + cell.y);
+      key = hash64bit(key + cell.z);
+      return key == kOpen ? key - 1 : key;
+    };
+
+    // sort the valid centers by cell, recording where each cell starts
+    Vec<Uint64> keys(n);
+    Vec<int> order(n);
+    for_each_n(autoPolicy(n), countAt(0), n, [&](int i) {
+      keys[i] = keep[i] ? cellKey(cellOf(i)) : kOpen;
+      order[i] = i;
+    });
+    RadixSort(keys.view(), order.view());
+    HashTable<int> cellStart(2 * n);
+    HashTableD<int> table = cellStart.D();
+    for_each_n(autoPolicy(n), countAt(0), n, [&](int i) {
+      // store start + 1, so the default value of 0 means empty
+      if (keys[i] != kOpen && (i == 0 || keys[i - 1] != keys[i]))
+        table.Insert(keys[i], i + 1);
+    });
 
-      (*output)[cell_idx.x] = Manifold::Hull(verts) ^ *original;
-      verts.clear();
-    } else {
-      std::cout << "[ERROR] Degenerate Voronoi Cell at Index: " << cell_idx.x
-                << std::endl;
+    // whether an earlier center in keep lies within tolerance of center i
+    auto nearEarlier = [&](int i) {
+      const glm::i64vec3 cell = cellOf(i);
+      const glm::dvec3 center(circles[i]);
+      for (const int x : {-1, 0, 1})
+        for (const int y : {-1, 0, 1})
+          for (const int z : {-1, 0, 1}) {
+            const Uint64 key = cellKey(cell + glm::i64vec3(x, y, z));
+            for (int j = table[key] - 1; j >= 0 && j < n && keys[j] == key;
+                 ++j) {
+              const int other = order[j];
+              if (other < i && keep[other] &&
+                  glm::distance(glm::dvec3(circles[other]), center) <
+                      tolerance) {
+                return true;
+              }
+            }
+          }
+      return false;
+    };
+
+    // Only centers near an earlier valid one can be dropped. Whether they
+    // are depends on which earlier ones were kept, so those few are settled
+    // in order; a center is never dropped for one that was itself dropped.
+    Vec<char> near(n, 0);
+    for_each_n(autoPolicy(n), countAt(0), n,
+               [&](int i) { near[i] = keep[i] && nearEarlier(i); });
+    for (int i = 0; i < n; ++i) {
+      if (near[i]) keep[i] = !nearEarlier(i);
     }
   }
-};
+
+  std::vector<int> kept;
+  for (int i = 0; i < n; ++i) {
+    if (keep[i]) kept.push_back(i);
+  }
+  return kept;
+}
 
 struct ComputeTriangleHull {
   const Manifold* bM;
@@ -107,28 +187,255 @@ struct ComputeTriangleHull {
   }
 };
 
-struct ComputeTriangleTriangleHull {
-  std::vector<glm::vec3>* vertPosAPtr;
-  std::vector<glm::vec3>* vertPosBPtr;
-  std::vector<Manifold>* output;
-  void operator()(thrust::tuple<int, std::pair<glm::ivec3, glm::ivec3>> inOut) {
-    const int idx = thrust::get<0>(inOut);
-    std::pair<glm::ivec3, glm::ivec3> tris = thrust::get<1>(inOut);
-    auto vertPosA = *vertPosAPtr;
-    auto vertPosB = *vertPosBPtr;
-    (*output)[idx] =
-        Manifold::Hull({vertPosA[tris.first.x] + vertPosB[tris.second.x],
-                        vertPosA[tris.first.x] + vertPosB[tris.second.y],
-                        vertPosA[tris.first.x] + vertPosB[tris.second.z],
-                        vertPosA[tris.first.y] + vertPosB[tris.second.x],
-                        vertPosA[tris.first.y] + vertPosB[tris.second.y],
-                        vertPosA[tris.first.y] + vertPosB[tris.second.z],
-                        vertPosA[tris.first.z] + vertPosB[tris.second.x],
-                        vertPosA[tris.first.z] + vertPosB[tris.second.y],
-                        vertPosA[tris.first.z] + vertPosB[tris.second.z]});
+// triangle pairs hulled per union in the non-convex Minkowski sum
+constexpr int kMinkowskiBatch = 1 << 14;
+
+// For each vert, the half-angle of the cone around its normal that bounds
+// the normals of its faces, i.e. its normal cone.
+std::vector<float> NormalConeAngles(const Manifold::Impl& impl) {
+  std::vector<float> minCos(impl.NumVert(), 1);
+  for (int edge = 0; edge < impl.halfedge_.size(); ++edge) {
+    const Halfedge& halfedge = impl.halfedge_[edge];
+    const float cos = glm::dot(impl.vertNormal_[halfedge.startVert],
+                               impl.faceNormal_[halfedge.face]);
+    minCos[halfedge.startVert] = glm::min(minCos[halfedge.startVert], cos);
   }
+  std::vector<float> angle(impl.NumVert());
+  for (int vert = 0; vert < impl.NumVert(); ++vert) {
+    angle[vert] = glm::length(impl.vertNormal_[vert]) > 0.5f
+                      ? glm::acos(glm::clamp(minCos[vert], -1.0f, 1.0f))
+                      : glm::pi<float>();
+  }
+  return angle;
+}
+
+// candidate cuts of a piece, as fractions of its extent along each axis
+constexpr float kCutFractions[] = {0.25f, 0.5f, 0.75f};
+
+struct ApproxPiece {
+  Manifold part;
+  Manifold hull;
+  // the volume of the hull not filled by the part
+  double gap;
 };
 
+ApproxPiece MakeApproxPiece(const Manifold& part) {
+  const Manifold hull = part.Hull();
+  const double gap =
+      hull.GetProperties().volume - part.GetProperties().volume;
+  return {part, hull, glm::max(gap, 0.0)};
+}
+
+/**
+ * The connected pieces of the best cut of this piece, among the axis-aligned
+ * planes through fractions of its bounding box: the cut whose pieces leave
+ * the least volume of their hulls unfilled.
+ */
+std::vector<ApproxPiece> SplitApproxPiece(const ApproxPiece& piece) {
+  const Box box = piece.part.BoundingBox();
+  const glm::vec3 size = box.Size();
+  std::vector<ApproxPiece> best;
+  double bestGap = std::numeric_limits<double>::infinity();
+  for (const int axis : {0, 1, 2}) {
+    if (size[axis] <= 0) continue;
+    glm::vec3 normal(0);
+    normal[axis] = 1;
+    for (const float fraction : kCutFractions) {
+      const std::pair<Manifold, Manifold> halves = piece.part.SplitByPlane(
+          normal, box.min[axis] + fraction * size[axis]);
+      std::vector<ApproxPiece> pieces;
+      double gap = 0;
+      for (const Manifold& half : {halves.first, halves.second}) {
+        for (const Manifold& component : half.Decompose()) {
+          pieces.push_back(MakeApproxPiece(component));
+          gap += pieces.back().gap;
+        }
+      }
+      if (pieces.size() > 1 && gap < bestGap) {
+        bestGap = gap;
+        best = pieces;
+      }
+    }
+  }
+  return best;
+}
+
+// fewer points are hulled without the extreme-point prefilter
+constexpr int kHullPrefilter = 1 << 10;
+
+/**
+ * Convex hull of all the points of the given spans, which are read in place.
+ * Larger inputs are first reduced to the points that are not strictly inside
+ * the hull of their extremes along the 26 directions to the faces, edges and
+ * corners of a cube, as those can't be vertices of the result; only the
+ * survivors are converted for QuickHull.
+ */
+Manifold HullSpans(const std::vector<VecView<const glm::vec3>>& spans) {
+  ZoneScoped;
+  constexpr int kBlockSize = 1 << 12;
+  struct Block {
+    int span, start, end;
+  };
+  std::vector<Block> blocks;
+  int numVert = 0;
+  for (int s = 0; s < static_cast<int>(spans.size()); ++s) {
+    const int n = spans[s].size();
+    for (int start = 0; start < n; start += kBlockSize)
+      blocks.push_back({s, start, glm::min(n, start + kBlockSize)});
+    numVert += n;
+  }
+  if (numVert < 4) return Manifold();
+  const int numBlock = blocks.size();
+  const ExecutionPolicy policy = autoPolicy(numVert);
+
+  std::vector<glm::vec4> planes;
+  if (numVert >= kHullPrefilter) {
+    std::vector<glm::vec3> dirs;
+    for (int x : {-1, 0, 1})
+      for (int y : {-1, 0, 1})
+        for (int z : {-1, 0, 1})
+          if (x != 0 || y != 0 || z != 0) dirs.push_back(glm::vec3(x, y, z));
+    const int numDir = dirs.size();
+
+    std::vector<glm::vec3> extremes(numBlock * numDir);
+    std::vector<float> extents(numBlock * numDir);
+    for_each_n(policy, countAt(0), numBlock, [&](int b) {
+      const Block& block = blocks[b];
+      const VecView<const glm::vec3>& span = spans[block.span];
+      float* extent = extents.data() + b * numDir;
+      glm::vec3* extreme = extremes.data() + b * numDir;
+      std::fill(extent, extent + numDir,
+                -std::numeric_limits<float>::infinity());
+      for (int i = block.start; i < block.end; ++i) {
+        for (int d = 0; d < numDir; ++d) {
+          const float dist = glm::dot(dirs[d], span[i]);
+          if (dist > extent[d]) {
+            extent[d] = dist;
+            extreme[d] = span[i];
+          }
+        }
+      }
+    });
+    std::vector<quickhull::Vector3<double>> inner;
+    glm::vec3 center(0);
+    float scale = 0;
+    for (int d = 0; d < numDir; ++d) {
+      int best = d;
+      for (int b = 1; b < numBlock; ++b)
+        if (extents[b * numDir + d] > extents[best]) best = b * numDir + d;
+      const glm::vec3 p = extremes[best];
+      inner.push_back({p.x, p.y, p.z});
+      center += p / static_cast<float>(numDir);
+      scale = glm::max(scale, glm::abs(extents[best]));
+    }
+
+    quickhull::QuickHull<double> qh;
+    auto innerHull = qh.getConvexHull(inner, false, true);
+    const auto& tris = innerHull.getIndexBuffer();
+    // points this close to a face are kept, as its rounding is unknown
+    const float tolerance = 1e-5f * scale;
+    for (int i = 0; i + 2 < static_cast<int>(tris.size()); i += 3) {
+      const auto& v0 = inner[tris[i]];
+      const auto& v1 = inner[tris[i + 1]];
+      const auto& v2 = inner[tris[i + 2]];
+      const glm::dvec3 p0(v0.x, v0.y, v0.z);
+      glm::dvec3 normal = glm::cross(glm::dvec3(v1.x, v1.y, v1.z) - p0,
+                                     glm::dvec3(v2.x, v2.y, v2.z) - p0);
+      const double length = glm::length(normal);
+      if (length == 0) continue;
+      normal /= length;
+      double offset = glm::dot(normal, p0);
+      // face outward, whatever the winding
+      if (glm::dot(normal, glm::dvec3(center)) > offset) {
+        normal = -normal;
+        offset = -offset;
+      }
+      planes.push_back(glm::vec4(normal, offset - tolerance));
+    }
+    // a flat or degenerate inner hull culls nothing
+    if (planes.size() < 4) planes.clear();
+  }
+
+  std::vector<std::vector<glm::vec3>> kept(numBlock);
+  for_each_n(policy, countAt(0), numBlock, [&](int b) {
+    const Block& block = blocks[b];
+    const VecView<const glm::vec3>& span = spans[block.span];
+    for (int i = block.start; i < block.end; ++i) {
+      bool inside = !planes.empty();
+      for (const glm::vec4& plane : planes) {
+        if (glm::dot(glm::vec3(plane), span[i]) >= plane.w) {
+          inside = false;
+          break;
+        }
+      }
+      if (!inside) kept[b].push_back(span[i]);
+    }
+  });
+
+  Mesh mesh;
+  for (const auto& blockPts : kept)
+    mesh.vertPos.insert(mesh.vertPos.end(), blockPts.begin(), blockPts.end());
+  const int numKept = mesh.vertPos.size();
+  if (numKept < 4) return Manifold();
+
+  std::vector<quickhull::Vector3<double>> vertices(numKept);
+  for_each_n(autoPolicy(numKept), countAt(0), numKept, [&](int i) {
+    const glm::vec3 p = mesh.vertPos[i];
+    vertices[i] = {p.x, p.y, p.z};
+  });
+
+  quickhull::QuickHull<double> qh;
+  // bools: correct triangle winding, and use original indices
+  auto hull = qh.getConvexHull(vertices, false, true);
+  const auto& triangles = hull.getIndexBuffer();
+  const int numTris = triangles.size() / 3;
+
+  mesh.triVerts.reserve(numTris);
+  for (int i = 0; i < numTris; i++) {
+    const int j = i * 3;
+    mesh.triVerts.push_back({triangles[j], triangles[j + 1], triangles[j + 2]});
+  }
+  return Manifold(mesh);
+}
+
+// The Minkowski sum of two convex manifolds, as the convex hull of the
+// pairwise sums of their verts. A sum can only be a vertex of the result if
+// it is extreme in some direction for both, which requires the normal cones
+// of its two verts to overlap, so when both are known to be convex every
+// other pair is skipped before the single hull. That test only holds for
+// convex inputs, and the parts of a ConvexDecomposition need not be, so
+// callers pass convex = false to hull every pair instead.
+Manifold ConvexMinkowski(const Manifold::Impl& a, const Manifold::Impl& b,
+                         bool convex) {
+  // slack for the rounding of the normals
+  constexpr float kConeSlack = 1e-3;
+  std::vector<float> coneA, coneB;
+  if (convex) {
+    coneA = NormalConeAngles(a);
+    coneB = NormalConeAngles(b);
+  }
+  std::vector<std::vector<glm::vec3>> sums(a.NumVert());
+  const int numSum = glm::min<int64_t>((int64_t)a.NumVert() * b.NumVert(),
+                                       std::numeric_limits<int>::max());
+  for_each_n(autoPolicy(numSum), countAt(0), a.NumVert(),
+             [&](int i) {
+               for (int j = 0; j < b.NumVert(); ++j) {
+                 if (convex) {
+                   const float cos =
+                       glm::dot(a.vertNormal_[i], b.vertNormal_[j]);
+                   if (glm::acos(glm::clamp(cos, -1.0f, 1.0f)) >
+                       coneA[i] + coneB[j] + kConeSlack)
+                     continue;
+                 }
+                 sums[i].push_back(a.vertPos_[i] + b.vertPos_[j]);
+               }
+             });
+  std::vector<glm::vec3> pts;
+  for (const auto& vertSums : sums)
+    pts.insert(pts.end(), vertSums.begin(), vertSums.end());
+  return Manifold::Hull(pts);
+}
+
 Manifold Halfspace(Box bBox, glm::vec3 normal, float originOffset) {
   normal = glm::normalize(normal);
   Manifold cutter =
@@ -140,6 +447,30 @@ Manifold Halfspace(Box bBox, glm::vec3 normal, float originOffset) {
   float zDeg = glm::degrees(glm::atan(normal.y, normal.x));
   return cutter.Rotate(0.0f, yDeg, zDeg);
 }
+
+// Best of three wall times of the kernel over n elements.
+template <typename Func>
+double TimeKernel(ExecutionPolicy policy, int n, Func f) {
+  double best = std::numeric_limits<double>::infinity();
+  for (int rep = 0; rep < 3; ++rep) {
+    PhaseTimer timer;
+    for_each_n(policy, countAt(0), n, f);
+    best = std::min(best, timer.Lap());
+  }
+  return best;
+}
+
+// The largest power of two below the first size at which the kernel runs
+// clearly faster in parallel, or maxSize if it never does.
+template <typename Func>
+int SerialCutoff(int maxSize, Func f) {
+  for (int n = 1 << 6; n <= maxSize; n *= 2) {
+    if (TimeKernel(ExecutionPolicy::Par, n, f) <
+        0.9 * TimeKernel(ExecutionPolicy::Seq, n, f))
+      return n / 2;
+  }
+  return maxSize;
+}
 }  // namespace
 
 namespace manifold {
@@ -153,7 +484,7 @@ Manifold::~Manifold() = default;
 Manifold::Manifold(Manifold&&) noexcept = default;
 Manifold& Manifold::operator=(Manifold&&) noexcept = default;
 
-Manifold::Manifold(const Manifold& other) : pNode_(other.pNode_) {}
+Manifold::Manifold(const Manifold& other) : pNode_(other.GetNode()) {}
 
 Manifold::Manifold(std::shared_ptr<CsgNode> pNode) : pNode_(pNode) {}
 
@@ -168,16 +499,36 @@ Manifold Manifold::Invalid() {
 
 Manifold& Manifold::operator=(const Manifold& other) {
   if (this != &other) {
-    pNode_ = other.pNode_;
+    pNode_ = other.GetNode();
   }
   return *this;
 }
 
+/**
+ * pNode_ is swapped for its evaluated leaf by const queries, which may run on
+ * several threads at once, so it is only read and written atomically.
+ */
+std::shared_ptr<CsgNode> Manifold::GetNode() const {
+  return std::atomic_load(&pNode_);
+}
+
 CsgLeafNode& Manifold::GetCsgLeafNode() const {
-  if (pNode_->GetNodeType() != CsgNodeType::Leaf) {
-    pNode_ = pNode_->ToLeafNode();
+  std::shared_ptr<CsgNode> node = GetNode();
+  if (node->GetNodeType() != CsgNodeType::Leaf) {
+    // ToLeafNode returns the same cached leaf to every caller, so pNode_ holds
+    // the node referenced here whichever thread stores it.
+    node = node->ToLeafNode();
+    // A cancelled result is not cached by ToLeafNode either, and must not
+    // replace the tree, so that it can be evaluated again outside the
+    // cancelled context. All such results are alike, so one is shared.
+    const auto leaf = std::static_pointer_cast<CsgLeafNode>(node);
+    if (leaf->GetBaseImpl()->status_ == Error::Cancelled) {
+      static CsgLeafNode cancelled(leaf->GetImpl());
+      return cancelled;
+    }
+    std::atomic_store(&pNode_, node);
   }
-  return *std::static_pointer_cast<CsgLeafNode>(pNode_);
+  return *std::static_pointer_cast<CsgLeafNode>(node);
 }
 
 /**
@@ -205,6 +556,18 @@ Manifold::Manifold(const MeshGL& meshGL,
     : pNode_(std::make_shared<CsgLeafNode>(
           std::make_shared<Impl>(meshGL, propertyTolerance))) {}
 
+/**
+ * As Manifold(const MeshGL&), but reading straight from caller-owned memory,
+ * which is not retained.
+ *
+ * @param meshGLView Views of the input arrays.
+ * @param propertyTolerance As for MeshGL.
+ */
+Manifold::Manifold(const MeshGLView& meshGLView,
+                   const std::vector<float>& propertyTolerance)
+    : pNode_(std::make_shared<CsgLeafNode>(
+          std::make_shared<Impl>(meshGLView, propertyTolerance))) {}
+
 /**
  * Convert a Mesh into a Manifold. Will return an empty Manifold
  * and set an Error Status if the Mesh is not an oriented 2-manifold. Will
@@ -416,6 +779,169 @@ MeshGL Manifold::GetMeshGL(glm::ivec3 normalIdx) const {
   return out;
 }
 
+/**
+ * Writes the vertex properties and triangles into caller-owned buffers, e.g.
+ * to refresh a preview every frame without allocating. Query the sizes first:
+ * vertProperties needs (3 + NumProp()) * NumPropVert() floats and triVerts
+ * needs 3 * NumTri() indices. Unlike GetMeshGL(), the triangles stay in
+ * internal order and there is one vertex per property vertex; normals aren't
+ * updated and no runs or merge vectors are produced, so use GetMeshGL() for a
+ * lossless round-trip. Property vertices no triangle refers to are left as
+ * they were.
+ *
+ * @param vertProperties Interleaved as in MeshGL::vertProperties.
+ * @param triVerts As in MeshGL::triVerts.
+ * @return false, writing nothing, if either buffer is too small.
+ */
+bool Manifold::GetMeshGL(VecView<float> vertProperties,
+                         VecView<uint32_t> triVerts) const {
+  ZoneScoped;
+  const Impl& impl = *GetCsgLeafNode().GetImpl();
+  const int numProp = NumProp();
+  const int stride = 3 + numProp;
+  const int numVert = NumPropVert();
+  const int numTri = NumTri();
+  if (vertProperties.size() < stride * numVert ||
+      triVerts.size() < 3 * numTri)
+    return false;
+
+  if (numProp == 0) {
+    for_each_n(autoPolicy(numVert), countAt(0), numVert, [&](int vert) {
+      for (const int j : {0, 1, 2})
+        vertProperties[3 * vert + j] = impl.vertPos_[vert][j];
+    });
+    for_each_n(autoPolicy(numTri), countAt(0), 3 * numTri, [&](int halfedge) {
+      triVerts[halfedge] = impl.halfedge_[halfedge].startVert;
+    });
+    return true;
+  }
+
+  const auto& relation = impl.meshRelation_;
+  for_each_n(autoPolicy(numVert), countAt(0), numVert, [&](int prop) {
+    for (int p = 0; p < numProp; ++p)
+      vertProperties[stride * prop + 3 + p] =
+          relation.properties[numProp * prop + p];
+  });
+  // Every corner of a property vertex is at the same position, so the
+  // repeated writes agree.
+  for_each_n(autoPolicy(numTri), countAt(0), numTri, [&](int tri) {
+    for (const int i : {0, 1, 2}) {
+      const int prop = relation.triProperties[tri][i];
+      const int vert = impl.halfedge_[3 * tri + i].startVert;
+      const glm::vec3 pos = impl.vertPos_[vert];
+      triVerts[3 * tri + i] = prop;
+      for (const int j : {0, 1, 2}) vertProperties[stride * prop + j] = pos[j];
+    }
+  });
+  return true;
+}
+
+/**
+ * Streams the positions and triangles to sink without building a MeshGL, for
+ * writing out large results with constant extra memory beyond the run order.
+ * The vertex indices match those of GetMeshGL() when there are no properties,
+ * and the triangles come in the same order.
+ *
+ * @param sink Receives the vertex positions, then the triangles in chunks.
+ * @param chunkTri The maximum number of triangles passed per Tris() call.
+ */
+void Manifold::StreamMesh(MeshSink& sink, int chunkTri) const {
+  ZoneScoped;
+  const Impl& impl = *GetCsgLeafNode().GetImpl();
+  const int numTri = NumTri();
+  chunkTri = std::max(1, std::min(chunkTri, numTri));
+
+  sink.Begin(impl.vertPos_.cview(), numTri);
+
+  const bool isOriginal = impl.meshRelation_.originalID >= 0;
+  VecView<const TriRef> triRef = impl.meshRelation_.triRef;
+  std::vector<int> triNew2Old;
+  // Don't sort originals - keep them in order
+  if (!isOriginal) {
+    triNew2Old.resize(numTri);
+    std::iota(triNew2Old.begin(), triNew2Old.end(), 0);
+    std::sort(triNew2Old.begin(), triNew2Old.end(), [triRef](int a, int b) {
+      return triRef[a].originalID == triRef[b].originalID
+                 ? triRef[a].meshID < triRef[b].meshID
+                 : triRef[a].originalID < triRef[b].originalID;
+    });
+  }
+  auto oldTri = [&](int tri) { return isOriginal ? tri : triNew2Old[tri]; };
+
+  std::vector<glm::ivec3> chunk(chunkTri);
+  int tri = 0;
+  while (tri < numTri) {
+    const int meshID = triRef[oldTri(tri)].meshID;
+    const auto it = impl.meshRelation_.meshIDtransform.find(meshID);
+    const int originalID =
+        it == impl.meshRelation_.meshIDtransform.end() ? -1
+                                                      : it->second.originalID;
+    int end = tri;
+    for (; end < numTri && end - tri < chunkTri; ++end) {
+      const int old = oldTri(end);
+      if (triRef[old].meshID != meshID) break;
+      for (const int i : {0, 1, 2})
+        chunk[end - tri][i] = impl.halfedge_[3 * old + i].startVert;
+    }
+    sink.Tris(tri, VecView<const glm::ivec3>(chunk.data(), end - tri),
+              originalID);
+    tri = end;
+  }
+  sink.End();
+}
+
+/**
+ * Returns each unique mesh of this Manifold once, with the transforms of all
+ * of its copies, for instanced rendering or export. If this Manifold is a
+ * union of transformed copies whose bounding boxes are pairwise disjoint, it
+ * is not evaluated, so memory scales with the unique geometry rather than the
+ * number of copies. Anything else is evaluated and returned as a single mesh
+ * with the identity transform. Each mesh is as from GetMeshGL().
+ *
+ * @param normalIdx As in GetMeshGL().
+ */
+std::vector<MeshInstances> Manifold::GetInstances(glm::ivec3 normalIdx) const {
+  const std::vector<std::shared_ptr<CsgLeafNode>> leaves =
+      GetNode()->DisjointLeaves();
+  if (leaves.empty()) {
+    if (IsEmpty()) return {};
+    return {{GetMeshGL(normalIdx), {glm::mat4x3(1.0f)}}};
+  }
+
+  std::vector<MeshInstances> instances;
+  std::unordered_map<const Impl*, int> instanceIdx;
+  for (const auto& leaf : leaves) {
+    const std::shared_ptr<const Impl> base = leaf->GetBaseImpl();
+    auto it = instanceIdx.find(base.get());
+    if (it == instanceIdx.end()) {
+      it = instanceIdx.emplace(base.get(), instances.size()).first;
+      const Manifold mesh(std::make_shared<CsgLeafNode>(base));
+      instances.push_back({mesh.GetMeshGL(normalIdx), {}});
+    }
+    instances[it->second].transforms.push_back(leaf->GetTransform());
+  }
+  return instances;
+}
+
+/**
+ * Starts evaluating the pending operations of this Manifold's CSG tree on a
+ * background thread, returning a future that becomes ready once they're done,
+ * so that the first query no longer blocks. Poll it with wait_for(0) or block
+ * with wait(); get() rethrows anything evaluation threw. The result is cached
+ * in the tree as usual, so afterwards this Manifold and its copies answer
+ * queries without further evaluation.
+ *
+ * Queries made meanwhile, from any thread, wait for the operations already
+ * started rather than starting them again, but a pending transform of a leaf
+ * may be applied by both, with one copy discarded.
+ */
+std::shared_future<void> Manifold::EvaluateAsync() const {
+  auto evaluate = [manifold = *this]() {
+    manifold.GetCsgLeafNode().GetImpl();
+  };
+  return std::async(std::launch::async, evaluate).share();
+}
+
 /**
  * Does the Manifold have any triangles?
  */
@@ -557,6 +1083,45 @@ int Manifold::NumOverlaps(const Manifold& other) const {
   return num_overlaps + overlaps.size();
 }
 
+/**
+ * Casts a batch of rays and returns the first surface hit by each. Rays start
+ * at origins[i] and travel along directions[i], which need not be normalized;
+ * the hit distance is measured in world units. Only hits in front of the
+ * origin count, including where the origin is inside the manifold.
+ *
+ * @param origins Ray start points.
+ * @param directions Ray directions, the same length as origins.
+ */
+std::vector<RayHit> Manifold::RayCast(
+    const std::vector<glm::vec3>& origins,
+    const std::vector<glm::vec3>& directions) const {
+  return GetCsgLeafNode().GetImpl()->RayCast(
+      {origins.data(), static_cast<int>(origins.size())},
+      {directions.data(), static_cast<int>(directions.size())});
+}
+
+/**
+ * Returns the closest point on the surface to each of a batch of points.
+ *
+ * @param points Query points.
+ */
+std::vector<SurfacePoint> Manifold::ClosestPoint(
+    const std::vector<glm::vec3>& points) const {
+  return GetCsgLeafNode().GetImpl()->ClosestPoint(
+      {points.data(), static_cast<int>(points.size())});
+}
+
+/**
+ * Tests a batch of points for containment, returning 1 for each point inside
+ * the manifold and 0 for each point outside. Points exactly on the surface may
+ * go either way.
+ *
+ * @param points Query points, e.g. a view of a caller-owned buffer.
+ */
+std::vector<char> Manifold::Contains(VecView<const glm::vec3> points) const {
+  return GetCsgLeafNode().GetImpl()->Contains(points);
+}
+
 /**
  * Move this Manifold in space. This operation can be chained. Transforms are
  * combined and applied lazily.
@@ -564,7 +1129,7 @@ int Manifold::NumOverlaps(const Manifold& other) const {
  * @param v The vector to add to every vertex.
  */
 Manifold Manifold::Translate(glm::vec3 v) const {
-  return Manifold(pNode_->Translate(v));
+  return Manifold(GetNode()->Translate(v));
 }
 
 /**
@@ -574,7 +1139,7 @@ Manifold Manifold::Translate(glm::vec3 v) const {
  * @param v The vector to multiply every vertex by per component.
  */
 Manifold Manifold::Scale(glm::vec3 v) const {
-  return Manifold(pNode_->Scale(v));
+  return Manifold(GetNode()->Scale(v));
 }
 
 /**
@@ -591,7 +1156,7 @@ Manifold Manifold::Scale(glm::vec3 v) const {
  */
 Manifold Manifold::Rotate(float xDegrees, float yDegrees,
                           float zDegrees) const {
-  return Manifold(pNode_->Rotate(xDegrees, yDegrees, zDegrees));
+  return Manifold(GetNode()->Rotate(xDegrees, yDegrees, zDegrees));
 }
 
 /**
@@ -602,7 +1167,7 @@ Manifold Manifold::Rotate(float xDegrees, float yDegrees,
  * @param m The affine transform matrix to apply to all the vertices.
  */
 Manifold Manifold::Transform(const glm::mat4x3& m) const {
-  return Manifold(pNode_->Transform(m));
+  return Manifold(GetNode()->Transform(m));
 }
 
 /**
@@ -619,7 +1184,7 @@ Manifold Manifold::Mirror(glm::vec3 normal) const {
   }
   auto n = glm::normalize(normal);
   auto m = glm::mat4x3(glm::mat3(1.0f) - 2.0f * glm::outerProduct(n, n));
-  return Manifold(pNode_->Transform(m));
+  return Manifold(GetNode()->Transform(m));
 }
 
 /**
@@ -665,8 +1230,27 @@ Manifold Manifold::SetProperties(
     int numProp, std::function<void(float* newProp, glm::vec3 position,
                                     const float* oldProp)>
                      propFunc) const {
+  return SetProperties<decltype(propFunc)&>(numProp, propFunc);
+}
+
+/**
+ * Same as Manifold::SetProperties, but calls propFunc once with views of all
+ * the property vertices: newProp holds numProp values for each (initialized
+ * to zero), position holds the position of each, and oldProp holds NumProp()
+ * values for each. This avoids a function call per vertex and lets propFunc
+ * vectorize or parallelize as it sees fit.
+ *
+ * @param numProp The new number of properties per vertex.
+ * @param propFunc A function that fills in the new properties of every
+ * property vertex.
+ */
+Manifold Manifold::SetPropertiesBatch(
+    int numProp,
+    std::function<void(VecView<float> newProp,
+                       VecView<const glm::vec3> position,
+                       VecView<const float> oldProp)>
+        propFunc) const {
   auto pImpl = std::make_shared<Impl>(*GetCsgLeafNode().GetImpl());
-  const int oldNumProp = NumProp();
   const Vec<float> oldProperties = pImpl->meshRelation_.properties;
 
   auto& triProperties = pImpl->meshRelation_.triProperties;
@@ -674,25 +1258,32 @@ Manifold Manifold::SetProperties(
     triProperties.resize(0);
     pImpl->meshRelation_.properties.resize(0);
   } else {
+    int numPropVert = NumPropVert();
     if (triProperties.size() == 0) {
       const int numTri = NumTri();
       triProperties.resize(numTri);
-      int idx = 0;
+      numPropVert = 0;
       for (int i = 0; i < numTri; ++i) {
         for (const int j : {0, 1, 2}) {
-          triProperties[i][j] = idx++;
+          triProperties[i][j] = numPropVert++;
         }
       }
-      pImpl->meshRelation_.properties = Vec<float>(numProp * idx, 0);
-    } else {
-      pImpl->meshRelation_.properties = Vec<float>(numProp * NumPropVert(), 0);
     }
-    thrust::for_each_n(
-        thrust::host, countAt(0), NumTri(),
-        UpdateProperties({pImpl->meshRelation_.properties.data(), numProp,
-                          oldProperties.data(), oldNumProp,
-                          pImpl->vertPos_.data(), triProperties.data(),
-                          pImpl->halfedge_.data(), propFunc}));
+    pImpl->meshRelation_.properties = Vec<float>(numProp * numPropVert, 0);
+
+    // Every corner of a property vertex has the same vertex, so any that race
+    // write the same position.
+    Vec<glm::vec3> position(numPropVert, glm::vec3(0));
+    const VecView<const Halfedge> halfedge = pImpl->halfedge_;
+    const VecView<const glm::vec3> vertPos = pImpl->vertPos_;
+    for_each_n(autoPolicy(NumTri()), countAt(0), NumTri(), [&](int tri) {
+      for (const int j : {0, 1, 2}) {
+        const int vert = halfedge[3 * tri + j].startVert;
+        position[triProperties[tri][j]] = vertPos[vert];
+      }
+    });
+    propFunc(pImpl->meshRelation_.properties.view(), position.cview(),
+             oldProperties.cview());
   }
 
   pImpl->meshRelation_.numProp = numProp;
@@ -735,7 +1326,60 @@ Manifold Manifold::CalculateCurvature(int gaussianIdx, int meanIdx) const {
  */
 Manifold Manifold::Refine(int n) const {
   auto pImpl = std::make_shared<Impl>(*GetCsgLeafNode().GetImpl());
-  pImpl->Refine(n);
+  pImpl->Refine([n](int) { return n; });
+  return Manifold(std::make_shared<CsgLeafNode>(pImpl));
+}
+
+/**
+ * Increase the density of the mesh by splitting each edge into pieces of
+ * roughly the input length. Interior verts are added to keep the rest of the
+ * triangulation edges also of roughly the same length. If halfedgeTangents
+ * are present (e.g. from the Smooth() constructor), the new vertices will be
+ * moved to the interpolated surface according to their barycentric
+ * coordinates. An edge is split into at most 512 pieces per call.
+ *
+ * @param length The length that edges will be broken down to.
+ */
+Manifold Manifold::RefineToLength(float length) const {
+  auto pImpl = std::make_shared<Impl>(*GetCsgLeafNode().GetImpl());
+  pImpl->RefineToLength(length);
+  return Manifold(std::make_shared<CsgLeafNode>(pImpl));
+}
+
+/**
+ * Increase the density of the mesh by splitting each edge into as many pieces
+ * as needed for the smooth surface given by its halfedgeTangents (e.g. from
+ * the Smooth() constructor) to deviate from the refined mesh by no more than
+ * the input precision. Flat areas are left coarse. If there are no
+ * halfedgeTangents, the mesh is returned unchanged. An edge is split into at
+ * most 512 pieces per call.
+ *
+ * @param precision The maximum distance between the smooth surface and the
+ * refined mesh.
+ */
+Manifold Manifold::RefineToPrecision(float precision) const {
+  auto pImpl = std::make_shared<Impl>(*GetCsgLeafNode().GetImpl());
+  pImpl->RefineToPrecision(precision);
+  return Manifold(std::make_shared<CsgLeafNode>(pImpl));
+}
+
+/**
+ * Reduce the density of the mesh for level-of-detail output by collapsing
+ * edges in order of their quadric error: the summed squared distance of a
+ * moved vert from the planes of the original triangles it has absorbed. The
+ * result stays manifold: no collapse flips a triangle or pinches the surface,
+ * and verts on the boundaries between runs of different input meshes or on
+ * property seams are never removed, so the mesh relation and properties are
+ * kept. Any halfedgeTangents are dropped.
+ *
+ * @param targetTris Stop once the number of triangles is at most this. Pass 0
+ * to be limited by maxError alone.
+ * @param maxError Do not make any collapse whose quadric error exceeds this
+ * distance.
+ */
+Manifold Manifold::Simplify(int targetTris, float maxError) const {
+  auto pImpl = std::make_shared<Impl>(*GetCsgLeafNode().GetImpl());
+  pImpl->Simplify(targetTris, maxError);
   return Manifold(std::make_shared<CsgLeafNode>(pImpl));
 }
 
@@ -754,7 +1398,7 @@ Manifold Manifold::Refine(int n) const {
  * @param op The type of operation to perform.
  */
 Manifold Manifold::Boolean(const Manifold& second, OpType op) const {
-  return Manifold(pNode_->Boolean(second.pNode_, op));
+  return Manifold(GetNode()->Boolean(second.GetNode(), op));
 }
 
 /**
@@ -769,7 +1413,7 @@ Manifold Manifold::BatchBoolean(const std::vector<Manifold>& manifolds,
     return manifolds[0];
   std::vector<std::shared_ptr<CsgNode>> children;
   children.reserve(manifolds.size());
-  for (const auto& m : manifolds) children.push_back(m.pNode_);
+  for (const auto& m : manifolds) children.push_back(m.GetNode());
   return Manifold(std::make_shared<CsgOpNode>(children, op));
 }
 
@@ -830,10 +1474,11 @@ std::pair<Manifold, Manifold> Manifold::Split(const Manifold& cutter) const {
   auto impl2 = cutter.GetCsgLeafNode().GetImpl();
 
   Boolean3 boolean(*impl1, *impl2, OpType::Subtract);
+  std::pair<Impl, Impl> results = boolean.Split();
   auto result1 = std::make_shared<CsgLeafNode>(
-      std::make_unique<Impl>(boolean.Result(OpType::Intersect)));
+      std::make_unique<Impl>(std::move(results.first)));
   auto result2 = std::make_shared<CsgLeafNode>(
-      std::make_unique<Impl>(boolean.Result(OpType::Subtract)));
+      std::make_unique<Impl>(std::move(results.second)));
   return std::make_pair(Manifold(result1), Manifold(result2));
 }
 
@@ -874,6 +1519,19 @@ CrossSection Manifold::Slice(float height) const {
   return GetCsgLeafNode().GetImpl()->Slice(height);
 }
 
+/**
+ * Returns the cross sections at each of the given Z heights, in the same
+ * order, as though Slice was called for each. This is much faster than
+ * separate calls for many layers, as the triangles are only visited once and
+ * the layers are assembled in parallel.
+ *
+ * @param heights The Z heights, in any order.
+ */
+std::vector<CrossSection> Manifold::Slices(
+    const std::vector<float>& heights) const {
+  return GetCsgLeafNode().GetImpl()->Slices(heights);
+}
+
 /**
  * Returns a cross section representing the projected outline of this object
  * onto the X-Y plane.
@@ -884,6 +1542,84 @@ CrossSection Manifold::Project() const {
 
 ExecutionParams& ManifoldParams() { return manifoldParams; }
 
+void SetBufferAllocator(const BufferAllocator& allocator) {
+  BufferPool::Get().SetAllocator(allocator);
+}
+
+void ReleaseBufferPool() { BufferPool::Get().Release(); }
+
+void RunInContext(const ExecutionContext& context,
+                  const std::function<void()>& f) {
+  const Cancellation cancellation(context.cancel, context.deadline);
+  auto run = [&]() {
+    SerialScope serial(context.maxConcurrency == 1);
+    Cancellation::Scope cancel(&cancellation);
+    f();
+  };
+  if (context.executor) {
+    context.executor(run);
+    return;
+  }
+#if MANIFOLD_PAR == 'T' && __has_include(<tbb/tbb.h>)
+  if (context.maxConcurrency > 1) {
+    tbb::task_arena arena(context.maxConcurrency);
+    arena.execute(run);
+    return;
+  }
+#endif
+  run();
+}
+
+SerialCutoffs& SerialCutoffs::Get() {
+  static SerialCutoffs cutoffs;
+  return cutoffs;
+}
+
+void SetParallelThresholds(const ParallelThresholds& thresholds) {
+  SerialCutoffs::Get().SetThresholds(thresholds);
+}
+
+ParallelThresholds GetParallelThresholds() {
+  return SerialCutoffs::Get().Thresholds();
+}
+
+ParallelThresholds CalibrateParallelThresholds() {
+#if MANIFOLD_PAR == 'T'
+  const int maxSize = 1 << 20;
+  Vec<float> in(maxSize);
+  Vec<float> out(maxSize);
+  sequence(ExecutionPolicy::Par, in.begin(), in.end());
+  // start the worker threads before anything is timed
+  for_each_n(ExecutionPolicy::Par, countAt(0), maxSize,
+             [&](int i) { out[i] = in[i]; });
+
+  ParallelThresholds thresholds;
+  thresholds.trivial =
+      SerialCutoff(maxSize, [&](int i) { out[i] = in[i]; });
+  thresholds.light = SerialCutoff(maxSize, [&](int i) {
+    const glm::vec3 v(in[i], 1.0f, out[i]);
+    out[i] = glm::length(glm::cross(v, glm::vec3(1.0f, 2.0f, 3.0f)));
+  });
+  thresholds.heavy = SerialCutoff(1 << 16, [&](int i) {
+    float x = in[i];
+    for (int j = 0; j < 256; ++j) x = 0.5f * glm::sqrt(x * x + 1.0f);
+    out[i] = x;
+  });
+  SetParallelThresholds(thresholds);
+  return thresholds;
+#else
+  return GetParallelThresholds();
+#endif
+}
+
+MemoryStats GetMemoryStats(MemoryCategory category) {
+  return MemoryCounters::Get().Stats(category);
+}
+
+MemoryStats GetMemoryStats() { return MemoryCounters::Get().Total(); }
+
+void ResetMemoryStats() { MemoryCounters::Get().Reset(); }
+
 /**
  * Compute the convex hull of a set of points. If the given points are fewer
  * than 4, or they are all coplanar, an empty Manifold will be returned.
@@ -892,35 +1628,16 @@ ExecutionParams& ManifoldParams() { return manifoldParams; }
  * hull.
  */
 Manifold Manifold::Hull(const std::vector<glm::vec3>& pts) {
-  ZoneScoped;
-  const int numVert = pts.size();
-  if (numVert < 4) return Manifold();
-
-  std::vector<quickhull::Vector3<double>> vertices(numVert);
-  for (int i = 0; i < numVert; i++) {
-    vertices[i] = {pts[i].x, pts[i].y, pts[i].z};
-  }
-
-  quickhull::QuickHull<double> qh;
-  // bools: correct triangle winding, and use original indices
-  auto hull = qh.getConvexHull(vertices, false, true);
-  const auto& triangles = hull.getIndexBuffer();
-  const int numTris = triangles.size() / 3;
-
-  Mesh mesh;
-  mesh.vertPos = pts;
-  mesh.triVerts.reserve(numTris);
-  for (int i = 0; i < numTris; i++) {
-    const int j = i * 3;
-    mesh.triVerts.push_back({triangles[j], triangles[j + 1], triangles[j + 2]});
-  }
-  return Manifold(mesh);
+  return HullSpans(
+      {VecView<const glm::vec3>(pts.data(), static_cast<int>(pts.size()))});
 }
 
 /**
  * Compute the convex hull of this manifold.
  */
-Manifold Manifold::Hull() const { return Hull(GetMesh().vertPos); }
+Manifold Manifold::Hull() const {
+  return HullSpans({GetCsgLeafNode().GetImpl()->vertPos_});
+}
 
 /**
  * Compute the convex hull enveloping a set of manifolds.
@@ -928,25 +1645,38 @@ Manifold Manifold::Hull() const { return Hull(GetMesh().vertPos); }
  * @param manifolds A vector of manifolds over which to compute a convex hull.
  */
 Manifold Manifold::Hull(const std::vector<Manifold>& manifolds) {
-  return Compose(manifolds).Hull();
+  std::vector<std::shared_ptr<const Impl>> impls;
+  std::vector<VecView<const glm::vec3>> spans;
+  for (const Manifold& manifold : manifolds) {
+    impls.push_back(manifold.GetCsgLeafNode().GetImpl());
+    spans.push_back(impls.back()->vertPos_);
+  }
+  return HullSpans(spans);
 }
 
 /**
- * Compute the convex hulls enveloping many sets of manifolds.
+ * Compute the convex hulls enveloping many sets of manifolds. The hulls are
+ * computed in parallel.
  *
  * @param manifolds A vector of vectors of manifolds over which compute hulls.
  */
 std::vector<Manifold> Manifold::BatchHull(
     const std::vector<std::vector<Manifold>>& manifolds) {
   ZoneScoped;
-  std::vector<Manifold> output;
-  output.reserve(manifolds.size());
-  output.resize(manifolds.size());
-  thrust::for_each_n(
-      thrust::host, zip(manifolds.begin(), output.begin()), manifolds.size(),
-      [](thrust::tuple<std::vector<Manifold>, Manifold&> inOut) {
-        thrust::get<1>(inOut) = Manifold::Hull(thrust::get<0>(inOut));
-      });
+  // resolved up front, as a manifold may be shared between groups
+  std::vector<std::shared_ptr<const Impl>> impls;
+  std::vector<std::vector<VecView<const glm::vec3>>> spans(manifolds.size());
+  for (size_t i = 0; i < manifolds.size(); ++i) {
+    for (const Manifold& manifold : manifolds[i]) {
+      impls.push_back(manifold.GetCsgLeafNode().GetImpl());
+      spans[i].push_back(impls.back()->vertPos_);
+    }
+  }
+  const int numHull = manifolds.size();
+  std::vector<Manifold> output(numHull);
+  for_each_n(numHull > 1 ? ExecutionPolicy::Par : ExecutionPolicy::Seq,
+             countAt(0), numHull,
+             [&](int i) { output[i] = HullSpans(spans[i]); });
   return output;
 }
 
@@ -955,6 +1685,8 @@ std::vector<Manifold> Manifold::BatchHull(
  *
  * @param pts A vector of points over which to fracture the manifold.
  * @param wts A vector of weights controlling the relative size of each chunk.
+ * @return One Manifold per point, or a single Manifold with status Cancelled if
+ * stopped through an ExecutionContext.
  */
 std::vector<Manifold> Manifold::Fracture(const std::vector<glm::dvec3>& pts,
                                          const std::vector<double>& wts) const {
@@ -968,21 +1700,28 @@ std::vector<Manifold> Manifold::Fracture(const std::vector<glm::dvec3>& pts,
   glm::vec3 max = bounds.max + 0.1f;
   double V = (max.x - min.x) * (max.y - min.y) * (max.z - min.z);
   double Nthird = powf((double)pts.size() / V, 1.0f / 3.0f);
-  voro::container_poly container(min.x, max.x, min.y, max.y, min.z, max.z,
-                                 std::round(Nthird * (max.x - min.x)),
-                                 std::round(Nthird * (max.y - min.y)),
-                                 std::round(Nthird * (max.z - min.z)),  //
-                                 false, false, false, pts.size());
-
   bool hasWeights = wts.size() == pts.size();
-  for (size_t i = 0; i < pts.size(); i++) {
-    container.put(i, pts[i].x, pts[i].y, pts[i].z, hasWeights ? wts[i] : 1.0f);
-  }
+  // Identical construction gives every container the same block layout, so a
+  // cell's (ijk, q) address is valid in all of them.
+  auto MakeContainer = [&]() {
+    auto container = std::make_unique<voro::container_poly>(
+        min.x, max.x, min.y, max.y, min.z, max.z,
+        std::round(Nthird * (max.x - min.x)),
+        std::round(Nthird * (max.y - min.y)),
+        std::round(Nthird * (max.z - min.z)),  //
+        false, false, false, pts.size());
+    for (size_t i = 0; i < pts.size(); i++) {
+      container->put(i, pts[i].x, pts[i].y, pts[i].z,
+                     hasWeights ? wts[i] : 1.0f);
+    }
+    return container;
+  };
+  std::unique_ptr<voro::container_poly> container = MakeContainer();
 
   // Prepare Parallel Voronoi Computation
   std::vector<glm::ivec3> cellIndices;
   std::vector<glm::dvec4> cellPosWeight;
-  voro::c_loop_all vl(container);
+  voro::c_loop_all vl(*container);
   if (vl.start()) do {
       int id;
       double x, y, z, r;
@@ -991,13 +1730,65 @@ std::vector<Manifold> Manifold::Fracture(const std::vector<glm::dvec3>& pts,
       cellPosWeight.push_back({x, y, z, r});
     } while (vl.inc());
 
-  ComputeVoronoiCell computeVoronoiCell;
-  computeVoronoiCell.container = &container;
-  computeVoronoiCell.original = this;
-  computeVoronoiCell.output = &output;
-  thrust::for_each_n(
-      thrust::host, zip(countAt(0), cellIndices.begin(), cellPosWeight.begin()),
-      cellIndices.size(), computeVoronoiCell);
+  // Every cell is convex, so rather than a Boolean each chunk is trimmed from
+  // the input by the cell's planes.
+  const Impl& original = *GetCsgLeafNode().GetImpl();
+
+  // voro++ keeps its search scratch inside the container, so each block of
+  // cells gets a private container and one reusable cell.
+  const int numCell = cellIndices.size();
+  const int numThread = std::max(1u, std::thread::hardware_concurrency());
+  const int numBlock = std::min(numCell, 4 * numThread);
+  const Cancellation* cancellation = Cancellation::Current();
+  std::atomic<bool> cancelled(false);
+  for_each_n(
+      numBlock > 1 ? ExecutionPolicy::Par : ExecutionPolicy::Seq, countAt(0),
+      numBlock, [&](int block) {
+        std::unique_ptr<voro::container_poly> local;
+        voro::container_poly* blockContainer = container.get();
+        if (block > 0) {
+          local = MakeContainer();
+          blockContainer = local.get();
+        }
+        voro::voronoicell_neighbor c(*blockContainer);
+        std::vector<glm::vec3> verts;
+        const int end = (int64_t)numCell * (block + 1) / numBlock;
+        for (int cell = (int64_t)numCell * block / numBlock; cell < end;
+             ++cell) {
+          if (cancelled.load(std::memory_order_relaxed)) return;
+          if (cancellation != nullptr && cancellation->Requested()) {
+            cancelled.store(true, std::memory_order_relaxed);
+            return;
+          }
+          const glm::ivec3 cellIdx = cellIndices[cell];
+          const glm::dvec4 cellPos = cellPosWeight[cell];
+          if (!blockContainer->compute_cell(c, cellIdx.y, cellIdx.z)) {
+            std::cout << "[ERROR] Degenerate Voronoi Cell at Index: "
+                      << cellIdx.x << std::endl;
+            continue;
+          }
+          verts.clear();
+          verts.reserve(c.p);
+          for (int i = 0; i < c.p; i++) {
+            verts.push_back(glm::vec3(cellPos.x + 0.5 * c.pts[(4 * i) + 0],
+                                      cellPos.y + 0.5 * c.pts[(4 * i) + 1],
+                                      cellPos.z + 0.5 * c.pts[(4 * i) + 2]));
+          }
+
+          // c.neighbors - Check neighbors for Mergeability...
+
+          const Manifold hull = Manifold::Hull(verts);
+          if (hull.IsEmpty()) continue;
+          output[cellIdx.x] = Manifold(std::make_shared<Impl>(
+              original.TrimByPlanes(CellPlanes(*hull.GetCsgLeafNode().GetImpl(),
+                                               original.bBox_))));
+        }
+      });
+  if (cancelled) {
+    auto pImpl = std::make_shared<Impl>();
+    pImpl->status_ = Error::Cancelled;
+    return {Manifold(pImpl)};
+  }
   return output;
 }
 /*std::vector<Manifold> Manifold::Fracture(
@@ -1013,31 +1804,45 @@ std::vector<Manifold> Manifold::Fracture(const std::vector<glm::dvec3>& pts,
 }*/
 
 std::vector<int> Manifold::ReflexFaces(double tolerance) const {
-  std::unordered_set<int> uniqueReflexFaceSet;
+  ZoneScoped;
   const Impl& impl = *GetCsgLeafNode().GetImpl();
-  for (size_t i = 0; i < impl.halfedge_.size(); i++) {
-    Halfedge halfedge = impl.halfedge_[i];
-    int faceA = halfedge.face;
-    int faceB = impl.halfedge_[halfedge.pairedHalfedge].face;
-    glm::dvec3 tangent =
-        glm::cross((glm::dvec3)impl.faceNormal_[faceA],
-                   (glm::dvec3)impl.vertPos_[impl.halfedge_[i].endVert] -
-                       (glm::dvec3)impl.vertPos_[impl.halfedge_[i].startVert]);
-    double tangentProjection =
-        glm::dot((glm::dvec3)impl.faceNormal_[faceB], tangent);
-    //  If we've found a pair of reflex triangles, add them to the set
-    if (tangentProjection > tolerance) {
-      uniqueReflexFaceSet.insert(faceA);
-      uniqueReflexFaceSet.insert(faceB);
+  const int numTri = impl.NumTri();
+  auto reflexEdge = [&](int edge) {
+    const Halfedge halfedge = impl.halfedge_[edge];
+    const int faceB = impl.halfedge_[halfedge.pairedHalfedge].face;
+    const glm::dvec3 tangent =
+        glm::cross((glm::dvec3)impl.faceNormal_[halfedge.face],
+                   (glm::dvec3)impl.vertPos_[halfedge.endVert] -
+                       (glm::dvec3)impl.vertPos_[halfedge.startVert]);
+    return glm::dot((glm::dvec3)impl.faceNormal_[faceB], tangent) > tolerance;
+  };
+  // A face is reflex if the test passes across any of its edges from either
+  // side, so each face only needs to read its own edges.
+  Vec<char> reflex(numTri, 0);
+  for_each_n(autoPolicy(numTri), countAt(0), numTri, [&](int tri) {
+    for (const int i : {0, 1, 2}) {
+      const int edge = 3 * tri + i;
+      if (reflexEdge(edge) || reflexEdge(impl.halfedge_[edge].pairedHalfedge)) {
+        reflex[tri] = 1;
+        return;
+      }
     }
+  });
+  std::vector<int> uniqueFaces;
+  for (int tri = 0; tri < numTri; ++tri) {
+    if (reflex[tri]) uniqueFaces.push_back(tri);
   }
-  std::vector<int> uniqueFaces;  // Copy to a vector for indexed access
-  uniqueFaces.insert(uniqueFaces.end(), uniqueReflexFaceSet.begin(),
-                     uniqueReflexFaceSet.end());
   return uniqueFaces;
 }
 
-std::vector<Manifold> Manifold::ConvexDecomposition() const {
+/**
+ * Decompose this Manifold into convex chunks, by fracturing it at the
+ * circumcenters of its reflex faces.
+ *
+ * @param tolerance Circumcenters closer than this to an earlier one are
+ * dropped.
+ */
+std::vector<Manifold> Manifold::ConvexDecomposition(double tolerance) const {
   ZoneScoped;
 
   //// Simplify the input mesh until it cannot be simplified any further
@@ -1060,59 +1865,130 @@ std::vector<Manifold> Manifold::ConvexDecomposition() const {
   }
 
   const Impl& impl = *GetCsgLeafNode().GetImpl();
-  std::vector<glm::dvec3> circumcenters(uniqueFaces.size());
-  std::vector<double> circumradii(uniqueFaces.size());
-  Vec<glm::dvec3> dVerts(impl.vertPos_.size());
-  for (size_t i = 0; i < impl.vertPos_.size(); i++) {
-    dVerts[i] = impl.vertPos_[i];
+  const int numFace = uniqueFaces.size();
+  Vec<glm::dvec3> dVerts(impl.NumVert());
+  for_each_n(autoPolicy(impl.NumVert()), countAt(0), impl.NumVert(),
+             [&](int vert) { dVerts[vert] = impl.vertPos_[vert]; });
+  std::vector<glm::dvec4> circumcircles(numFace);
+  for_each_n(autoPolicy(numFace), countAt(0), numFace, [&](int i) {
+    circumcircles[i] = impl.Circumcircle(dVerts, uniqueFaces[i]);
+  });
+
+  // Degenerate faces are marked by a negative circumradius.
+  std::vector<glm::dvec3> circumcenters;
+  std::vector<double> circumradii;
+  for (const int i : DedupeCircumcenters(circumcircles, tolerance)) {
+    circumcenters.push_back(glm::dvec3(circumcircles[i]));
+    circumradii.push_back(circumcircles[i].w);
   }
-  std::vector<Manifold> debugShapes;
-  for (size_t i = 0; i < uniqueFaces.size(); i++) {
-    glm::dvec4 circumcircle = impl.Circumcircle(dVerts, uniqueFaces[i]);
-    circumcenters[i] =
-        glm::dvec3(circumcircle.x, circumcircle.y, circumcircle.z);
-    circumradii[i] = circumcircle.w;
-
-    // Debug Draw the Circumcenter and Triangle of Degenerate Triangles 
-    // if (circumcircle.w < 0.0) {
-    //   std::cout << "Circumradius: " << circumcircle.w << std::endl;
-    //   debugShapes.push_back(Hull(
-    //       {Manifold::Sphere(circumcircle.w * 0.1, 10)
-    //            .Translate(glm::vec3(
-    //                dVerts[impl.halfedge_[(uniqueFaces[i] * 3) +
-    //                0].startVert])),
-    //        Manifold::Sphere(circumcircle.w * 0.1, 10)
-    //            .Translate(glm::vec3(
-    //                dVerts[impl.halfedge_[(uniqueFaces[i] * 3) +
-    //                1].startVert])),
-    //        Manifold::Sphere(circumcircle.w * 0.1, 10)
-    //            .Translate(glm::vec3(
-    //                dVerts[impl.halfedge_[(uniqueFaces[i] * 3) +
-    //                2].startVert]))
-    //     }));
-    //
-    //   debugShapes.push_back(Manifold::Sphere(circumcircle.w * 0.2, 10)
-    //                             .Translate(glm::vec3(circumcenters[i])));
-    // }
+
+  return Fracture(circumcenters, circumradii);
+}
+
+/**
+ * Grow this Manifold by delta in every direction, or shrink it for negative
+ * delta, like the Minkowski sum with (or difference of) a sphere of radius
+ * delta. The surface is remeshed as a level set of the signed distance to
+ * this one, which is only computed exactly within a narrow band around the
+ * surface, so this is far cheaper than Minkowski with a sphere. Features
+ * finer than edgeLength are lost in the remeshing, and the result does not
+ * keep this Manifold's properties.
+ *
+ * @param delta The distance to move the surface outward.
+ * @param edgeLength The approximate edge length of the result; if not
+ * positive, the larger of half of |delta| and 1/128 of the largest dimension
+ * of the bounding box.
+ */
+Manifold Manifold::Offset(float delta, float edgeLength) const {
+  ZoneScoped;
+  if (delta == 0 || IsEmpty()) return *this;
+  const std::shared_ptr<const Impl> impl = GetCsgLeafNode().GetImpl();
+  Box bounds = impl->bBox_;
+  const glm::vec3 size = bounds.Size();
+  if (edgeLength <= 0) {
+    edgeLength = glm::max(glm::abs(delta) / 2,
+                          glm::max(size.x, glm::max(size.y, size.z)) / 128);
   }
+  // LevelSet closes the surface off at the bounds, so leave it room
+  const float margin = glm::max(delta, 0.0f) + 2 * edgeLength;
+  bounds.min -= margin;
+  bounds.max += margin;
+  // enough distance for every grid edge that can cross the level
+  const float band = glm::abs(delta) + 2 * edgeLength;
+  return Manifold(LevelSet(
+      [&impl, band](glm::vec3 p) { return impl->SignedDistance(p, band); },
+      bounds, edgeLength, -delta, true, 1));
+}
 
-  for (size_t i = 0; i < circumcenters.size() - 1; i++) {
-    for (size_t j = circumcenters.size() - 1; j > i; j--) {
-      if (glm::distance(circumcenters[i], circumcenters[j]) < 1e-9 ||
-          circumradii[j] < 0.0) {
-        std::vector<glm::dvec3>::iterator it = circumcenters.begin();
-        std::advance(it, j);
-        circumcenters.erase(it);
-        std::vector<double>::iterator it2 = circumradii.begin();
-        std::advance(it2, j);
-        circumradii.erase(it2);
+/**
+ * Decompose this Manifold approximately into at most maxParts convex hulls,
+ * which may overlap and cover some space outside it. Pieces are split
+ * recursively by axis-aligned planes, most concave first, until the volume of
+ * each piece's hull that the piece does not fill is within concavity times
+ * the volume of this Manifold. This is far faster than ConvexDecomposition()
+ * and gives far fewer pieces, so it suits colliders and approximate Minkowski
+ * sums.
+ *
+ * @param concavity The largest uncovered hull volume allowed per piece, as a
+ * fraction of the volume of this Manifold.
+ * @param maxParts The largest number of pieces returned.
+ */
+std::vector<Manifold> Manifold::ApproxConvexDecomposition(double concavity,
+                                                          int maxParts) const {
+  ZoneScoped;
+  if (IsEmpty() || maxParts < 1) return {};
+  const double threshold = concavity * GetProperties().volume;
+
+  std::vector<ApproxPiece> pieces;
+  for (const Manifold& component : Decompose())
+    pieces.push_back(MakeApproxPiece(component));
+  std::vector<char> done(pieces.size(), 0);
+  bool full = false;
+  while (!full) {
+    std::vector<int> order;
+    for (int i = 0; i < static_cast<int>(pieces.size()); ++i)
+      if (!done[i] && pieces[i].gap > threshold) order.push_back(i);
+    const int budget = maxParts - static_cast<int>(pieces.size());
+    if (order.empty() || budget <= 0) break;
+    std::sort(order.begin(), order.end(), [&pieces](int a, int b) {
+      return pieces[a].gap > pieces[b].gap;
+    });
+    // every useful split adds at least one piece
+    if (static_cast<int>(order.size()) > budget) order.resize(budget);
+
+    // each piece is only touched by its own branch
+    const int numSplit = order.size();
+    std::vector<std::vector<ApproxPiece>> splits(numSplit);
+    for_each_n(numSplit > 1 ? ExecutionPolicy::Par : ExecutionPolicy::Seq,
+               countAt(0), numSplit,
+               [&](int i) { splits[i] = SplitApproxPiece(pieces[order[i]]); });
+
+    int numPiece = pieces.size();
+    for (int i = 0; i < numSplit; ++i) {
+      std::vector<ApproxPiece>& split = splits[i];
+      double gap = 0;
+      for (const ApproxPiece& piece : split) gap += piece.gap;
+      if (split.size() < 2 || gap >= pieces[order[i]].gap) {
+        done[order[i]] = 1;
+        continue;
+      }
+      if (numPiece + static_cast<int>(split.size()) - 1 > maxParts) {
+        full = true;
+        break;
+      }
+      numPiece += split.size() - 1;
+      pieces[order[i]] = split[0];
+      for (size_t j = 1; j < split.size(); ++j) {
+        pieces.push_back(split[j]);
+        done.push_back(0);
       }
     }
   }
 
-  std::vector<Manifold> output = Fracture(circumcenters, circumradii);
-  output.insert(output.end(), debugShapes.begin(), debugShapes.end());
-  return output;
+  std::vector<Manifold> hulls;
+  for (const ApproxPiece& piece : pieces)
+    if (!piece.hull.IsEmpty()) hulls.push_back(piece.hull);
+  return hulls;
 }
 
 /**
@@ -1123,21 +1999,9 @@ std::vector<Manifold> Manifold::ConvexDecomposition() const {
  */
 Manifold Manifold::Minkowski(const Manifold& a, const Manifold& b,
                              bool useNaive) {
-  std::vector<std::vector<Manifold>> composedParts;
   std::vector<Manifold> composedHulls({a});
   if (!useNaive) {  // Use the general method
-    std::vector<Manifold> aDecomposition = a.ConvexDecomposition();
-    std::vector<Manifold> bDecomposition = b.ConvexDecomposition();
-    for (Manifold aPart : aDecomposition) {
-      manifold::Mesh aMesh = aPart.GetMesh();
-      for (Manifold bPart : bDecomposition) {
-        std::vector<Manifold> abComposition;
-        for (glm::vec3 vertexPosition : aMesh.vertPos) {
-          abComposition.push_back(bPart.Translate(vertexPosition));
-        }
-        composedParts.push_back(abComposition);
-      }
-    }
+    composedHulls.push_back(Minkowski(ConvexParts(a), ConvexParts(b)));
   } else {  // Use the naive method
     bool aConvex = a.ReflexFaces().size() == 0;
     bool bConvex = b.ReflexFaces().size() == 0;
@@ -1155,11 +2019,9 @@ Manifold Manifold::Minkowski(const Manifold& a, const Manifold& b,
 
     // Convex-Convex Minkowski: Very Fast
     if (aConvex && bConvex) {
-      std::vector<Manifold> simpleHull;
-      for (glm::vec3 vertex : aMesh.vertPos) {
-        simpleHull.push_back({bM.Translate(vertex)});
-      }
-      composedHulls.push_back(Manifold::Hull(simpleHull));
+      composedHulls.push_back(
+          ConvexMinkowski(*aM.GetCsgLeafNode().GetImpl(),
+                          *bM.GetCsgLeafNode().GetImpl(), true));
       // Convex - Non-Convex Minkowski: Slower
     } else if (!aConvex && bConvex) {
       // Speed Equivalent?
@@ -1202,21 +2064,142 @@ Manifold Manifold::Minkowski(const Manifold& a, const Manifold& b,
       //  }
       //}
 
-      std::vector<std::pair<glm::ivec3, glm::ivec3>> trianglePairs;
-      for (glm::ivec3 aVertexIndices : aMesh.triVerts) {
-        for (glm::ivec3 bVertexIndices : bMesh.triVerts) {
-          trianglePairs.push_back({aVertexIndices, bVertexIndices});
+      // The triangle pairs are streamed in batches into a running union.
+      // A pair is skipped when its box is clear of the union's surface and
+      // one of its points is inside, so its hull is already covered.
+      const int64_t numTriB = bMesh.triVerts.size();
+      const int64_t numPair = (int64_t)aMesh.triVerts.size() * numTriB;
+      Manifold result = aM;
+      for (int64_t start = 0; start < numPair; start += kMinkowskiBatch) {
+        const int batch = glm::min<int64_t>(kMinkowskiBatch, numPair - start);
+        std::vector<std::vector<glm::vec3>> sums(batch);
+        Vec<Box> boxes(batch);
+        for_each_n(autoPolicy(batch), countAt(0), batch, [&](int i) {
+          const glm::ivec3 triA = aMesh.triVerts[(start + i) / numTriB];
+          const glm::ivec3 triB = bMesh.triVerts[(start + i) % numTriB];
+          for (const int j : {0, 1, 2})
+            for (const int k : {0, 1, 2}) {
+              sums[i].push_back(aMesh.vertPos[triA[j]] +
+                                bMesh.vertPos[triB[k]]);
+              boxes[i].Union(sums[i].back());
+            }
+        });
+
+        const Impl& current = *result.GetCsgLeafNode().GetImpl();
+        std::vector<char> clear(batch, 1);
+        const SparseIndices hits =
+            current.collider_.Collisions<false, false>(boxes.cview());
+        for (int i = 0; i < hits.size(); ++i) clear[hits.Get(i, false)] = 0;
+        std::vector<int> probePair;
+        std::vector<glm::vec3> probe;
+        for (int i = 0; i < batch; ++i) {
+          if (!clear[i]) continue;
+          probePair.push_back(i);
+          probe.push_back(sums[i][0]);
         }
+        std::vector<char> covered(batch, 0);
+        const std::vector<char> inside = current.Contains(
+            {probe.data(), static_cast<int>(probe.size())});
+        for (int i = 0; i < probe.size(); ++i)
+          covered[probePair[i]] = inside[i];
+
+        std::vector<Manifold> hulls(batch);
+        for_each_n(autoPolicy(batch), countAt(0), batch, [&](int i) {
+          if (!covered[i]) hulls[i] = Manifold::Hull(sums[i]);
+        });
+        hulls.erase(std::remove_if(hulls.begin(), hulls.end(),
+                                   [](const Manifold& hull) {
+                                     return hull.IsEmpty();
+                                   }),
+                    hulls.end());
+        if (hulls.empty()) continue;
+        result += Manifold::BatchBoolean(hulls, manifold::OpType::Add);
       }
-      composedHulls.resize(trianglePairs.size() + 1);
-      thrust::for_each_n(thrust::host, zip(countAt(1), trianglePairs.begin()),
-                         trianglePairs.size(),
-                         ComputeTriangleTriangleHull(
-                             {&aMesh.vertPos, &bMesh.vertPos, &composedHulls}));
+      composedHulls = {result};
     }
   }
-  auto newHulls = Manifold::BatchHull(composedParts);
-  composedHulls.insert(composedHulls.end(), newHulls.begin(), newHulls.end());
   return Manifold::BatchBoolean(composedHulls, manifold::OpType::Add);
 }
+
+/**
+ * Compute the minkowski sum of two convex decompositions, as the union of the
+ * sums of each pair of parts. Decomposing once and reusing it saves the
+ * repeated decomposition when the same shape is summed with many others.
+ *
+ * @param a The first decomposition in the sum.
+ * @param b The second decomposition in the sum.
+ */
+Manifold Manifold::Minkowski(const ConvexParts& a, const ConvexParts& b) {
+  ZoneScoped;
+  // resolved up front, as the parts are shared between threads
+  std::vector<std::shared_ptr<const Impl>> aParts, bParts;
+  std::vector<char> aConvex, bConvex;
+  for (const Manifold& part : a.Parts()) {
+    aParts.push_back(part.GetCsgLeafNode().GetImpl());
+    aConvex.push_back(part.ReflexFaces().empty());
+  }
+  for (const Manifold& part : b.Parts()) {
+    bParts.push_back(part.GetCsgLeafNode().GetImpl());
+    bConvex.push_back(part.ReflexFaces().empty());
+  }
+  const int numB = bParts.size();
+  const int numPair = aParts.size() * numB;
+  std::vector<Manifold> sums(numPair);
+  for_each_n(numPair > 1 ? ExecutionPolicy::Par : ExecutionPolicy::Seq,
+             countAt(0), numPair, [&](int pair) {
+               const int i = pair / numB;
+               const int j = pair % numB;
+               sums[pair] = ConvexMinkowski(*aParts[i], *bParts[j],
+                                            aConvex[i] && bConvex[j]);
+             });
+  return BatchBoolean(sums, OpType::Add);
+}
+
+/**
+ * Decompose a manifold into convex parts; see
+ * Manifold::ConvexDecomposition().
+ *
+ * @param manifold The manifold to decompose.
+ * @param tolerance Passed to Manifold::ConvexDecomposition().
+ */
+ConvexParts::ConvexParts(const Manifold& manifold, double tolerance)
+    : parts_(manifold.ConvexDecomposition(tolerance)) {}
+
+ConvexParts ConvexParts::FromParts(const std::vector<Manifold>& parts) {
+  ConvexParts result;
+  result.parts_ = parts;
+  return result;
+}
+
+Manifold ConvexParts::ToManifold() const {
+  return Manifold::BatchBoolean(parts_, OpType::Add);
+}
+
+ConvexParts ConvexParts::Transform(const glm::mat4x3& m) const {
+  ConvexParts result;
+  for (const Manifold& part : parts_)
+    result.parts_.push_back(part.Transform(m));
+  return result;
+}
+
+ConvexParts ConvexParts::Translate(glm::vec3 v) const {
+  ConvexParts result;
+  for (const Manifold& part : parts_)
+    result.parts_.push_back(part.Translate(v));
+  return result;
+}
+
+ConvexParts ConvexParts::Scale(glm::vec3 v) const {
+  ConvexParts result;
+  for (const Manifold& part : parts_) result.parts_.push_back(part.Scale(v));
+  return result;
+}
+
+ConvexParts ConvexParts::Rotate(float xDegrees, float yDegrees,
+                                float zDegrees) const {
+  ConvexParts result;
+  for (const Manifold& part : parts_)
+    result.parts_.push_back(part.Rotate(xDegrees, yDegrees, zDegrees));
+  return result;
+}
 }  // namespace manifold
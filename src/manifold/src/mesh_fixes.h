@@ -1,4 +1,5 @@
 #include "impl.h"
+#include "par.h"
 
 namespace {
 using namespace manifold;
@@ -19,39 +20,125 @@ struct TransformNormals {
   }
 };
 
-struct TransformTangents {
-  const glm::mat3 transform;
-  const bool invert;
-  VecView<const glm::vec4> oldTangents;
-  VecView<const Halfedge> halfedge;
-
-  void operator()(thrust::tuple<glm::vec4&, int> inOut) {
-    glm::vec4& tangent = thrust::get<0>(inOut);
-    int edge = thrust::get<1>(inOut);
-    if (invert) {
-      edge = halfedge[FlipHalfedge(edge)].pairedHalfedge;
+// Where a mesh's block starts in each array of the mesh it is appended to.
+struct MeshOffset {
+  int vert = 0;
+  int halfedge = 0;
+  int tri = 0;
+  int propVert = 0;
+  int meshID = 0;
+};
+
+/**
+ * Writes in, transformed, into its block of out in a single pass: item i
+ * handles vert i, triangle i with its halfedges and tangents, and property
+ * vert i, so each input array is read once and each output written once.
+ * Indices are offset to the block and inverting transforms reverse the
+ * triangles. The arrays of out must already be sized; those left empty are
+ * skipped, except for vertPos_ and halfedge_, which are required. The
+ * meshIDs of in, sorted in meshIDs, are renumbered consecutively from
+ * offset.meshID.
+ */
+inline void AppendMesh(ExecutionPolicy policy, const Manifold::Impl& in,
+                       const glm::mat4x3& transform, Manifold::Impl& out,
+                       const MeshOffset& offset, VecView<const int> meshIDs) {
+  const int numVert = in.NumVert();
+  const int numTri = in.NumTri();
+  const int numProp = in.NumProp();
+  const int numPropOut = out.NumProp();
+  const int numPropVert =
+      numProp == 0 ? 0 : in.meshRelation_.properties.size() / numProp;
+  const bool identity = transform == glm::mat4x3(1.0f);
+  const bool invert = glm::determinant(glm::mat3(transform)) < 0;
+  const glm::mat3 normalTransform = NormalTransform(transform);
+
+  VecView<glm::vec3> vertPos = out.vertPos_.view(offset.vert, numVert);
+  VecView<Halfedge> halfedge =
+      out.halfedge_.view(offset.halfedge, in.halfedge_.size());
+  VecView<glm::vec3> faceNormal;
+  if (out.faceNormal_.size() > 0 && in.faceNormal_.size() == numTri)
+    faceNormal = out.faceNormal_.view(offset.tri, numTri);
+  VecView<glm::vec3> vertNormal;
+  if (out.vertNormal_.size() > 0 && in.vertNormal_.size() == numVert)
+    vertNormal = out.vertNormal_.view(offset.vert, numVert);
+  VecView<glm::vec4> tangent;
+  if (out.halfedgeTangent_.size() > 0 && in.halfedgeTangent_.size() > 0)
+    tangent = out.halfedgeTangent_.view(offset.halfedge, in.halfedge_.size());
+  VecView<TriRef> triRef;
+  if (out.meshRelation_.triRef.size() > 0)
+    triRef = out.meshRelation_.triRef.view(offset.tri, numTri);
+  VecView<glm::ivec3> triProp;
+  if (out.meshRelation_.triProperties.size() > 0)
+    triProp = out.meshRelation_.triProperties.view(offset.tri, numTri);
+  VecView<float> prop;
+  if (out.meshRelation_.properties.size() > 0 && numProp > 0)
+    prop = out.meshRelation_.properties.view(numPropOut * offset.propVert,
+                                             numPropOut * numPropVert);
+
+  const int n = std::max(std::max(numVert, numTri), numPropVert);
+  for_each_n(policy, countAt(0), n, [&](int i) {
+    if (i < numVert) {
+      // exact for the identity, so this needs no branch
+      vertPos[i] = transform * glm::vec4(in.vertPos_[i], 1.0f);
+      if (!vertNormal.empty()) {
+        const glm::vec3 normal = in.vertNormal_[i];
+        vertNormal[i] =
+            identity ? normal : TransformNormals({normalTransform})(normal);
+      }
     }
 
-    tangent = glm::vec4(transform * glm::vec3(oldTangents[edge]),
-                        oldTangents[edge].w);
-  }
-};
+    if (i < numTri) {
+      for (const int j : {0, 1, 2}) {
+        const int edge = 3 * i + j;
+        // The corners of a reversed triangle are in the order 0, 2, 1.
+        Halfedge he = in.halfedge_[invert ? FlipHalfedge(edge) : edge];
+        if (invert) {
+          std::swap(he.startVert, he.endVert);
+          he.pairedHalfedge = FlipHalfedge(he.pairedHalfedge);
+        }
+        he.startVert += offset.vert;
+        he.endVert += offset.vert;
+        he.pairedHalfedge += offset.halfedge;
+        he.face += offset.tri;
+        halfedge[edge] = he;
 
-struct FlipTris {
-  VecView<Halfedge> halfedge;
+        if (!tangent.empty()) {
+          const int from =
+              invert ? in.halfedge_[FlipHalfedge(edge)].pairedHalfedge : edge;
+          const glm::vec4 t = in.halfedgeTangent_[from];
+          tangent[edge] = glm::vec4(glm::mat3(transform) * glm::vec3(t), t.w);
+        }
+      }
 
-  void operator()(thrust::tuple<TriRef&, int> inOut) {
-    TriRef& bary = thrust::get<0>(inOut);
-    const int tri = thrust::get<1>(inOut);
+      if (!faceNormal.empty()) {
+        const glm::vec3 normal = in.faceNormal_[i];
+        faceNormal[i] =
+            identity ? normal : TransformNormals({normalTransform})(normal);
+      }
 
-    thrust::swap(halfedge[3 * tri], halfedge[3 * tri + 2]);
+      if (!triRef.empty()) {
+        TriRef ref = in.meshRelation_.triRef[i];
+        ref.meshID =
+            offset.meshID +
+            (std::lower_bound(meshIDs.begin(), meshIDs.end(), ref.meshID) -
+             meshIDs.begin());
+        triRef[i] = ref;
+      }
 
-    for (const int i : {0, 1, 2}) {
-      thrust::swap(halfedge[3 * tri + i].startVert,
-                   halfedge[3 * tri + i].endVert);
-      halfedge[3 * tri + i].pairedHalfedge =
-          FlipHalfedge(halfedge[3 * tri + i].pairedHalfedge);
+      if (!triProp.empty()) {
+        // without properties, all triangles point at a single one of zeros
+        glm::ivec3 props =
+            numProp > 0 ? in.meshRelation_.triProperties[i] : glm::ivec3(0);
+        if (invert) std::swap(props[1], props[2]);
+        triProp[i] = props + offset.propVert;
+      }
     }
-  }
-};
+
+    if (i < numPropVert && !prop.empty()) {
+      for (int p = 0; p < numProp; ++p)
+        prop[numPropOut * i + p] =
+            in.meshRelation_.properties[numProp * i + p];
+    }
+  });
+}
 }  // namespace
@@ -20,29 +20,6 @@
 namespace {
 using namespace manifold;
 
-struct FaceAreaVolume {
-  VecView<const Halfedge> halfedges;
-  VecView<const glm::vec3> vertPos;
-  const float precision;
-
-  thrust::pair<float, float> operator()(int face) {
-    float perimeter = 0;
-    glm::vec3 edge[3];
-    for (int i : {0, 1, 2}) {
-      const int j = (i + 1) % 3;
-      edge[i] = vertPos[halfedges[3 * face + j].startVert] -
-                vertPos[halfedges[3 * face + i].startVert];
-      perimeter += glm::length(edge[i]);
-    }
-    glm::vec3 crossP = glm::cross(edge[0], edge[1]);
-
-    float area = glm::length(crossP);
-    float volume = glm::dot(crossP, vertPos[halfedges[3 * face].startVert]);
-
-    return thrust::make_pair(area / 2.0f, volume / 6.0f);
-  }
-};
-
 struct PosMin
     : public thrust::binary_function<glm::vec3, glm::vec3, glm::vec3> {
   glm::vec3 operator()(glm::vec3 a, glm::vec3 b) {
@@ -81,33 +58,66 @@ struct MinMax
   }
 };
 
-struct SumPair : public thrust::binary_function<thrust::pair<float, float>,
-                                                thrust::pair<float, float>,
-                                                thrust::pair<float, float>> {
-  thrust::pair<float, float> operator()(thrust::pair<float, float> a,
-                                        thrust::pair<float, float> b) {
-    a.first += b.first;
-    a.second += b.second;
-    return a;
+// The running sum and its lost low-order bits.
+struct KahanSum {
+  float sum = 0;
+  float compensation = 0;
+
+  void Add(float x) {
+    const float t = sum + x;
+    compensation += (sum - t) + x;
+    sum = t;
   }
+
+  float Get() const { return sum + compensation; }
 };
 
-struct CurvatureAngles {
-  VecView<float> meanCurvature;
-  VecView<float> gaussianCurvature;
-  VecView<float> area;
-  VecView<float> degree;
+// Triangles per block of Analyze; the block partition doesn't depend on the
+// thread count, so the sums are deterministic.
+constexpr int kStatsBlockSize = 1 << 12;
+
+struct BlockStats {
+  KahanSum area;
+  KahanSum volume;
+  int numDegenerateTri = 0;
+};
+
+/**
+ * Everything Analyze measures about one triangle, sharing its edge vectors:
+ * area, signed volume, degeneracy (colinear within precision / 2 in the
+ * projection of its normal, as in NumDegenerateTris) and, if vertCurvature is
+ * given, the per-vert sums for curvature (mean, Gaussian, area, degree).
+ */
+struct TriStats {
+  VecView<glm::vec4> vertCurvature;
   VecView<const Halfedge> halfedge;
   VecView<const glm::vec3> vertPos;
   VecView<const glm::vec3> triNormal;
+  const float precision;
 
-  void operator()(int tri) {
+  void operator()(int tri, BlockStats& stats) {
+    glm::vec3 pos[3];
+    for (int i : {0, 1, 2}) pos[i] = vertPos[halfedge[3 * tri + i].startVert];
     glm::vec3 edge[3];
-    glm::vec3 edgeLength(0.0);
+    for (int i : {0, 1, 2}) edge[i] = pos[(i + 1) % 3] - pos[i];
+    const glm::vec3 crossP = glm::cross(edge[0], edge[1]);
+    const float area = glm::length(crossP) / 2;
+    stats.area.Add(area);
+    stats.volume.Add(glm::dot(crossP, pos[0]) / 6);
+
+    if (triNormal.size() > 0 && halfedge[3 * tri].pairedHalfedge >= 0) {
+      const glm::mat3x2 projection = GetAxisAlignedProjection(triNormal[tri]);
+      if (CCW(projection * pos[0], projection * pos[1], projection * pos[2],
+              precision / 2) == 0) {
+        ++stats.numDegenerateTri;
+      }
+    }
+
+    if (vertCurvature.size() == 0) return;
+    glm::vec3 edgeLength;
     for (int i : {0, 1, 2}) {
       const int startVert = halfedge[3 * tri + i].startVert;
       const int endVert = halfedge[3 * tri + i].endVert;
-      edge[i] = vertPos[endVert] - vertPos[startVert];
       edgeLength[i] = glm::length(edge[i]);
       edge[i] /= edgeLength[i];
       const int neighborTri = halfedge[3 * tri + i].pairedHalfedge / 3;
@@ -115,45 +125,30 @@ struct CurvatureAngles {
           0.25 * edgeLength[i] *
           glm::asin(glm::dot(glm::cross(triNormal[tri], triNormal[neighborTri]),
                              edge[i]));
-      AtomicAdd(meanCurvature[startVert], dihedral);
-      AtomicAdd(meanCurvature[endVert], dihedral);
-      AtomicAdd(degree[startVert], 1.0f);
+      AtomicAdd(vertCurvature[startVert][0], dihedral);
+      AtomicAdd(vertCurvature[endVert][0], dihedral);
+      AtomicAdd(vertCurvature[startVert][3], 1.0f);
     }
 
     glm::vec3 phi;
     phi[0] = glm::acos(-glm::dot(edge[2], edge[0]));
     phi[1] = glm::acos(-glm::dot(edge[0], edge[1]));
     phi[2] = glm::pi<float>() - phi[0] - phi[1];
-    const float area3 = edgeLength[0] * edgeLength[1] *
-                        glm::length(glm::cross(edge[0], edge[1])) / 6;
 
     for (int i : {0, 1, 2}) {
       const int vert = halfedge[3 * tri + i].startVert;
-      AtomicAdd(gaussianCurvature[vert], -phi[i]);
-      AtomicAdd(area[vert], area3);
+      AtomicAdd(vertCurvature[vert][1], -phi[i]);
+      AtomicAdd(vertCurvature[vert][2], area / 3);
     }
   }
 };
 
-struct NormalizeCurvature {
-  void operator()(thrust::tuple<float&, float&, float, float> inOut) {
-    float& meanCurvature = thrust::get<0>(inOut);
-    float& gaussianCurvature = thrust::get<1>(inOut);
-    float area = thrust::get<2>(inOut);
-    float degree = thrust::get<3>(inOut);
-    float factor = degree / (6 * area);
-    meanCurvature *= factor;
-    gaussianCurvature *= factor;
-  }
-};
-
 struct UpdateProperties {
   VecView<float> properties;
 
   VecView<const float> oldProperties;
   VecView<const Halfedge> halfedge;
-  VecView<const float> meanCurvature;
-  VecView<const float> gaussianCurvature;
+  VecView<const glm::vec4> vertCurvature;
   const int oldNumProp;
   const int numProp;
   const int gaussianIdx;
@@ -176,11 +171,14 @@ struct UpdateProperties {
             oldProperties[oldNumProp * propVert + p];
       }
 
+      // normalize the sums by the vert's area
+      const glm::vec4 curvature = vertCurvature[vert];
+      const float factor = curvature[3] / (6 * curvature[2]);
       if (gaussianIdx >= 0) {
-        properties[numProp * propVert + gaussianIdx] = gaussianCurvature[vert];
+        properties[numProp * propVert + gaussianIdx] = curvature[1] * factor;
       }
       if (meanIdx >= 0) {
-        properties[numProp * propVert + meanIdx] = meanCurvature[vert];
+        properties[numProp * propVert + meanIdx] = curvature[0] * factor;
       }
     }
   }
@@ -310,51 +308,63 @@ bool Manifold::Impl::MatchesTriNormals() const {
  */
 int Manifold::Impl::NumDegenerateTris() const {
   if (halfedge_.size() == 0 || faceNormal_.size() != NumTri()) return true;
-  return count_if(
-      autoPolicy(NumTri()), countAt(0), countAt(NumTri()),
-      CheckCCW({halfedge_, vertPos_, faceNormal_, -1 * precision_ / 2}));
+  return Analyze().numDegenerateTri;
 }
 
-Properties Manifold::Impl::GetProperties() const {
+/**
+ * Measures the surface area, volume and number of degenerate triangles in a
+ * single parallel pass over the triangles. If vertCurvature is given (sized
+ * NumVert() and initialized to (0, 2 pi, 0, 0)), the same pass also sums each
+ * vert's mean curvature, Gaussian curvature, area and degree into it, which
+ * CalculateCurvature normalizes.
+ */
+Manifold::Impl::Stats Manifold::Impl::Analyze(
+    VecView<glm::vec4> vertCurvature) const {
   ZoneScoped;
-  if (IsEmpty()) return {0, 0};
-  // Kahan summation
-  float area = 0;
-  float volume = 0;
-  float areaCompensation = 0;
-  float volumeCompensation = 0;
-  for (int i = 0; i < NumTri(); ++i) {
-    auto [area1, volume1] =
-        FaceAreaVolume({halfedge_, vertPos_, precision_})(i);
-    const float t1 = area + area1;
-    const float t2 = volume + volume1;
-    areaCompensation += (area - t1) + area1;
-    volumeCompensation += (volume - t2) + volume1;
-    area = t1;
-    volume = t2;
+  Stats stats;
+  if (IsEmpty()) return stats;
+  const int numTri = NumTri();
+  const int numBlock = (numTri + kStatsBlockSize - 1) / kStatsBlockSize;
+  const VecView<const glm::vec3> triNormal =
+      faceNormal_.size() == numTri ? faceNormal_.cview()
+                                   : VecView<const glm::vec3>(nullptr, 0);
+  TriStats triStats({vertCurvature, halfedge_, vertPos_, triNormal,
+                     precision_});
+
+  std::vector<BlockStats> blocks(numBlock);
+  for_each_n(autoPolicy(numTri), countAt(0), numBlock, [&](int block) {
+    const int end = glm::min(numTri, (block + 1) * kStatsBlockSize);
+    for (int tri = block * kStatsBlockSize; tri < end; ++tri) {
+      triStats(tri, blocks[block]);
+    }
+  });
+
+  KahanSum area;
+  KahanSum volume;
+  for (const BlockStats& block : blocks) {
+    area.Add(block.area.Get());
+    volume.Add(block.volume.Get());
+    stats.numDegenerateTri += block.numDegenerateTri;
   }
-  area += areaCompensation;
-  volume += volumeCompensation;
+  stats.area = area.Get();
+  stats.volume = volume.Get();
+  return stats;
+}
 
-  return {area, volume};
+Properties Manifold::Impl::GetProperties() const {
+  const Stats stats = Analyze();
+  return {stats.area, stats.volume};
 }
 
 void Manifold::Impl::CalculateCurvature(int gaussianIdx, int meanIdx) {
   ZoneScoped;
   if (IsEmpty()) return;
   if (gaussianIdx < 0 && meanIdx < 0) return;
-  Vec<float> vertMeanCurvature(NumVert(), 0);
-  Vec<float> vertGaussianCurvature(NumVert(), glm::two_pi<float>());
-  Vec<float> vertArea(NumVert(), 0);
-  Vec<float> degree(NumVert(), 0);
+  // mean, Gaussian, area, degree
+  Vec<glm::vec4> vertCurvature(NumVert(),
+                               glm::vec4(0, glm::two_pi<float>(), 0, 0));
+  Analyze(vertCurvature);
   auto policy = autoPolicy(NumTri());
-  for_each(policy, countAt(0), countAt(NumTri()),
-           CurvatureAngles({vertMeanCurvature, vertGaussianCurvature, vertArea,
-                            degree, halfedge_, vertPos_, faceNormal_}));
-  for_each_n(policy,
-             zip(vertMeanCurvature.begin(), vertGaussianCurvature.begin(),
-                 vertArea.begin(), degree.begin()),
-             NumVert(), NormalizeCurvature());
 
   const int oldNumProp = NumProp();
   const int numProp = glm::max(oldNumProp, glm::max(gaussianIdx, meanIdx) + 1);
@@ -368,8 +378,8 @@ void Manifold::Impl::CalculateCurvature(int gaussianIdx, int meanIdx) {
   for_each_n(
       policy, zip(meshRelation_.triProperties.begin(), countAt(0)), NumTri(),
       UpdateProperties({meshRelation_.properties, oldProperties, halfedge_,
-                        vertMeanCurvature, vertGaussianCurvature, oldNumProp,
-                        numProp, gaussianIdx, meanIdx}));
+                        vertCurvature, oldNumProp, numProp, gaussianIdx,
+                        meanIdx}));
 
   CreateFaces();
   Finish();
@@ -0,0 +1,281 @@
+// Copyright 2024 The Manifold Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <limits>
+#include <utility>
+
+#include "impl.h"
+#include "par.h"
+
+namespace {
+using namespace manifold;
+
+constexpr float kInf = std::numeric_limits<float>::infinity();
+
+struct RayQuery {
+  VecView<const Halfedge> halfedge;
+  VecView<const glm::vec3> vertPos;
+  VecView<const glm::vec3> faceNormal;
+  const glm::vec3 origin;
+  // unit length
+  const glm::vec3 dir;
+  const glm::vec3 invDir;
+  RayHit hit;
+
+  float Best() const { return hit.distance; }
+
+  // slab test: the distance at which the ray enters the box, or infinity
+  float Bound(const Box& box) const {
+    float enter = 0;
+    float exit = kInf;
+    for (const int i : {0, 1, 2}) {
+      if (dir[i] == 0) {
+        // parallel to this slab, where 0 * inf would give NaN
+        if (origin[i] < box.min[i] || origin[i] > box.max[i]) return kInf;
+        continue;
+      }
+      const float t0 = (box.min[i] - origin[i]) * invDir[i];
+      const float t1 = (box.max[i] - origin[i]) * invDir[i];
+      enter = glm::max(enter, glm::min(t0, t1));
+      exit = glm::min(exit, glm::max(t0, t1));
+    }
+    return enter <= exit ? enter : kInf;
+  }
+
+  // Moller-Trumbore, counting hits from either side
+  void Leaf(int face) {
+    const glm::vec3 v0 = vertPos[halfedge[3 * face].startVert];
+    const glm::vec3 e1 = vertPos[halfedge[3 * face + 1].startVert] - v0;
+    const glm::vec3 e2 = vertPos[halfedge[3 * face + 2].startVert] - v0;
+    const glm::vec3 p = glm::cross(dir, e2);
+    const float det = glm::dot(e1, p);
+    if (det == 0) return;
+    const float invDet = 1 / det;
+    const glm::vec3 s = origin - v0;
+    const float u = glm::dot(s, p) * invDet;
+    if (u < 0 || u > 1) return;
+    const glm::vec3 q = glm::cross(s, e1);
+    const float v = glm::dot(dir, q) * invDet;
+    if (v < 0 || u + v > 1) return;
+    const float t = glm::dot(e2, q) * invDet;
+    if (t < 0 || t >= hit.distance) return;
+    hit.distance = t;
+    hit.face = face;
+    hit.position = origin + t * dir;
+    hit.normal = face < faceNormal.size() ? faceNormal[face]
+                                          : glm::normalize(glm::cross(e1, e2));
+  }
+};
+
+glm::vec3 ClosestPointOnTri(glm::vec3 p, glm::vec3 a, glm::vec3 b,
+                            glm::vec3 c) {
+  // Ericson, Real-Time Collision Detection, 5.1.5
+  const glm::vec3 ab = b - a;
+  const glm::vec3 ac = c - a;
+  const glm::vec3 ap = p - a;
+  const float d1 = glm::dot(ab, ap);
+  const float d2 = glm::dot(ac, ap);
+  if (d1 <= 0 && d2 <= 0) return a;
+
+  const glm::vec3 bp = p - b;
+  const float d3 = glm::dot(ab, bp);
+  const float d4 = glm::dot(ac, bp);
+  if (d3 >= 0 && d4 <= d3) return b;
+
+  const float vc = d1 * d4 - d3 * d2;
+  if (vc <= 0 && d1 >= 0 && d3 <= 0) return a + d1 / (d1 - d3) * ab;
+
+  const glm::vec3 cp = p - c;
+  const float d5 = glm::dot(ab, cp);
+  const float d6 = glm::dot(ac, cp);
+  if (d6 >= 0 && d5 <= d6) return c;
+
+  const float vb = d5 * d2 - d1 * d6;
+  if (vb <= 0 && d2 >= 0 && d6 <= 0) return a + d2 / (d2 - d6) * ac;
+
+  const float va = d3 * d6 - d5 * d4;
+  if (va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0)
+    return b + (d4 - d3) / ((d4 - d3) + (d5 - d6)) * (c - b);
+
+  const float denom = 1 / (va + vb + vc);
+  return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+struct ClosestQuery {
+  VecView<const Halfedge> halfedge;
+  VecView<const glm::vec3> vertPos;
+  const glm::vec3 point;
+  SurfacePoint closest;
+
+  float Best() const { return closest.distance; }
+
+  float Bound(const Box& box) const {
+    return glm::distance(point, glm::clamp(point, box.min, box.max));
+  }
+
+  void Leaf(int face) {
+    const glm::vec3 pos =
+        ClosestPointOnTri(point, vertPos[halfedge[3 * face].startVert],
+                          vertPos[halfedge[3 * face + 1].startVert],
+                          vertPos[halfedge[3 * face + 2].startVert]);
+    const float distance = glm::distance(point, pos);
+    if (distance >= closest.distance) return;
+    closest.distance = distance;
+    closest.face = face;
+    closest.position = pos;
+  }
+};
+// Returns which side of the directed edge a -> b the point p lies on in the XY
+// plane, and in area twice the signed area of (a, b, p). The area is always
+// evaluated with the endpoints in lexicographic order, so the two triangles
+// sharing an edge see exactly negated values. Points on the edge are resolved
+// as if p moved by (epsilon, epsilon^2), which is consistent across all
+// triangles, so a ray is never counted twice or missed.
+int EdgeSide(glm::dvec2 a, glm::dvec2 b, glm::dvec2 p, double& area) {
+  const bool flipped = b.x < a.x || (b.x == a.x && b.y < a.y);
+  if (flipped) std::swap(a, b);
+  area = (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+  int side = area > 0 ? 1 : area < 0 ? -1 : (b.y - a.y <= 0 ? 1 : -1);
+  if (flipped) {
+    area = -area;
+    side = -side;
+  }
+  return side;
+}
+
+struct WindingQuery {
+  VecView<const Halfedge> halfedge;
+  VecView<const glm::vec3> vertPos;
+  const glm::vec3 point;
+  int winding = 0;
+
+  // never prunes, as every face above the point counts
+  float Best() const { return kInf; }
+
+  // faces whose box spans the point in XY and reaches above it
+  float Bound(const Box& box) const {
+    return point.x >= box.min.x && point.x <= box.max.x &&
+                   point.y >= box.min.y && point.y <= box.max.y &&
+                   point.z <= box.max.z
+               ? 0
+               : kInf;
+  }
+
+  // Adds the face's crossing of the ray going up from the point in +z.
+  void Leaf(int face) {
+    glm::dvec3 v[3];
+    for (const int i : {0, 1, 2})
+      v[i] = vertPos[halfedge[3 * face + i].startVert];
+    const glm::dvec2 p(point.x, point.y);
+    const double area = (v[1].x - v[0].x) * (v[2].y - v[0].y) -
+                        (v[1].y - v[0].y) * (v[2].x - v[0].x);
+    // vertical faces have no interior in projection
+    if (area == 0) return;
+    const int orientation = area > 0 ? 1 : -1;
+
+    // barycentric weights, each scaled by area
+    double bary[3];
+    for (const int i : {0, 1, 2}) {
+      // the weight of the vertex opposite this edge
+      double& weight = bary[(i + 2) % 3];
+      if (EdgeSide(glm::dvec2(v[i]), glm::dvec2(v[(i + 1) % 3]), p, weight) !=
+          orientation)
+        return;
+    }
+    const double z =
+        (bary[0] * v[0].z + bary[1] * v[1].z + bary[2] * v[2].z) / area;
+    if (z > point.z) winding += orientation;
+  }
+};
+}  // namespace
+
+namespace manifold {
+
+/**
+ * Returns the first hit of each ray, traversing the face collider nearest box
+ * first so each ray only tests the triangles it could hit before its current
+ * best.
+ */
+std::vector<RayHit> Manifold::Impl::RayCast(
+    VecView<const glm::vec3> origins,
+    VecView<const glm::vec3> directions) const {
+  ZoneScoped;
+  ASSERT(origins.size() == directions.size(), userErr,
+         "origins and directions must be the same length");
+  const int numRay = glm::min(origins.size(), directions.size());
+  std::vector<RayHit> hits(numRay);
+  const auto policy = autoPolicy(numRay, KernelCost::Heavy);
+  for_each_n(policy, countAt(0), numRay, [&](int i) {
+    const float length = glm::length(directions[i]);
+    if (!(length > 0)) return;
+    const glm::vec3 dir = directions[i] / length;
+    RayQuery query{halfedge_, vertPos_, faceNormal_, origins[i], dir,
+                   1.0f / dir};
+    collider_.Nearest(query);
+    hits[i] = query.hit;
+  });
+  return hits;
+}
+
+/**
+ * Returns the closest surface point to each query point, traversing the face
+ * collider nearest box first and pruning boxes farther than the current best.
+ */
+std::vector<SurfacePoint> Manifold::Impl::ClosestPoint(
+    VecView<const glm::vec3> points) const {
+  ZoneScoped;
+  std::vector<SurfacePoint> closest(points.size());
+  const auto policy = autoPolicy(points.size(), KernelCost::Heavy);
+  for_each_n(policy, countAt(0), points.size(), [&](int i) {
+    ClosestQuery query{halfedge_, vertPos_, points[i]};
+    collider_.Nearest(query);
+    closest[i] = query.closest;
+  });
+  return closest;
+}
+
+/**
+ * Returns 1 for each point inside the manifold and 0 for each point outside,
+ * from the winding number of a vertical ray through the faces above it.
+ */
+std::vector<char> Manifold::Impl::Contains(
+    VecView<const glm::vec3> points) const {
+  ZoneScoped;
+  std::vector<char> inside(points.size());
+  const auto policy = autoPolicy(points.size(), KernelCost::Heavy);
+  for_each_n(policy, countAt(0), points.size(), [&](int i) {
+    WindingQuery query{halfedge_, vertPos_, points[i]};
+    collider_.Nearest(query);
+    inside[i] = query.winding != 0;
+  });
+  return inside;
+}
+
+/**
+ * Returns the distance from the point to the surface, positive inside and
+ * negative outside, with its magnitude clamped to band. Boxes farther than
+ * band are pruned from the closest-point search, so points away from the
+ * surface only pay for the containment test.
+ */
+float Manifold::Impl::SignedDistance(glm::vec3 point, float band) const {
+  ClosestQuery closest{halfedge_, vertPos_, point};
+  closest.closest.distance = band;
+  collider_.Nearest(closest);
+  WindingQuery winding{halfedge_, vertPos_, point};
+  collider_.Nearest(winding);
+  const float distance = closest.closest.distance;
+  return winding.winding != 0 ? distance : -distance;
+}
+
+}  // namespace manifold
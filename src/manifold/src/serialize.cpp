@@ -0,0 +1,159 @@
+// Copyright 2024 The Manifold Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+
+#include "csg_tree.h"
+#include "impl.h"
+#include "serialize.h"
+
+namespace {
+using namespace manifold;
+
+constexpr char kMagic[8] = {'M', 'A', 'N', 'I', 'F', 'O', 'L', 'D'};
+constexpr uint32_t kVersion = 1;
+// reads back differently on a host of the other byte order
+constexpr uint32_t kByteOrder = 0x01020304;
+}  // namespace
+
+namespace manifold {
+
+/**
+ * Appends the mesh exactly as it is held, collider included, so Deserialize()
+ * needs no validation, sorting or rebuilding.
+ */
+void Manifold::Impl::Serialize(SerialWriter& writer) const {
+  writer.Pod(bBox_);
+  writer.Pod(precision_);
+  writer.Pod(static_cast<int32_t>(status_));
+  writer.Array(vertPos_);
+  writer.Array(halfedge_);
+  writer.Array(vertNormal_);
+  writer.Array(faceNormal_);
+  writer.Array(halfedgeTangent_);
+
+  writer.Pod<int32_t>(meshRelation_.originalID);
+  writer.Pod<int32_t>(meshRelation_.numProp);
+  writer.Array(meshRelation_.properties);
+  writer.Pod<uint64_t>(meshRelation_.meshIDtransform.size());
+  for (const auto& pair : meshRelation_.meshIDtransform) {
+    writer.Pod<int32_t>(pair.first);
+    writer.Pod<int32_t>(pair.second.originalID);
+    writer.Pod(pair.second.transform);
+    writer.Pod<int32_t>(pair.second.backSide);
+  }
+  writer.Array(meshRelation_.triRef);
+  writer.Array(meshRelation_.triProperties);
+
+  collider_.Serialize(writer);
+}
+
+/**
+ * The inverse of Serialize(). The meshIDs are renewed like those of any copy,
+ * and the ID counter is moved past the stored originalIDs so that IDs
+ * reserved later in this process cannot collide with them.
+ */
+bool Manifold::Impl::Deserialize(SerialReader& reader) {
+  int32_t status;
+  reader.Pod(bBox_);
+  reader.Pod(precision_);
+  reader.Pod(status);
+  status_ = static_cast<Error>(status);
+  reader.Array(vertPos_);
+  reader.Array(halfedge_);
+  reader.Array(vertNormal_);
+  reader.Array(faceNormal_);
+  reader.Array(halfedgeTangent_);
+
+  int32_t originalID, numProp;
+  reader.Pod(originalID);
+  reader.Pod(numProp);
+  meshRelation_.originalID = originalID;
+  meshRelation_.numProp = numProp;
+  reader.Array(meshRelation_.properties);
+  uint64_t numRelation = 0;
+  reader.Pod(numRelation);
+  uint32_t maxID = std::max(originalID, 0);
+  for (uint64_t i = 0; i < numRelation && reader.Ok(); ++i) {
+    int32_t meshID, backSide;
+    Relation relation;
+    reader.Pod(meshID);
+    reader.Pod(originalID);
+    reader.Pod(relation.transform);
+    reader.Pod(backSide);
+    relation.originalID = originalID;
+    relation.backSide = backSide;
+    meshRelation_.meshIDtransform[meshID] = relation;
+    maxID = std::max<uint32_t>(maxID, std::max(originalID, 0));
+  }
+  reader.Array(meshRelation_.triRef);
+  reader.Array(meshRelation_.triProperties);
+
+  collider_.Deserialize(reader);
+  if (!reader.Ok()) return false;
+
+  uint32_t counter = meshIDCounter_.load();
+  while (counter <= maxID &&
+         !meshIDCounter_.compare_exchange_weak(counter, maxID + 1)) {
+  }
+  IncrementMeshIDs();
+  return true;
+}
+
+/**
+ * Returns a binary snapshot of this Manifold's internal representation:
+ * vertices, halfedges, normals, mesh relations and the collider, written
+ * as-is. Loading it with Deserialize() is far faster than rebuilding from a
+ * MeshGL, since none of the validation, sorting or collider construction is
+ * repeated.
+ *
+ * The format is versioned and in native byte order, which is little-endian on
+ * all supported platforms. It is meant as a cache for the same library
+ * version, not as an interchange format.
+ */
+std::vector<char> Manifold::Serialize() const {
+  SerialWriter writer;
+  writer.Bytes(kMagic, sizeof(kMagic));
+  writer.Pod(kVersion);
+  writer.Pod(kByteOrder);
+  GetCsgLeafNode().GetImpl()->Serialize(writer);
+  return std::move(writer.Buffer());
+}
+
+/**
+ * Loads a snapshot from Serialize(). The buffer can point straight into a
+ * memory-mapped file; it is only read during this call. A buffer that is
+ * truncated, of another version or of the other byte order gives an empty
+ * Manifold with status InvalidConstruction. The contents are otherwise
+ * trusted, so only load snapshots you wrote.
+ *
+ * @param data The start of the buffer.
+ * @param size The length of the buffer in bytes.
+ */
+Manifold Manifold::Deserialize(const char* data, size_t size) {
+  SerialReader reader(data, size);
+  char magic[8];
+  uint32_t version = 0, byteOrder = 0;
+  reader.Bytes(magic, sizeof(magic));
+  reader.Pod(version);
+  reader.Pod(byteOrder);
+  if (!reader.Ok() || !std::equal(magic, magic + 8, kMagic) ||
+      version != kVersion || byteOrder != kByteOrder)
+    return Invalid();
+
+  auto pImpl = std::make_shared<Impl>();
+  if (!pImpl->Deserialize(reader)) return Invalid();
+  return Manifold(pImpl);
+}
+}  // namespace manifold
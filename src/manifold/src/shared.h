@@ -141,6 +141,65 @@ struct Halfedge {
   }
 };
 
+/**
+ * Halfedges in half the memory of Vec<Halfedge>, as a structure of arrays of
+ * only endVert and pairedHalfedge. The face of halfedge e is e / 3 and its
+ * startVert is the endVert of the previous halfedge of the same triangle, so
+ * neither is stored. View indexes to a Halfedge just like
+ * VecView<const Halfedge>, so read-only kernels can be templated on which of
+ * the two they stream. Must be built from halfedges without removed
+ * triangles, as they are after Finish().
+ */
+class CompactHalfedges {
+ public:
+  class View {
+   public:
+    Halfedge operator[](int edge) const {
+      const int prev = edge % 3 == 0 ? edge + 2 : edge - 1;
+      return {endVert_[prev], endVert_[edge], paired_[edge], edge / 3};
+    }
+    int size() const { return endVert_.size(); }
+
+   private:
+    friend class CompactHalfedges;
+    View(VecView<const int> endVert, VecView<const int> paired)
+        : endVert_(endVert), paired_(paired) {}
+
+    VecView<const int> endVert_;
+    VecView<const int> paired_;
+  };
+
+  CompactHalfedges()
+      : endVert_(MemoryCategory::Halfedge), paired_(MemoryCategory::Halfedge) {}
+
+  explicit CompactHalfedges(VecView<const Halfedge> halfedge)
+      : CompactHalfedges() {
+    const int n = halfedge.size();
+    endVert_.resize(n);
+    paired_.resize(n);
+    for_each_n(autoPolicy(n), countAt(0), n, [&](int edge) {
+      endVert_[edge] = halfedge[edge].endVert;
+      paired_[edge] = halfedge[edge].pairedHalfedge;
+    });
+  }
+
+  View view() const { return View(endVert_, paired_); }
+  int size() const { return endVert_.size(); }
+
+  Vec<Halfedge> Expand() const {
+    const View edges = view();
+    Vec<Halfedge> halfedge(MemoryCategory::Halfedge);
+    halfedge.resize(size());
+    for_each_n(autoPolicy(size()), countAt(0), size(),
+               [&](int edge) { halfedge[edge] = edges[edge]; });
+    return halfedge;
+  }
+
+ private:
+  Vec<int> endVert_;
+  Vec<int> paired_;
+};
+
 struct Barycentric {
   int tri;
   glm::vec3 uvw;
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <functional>
 #include <map>
 
 #include "impl.h"
@@ -35,20 +36,25 @@ int VertsPerTri(int edgeVerts) {
 
 /**
  * Retained verts are part of several triangles, and it doesn't matter which one
- * the vertBary refers to. Here, whichever is last will win and it's done on the
- * CPU for simplicity for now. Using AtomicCAS on .tri should work for a GPU
- * version if desired.
+ * the vertBary refers to. Here, the last one wins, as claimed by an atomic max
+ * over the halfedges so that the result does not depend on scheduling.
  */
 void FillRetainedVerts(Vec<Barycentric>& vertBary,
-                       const Vec<Halfedge>& halfedge_) {
-  const int numTri = halfedge_.size() / 3;
-  for (int tri = 0; tri < numTri; ++tri) {
-    for (const int i : {0, 1, 2}) {
-      glm::vec3 uvw(0);
-      uvw[i] = 1;
-      vertBary[halfedge_[3 * tri + i].startVert] = {tri, uvw};
-    }
-  }
+                       const Vec<Halfedge>& halfedge_, int numVert) {
+  const int numHalfedge = halfedge_.size();
+  Vec<int> vertHalfedge(numVert, -1);
+  for_each_n(autoPolicy(numHalfedge, KernelCost::Trivial), countAt(0),
+             numHalfedge, [&vertHalfedge, &halfedge_](int edge) {
+               AtomicMax(vertHalfedge[halfedge_[edge].startVert], edge);
+             });
+  for_each_n(autoPolicy(numVert, KernelCost::Trivial), countAt(0), numVert,
+             [&vertBary, &vertHalfedge](int vert) {
+               const int edge = vertHalfedge[vert];
+               if (edge < 0) return;
+               glm::vec3 uvw(0);
+               uvw[edge % 3] = 1;
+               vertBary[vert] = {edge / 3, uvw};
+             });
 }
 
 struct ReindexHalfedge {
@@ -65,16 +71,17 @@ struct ReindexHalfedge {
 struct EdgeVerts {
   VecView<glm::vec3> vertPos;
   VecView<Barycentric> vertBary;
-  const int startIdx;
-  const int n;
+  VecView<const int> edgeOffset;
+  VecView<const int> edgeDivisions;
 
   void operator()(thrust::tuple<int, TmpEdge> in) {
     int edge = thrust::get<0>(in);
     TmpEdge edgeVerts = thrust::get<1>(in);
 
+    const int n = edgeDivisions[edge];
     float invTotal = 1.0f / n;
     for (int i = 1; i < n; ++i) {
-      const int vert = startIdx + (n - 1) * edge + i - 1;
+      const int vert = edgeOffset[edge] + i - 1;
       const float v = i * invTotal;
       const float u = 1 - v;
       vertPos[vert] =
@@ -90,91 +97,163 @@ struct EdgeVerts {
   }
 };
 
-struct InteriorVerts {
-  VecView<glm::vec3> vertPos;
-  VecView<Barycentric> vertBary;
-  const int startIdx;
-  const int n;
+int HalfedgeDivisions(VecView<const Halfedge> halfedge,
+                      VecView<const int> half2Edge,
+                      VecView<const int> edgeDivisions, int edge) {
+  const Halfedge& h = halfedge[edge];
+  return edgeDivisions[half2Edge[h.IsForward() ? edge : h.pairedHalfedge]];
+}
+
+/**
+ * Divisions of the interior grid of each triangle: that of its edges if they
+ * all agree, so that uniform refinement gives the uniform grid. Otherwise the
+ * grid is at least as fine as the finest edge and it is joined to each edge
+ * by a strip; this needs an interior row along each edge, so n >= 3.
+ */
+struct TriDivisions {
   VecView<const Halfedge> halfedge;
+  VecView<const int> half2Edge;
+  VecView<const int> edgeDivisions;
 
-  void operator()(int tri) {
-    const float invTotal = 1.0f / n;
-    int pos = startIdx + tri * VertsPerTri(n - 2);
-    for (int i = 0; i <= n; ++i) {
-      for (int j = 0; j <= n - i; ++j) {
-        const int k = n - i - j;
-        const float u = invTotal * j;
-        const float v = invTotal * k;
-        const float w = invTotal * i;
-        if (i == 0 || j == 0 || k == 0 || j == n - i) continue;
-
-        vertPos[pos] = u * vertPos[halfedge[3 * tri].startVert] +      //
-                       v * vertPos[halfedge[3 * tri + 1].startVert] +  //
-                       w * vertPos[halfedge[3 * tri + 2].startVert];
-
-        vertBary[pos++] = {tri, {u, v, w}};
-      }
+  int Divisions(int edge) const {
+    return HalfedgeDivisions(halfedge, half2Edge, edgeDivisions, edge);
+  }
+
+  void operator()(thrust::tuple<int, int&, int&, int&> inOut) {
+    const int tri = thrust::get<0>(inOut);
+    int& n = thrust::get<1>(inOut);
+    int& numVert = thrust::get<2>(inOut);
+    int& numTri = thrust::get<3>(inOut);
+
+    const glm::ivec3 d(Divisions(3 * tri), Divisions(3 * tri + 1),
+                       Divisions(3 * tri + 2));
+    if (d[0] == d[1] && d[1] == d[2]) {
+      n = d[0];
+      numTri = n * n;
+    } else {
+      n = glm::max(3, glm::max(d[0], glm::max(d[1], d[2])));
+      numTri = (n - 3) * (n - 3) + 3 * (n - 3) + d[0] + d[1] + d[2];
     }
+    numVert = VertsPerTri(n - 2);
   }
 };
 
+/**
+ * Sub-triangulates each triangle and places its interior verts. Grid points
+ * are given by integer barycentric coordinates b summing to the triangle's
+ * divisions n, where b[i] = n at the startVert of halfedge 3 * tri + i.
+ */
 struct SplitTris {
   VecView<glm::ivec3> triVerts;
-  VecView<Halfedge> halfedge;
+  VecView<glm::vec3> vertPos;
+  VecView<Barycentric> vertBary;
+  VecView<const Halfedge> halfedge;
   VecView<const int> half2Edge;
-  const int edgeIdx;
-  const int triIdx;
-  const int n;
-
-  int EdgeVert(int i, int inHalfedge) const {
-    bool forward = halfedge[inHalfedge].IsForward();
-    int edge = forward ? half2Edge[inHalfedge]
-                       : half2Edge[halfedge[inHalfedge].pairedHalfedge];
-    return edgeIdx + (n - 1) * edge + (forward ? i - 1 : n - 1 - i);
+  VecView<const int> edgeOffset;
+  VecView<const int> edgeDivisions;
+  VecView<const int> triDivisions;
+  VecView<const int> triVertOffset;
+  VecView<const int> triOffset;
+
+  int Divisions(int edge) const {
+    return HalfedgeDivisions(halfedge, half2Edge, edgeDivisions, edge);
   }
 
-  int TriVert(int i, int j, int tri) const {
-    --i;
-    --j;
-    int m = n - 2;
-    int vertsPerTri = (m * m + m) / 2;
-    int vertOffset = (i * (2 * m - i + 1)) / 2 + j;
-    return triIdx + vertsPerTri * tri + vertOffset;
+  // Vert p of the Divisions() + 1 along halfedge 3 * tri + i.
+  int EdgeVert(int tri, int i, int p) const {
+    const int edge = 3 * tri + i;
+    const int d = Divisions(edge);
+    if (p == 0) return halfedge[edge].startVert;
+    if (p == d) return halfedge[edge].endVert;
+    const bool forward = halfedge[edge].IsForward();
+    const int offset =
+        edgeOffset[half2Edge[forward ? edge : halfedge[edge].pairedHalfedge]];
+    return offset + (forward ? p - 1 : d - 1 - p);
   }
 
-  int Vert(int i, int j, int tri) const {
-    bool edge0 = i == 0;
-    bool edge1 = j == 0;
-    bool edge2 = j == n - i;
-    if (edge0) {
-      if (edge1)
-        return halfedge[3 * tri + 1].startVert;
-      else if (edge2)
-        return halfedge[3 * tri].startVert;
-      else
-        return EdgeVert(n - j, 3 * tri);
-    } else if (edge1) {
-      if (edge2)
-        return halfedge[3 * tri + 2].startVert;
-      else
-        return EdgeVert(i, 3 * tri + 1);
-    } else if (edge2)
-      return EdgeVert(j, 3 * tri + 2);
-    else
-      return TriVert(i, j, tri);
+  int InteriorVert(int tri, int n, glm::ivec3 b) const {
+    return triVertOffset[tri] + (b[0] - 1) * (n - 1) - (b[0] - 1) * b[0] / 2 +
+           b[1] - 1;
+  }
+
+  int GridVert(int tri, int n, glm::ivec3 b) const {
+    for (const int i : {0, 1, 2}) {
+      // the edge from corner i to Next3(i) is opposite Prev3(i)
+      if (b[Prev3(i)] == 0) return EdgeVert(tri, i, b[Next3(i)]);
+    }
+    return InteriorVert(tri, n, b);
+  }
+
+  // Emits the uniform triangulation of a grid of m divisions.
+  template <typename Vert>
+  void Grid(int m, Vert vert, int& pos) {
+    for (int i = 0; i < m; ++i) {
+      for (int j = 0; j < m - i; ++j) {
+        const int a = vert(i + 1, j);
+        const int b = vert(i, j + 1);
+        triVerts[pos++] = {a, b, vert(i, j)};
+        if (j < m - 1 - i) triVerts[pos++] = {b, a, vert(i + 1, j + 1)};
+      }
+    }
   }
 
   void operator()(int tri) {
-    int pos = n * n * tri;
-    for (int i = 0; i < n; ++i) {
-      for (int j = 0; j < n - i; ++j) {
-        int a = Vert(i, j, tri);
-        int b = Vert(i + 1, j, tri);
-        int c = Vert(i, j + 1, tri);
-        triVerts[pos++] = glm::ivec3(c, a, b);
-        if (j < n - 1 - i) {
-          int d = Vert(i + 1, j + 1, tri);
-          triVerts[pos++] = glm::ivec3(b, d, c);
+    const int n = triDivisions[tri];
+    const glm::vec3 corner[3] = {vertPos[halfedge[3 * tri].startVert],
+                                 vertPos[halfedge[3 * tri + 1].startVert],
+                                 vertPos[halfedge[3 * tri + 2].startVert]};
+    const float invTotal = 1.0f / n;
+    for (int i = 1; i < n - 1; ++i) {
+      for (int j = 1; j < n - i; ++j) {
+        const glm::ivec3 b(i, j, n - i - j);
+        const glm::vec3 uvw = invTotal * glm::vec3(b);
+        const int vert = InteriorVert(tri, n, b);
+        vertPos[vert] =
+            uvw[0] * corner[0] + uvw[1] * corner[1] + uvw[2] * corner[2];
+        vertBary[vert] = {tri, uvw};
+      }
+    }
+
+    int pos = triOffset[tri];
+    if (Divisions(3 * tri) == n && Divisions(3 * tri + 1) == n &&
+        Divisions(3 * tri + 2) == n) {
+      Grid(
+          n,
+          [&](int i, int j) { return GridVert(tri, n, {i, j, n - i - j}); },
+          pos);
+      return;
+    }
+
+    // The interior points with all b >= 1 form a grid of n - 3 divisions.
+    const int m = n - 3;
+    Grid(
+        m,
+        [&](int i, int j) {
+          return InteriorVert(tri, n, {i + 1, j + 1, m - i - j + 1});
+        },
+        pos);
+    // Zip each edge to the parallel interior row, which runs from b[i] =
+    // n - 2 to b[Next3(i)] = n - 2, always advancing whichever side's next
+    // vert is earlier as seen from the opposite corner.
+    for (const int i : {0, 1, 2}) {
+      const int d = Divisions(3 * tri + i);
+      auto row = [&](int r) {
+        glm::ivec3 b;
+        b[i] = n - 2 - r;
+        b[Next3(i)] = 1 + r;
+        b[Prev3(i)] = 1;
+        return InteriorVert(tri, n, b);
+      };
+      int p = 0;
+      int r = 0;
+      while (p < d || r < n - 3) {
+        if (p < d && (r == n - 3 || (p + 1) * (n - 1) <= (r + 2) * d)) {
+          triVerts[pos++] = {EdgeVert(tri, i, p), EdgeVert(tri, i, p + 1),
+                             row(r)};
+          ++p;
+        } else {
+          triVerts[pos++] = {EdgeVert(tri, i, p), row(r + 1), row(r)};
+          ++r;
         }
       }
     }
@@ -308,6 +387,17 @@ struct InterpTri {
     pos = HNormalize(posH);
   }
 };
+
+// The most pieces RefineToLength and RefineToPrecision split an edge into in
+// one call. This keeps the cast below defined and the n^2 triangles per face
+// well inside the int index range; finer results take repeated calls.
+constexpr int kMaxEdgeDivisions = 1 << 9;
+
+int EdgeDivisions(float pieces) {
+  if (!glm::isfinite(pieces)) return 1;
+  return static_cast<int>(
+      glm::min(pieces, static_cast<float>(kMaxEdgeDivisions)));
+}
 }  // namespace
 
 namespace manifold {
@@ -337,11 +427,13 @@ void Manifold::Impl::CreateTangents(
     // sharpenedEdges are referenced to the input Mesh, but the triangles have
     // been sorted in creating the Manifold, so the indices are converted using
     // meshRelation_.
-    std::vector<int> oldHalfedge2New(halfedge_.size());
-    for (int tri = 0; tri < NumTri(); ++tri) {
-      int oldTri = triRef[tri].tri;
-      for (int i : {0, 1, 2}) oldHalfedge2New[3 * oldTri + i] = 3 * tri + i;
-    }
+    Vec<int> oldHalfedge2New(halfedge_.size());
+    for_each_n(autoPolicy(NumTri(), KernelCost::Trivial), countAt(0), NumTri(),
+               [&oldHalfedge2New, &triRef](int tri) {
+                 const int oldTri = triRef[tri].tri;
+                 for (int i : {0, 1, 2})
+                   oldHalfedge2New[3 * oldTri + i] = 3 * tri + i;
+               });
 
     using Pair = std::pair<Smoothness, Smoothness>;
     // Fill in missing pairs with default smoothness = 1.
@@ -364,12 +456,18 @@ void Manifold::Impl::CreateTangents(
       vertTangents[halfedge_[edge.second.halfedge].startVert].push_back(
           {edge.second, edge.first});
     }
+    // Each vert only touches the tangents of its own fan of outgoing
+    // halfedges, so the fans are processed in parallel.
+    std::vector<const std::vector<Pair>*> fans;
+    fans.reserve(vertTangents.size());
+    for (const auto& value : vertTangents) fans.push_back(&value.second);
 
     Vec<glm::vec4>& tangent = halfedgeTangent_;
-    for (const auto& value : vertTangents) {
-      const std::vector<Pair>& vert = value.second;
+    const int numFan = fans.size();
+    for_each_n(autoPolicy(numFan), countAt(0), numFan, [&](int fan) {
+      const std::vector<Pair>& vert = *fans[fan];
       // Sharp edges that end are smooth at their terminal vert.
-      if (vert.size() == 1) continue;
+      if (vert.size() == 1) return;
       if (vert.size() == 2) {  // Make continuous edge
         const int first = vert[0].first.halfedge;
         const int second = vert[1].first.halfedge;
@@ -416,49 +514,89 @@ void Manifold::Impl::CreateTangents(
           current = NextHalfedge(halfedge_[current].pairedHalfedge);
         } while (current != start);
       }
-    }
+    });
   }
 }
 
 /**
- * Split each edge into n pieces and sub-triangulate each triangle accordingly.
- * This function doesn't run Finish(), as that is expensive and it'll need to be
- * run after the new vertices have moved, which is a likely scenario after
+ * Split each edge into the number of pieces given by edgeDivisions and
+ * sub-triangulate each triangle accordingly. edgeDivisions is called in
+ * parallel with the forward halfedge of each edge, before the mesh is
+ * modified; values below 1 count as 1. Triangles whose edges all have the
+ * same divisions n are split into a uniform grid of n * n triangles.
+ *
+ * This function doesn't run Finish(), as that is expensive and it'll need to
+ * be run after the new vertices have moved, which is a likely scenario after
  * refinement (smoothing).
  */
-Vec<Barycentric> Manifold::Impl::Subdivide(int n) {
+Vec<Barycentric> Manifold::Impl::Subdivide(
+    std::function<int(int)> edgeDivisions) {
   ZoneScoped;
-  if (n < 2) return Vec<Barycentric>();
-  faceNormal_.resize(0);
-  vertNormal_.resize(0);
+  Vec<TmpEdge> edges = CreateTmpEdges(halfedge_);
   const int numVert = NumVert();
-  const int numEdge = NumEdge();
+  const int numEdge = edges.size();
   const int numTri = NumTri();
-  // Append new verts
-  const int vertsPerEdge = n - 1;
-  const int triVertStart = numVert + numEdge * vertsPerEdge;
-  vertPos_.resize(triVertStart + numTri * VertsPerTri(n - 2));
-  Vec<Barycentric> vertBary(vertPos_.size());
-  FillRetainedVerts(vertBary, halfedge_);
+  auto policy = autoPolicy(numEdge);
 
-  MeshRelationD oldMeshRelation = std::move(meshRelation_);
-  meshRelation_.triRef.resize(n * n * numTri);
-  meshRelation_.originalID = oldMeshRelation.originalID;
+  Vec<int> divisions(numEdge);
+  for_each_n(policy, countAt(0), numEdge, [&](int edge) {
+    divisions[edge] = glm::max(1, edgeDivisions(edges[edge].halfedgeIdx));
+  });
+  if (all_of(policy, divisions.begin(), divisions.end(),
+             [](int d) { return d == 1; }))
+    return Vec<Barycentric>();
+
+  faceNormal_.resize(0);
+  vertNormal_.resize(0);
 
-  Vec<TmpEdge> edges = CreateTmpEdges(halfedge_);
   Vec<int> half2Edge(2 * numEdge);
-  auto policy = autoPolicy(numEdge);
   for_each_n(policy, zip(countAt(0), edges.begin()), numEdge,
              ReindexHalfedge({half2Edge}));
+
+  // Lay out the new verts and triangles by prefix sums: the edge verts follow
+  // the retained verts, then each triangle's interior verts.
+  Vec<int> edgeOffset(numEdge);
+  transform(policy, divisions.begin(), divisions.end(), edgeOffset.begin(),
+            [](int d) { return d - 1; });
+  const int numEdgeVert = reduce<int>(policy, edgeOffset.begin(),
+                                      edgeOffset.end(), 0, thrust::plus<int>());
+  exclusive_scan(policy, edgeOffset.begin(), edgeOffset.end(),
+                 edgeOffset.begin(), numVert);
+
+  Vec<int> triDivisions(numTri);
+  Vec<int> triVertOffset(numTri);
+  Vec<int> triOffset(numTri);
+  for_each_n(autoPolicy(numTri),
+             zip(countAt(0), triDivisions.begin(), triVertOffset.begin(),
+                 triOffset.begin()),
+             numTri, TriDivisions({halfedge_, half2Edge, divisions}));
+  const int numTriVert =
+      reduce<int>(autoPolicy(numTri), triVertOffset.begin(),
+                  triVertOffset.end(), 0, thrust::plus<int>());
+  const int numNewTri = reduce<int>(autoPolicy(numTri), triOffset.begin(),
+                                    triOffset.end(), 0, thrust::plus<int>());
+  exclusive_scan(autoPolicy(numTri), triVertOffset.begin(),
+                 triVertOffset.end(), triVertOffset.begin(),
+                 numVert + numEdgeVert);
+  exclusive_scan(autoPolicy(numTri), triOffset.begin(), triOffset.end(),
+                 triOffset.begin(), 0);
+
+  vertPos_.resize(numVert + numEdgeVert + numTriVert);
+  Vec<Barycentric> vertBary(vertPos_.size());
+  FillRetainedVerts(vertBary, halfedge_, numVert);
+
+  MeshRelationD oldMeshRelation = std::move(meshRelation_);
+  meshRelation_.triRef.resize(numNewTri);
+  meshRelation_.originalID = oldMeshRelation.originalID;
+
   for_each_n(policy, zip(countAt(0), edges.begin()), numEdge,
-             EdgeVerts({vertPos_, vertBary, numVert, n}));
-  for_each_n(policy, countAt(0), numTri,
-             InteriorVerts({vertPos_, vertBary, triVertStart, n, halfedge_}));
+             EdgeVerts({vertPos_, vertBary, edgeOffset, divisions}));
   // Create sub-triangles
-  Vec<glm::ivec3> triVerts(n * n * numTri);
-  for_each_n(
-      policy, countAt(0), numTri,
-      SplitTris({triVerts, halfedge_, half2Edge, numVert, triVertStart, n}));
+  Vec<glm::ivec3> triVerts(numNewTri);
+  for_each_n(autoPolicy(numTri), countAt(0), numTri,
+             SplitTris({triVerts, vertPos_, vertBary, halfedge_, half2Edge,
+                        edgeOffset, divisions, triDivisions, triVertOffset,
+                        triOffset}));
   CreateHalfedges(triVerts);
   // Make original since the subdivided faces are intended to be warped into
   // being non-coplanar, and hence not being related to the original faces.
@@ -476,9 +614,9 @@ Vec<Barycentric> Manifold::Impl::Subdivide(int n) {
   return vertBary;
 }
 
-void Manifold::Impl::Refine(int n) {
+void Manifold::Impl::Refine(std::function<int(int)> edgeDivisions) {
   Manifold::Impl old = *this;
-  Vec<Barycentric> vertBary = Subdivide(n);
+  Vec<Barycentric> vertBary = Subdivide(edgeDivisions);
   if (vertBary.size() == 0) return;
 
   if (old.halfedgeTangent_.size() == old.halfedge_.size()) {
@@ -490,4 +628,43 @@ void Manifold::Impl::Refine(int n) {
   halfedgeTangent_.resize(0);
   Finish();
 }
+
+/**
+ * Splits each edge into pieces no longer than length.
+ */
+void Manifold::Impl::RefineToLength(float length) {
+  length = glm::abs(length);
+  Refine([this, length](int edge) {
+    const float edgeLength =
+        glm::length(vertPos_[halfedge_[edge].endVert] -
+                    vertPos_[halfedge_[edge].startVert]);
+    return EdgeDivisions(glm::ceil(edgeLength / length));
+  });
+}
+
+/**
+ * Splits each edge into enough pieces that its Bezier curve, given by
+ * halfedgeTangent_, deviates from each piece's chord by at most precision.
+ * The deviation of a cubic is bounded by 3/4 of the distance of its inner
+ * control points from the chord, and shrinks quadratically with the number
+ * of pieces. Without tangents the mesh is left as is.
+ */
+void Manifold::Impl::RefineToPrecision(float precision) {
+  if (halfedgeTangent_.size() != halfedge_.size()) return;
+  precision = glm::abs(precision);
+  Refine([this, precision](int edge) {
+    const Halfedge& halfedge = halfedge_[edge];
+    const glm::vec3 start = vertPos_[halfedge.startVert];
+    const glm::vec3 end = vertPos_[halfedge.endVert];
+    const glm::vec3 dir = SafeNormalize(end - start);
+    auto offset = [&](glm::vec3 point, glm::vec4 tangent) {
+      return glm::length(OrthogonalTo(point + glm::vec3(tangent) - start, dir));
+    };
+    const glm::vec4 tangentStart = halfedgeTangent_[edge];
+    const glm::vec4 tangentEnd = halfedgeTangent_[halfedge.pairedHalfedge];
+    const float deviation = 0.75f * glm::max(offset(start, tangentStart),
+                                             offset(end, tangentEnd));
+    return EdgeDivisions(glm::ceil(glm::sqrt(deviation / precision)));
+  });
+}
 }  // namespace manifold
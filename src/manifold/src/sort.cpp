@@ -14,15 +14,23 @@
 
 #include <atomic>
 #include <numeric>
-#include <set>
 
+#include "hashtable.h"
 #include "impl.h"
 #include "par.h"
+#include "radix_sort.h"
 
 namespace {
 using namespace manifold;
 
-constexpr uint32_t kNoCode = 0xFFFFFFFFu;
+constexpr uint32_t kNoCode = Collider::kNoCode;
+constexpr uint64_t kNoCode64 = Collider::kNoCode64;
+
+// The code of removed elements, for either width of Morton code.
+template <typename Code>
+constexpr Code NoCode() {
+  return sizeof(Code) == sizeof(uint64_t) ? kNoCode64 : kNoCode;
+}
 
 struct Extrema : public thrust::binary_function<Halfedge, Halfedge, Halfedge> {
   void MakeForward(Halfedge& a) {
@@ -48,51 +56,52 @@ struct Extrema : public thrust::binary_function<Halfedge, Halfedge, Halfedge> {
   }
 };
 
-uint32_t SpreadBits3(uint32_t v) {
-  v = 0xFF0000FFu & (v * 0x00010001u);
-  v = 0x0F00F00Fu & (v * 0x00000101u);
-  v = 0xC30C30C3u & (v * 0x00000011u);
-  v = 0x49249249u & (v * 0x00000005u);
-  return v;
-}
-
-uint32_t MortonCode(glm::vec3 position, Box bBox) {
-  // Unreferenced vertices are marked NaN, and this will sort them to the end
-  // (the Morton code only uses the first 30 of 32 bits).
-  if (isnan(position.x)) return kNoCode;
-
-  glm::vec3 xyz = (position - bBox.min) / (bBox.max - bBox.min);
-  xyz = glm::min(glm::vec3(1023.0f), glm::max(glm::vec3(0.0f), 1024.0f * xyz));
-  uint32_t x = SpreadBits3(static_cast<uint32_t>(xyz.x));
-  uint32_t y = SpreadBits3(static_cast<uint32_t>(xyz.y));
-  uint32_t z = SpreadBits3(static_cast<uint32_t>(xyz.z));
-  return x * 4 + y * 2 + z;
-}
-
 struct Morton {
   const Box bBox;
+  // Use the index instead, so only removed verts move.
+  const bool keepOrder;
 
-  void operator()(thrust::tuple<uint32_t&, const glm::vec3&> inout) {
+  void operator()(thrust::tuple<uint32_t&, const glm::vec3&, int> inout) {
     glm::vec3 position = thrust::get<1>(inout);
-    thrust::get<0>(inout) = MortonCode(position, bBox);
+    thrust::get<0>(inout) =
+        keepOrder && !glm::isnan(position.x)
+            ? static_cast<uint32_t>(thrust::get<2>(inout))
+            : Collider::MortonCode(position, bBox);
   }
 };
 
+struct FaceBox {
+  VecView<const Halfedge> halfedge;
+  VecView<const glm::vec3> vertPos;
+
+  void operator()(thrust::tuple<Box&, int> inout) {
+    Box& faceBox = thrust::get<0>(inout);
+    const int face = thrust::get<1>(inout);
+    faceBox = Box();
+    if (halfedge[3 * face].pairedHalfedge < 0) return;
+    for (const int i : {0, 1, 2})
+      faceBox.Union(vertPos[halfedge[3 * face + i].startVert]);
+  }
+};
+
+template <typename Code>
 struct FaceMortonBox {
   VecView<const Halfedge> halfedge;
   VecView<const glm::vec3> vertPos;
   const Box bBox;
+  // Use the index instead, so only removed tris move.
+  const bool keepOrder;
 
-  void operator()(thrust::tuple<uint32_t&, Box&, int> inout) {
-    uint32_t& mortonCode = thrust::get<0>(inout);
+  void operator()(thrust::tuple<Code&, Box&, int> inout) {
+    Code& mortonCode = thrust::get<0>(inout);
     Box& faceBox = thrust::get<1>(inout);
     int face = thrust::get<2>(inout);
 
     // Removed tris are marked by all halfedges having pairedHalfedge = -1, and
-    // this will sort them to the end (the Morton code only uses the first 30 of
-    // 32 bits).
+    // this will sort them to the end (the Morton code leaves the top bits
+    // unused).
     if (halfedge[3 * face].pairedHalfedge < 0) {
-      mortonCode = kNoCode;
+      mortonCode = NoCode<Code>();
       return;
     }
 
@@ -105,10 +114,50 @@ struct FaceMortonBox {
     }
     center /= 3;
 
-    mortonCode = MortonCode(center, bBox);
+    if (keepOrder)
+      mortonCode = face;
+    else if constexpr (sizeof(Code) == sizeof(uint64_t))
+      mortonCode = Collider::MortonCode64(center, bBox);
+    else
+      mortonCode = Collider::MortonCode(center, bBox);
   }
 };
 
+/**
+ * Stable sort of keys, applying the same permutation to new2Old, which must
+ * be the identity on entry. Returns false if the keys were already in order,
+ * in which case nothing moved. When only a short tail is out of order, as for
+ * elements appended to already sorted data, just the tail is sorted and then
+ * merged into the sorted prefix in linear time.
+ */
+template <typename Key>
+bool SortByKey(Vec<Key>& keys, Vec<int>& new2Old) {
+  const int n = keys.size();
+  const int sorted =
+      std::is_sorted_until(keys.begin(), keys.end()) - keys.begin();
+  if (sorted == n) return false;
+  if (sorted < n / 2) {
+    RadixSort(keys.view(), new2Old.view());
+    return true;
+  }
+
+  RadixSort(keys.view(sorted), new2Old.view(sorted));
+  Vec<Key> mergedKeys(n);
+  Vec<int> merged(n);
+  int i = 0;
+  int j = sorted;
+  for (int k = 0; k < n; ++k) {
+    // ties take the prefix first to stay stable
+    const bool takeTail = i == sorted || (j < n && keys[j] < keys[i]);
+    const int from = takeTail ? j++ : i++;
+    mergedKeys[k] = keys[from];
+    merged[k] = new2Old[from];
+  }
+  keys = std::move(mergedKeys);
+  new2Old = std::move(merged);
+  return true;
+}
+
 struct Reindex {
   VecView<const int> indexInv;
 
@@ -160,8 +209,8 @@ template <typename T>
 void Permute(Vec<T>& inOut, const Vec<int>& new2Old) {
   Vec<T> tmp(std::move(inOut));
   inOut.resize(new2Old.size());
-  gather(autoPolicy(new2Old.size()), new2Old.begin(), new2Old.end(),
-         tmp.begin(), inOut.begin());
+  gather(autoPolicy(new2Old.size(), KernelCost::Trivial), new2Old.begin(),
+         new2Old.end(), tmp.begin(), inOut.begin());
 }
 
 template void Permute<TriRef>(Vec<TriRef>&, const Vec<int>&);
@@ -193,27 +242,15 @@ struct ReindexFace {
   }
 };
 
-struct VertMortonBox {
-  VecView<const float> vertProperties;
-  const uint32_t numProp;
-  const float tol;
-  const Box bBox;
-
-  void operator()(thrust::tuple<uint32_t&, Box&, int> inout) {
-    uint32_t& mortonCode = thrust::get<0>(inout);
-    Box& vertBox = thrust::get<1>(inout);
-    int vert = thrust::get<2>(inout);
+constexpr int kCellBits = 21;
+constexpr int kCellMax = (1 << kCellBits) - 1;
 
-    const glm::vec3 center(vertProperties[numProp * vert],
-                           vertProperties[numProp * vert + 1],
-                           vertProperties[numProp * vert + 2]);
-
-    vertBox.min = center - tol / 2;
-    vertBox.max = center + tol / 2;
-
-    mortonCode = MortonCode(center, bBox);
-  }
-};
+// The hash key of a cell of the weld grid; it never equals the open key.
+Uint64 CellKey(glm::ivec3 cell) {
+  return (static_cast<Uint64>(cell.x) << (2 * kCellBits)) |
+         (static_cast<Uint64>(cell.y) << kCellBits) |
+         static_cast<Uint64>(cell.z);
+}
 
 struct Duplicate {
   thrust::pair<float, float> operator()(float x) {
@@ -237,9 +274,11 @@ namespace manifold {
 /**
  * Once halfedge_ has been filled in, this function can be called to create the
  * rest of the internal data structures. This function also removes the verts
- * and halfedges flagged for removal (NaN verts and -1 halfedges).
+ * and halfedges flagged for removal (NaN verts and -1 halfedges). With
+ * keepOrder, the verts and faces are not resorted by Morton code.
  */
-void Manifold::Impl::Finish() {
+void Manifold::Impl::Finish(bool keepOrder) {
+  edgeCache_.Store(nullptr);
   if (halfedge_.size() == 0) return;
 
   CalculateBBox();
@@ -250,11 +289,19 @@ void Manifold::Impl::Finish() {
     return;
   }
 
-  SortVerts();
+  SortVerts(keepOrder);
+  // only one of these is used, by ExecutionParams::mortonCode64
+  const bool morton64 = ManifoldParams().mortonCode64;
   Vec<Box> faceBox;
   Vec<uint32_t> faceMorton;
-  GetFaceBoxMorton(faceBox, faceMorton);
-  SortFaces(faceBox, faceMorton);
+  Vec<uint64_t> faceMorton64;
+  if (morton64) {
+    GetFaceBoxMorton(faceBox, faceMorton64, keepOrder);
+    SortFaces(faceBox, faceMorton64);
+  } else {
+    GetFaceBoxMorton(faceBox, faceMorton, keepOrder);
+    SortFaces(faceBox, faceMorton);
+  }
   if (halfedge_.size() == 0) return;
   CompactProps();
 
@@ -291,33 +338,30 @@ void Manifold::Impl::Finish() {
   //            ", NumVert = " + std::to_string(NumVert()));
 
   CalculateNormals();
-  collider_ = Collider(faceBox, faceMorton);
+  const bool sah = ManifoldParams().sahCollider;
+  collider_ = morton64 ? Collider(faceBox, faceMorton64, sah)
+                       : Collider(faceBox, faceMorton, sah);
+  if (ManifoldParams().wideCollider) collider_.BuildWide();
 
   ASSERT(Is2Manifold(), logicErr, "mesh is not 2-manifold!");
 }
 
 /**
- * Sorts the vertices according to their Morton code.
+ * Sorts the vertices according to their Morton code. With keepOrder, the
+ * current order is kept and only removed verts are dropped.
  */
-void Manifold::Impl::SortVerts() {
+void Manifold::Impl::SortVerts(bool keepOrder) {
   ZoneScoped;
   const int numVert = NumVert();
   Vec<uint32_t> vertMorton(numVert);
   auto policy = autoPolicy(numVert);
-  for_each_n(policy, zip(vertMorton.begin(), vertPos_.cbegin()), numVert,
-             Morton({bBox_}));
+  for_each_n(policy, zip(vertMorton.begin(), vertPos_.cbegin(), countAt(0)),
+             numVert, Morton({bBox_, keepOrder}));
 
   Vec<int> vertNew2Old(numVert);
   sequence(policy, vertNew2Old.begin(), vertNew2Old.end());
 
-  stable_sort(policy, zip(vertMorton.begin(), vertNew2Old.begin()),
-              zip(vertMorton.end(), vertNew2Old.end()),
-              [](const thrust::tuple<uint32_t, int>& a,
-                 const thrust::tuple<uint32_t, int>& b) {
-                return thrust::get<0>(a) < thrust::get<0>(b);
-              });
-
-  ReindexVerts(vertNew2Old, numVert);
+  const bool moved = SortByKey(vertMorton, vertNew2Old);
 
   // Verts were flagged for removal with NaNs and assigned kNoCode to sort
   // them to the end, which allows them to be removed.
@@ -325,6 +369,15 @@ void Manifold::Impl::SortVerts() {
       std::lower_bound(vertMorton.begin(), vertMorton.end(), kNoCode) -
       vertMorton.begin();
 
+  if (!moved) {
+    // already in order: removed verts are unreferenced, so just drop them
+    vertPos_.resize(newNumVert);
+    if (vertNormal_.size() == numVert) vertNormal_.resize(newNumVert);
+    return;
+  }
+
+  ReindexVerts(vertNew2Old, numVert);
+
   vertNew2Old.resize(newNumVert);
   Permute(vertPos_, vertNew2Old);
 
@@ -376,41 +429,52 @@ void Manifold::Impl::CompactProps() {
 /**
  * Fills the faceBox and faceMorton input with the bounding boxes and Morton
  * codes of the faces, respectively. The Morton code is based on the center of
- * the bounding box.
+ * the bounding box. With keepOrder, the face index is used as its code
+ * instead, so the faces keep their order and the collider is built over it.
  */
-void Manifold::Impl::GetFaceBoxMorton(Vec<Box>& faceBox,
-                                      Vec<uint32_t>& faceMorton) const {
+template <typename Code>
+void Manifold::Impl::GetFaceBoxMorton(Vec<Box>& faceBox, Vec<Code>& faceMorton,
+                                      bool keepOrder) const {
   ZoneScoped;
   faceBox.resize(NumTri());
   faceMorton.resize(NumTri());
   for_each_n(autoPolicy(NumTri()),
              zip(faceMorton.begin(), faceBox.begin(), countAt(0)), NumTri(),
-             FaceMortonBox({halfedge_, vertPos_, bBox_}));
+             FaceMortonBox<Code>({halfedge_, vertPos_, bBox_, keepOrder}));
+}
+
+/**
+ * Fills the faceBox input with the bounding boxes of the faces, without the
+ * Morton codes, for refitting the collider when the faces are not resorted.
+ */
+void Manifold::Impl::GetFaceBox(Vec<Box>& faceBox) const {
+  ZoneScoped;
+  faceBox.resize(NumTri());
+  for_each_n(autoPolicy(NumTri()), zip(faceBox.begin(), countAt(0)), NumTri(),
+             FaceBox({halfedge_, vertPos_}));
 }
 
 /**
  * Sorts the faces of this manifold according to their input Morton code. The
  * bounding box and Morton code arrays are also sorted accordingly.
  */
-void Manifold::Impl::SortFaces(Vec<Box>& faceBox, Vec<uint32_t>& faceMorton) {
+template <typename Code>
+void Manifold::Impl::SortFaces(Vec<Box>& faceBox, Vec<Code>& faceMorton) {
   ZoneScoped;
   Vec<int> faceNew2Old(NumTri());
   auto policy = autoPolicy(faceNew2Old.size());
   sequence(policy, faceNew2Old.begin(), faceNew2Old.end());
 
-  stable_sort(policy, zip(faceMorton.begin(), faceNew2Old.begin()),
-              zip(faceMorton.end(), faceNew2Old.end()),
-              [](const thrust::tuple<uint32_t, int>& a,
-                 const thrust::tuple<uint32_t, int>& b) {
-                return thrust::get<0>(a) < thrust::get<0>(b);
-              });
+  const bool moved = SortByKey(faceMorton, faceNew2Old);
 
-  // Tris were flagged for removal with pairedHalfedge = -1 and assigned kNoCode
-  // to sort them to the end, which allows them to be removed.
+  // Tris were flagged for removal with pairedHalfedge = -1 and assigned
+  // the no-code value to sort them to the end, which allows them to be
+  // removed.
   const int newNumTri =
       find<decltype(faceMorton.begin())>(policy, faceMorton.begin(),
-                                         faceMorton.end(), kNoCode) -
+                                         faceMorton.end(), NoCode<Code>()) -
       faceMorton.begin();
+  if (!moved && newNumTri == NumTri()) return;
   faceMorton.resize(newNumTri);
   faceNew2Old.resize(newNumTri);
 
@@ -503,6 +567,21 @@ MeshGL::MeshGL(const Mesh& mesh) {
   }
 }
 
+MeshGLView::MeshGLView(const MeshGL& meshGL)
+    : numProp(meshGL.numProp),
+      vertProperties(meshGL.vertProperties.data(),
+                     meshGL.vertProperties.size()),
+      triVerts(meshGL.triVerts.data(), meshGL.triVerts.size()),
+      mergeFromVert(meshGL.mergeFromVert.data(), meshGL.mergeFromVert.size()),
+      mergeToVert(meshGL.mergeToVert.data(), meshGL.mergeToVert.size()),
+      runIndex(meshGL.runIndex.data(), meshGL.runIndex.size()),
+      runOriginalID(meshGL.runOriginalID.data(), meshGL.runOriginalID.size()),
+      runTransform(meshGL.runTransform.data(), meshGL.runTransform.size()),
+      faceID(meshGL.faceID.data(), meshGL.faceID.size()),
+      halfedgeTangent(meshGL.halfedgeTangent.data(),
+                      meshGL.halfedgeTangent.size()),
+      precision(meshGL.precision) {}
+
 /**
  * Updates the mergeFromVert and mergeToVert vectors in order to create a
  * manifold solid. If the MeshGL is already manifold, no change will occur and
@@ -518,48 +597,66 @@ MeshGL::MeshGL(const Mesh& mesh) {
  */
 bool MeshGL::Merge() {
   ZoneScoped;
-  std::multiset<std::pair<int, int>> openEdges;
+  const int numVert = NumVert();
+  const int numHalfedge = 3 * NumTri();
 
-  std::vector<int> merge(NumVert());
-  std::iota(merge.begin(), merge.end(), 0);
+  Vec<int> merge(numVert);
+  sequence(autoPolicy(numVert, KernelCost::Trivial), merge.begin(),
+           merge.end());
   for (int i = 0; i < mergeFromVert.size(); ++i) {
     merge[mergeFromVert[i]] = mergeToVert[i];
   }
 
-  const int numVert = NumVert();
-  const int numTri = NumTri();
-  const int next[3] = {1, 2, 0};
-  for (int tri = 0; tri < numTri; ++tri) {
-    for (int i : {0, 1, 2}) {
-      auto edge = std::make_pair(merge[triVerts[3 * tri + next[i]]],
-                                 merge[triVerts[3 * tri + i]]);
-      auto it = openEdges.find(edge);
-      if (it == openEdges.end()) {
-        std::swap(edge.first, edge.second);
-        openEdges.insert(edge);
-      } else {
-        openEdges.erase(it);
-      }
-    }
-  }
+  // Key each halfedge by its undirected edge and sort; an edge is open where
+  // the directions of its halfedges don't cancel, or where it joins a vert to
+  // itself and so has no direction.
+  auto policy = autoPolicy(numHalfedge);
+  Vec<Uint64> edgeKey(numHalfedge);
+  Vec<int> edgeDir(numHalfedge);
+  for_each_n(policy, countAt(0), numHalfedge, [&](int e) {
+    const int v0 = merge[triVerts[e]];
+    const int v1 = merge[triVerts[e % 3 == 2 ? e - 2 : e + 1]];
+    edgeKey[e] = (static_cast<Uint64>(glm::min(v0, v1)) << 32) |
+                 static_cast<Uint64>(glm::max(v0, v1));
+    edgeDir[e] = v0 < v1 ? 1 : (v0 > v1 ? -1 : 0);
+  });
+  stable_sort(policy, zip(edgeKey.begin(), edgeDir.begin()),
+              zip(edgeKey.end(), edgeDir.end()),
+              [](const thrust::tuple<Uint64, int>& a,
+                 const thrust::tuple<Uint64, int>& b) {
+                return thrust::get<0>(a) < thrust::get<0>(b);
+              });
 
-  if (openEdges.empty()) {
+  Vec<uint8_t> isOpen(numVert, 0);
+  for_each_n(policy, countAt(0), numHalfedge, [&](int e) {
+    const Uint64 key = edgeKey[e];
+    if (e > 0 && edgeKey[e - 1] == key) return;
+    int dir = 0;
+    for (int f = e; f < numHalfedge && edgeKey[f] == key; ++f)
+      dir += edgeDir[f];
+    if (dir == 0 && (key >> 32) != (key & 0xffffffff)) return;
+    AtomicStore(isOpen[key >> 32], static_cast<uint8_t>(1));
+    AtomicStore(isOpen[key & 0xffffffff], static_cast<uint8_t>(1));
+  });
+
+  Vec<int> openVerts(numVert);
+  const int numOpenVert =
+      copy_if<decltype(openVerts.begin())>(
+          autoPolicy(numVert), countAt(0), countAt(numVert),
+          openVerts.begin(), [&isOpen](int v) { return isOpen[v] != 0; }) -
+      openVerts.begin();
+  if (numOpenVert == 0) {
     return false;
   }
+  openVerts.resize(numOpenVert);
 
-  const int numOpenVert = openEdges.size();
-  Vec<int> openVerts(numOpenVert);
-  int i = 0;
-  for (const auto& edge : openEdges) {
-    const int vert = edge.first;
-    openVerts[i++] = vert;
-  }
-
-  Vec<float> vertPropD(vertProperties);
+  const VecView<const float> vertPos(vertProperties.data(),
+                                     vertProperties.size());
   Box bBox;
   for (const int i : {0, 1, 2}) {
-    strided_range<Vec<float>::Iter> iPos(vertPropD.begin() + i, vertPropD.end(),
-                                         numProp);
+    strided_range<const float*> iPos(vertPos.begin() + i,
+                                     vertPos.begin() + vertPos.size(),
+                                     numProp);
     auto minMax = transform_reduce<thrust::pair<float, float>>(
         autoPolicy(numVert), iPos.begin(), iPos.end(), Duplicate(),
         thrust::make_pair(std::numeric_limits<float>::infinity(),
@@ -571,33 +668,93 @@ bool MeshGL::Merge() {
   precision = MaxPrecision(precision, bBox);
   if (precision < 0) return false;
 
-  auto policy = autoPolicy(numOpenVert);
-  Vec<Box> vertBox(numOpenVert);
-  Vec<uint32_t> vertMorton(numOpenVert);
-
-  for_each_n(policy,
-             zip(vertMorton.begin(), vertBox.begin(), openVerts.cbegin()),
-             numOpenVert, VertMortonBox({vertPropD, numProp, precision, bBox}));
-
-  stable_sort(policy,
-              zip(vertMorton.begin(), vertBox.begin(), openVerts.begin()),
-              zip(vertMorton.end(), vertBox.end(), openVerts.end()),
-              [](const thrust::tuple<uint32_t, Box, int>& a,
-                 const thrust::tuple<uint32_t, Box, int>& b) {
+  // Hash the open verts into a grid of cells no smaller than precision, so
+  // that every vert within precision of another lies in one of the 27 cells
+  // around it. Cells grow for huge extents so that their indices fit the key.
+  const glm::vec3 size = bBox.Size();
+  const float cellSize = glm::max(
+      glm::max(precision, glm::max(size.x, glm::max(size.y, size.z)) /
+                              (kCellMax - 1)),
+      std::numeric_limits<float>::min());
+  const uint32_t nProp = numProp;
+  auto Pos = [vertPos, nProp](int vert) {
+    return glm::vec3(vertPos[nProp * vert], vertPos[nProp * vert + 1],
+                     vertPos[nProp * vert + 2]);
+  };
+  auto Cell = [&](int vert) {
+    return glm::ivec3(glm::floor((Pos(vert) - bBox.min) / cellSize));
+  };
+
+  policy = autoPolicy(numOpenVert);
+  Vec<Uint64> cellKey(numOpenVert);
+  for_each_n(policy, countAt(0), numOpenVert,
+             [&](int i) { cellKey[i] = CellKey(Cell(openVerts[i])); });
+  stable_sort(policy, zip(cellKey.begin(), openVerts.begin()),
+              zip(cellKey.end(), openVerts.end()),
+              [](const thrust::tuple<Uint64, int>& a,
+                 const thrust::tuple<Uint64, int>& b) {
                 return thrust::get<0>(a) < thrust::get<0>(b);
               });
 
-  Collider collider(vertBox, vertMorton);
-  SparseIndices toMerge = collider.Collisions<true>(vertBox.cview());
+  // Each occupied cell maps to the start of its run of sorted verts.
+  HashTable<int> cellStart(2 * numOpenVert);
+  HashTableD<int> cellStartD = cellStart.D();
+  for_each_n(policy, countAt(0), numOpenVert, [&](int i) {
+    if (i == 0 || cellKey[i - 1] != cellKey[i])
+      cellStartD.Insert(cellKey[i], i);
+  });
+
+  // Visits each pair of open verts within precision once, calling
+  // f(i, j) with sorted indices i < j.
+  auto ForNeighbors = [&](int i, auto f) {
+    const glm::vec3 pos = Pos(openVerts[i]);
+    const glm::ivec3 cell = Cell(openVerts[i]);
+    for (const int x : {-1, 0, 1})
+      for (const int y : {-1, 0, 1})
+        for (const int z : {-1, 0, 1}) {
+          const glm::ivec3 nCell = cell + glm::ivec3(x, y, z);
+          if (glm::any(glm::lessThan(nCell, glm::ivec3(0))) ||
+              glm::any(glm::greaterThan(nCell, glm::ivec3(kCellMax))))
+            continue;
+          const Uint64 key = CellKey(nCell);
+          // An empty cell gives an unused slot, whose value is 0.
+          const int start = cellStartD[key];
+          for (int j = start; j < numOpenVert && cellKey[j] == key; ++j) {
+            if (j <= i) continue;
+            const glm::vec3 diff = glm::abs(Pos(openVerts[j]) - pos);
+            if (glm::all(glm::lessThanEqual(diff, glm::vec3(precision))))
+              f(i, j);
+          }
+        }
+  };
+
+  Vec<int> pairOffset(numOpenVert + 1, 0);
+  for_each_n(policy, countAt(0), numOpenVert, [&](int i) {
+    int count = 0;
+    ForNeighbors(i, [&count](int, int) { ++count; });
+    pairOffset[i + 1] = count;
+  });
+  inclusive_scan(policy, pairOffset.begin(), pairOffset.end(),
+                 pairOffset.begin());
+  const int numPair = pairOffset[numOpenVert];
+  Vec<int> pairFrom(numPair);
+  Vec<int> pairTo(numPair);
+  for_each_n(policy, countAt(0), numOpenVert, [&](int i) {
+    int k = pairOffset[i];
+    ForNeighbors(i, [&](int a, int b) {
+      pairFrom[k] = openVerts[a];
+      pairTo[k] = openVerts[b];
+      ++k;
+    });
+  });
 
   UnionFind<> uf(numVert);
   for (int i = 0; i < mergeFromVert.size(); ++i) {
     uf.unionXY(static_cast<int>(mergeFromVert[i]),
                static_cast<int>(mergeToVert[i]));
   }
-  for (int i = 0; i < toMerge.size(); ++i) {
-    uf.unionXY(openVerts[toMerge.Get(i, false)],
-               openVerts[toMerge.Get(i, true)]);
+  for (int i = 0; i < numPair; ++i) {
+    uf.unionXY(pairFrom[i], pairTo[i]);
   }
 
   mergeToVert.clear();
@@ -31,6 +31,8 @@ using namespace manifold;
 static ExecutionParams params;
 
 constexpr float kBest = -std::numeric_limits<float>::infinity();
+// Polygons with fewer verts check every ear against all of them.
+constexpr int kGridMinVerts = 64;
 
 #ifdef MANIFOLD_DEBUG
 struct PolyEdge {
@@ -161,7 +163,8 @@ void PrintFailure(const std::exception &e, const PolygonsIdx &polys,
  * fallback that ensures a manifold triangulation even for overlapping polygons.
  * This is an O(n^2) algorithm, but hopefully this is not a big problem as the
  * number of edges in a given polygon is generally much less than the number of
- * triangles in a mesh, and relatively few faces even need triangulation.
+ * triangles in a mesh, and relatively few faces even need triangulation. Large
+ * polygons use a grid so each ear is only checked against its neighborhood.
  *
  * The main adjustments for robustness involve clipping the sharpest ears first
  * (a known technique to get higher triangle quality), and doing an exhaustive
@@ -222,6 +225,74 @@ class EarClip {
   };
   typedef std::set<VertItr, MinCost>::iterator qItr;
 
+  // A uniform grid over the verts of the polygon being triangulated, with
+  // roughly one vert per cell, so that each ear only needs to be checked
+  // against the verts near it. Verts are stored per cell in one flat array.
+  // Clipped verts are not removed; they are skipped by the caller.
+  class VertGrid {
+   public:
+    void Build(const std::vector<VertItr> &verts) {
+      const int n = verts.size();
+      bBox_ = Rect();
+      for (const VertItr v : verts) bBox_.Union(v->pos);
+      const glm::vec2 size = bBox_.Size();
+      cellSize_ = glm::max(glm::sqrt(size.x * size.y / n),
+                           glm::max(size.x, size.y) / n);
+      dim_ = cellSize_ > 0 ? glm::min(glm::ivec2(size / cellSize_) + 1, n)
+                           : glm::ivec2(1);
+
+      cellStart_.assign(dim_.x * dim_.y + 1, 0);
+      for (const VertItr v : verts) ++cellStart_[Cell(v->pos) + 1];
+      std::partial_sum(cellStart_.begin(), cellStart_.end(),
+                       cellStart_.begin());
+      std::vector<int> fill(cellStart_.begin(), cellStart_.end() - 1);
+      verts_.resize(n);
+      for (const VertItr v : verts) verts_[fill[Cell(v->pos)]++] = v;
+    }
+
+    void Clear() {
+      verts_.clear();
+      cellStart_.clear();
+    }
+
+    bool Empty() const { return verts_.empty(); }
+
+    // Apply func to every vert in the cells overlapping box.
+    template <typename Func>
+    void ForEach(const Rect &box, Func func) const {
+      const glm::ivec2 min = CellIdx(box.min);
+      const glm::ivec2 max = CellIdx(box.max);
+      for (int y = min.y; y <= max.y; ++y) {
+        for (int x = min.x; x <= max.x; ++x) {
+          const int cell = y * dim_.x + x;
+          for (int i = cellStart_[cell]; i < cellStart_[cell + 1]; ++i) {
+            func(verts_[i]);
+          }
+        }
+      }
+    }
+
+   private:
+    Rect bBox_;
+    float cellSize_;
+    glm::ivec2 dim_;
+    std::vector<int> cellStart_;
+    std::vector<VertItr> verts_;
+
+    glm::ivec2 CellIdx(glm::vec2 pos) const {
+      if (cellSize_ <= 0) return glm::ivec2(0);
+      // clamp before the cast, so far-away queries don't overflow
+      const glm::vec2 idx = glm::clamp((pos - bBox_.min) / cellSize_,
+                                       glm::vec2(0), glm::vec2(dim_ - 1));
+      return glm::ivec2(idx);
+    }
+
+    int Cell(glm::vec2 pos) const {
+      const glm::ivec2 idx = CellIdx(pos);
+      return idx.y * dim_.x + idx.x;
+    }
+  };
+
   // The flat list where all the Verts are stored. Not used much for traversal.
   std::vector<Vert> polygon_;
   // The set of right-most starting points, one for each negative-area contour.
@@ -238,6 +309,8 @@ class EarClip {
   std::vector<glm::ivec3> triangles_;
   // Working precision: max of float error and input value.
   float precision_;
+  // Spatial index of the polygon being triangulated; empty for small ones.
+  VertGrid grid_;
 
   // A circularly-linked list representing the polygon(s) that still need to be
   // triangulated. This gets smaller as ears are clipped until it degenerates to
@@ -403,9 +476,10 @@ class EarClip {
     }
 
     // This is the O(n^2) part of the algorithm, checking this ear against every
-    // Vert to ensure none are inside. It may be possible to improve performance
-    // by using the Collider to get it down to nlogn or doing some
-    // parallelization, but that may be more trouble than it's worth.
+    // Vert to ensure none are inside. For large polygons the grid limits this
+    // to the Verts near the ear: only those within precision of the triangle
+    // can be invalid and only those within the Delaunay circle can raise the
+    // cost, so the result is the same as checking them all.
     //
     // Think of a cost as vaguely a distance metric - 0 is right on the edge of
     // being invalid. cost > precision is definitely invalid. Cost < -precision
@@ -413,10 +487,11 @@ class EarClip {
     // values < -precision so they will never affect validity. The first
     // totalCost is designed to give priority to sharper angles. Any cost < (-1
     // - precision) has satisfied the Delaunay condition.
-    float EarCost(float precision) const {
+    float EarCost(float precision, const VertGrid &grid) const {
       glm::vec2 openSide = left->pos - right->pos;
       const glm::vec2 center = 0.5f * (left->pos + right->pos);
       const float scale = 4 / glm::dot(openSide, openSide);
+      const float length = glm::length(openSide);
       openSide = glm::normalize(openSide);
 
       float totalCost = glm::dot(left->rightDir, rightDir) - 1 - precision;
@@ -424,8 +499,8 @@ class EarClip {
         // Clip folded ears first
         return totalCost < -1 ? kBest : 0;
       }
-      VertItr test = right->right;
-      while (test != left) {
+
+      auto AddCost = [&](VertItr test) {
         if (test->mesh_idx != mesh_idx && test->mesh_idx != left->mesh_idx &&
             test->mesh_idx != right->mesh_idx) {  // Skip duplicated verts
           float cost = Cost(test, openSide, precision);
@@ -434,8 +509,32 @@ class EarClip {
           }
           totalCost = glm::max(totalCost, cost);
         }
-
-        test = test->right;
+      };
+
+      // Offsetting the sides by precision moves each corner by precision /
+      // sin(angle / 2), which is 2 * precision / |a - b| for the unit vectors
+      // a, b along its sides.
+      const float minChord = glm::min(
+          glm::length(rightDir + left->rightDir),
+          glm::min(glm::length(openSide + rightDir),
+                   glm::length(openSide + left->rightDir)));
+      const float margin = 2 * precision / minChord;
+      // Delaunay costs below the starting totalCost can't matter.
+      const float radius = length * glm::sqrt(0.5f);
+      Rect box(center - radius, center + radius);
+      box.Union(pos);
+      box.min -= margin;
+      box.max += margin;
+
+      if (grid.Empty() || !glm::isfinite(margin)) {
+        for (VertItr test = right->right; test != left; test = test->right) {
+          AddCost(test);
+        }
+      } else {
+        grid.ForEach(box, [&](VertItr test) {
+          // clipped Verts have been unlinked by their neighbors
+          if (test->right->left == test) AddCost(test);
+        });
       }
       return totalCost;
     }
@@ -735,7 +834,7 @@ class EarClip {
       v->cost = kBest;
       v->ear = earsQueue_.insert(v);
     } else if (v->IsConvex(precision_)) {
-      v->cost = v->EarCost(precision_);
+      v->cost = v->EarCost(precision_, grid_);
       v->ear = earsQueue_.insert(v);
     }
   }
@@ -755,6 +854,17 @@ class EarClip {
       v->PrintVert();
     };
 
+    std::vector<VertItr> verts;
+    if (Loop(start, [&verts](VertItr v) { verts.push_back(v); }) ==
+        polygon_.end()) {
+      return;
+    }
+    if (static_cast<int>(verts.size()) > kGridMinVerts) {
+      grid_.Build(verts);
+    } else {
+      grid_.Clear();
+    }
+
     VertItr v = Loop(start, QueueVert);
     if (v == polygon_.end()) return;
     Dump(v);
@@ -800,6 +910,142 @@ class EarClip {
 #endif
   }
 };
+
+// The sweep order: by y, then by x.
+bool Below(glm::vec2 a, glm::vec2 b) {
+  return a.y < b.y || (a.y == b.y && a.x < b.x);
+}
+
+/**
+ * Linear-time triangulation of a single y-monotone contour, which includes
+ * every convex one, skipping the EarClip data structures that dominate for the
+ * simple faces of extrusions and revolutions. Convex polygons become a fan,
+ * other monotone ones use the classic stack sweep from bottom to top. Returns
+ * no triangles if the polygon doesn't qualify, or if any triangle came out CW
+ * beyond precision (e.g. for self-overlapping input), in which case the caller
+ * falls back to EarClip. Like EarClip, a negative precision is replaced by the
+ * working precision.
+ */
+std::vector<glm::ivec3> TriangulateMonotone(const PolygonsIdx &polys,
+                                            float &precision) {
+  std::vector<glm::ivec3> triangles;
+  if (polys.size() != 1) return triangles;
+  const SimplePolygonIdx &poly = polys[0];
+  const int n = poly.size();
+  if (n < 3) return triangles;
+  auto Next = [n](int i) { return i + 1 == n ? 0 : i + 1; };
+  auto Prev = [n](int i) { return i == 0 ? n - 1 : i - 1; };
+
+  int bottom = 0;
+  int top = 0;
+  float bound = 0;
+  for (int i = 0; i < n; ++i) {
+    const glm::vec2 pos = poly[i].pos;
+    bound = glm::max(bound, glm::max(glm::abs(pos.x), glm::abs(pos.y)));
+    if (Below(pos, poly[bottom].pos)) bottom = i;
+    if (Below(poly[top].pos, pos)) top = i;
+  }
+  if (precision < 0) precision = bound * kTolerance;
+
+  // Walking CCW, the right chain rises from bottom to top and the left chain
+  // falls back down; anything else is not monotone.
+  for (int i = bottom; i != top; i = Next(i)) {
+    if (!Below(poly[i].pos, poly[Next(i)].pos)) return triangles;
+  }
+  for (int i = top; i != bottom; i = Next(i)) {
+    if (!Below(poly[Next(i)].pos, poly[i].pos)) return triangles;
+  }
+
+  bool convex = true;
+  for (int i = 0; i < n && convex; ++i) {
+    convex = CCW(poly[Prev(i)].pos, poly[i].pos, poly[Next(i)].pos,
+                 precision) > 0;
+  }
+
+  // Local indices into poly until they are checked.
+  std::vector<glm::ivec3> local;
+  local.reserve(n - 2);
+  auto AddTri = [&local](glm::ivec3 tri) { local.push_back(tri); };
+
+  if (convex) {
+    for (int i = Next(bottom); Next(i) != bottom; i = Next(i)) {
+      AddTri({bottom, i, Next(i)});
+    }
+  } else {
+    // Merge the chains into sweep order.
+    std::vector<int> sorted;
+    sorted.reserve(n);
+    std::vector<bool> onRight(n, false);
+    sorted.push_back(bottom);
+    int right = Next(bottom);
+    int left = Prev(bottom);
+    while (right != top || left != top) {
+      if (left == top ||
+          (right != top && Below(poly[right].pos, poly[left].pos))) {
+        onRight[right] = true;
+        sorted.push_back(right);
+        right = Next(right);
+      } else {
+        sorted.push_back(left);
+        left = Prev(left);
+      }
+    }
+    sorted.push_back(top);
+
+    // The CCW triangle of the stack pair (lower, upper), which lie on the
+    // given chain, and the apex above them.
+    auto Tri = [](int lower, int upper, int apex, bool isRight) {
+      return isRight ? glm::ivec3(lower, upper, apex)
+                     : glm::ivec3(upper, lower, apex);
+    };
+
+    std::vector<int> stack = {sorted[0], sorted[1]};
+    auto StackSize = [&stack]() { return static_cast<int>(stack.size()); };
+    for (int j = 2; j < n - 1; ++j) {
+      const int v = sorted[j];
+      const bool isRight = onRight[stack.back()];
+      if (onRight[v] != isRight) {
+        // Across the polygon, every stack vert is visible.
+        for (int k = 0; k + 1 < StackSize(); ++k) {
+          AddTri(Tri(stack[k], stack[k + 1], v, isRight));
+        }
+        stack = {stack.back(), v};
+      } else {
+        // Along the same chain, clip while the ears are convex.
+        int last = stack.back();
+        stack.pop_back();
+        while (!stack.empty()) {
+          const glm::ivec3 tri = Tri(stack.back(), last, v, isRight);
+          if (CCW(poly[tri[0]].pos, poly[tri[1]].pos, poly[tri[2]].pos,
+                  precision) <= 0) {
+            break;
+          }
+          AddTri(tri);
+          last = stack.back();
+          stack.pop_back();
+        }
+        stack.push_back(last);
+        stack.push_back(v);
+      }
+    }
+    const bool isRight = onRight[stack.back()];
+    for (int k = 0; k + 1 < StackSize(); ++k) {
+      AddTri(Tri(stack[k], stack[k + 1], top, isRight));
+    }
+  }
+
+  for (const glm::ivec3 &tri : local) {
+    if (CCW(poly[tri[0]].pos, poly[tri[1]].pos, poly[tri[2]].pos,
+            precision) < 0) {
+      return triangles;
+    }
+  }
+  triangles.reserve(local.size());
+  for (const glm::ivec3 &tri : local) {
+    triangles.push_back({poly[tri[0]].idx, poly[tri[1]].idx, poly[tri[2]].idx});
+  }
+  return triangles;
+}
 }  // namespace
 
 namespace manifold {
@@ -821,13 +1067,18 @@ std::vector<glm::ivec3> TriangulateIdx(const PolygonsIdx &polys,
                                        float precision) {
   std::vector<glm::ivec3> triangles;
   try {
-    EarClip triangulator(polys, precision);
-    triangles = triangulator.Triangulate();
+    float workingPrecision = precision;
+    triangles = TriangulateMonotone(polys, workingPrecision);
+    if (triangles.empty()) {
+      EarClip triangulator(polys, precision);
+      triangles = triangulator.Triangulate();
+      workingPrecision = triangulator.GetPrecision();
+    }
 #ifdef MANIFOLD_DEBUG
     if (params.intermediateChecks) {
       CheckTopology(triangles, polys);
       if (!params.processOverlaps) {
-        CheckGeometry(triangles, polys, 2 * triangulator.GetPrecision());
+        CheckGeometry(triangles, polys, 2 * workingPrecision);
       }
     }
   } catch (const geometryErr &e) {
@@ -17,8 +17,21 @@
 #include <functional>
 
 #include "public.h"
+#include "sdf_expr.h"
+#include "vec_view.h"
 
 namespace manifold {
 Mesh LevelSet(std::function<float(glm::vec3)> sdf, Box bounds, float edgeLength,
+              float level = 0, bool canParallel = true, float lipschitz = 0);
+Mesh LevelSet(
+    std::function<void(VecView<const glm::vec3>, VecView<float>)> sdf,
+    Box bounds, float edgeLength, float level = 0, float lipschitz = 0);
+Mesh LevelSet(const SDFExpr& sdf, Box bounds, float edgeLength,
               float level = 0, bool canParallel = true);
+std::vector<Mesh> LevelSets(std::function<float(glm::vec3)> sdf, Box bounds,
+                            float edgeLength, const std::vector<float>& levels,
+                            bool canParallel = true);
+Mesh LevelSetTiled(std::function<float(glm::vec3)> sdf, Box bounds,
+                   float edgeLength, float level = 0, int tileLength = 64,
+                   bool canParallel = true);
 }
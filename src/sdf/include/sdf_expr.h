@@ -0,0 +1,87 @@
+// Copyright 2024 The Manifold Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <memory>
+
+#include "public.h"
+#include "vec_view.h"
+
+namespace manifold {
+
+/** @addtogroup Core
+ *  @{
+ */
+
+/**
+ * A signed-distance function built as an expression graph of primitives,
+ * transforms and CSG operations, rather than as an opaque function, so that
+ * LevelSet can evaluate it natively over batches of points and bound it over
+ * whole blocks of the grid. As with LevelSet, positive values are inside.
+ *
+ * Every primitive and operation keeps the function 1-Lipschitz, i.e. it never
+ * overestimates the distance to its surface, which is what makes the bounds
+ * of Range() conservative. SDFExpr is immutable and cheap to copy; shared
+ * subexpressions are shared, not copied.
+ */
+class SDFExpr {
+ public:
+  /** @name Primitives
+   *  All are centered on the origin.
+   */
+  ///@{
+  static SDFExpr Sphere(float radius);
+  static SDFExpr Cube(glm::vec3 size);
+  static SDFExpr Cylinder(float height, float radius);
+  static SDFExpr Torus(float majorRadius, float minorRadius);
+  static SDFExpr HalfSpace(glm::vec3 normal, float offset = 0);
+  ///@}
+
+  /** @name Transforms
+   */
+  ///@{
+  SDFExpr Translate(glm::vec3 v) const;
+  SDFExpr Rotate(float xDegrees, float yDegrees = 0.0f,
+                 float zDegrees = 0.0f) const;
+  SDFExpr Scale(float factor) const;
+  SDFExpr Repeat(glm::vec3 period) const;
+  ///@}
+
+  /** @name Combination
+   *  A positive smoothness blends the surfaces over roughly that distance.
+   */
+  ///@{
+  SDFExpr Union(const SDFExpr& other, float smoothness = 0) const;
+  SDFExpr Intersect(const SDFExpr& other, float smoothness = 0) const;
+  SDFExpr Subtract(const SDFExpr& other, float smoothness = 0) const;
+  SDFExpr Offset(float delta) const;
+  ///@}
+
+  /** @name Evaluation
+   */
+  ///@{
+  float operator()(glm::vec3 point) const;
+  void Evaluate(VecView<const glm::vec3> points, VecView<float> values,
+                bool canParallel = true) const;
+  glm::vec2 Range(const Box& box) const;
+  ///@}
+
+  struct Node;
+
+ private:
+  explicit SDFExpr(std::shared_ptr<const Node> node);
+  std::shared_ptr<const Node> node_;
+};
+/** @} */
+}  // namespace manifold
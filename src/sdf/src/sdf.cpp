@@ -14,6 +14,10 @@
 
 #include "sdf.h"
 
+#include <array>
+#include <unordered_map>
+#include <vector>
+
 #include "hashtable.h"
 #include "par.h"
 #include "utils.h"
@@ -122,11 +126,35 @@ struct GridVert {
   }
 };
 
+// Evaluates a pointwise SDF at a grid point.
+struct PointSDF {
+  const std::function<float(glm::vec3)>& sdf;
+
+  float operator()(glm::ivec4, glm::vec3 position) const {
+    return sdf(position);
+  }
+};
+
+// Reads the SDF at a grid point from the values batch-evaluated over the
+// block starting at lo, padded by one grid point on every side.
+struct BlockSDF {
+  const float* values;
+  const glm::ivec3 lo;
+  const int width;
+
+  float operator()(glm::ivec4 gridIndex, glm::vec3) const {
+    const glm::ivec3 i = glm::ivec3(gridIndex) - lo + 1;
+    return values[2 * ((i.z * (width + 2) + i.y) * (width + 2) + i.x) +
+                  gridIndex.w];
+  }
+};
+
+template <typename SDF>
 struct ComputeVerts {
   VecView<glm::vec3> vertPos;
   VecView<int> vertIndex;
   HashTableD<GridVert, identity> gridVerts;
-  const std::function<float(glm::vec3)> sdf;
+  const SDF sdf;
   const glm::vec3 origin;
   const glm::ivec3 gridSize;
   const glm::vec3 spacing;
@@ -138,7 +166,7 @@ struct ComputeVerts {
   }
 
   inline float BoundedSDF(glm::ivec4 gridIndex) const {
-    const float d = sdf(Position(gridIndex)) - level;
+    const float d = sdf(gridIndex, Position(gridIndex)) - level;
 
     const glm::ivec3 xyz(gridIndex);
     const bool onLowerBound = glm::any(glm::lessThanEqual(xyz, glm::ivec3(0)));
@@ -187,10 +215,121 @@ struct ComputeVerts {
   }
 };
 
+// grid points per axis of a leaf block, as a power of two
+constexpr int kLeafBits = 3;
+// larger blocks for batches, so their padding costs fewer extra points
+constexpr int kBatchBits = 4;
+// points per call of a batch SDF, roughly
+constexpr int kBatchPoints = 1 << 20;
+// Morton codes visited between checks of the hash table's room
+constexpr Uint64 kChunkCodes = 1 << 16;
+
+Uint64 BlockCodes(int bits) { return Uint64(1) << (3 * bits + 1); }
+
+// The grid layout shared by the passes of LevelSet.
+struct Grid {
+  glm::vec3 origin;
+  // the largest grid index along each axis
+  glm::ivec3 gridSize;
+  glm::vec3 spacing;
+  float level;
+  Uint64 maxMorton;
+  ExecutionPolicy policy;
+
+  glm::vec3 Position(glm::ivec4 gridIndex) const {
+    return origin +
+           spacing * (glm::vec3(gridIndex) + (gridIndex.w == 1 ? 0.0f : -0.5f));
+  }
+
+  bool Outside(glm::ivec3 lo) const {
+    return glm::any(glm::greaterThan(lo, gridSize));
+  }
+};
+
+using BatchSDF =
+    std::function<void(VecView<const glm::vec3>, VecView<float>)>;
+// fills a conservative (min, max) of the SDF over each box
+using RangeSDF = std::function<void(VecView<const Box>, VecView<glm::vec2>)>;
+
+/**
+ * The first Morton codes of the blocks of 2^leafBits grid points per axis
+ * that may hold part of the level set. A block is an aligned run of Morton
+ * codes, covering a cube of both grids. Blocks are refined from the whole
+ * grid down to leaves, dropping every block whose range over itself and the
+ * edges to its neighbors can't reach the level. The ranges of each round are
+ * found in one batch.
+ */
+std::vector<Uint64> NarrowBandBlocks(const RangeSDF& range, const Grid& grid,
+                                     int leafBits) {
+  ZoneScoped;
+  int topBits = leafBits;
+  while ((1 << topBits) <= glm::compMax(grid.gridSize)) ++topBits;
+
+  std::vector<Uint64> blocks(1, 0);
+  for (int bits = topBits;; --bits) {
+    const int numBlock = blocks.size();
+    const int width = 1 << bits;
+    // the positions of both grids over each block, padded by the edges to
+    // their neighbors
+    Vec<Box> boxes(numBlock);
+    for_each_n(grid.policy, countAt(0), numBlock, [&](int i) {
+      const glm::vec3 lo(DecodeMorton(blocks[i]));
+      boxes[i] = {grid.origin + grid.spacing * (lo - 1.5f),
+                  grid.origin + grid.spacing * (lo + float(width))};
+    });
+    Vec<glm::vec2> ranges(numBlock);
+    range(boxes, ranges);
+
+    std::vector<Uint64> kept;
+    for (int i = 0; i < numBlock; ++i) {
+      const glm::ivec3 lo(DecodeMorton(blocks[i]));
+      if (grid.Outside(lo)) continue;
+      const glm::vec2 d = ranges[i] - grid.level;
+      // the bounds clamp the inside to zero, which makes surface there
+      const bool onBound =
+          glm::any(glm::lessThanEqual(lo, glm::ivec3(1))) ||
+          glm::any(glm::greaterThanEqual(lo + width, grid.gridSize - 1));
+      if ((d[0] <= 0 && d[1] >= 0) || (d[1] > 0 && onBound))
+        kept.push_back(blocks[i]);
+    }
+    if (bits == leafBits) return kept;
+
+    const int numKept = kept.size();
+    const Uint64 childCodes = BlockCodes(bits - 1);
+    blocks.resize(8 * numKept);
+    for_each_n(grid.policy, countAt(0), 8 * numKept, [&](int i) {
+      blocks[i] = kept[i / 8] + (i % 8) * childCodes;
+    });
+  }
+}
+
+/**
+ * Ranges from the Lipschitz bound: the SDF at the center of each box, give
+ * or take as much as it can change over the half-diagonal.
+ */
+RangeSDF LipschitzRange(BatchSDF sdf, ExecutionPolicy policy, float lipschitz) {
+  return [sdf, policy, lipschitz](VecView<const Box> boxes,
+                                  VecView<glm::vec2> ranges) {
+    const int numBox = boxes.size();
+    Vec<glm::vec3> centers(numBox);
+    for_each_n(policy, countAt(0), numBox,
+               [&](int i) { centers[i] = boxes[i].Center(); });
+    Vec<float> values(numBox);
+    sdf(centers, values);
+    for_each_n(policy, countAt(0), numBox, [&](int i) {
+      const float radius = lipschitz * glm::length(boxes[i].Size()) / 2;
+      ranges[i] = {values[i] - radius, values[i] + radius};
+    });
+  };
+}
+
 struct BuildTris {
   VecView<glm::ivec3> triVerts;
   VecView<int> triIndex;
   const HashTableD<GridVert, identity> gridVerts;
+  // only grid verts within these grid indices build triangles
+  glm::ivec3 tileMin = glm::ivec3(0);
+  glm::ivec3 tileMax = glm::ivec3(std::numeric_limits<int>::max());
 
   void CreateTri(const glm::ivec3& tri, const int edges[6]) {
     if (tri[0] < 0) return;
@@ -212,6 +351,10 @@ struct BuildTris {
 
     const GridVert& base = gridVerts.At(idx);
     const glm::ivec4 baseIndex = DecodeMorton(basekey);
+    const glm::ivec3 xyz(baseIndex);
+    if (glm::any(glm::lessThan(xyz, tileMin)) ||
+        glm::any(glm::greaterThan(xyz, tileMax)))
+      return;
 
     glm::ivec4 leadIndex = baseIndex;
     if (leadIndex.w == 0)
@@ -268,6 +411,166 @@ struct BuildTris {
     }
   }
 };
+
+Grid MakeGrid(Box bounds, float edgeLength, float level) {
+  const glm::vec3 dim = bounds.Size();
+  const glm::ivec3 gridSize(dim / edgeLength);
+  const glm::vec3 spacing = dim / (glm::vec3(gridSize));
+  const Uint64 maxMorton = MortonCode(glm::ivec4(gridSize + 1, 1));
+  // serial within a SerialScope, see canParallel
+  const ExecutionPolicy policy = autoPolicy(maxMorton, KernelCost::Heavy);
+  return {bounds.min, gridSize + 1, spacing, level, maxMorton, policy};
+}
+
+struct GridVerts {
+  HashTable<GridVert, identity> table;
+  Vec<glm::vec3> vertPos;
+};
+
+/**
+ * Grows the table, if it lacks room for a grid vert at every one of the next
+ * numCode codes, so that visiting them can never fill it. The first numVert
+ * verts are kept.
+ */
+void MakeRoom(GridVerts& found, int numVert, Uint64 numCode) {
+  HashTable<GridVert, identity>& gridVerts = found.table;
+  const Uint64 room = 2 * (gridVerts.Entries() + numCode) + 1;
+  if (room <= static_cast<Uint64>(gridVerts.Size())) return;
+  gridVerts.Resize(glm::max(room, 2 * static_cast<Uint64>(gridVerts.Size())));
+  Vec<glm::vec3> vertPos(gridVerts.Size() * 7);
+  copy(autoPolicy(numVert, KernelCost::Trivial), found.vertPos.begin(),
+       found.vertPos.begin() + numVert, vertPos.begin());
+  found.vertPos = std::move(vertPos);
+}
+
+/**
+ * Calls computeVerts(vertPos, vertIndex, gridVerts, start, end) on
+ * consecutive ranges of its numCode codes, returning the grid verts it found.
+ * Room is made before each range, so every grid point is evaluated exactly
+ * once.
+ */
+template <typename F>
+GridVerts FindGridVerts(int tableSize, Uint64 numCode, Uint64 chunkCodes,
+                        F computeVerts) {
+  GridVerts found{HashTable<GridVert, identity>(tableSize), {}};
+  found.vertPos = Vec<glm::vec3>(found.table.Size() * 7);
+  Vec<int> index(1, 0);
+
+  for (Uint64 start = 0; start < numCode; start += chunkCodes) {
+    if (Cancellation::Check()) break;
+    const Uint64 end = glm::min(numCode, start + chunkCodes);
+    MakeRoom(found, index[0], end - start);
+    computeVerts(found.vertPos, index, found.table.D(), start, end);
+  }
+  found.vertPos.resize(index[0]);
+  return found;
+}
+
+// Joins the grid verts into triangles.
+Mesh BuildMesh(const Grid& grid, GridVerts& found) {
+  Vec<glm::ivec3> triVerts(found.table.Entries() * 12);  // worst case
+
+  Vec<int> triIndex(1, 0);
+  for_each_n(grid.policy, countAt(0), found.table.Size(),
+             BuildTris({triVerts, triIndex, found.table.D()}));
+  triVerts.resize(triIndex[0]);
+
+  Mesh out;
+  out.vertPos.insert(out.vertPos.end(), found.vertPos.begin(),
+                     found.vertPos.end());
+  out.triVerts.insert(out.triVerts.end(), triVerts.begin(), triVerts.end());
+  return out;
+}
+
+template <typename F>
+Mesh MarchGrid(const Grid& grid, int tableSize, Uint64 numCode,
+               Uint64 chunkCodes, F computeVerts) {
+  GridVerts found = FindGridVerts(tableSize, numCode, chunkCodes, computeVerts);
+  // a partial grid would leave holes, so a cancelled march gives nothing
+  if (Cancellation::Check()) return Mesh();
+  return BuildMesh(grid, found);
+}
+
+constexpr int kBatchWidth = 1 << kBatchBits;
+constexpr int kBatchPadded =
+    2 * (kBatchWidth + 2) * (kBatchWidth + 2) * (kBatchWidth + 2);
+
+// All the batch blocks that hold some of the grid.
+std::vector<Uint64> GridBlocks(const Grid& grid) {
+  std::vector<Uint64> blocks;
+  const Uint64 blockCodes = BlockCodes(kBatchBits);
+  for (Uint64 code = 0; code <= grid.maxMorton; code += blockCodes)
+    if (!grid.Outside(glm::ivec3(DecodeMorton(code)))) blocks.push_back(code);
+  return blocks;
+}
+
+// The padded positions of the numBlock batch blocks from start, in the layout
+// read back by BlockSDF.
+void BlockPoints(const Grid& grid, const std::vector<Uint64>& blocks,
+                 int start, int numBlock, VecView<glm::vec3> points) {
+  constexpr int side = kBatchWidth + 2;
+  for_each_n(grid.policy, countAt(0), numBlock * kBatchPadded, [&](int i) {
+    const int padded = i % kBatchPadded;
+    const int xyz = padded / 2;
+    glm::ivec4 gridIndex(DecodeMorton(blocks[start + i / kBatchPadded]));
+    gridIndex += glm::ivec4(xyz % side - 1, (xyz / side) % side - 1,
+                            xyz / side / side - 1, padded % 2);
+    points[i] = grid.Position(gridIndex);
+  });
+}
+
+// Finds the grid verts of the numBlock batch blocks from start, at the given
+// level of their padded SDF values.
+void BlockVerts(const Grid& grid, const std::vector<Uint64>& blocks, int start,
+                int numBlock, VecView<const float> values, float level,
+                VecView<glm::vec3> vertPos, VecView<int> index,
+                HashTableD<GridVert, identity> gridVerts) {
+  const Uint64 blockCodes = BlockCodes(kBatchBits);
+  for_each_n(grid.policy, countAt(0), numBlock * blockCodes, [&](Uint64 i) {
+    const int block = i / blockCodes;
+    const Uint64 code = blocks[start + block];
+    ComputeVerts<BlockSDF> computeVerts(
+        {vertPos, index, gridVerts,
+         {values.data() + block * kBatchPadded, glm::ivec3(DecodeMorton(code)),
+          kBatchWidth},
+         grid.origin, grid.gridSize, grid.spacing, level});
+    computeVerts(code + i % blockCodes);
+  });
+}
+
+int InitialTableSize(const Grid& grid, Uint64 numCode) {
+  const int tableSize =
+      glm::min(2 * grid.maxMorton,
+               static_cast<Uint64>(10 * glm::pow(grid.maxMorton, 0.667)));
+  // the surface crosses at most every grid point visited
+  return glm::max(static_cast<int>(glm::min<Uint64>(numCode, tableSize)), 1);
+}
+
+// Marches the given batch blocks, evaluating a chunk of them per batch.
+Mesh MarchBlocks(const BatchSDF& sdf, const Grid& grid,
+                 const std::vector<Uint64>& blocks) {
+  const Uint64 blockCodes = BlockCodes(kBatchBits);
+  const int numBlock = blocks.size();
+  const int chunk = glm::max(1, kBatchPoints / kBatchPadded);
+
+  // each range of MarchGrid is one chunk of blocks, evaluated in one batch
+  Vec<glm::vec3> points(glm::min(chunk, numBlock) * kBatchPadded);
+  Vec<float> values(points.size());
+  return MarchGrid(
+      grid, InitialTableSize(grid, numBlock * blockCodes),
+      numBlock * blockCodes, chunk * blockCodes,
+      [&](VecView<glm::vec3> vertPos, VecView<int> index,
+          HashTableD<GridVert, identity> gridVerts, Uint64 startCode,
+          Uint64 endCode) {
+        const int start = startCode / blockCodes;
+        const int numChunk = (endCode - startCode) / blockCodes;
+        const int numPoint = numChunk * kBatchPadded;
+        BlockPoints(grid, blocks, start, numChunk, points);
+        sdf(points.cview(0, numPoint), values.view(0, numPoint));
+        BlockVerts(grid, blocks, start, numChunk, values, grid.level, vertPos,
+                   index, gridVerts);
+      });
+}
 }  // namespace
 
 namespace manifold {
@@ -297,64 +600,305 @@ namespace manifold {
  * @param canParallel Parallel policies violate will crash language runtimes
  * with runtime locks that expect to not be called back by unregistered threads.
  * This allows bindings use LevelSet despite being compiled with MANIFOLD_PAR
- * active.
+ * active. Setting it false is the same as running in an ExecutionContext with
+ * a maxConcurrency of one, see RunInContext().
+ * @param lipschitz If positive, a bound on how fast the SDF can change with
+ * distance, e.g. 1 for a true distance field. The grid is then refined from
+ * coarse blocks, skipping those that can't reach the level, so the cost scales
+ * with the surface area rather than the volume of the bounds. If the bound is
+ * wrong, parts of the surface may go missing.
  * @return Mesh This class does not depend on Manifold, so it just returns a
  * Mesh, but it is guaranteed to be manifold and so can always be used as
- * input to the Manifold constructor for further operations.
+ * input to the Manifold constructor for further operations. It is empty if
+ * stopped through an ExecutionContext.
  */
 Mesh LevelSet(std::function<float(glm::vec3)> sdf, Box bounds, float edgeLength,
-              float level, bool canParallel) {
-  Mesh out;
+              float level, bool canParallel, float lipschitz) {
+  SerialScope serial(!canParallel);
+  const Grid grid = MakeGrid(bounds, edgeLength, level);
+
+  if (lipschitz <= 0) {
+    return MarchGrid(
+        grid, InitialTableSize(grid, grid.maxMorton + 1), grid.maxMorton + 1,
+        kChunkCodes,
+        [&](VecView<glm::vec3> vertPos, VecView<int> index,
+            HashTableD<GridVert, identity> gridVerts, Uint64 start,
+            Uint64 end) {
+          for_each_n(grid.policy, countAt(start), end - start,
+                     ComputeVerts<PointSDF>(
+                         {vertPos, index, gridVerts, {sdf}, grid.origin,
+                          grid.gridSize, grid.spacing, level}));
+        });
+  }
 
-  const glm::vec3 dim = bounds.Size();
-  const glm::ivec3 gridSize(dim / edgeLength);
-  const glm::vec3 spacing = dim / (glm::vec3(gridSize));
+  const std::vector<Uint64> blocks = NarrowBandBlocks(
+      LipschitzRange(
+          [&](VecView<const glm::vec3> points, VecView<float> values) {
+            for_each_n(grid.policy, countAt(0), points.size(),
+                       [&](int i) { values[i] = sdf(points[i]); });
+          },
+          grid.policy, lipschitz),
+      grid, kLeafBits);
+  const Uint64 leafCodes = BlockCodes(kLeafBits);
+  const Uint64 numCode = blocks.size() * leafCodes;
+  return MarchGrid(
+      grid, InitialTableSize(grid, numCode), numCode, kChunkCodes,
+      [&](VecView<glm::vec3> vertPos, VecView<int> index,
+          HashTableD<GridVert, identity> gridVerts, Uint64 start, Uint64 end) {
+        ComputeVerts<PointSDF> computeVerts({vertPos, index, gridVerts, {sdf},
+                                             grid.origin, grid.gridSize,
+                                             grid.spacing, level});
+        for_each_n(grid.policy, countAt(start), end - start, [&](Uint64 i) {
+          computeVerts(blocks[i / leafCodes] + i % leafCodes);
+        });
+      });
+}
 
-  const Uint64 maxMorton = MortonCode(glm::ivec4(gridSize + 1, 1));
+/**
+ * Constructs a level-set Mesh from a batch SDF, which is handed the grid
+ * points in Morton-contiguous blocks, so that it may be vectorized, or cross
+ * into another language once per block instead of once per point. It is
+ * always called from the calling thread, while the rest of the work may be
+ * parallel. Each block is padded by one grid point on every side, so some
+ * points are evaluated more than once. See the pointwise LevelSet for the
+ * remaining parameters.
+ *
+ * @param sdf The signed-distance functor, containing this function signature:
+ * `void operator()(VecView<const glm::vec3> points, VecView<float> values)`,
+ * which writes the signed distance of each point to the value of the same
+ * index. Positive values are inside, negative outside.
+ * @param bounds An axis-aligned box that defines the extent of the grid.
+ * @param edgeLength Approximate maximum edge length of the triangles in the
+ * final result.
+ * @param level You can inset your Mesh by using a positive value, or outset
+ * it with a negative value.
+ * @param lipschitz If positive, a bound on how fast the SDF can change with
+ * distance, which skips the blocks that can't reach the level.
+ */
+Mesh LevelSet(
+    std::function<void(VecView<const glm::vec3>, VecView<float>)> sdf,
+    Box bounds, float edgeLength, float level, float lipschitz) {
+  const Grid grid = MakeGrid(bounds, edgeLength, level);
+  const std::vector<Uint64> blocks =
+      lipschitz > 0
+          ? NarrowBandBlocks(LipschitzRange(sdf, grid.policy, lipschitz), grid,
+                             kBatchBits)
+          : GridBlocks(grid);
+  return MarchBlocks(sdf, grid, blocks);
+}
 
-  // Parallel policies violate will crash language runtimes with runtime locks
-  // that expect to not be called back by unregistered threads. This allows
-  // bindings use LevelSet despite being compiled with MANIFOLD_PAR
-  // active.
-  const auto pol = canParallel ? autoPolicy(maxMorton) : ExecutionPolicy::Seq;
+/**
+ * Constructs a level-set Mesh from an SDFExpr, which is evaluated natively in
+ * batches. Its conservative ranges over blocks of the grid skip every block
+ * that can't reach the level, so the cost scales with the surface area rather
+ * than the volume of the bounds, with no Lipschitz bound to supply. See the
+ * pointwise LevelSet for the remaining parameters.
+ *
+ * @param sdf The expression graph of the signed-distance function.
+ * @param canParallel Set false to run on the calling thread only. The SDFExpr
+ * makes no callbacks, so this is rarely needed.
+ */
+Mesh LevelSet(const SDFExpr& sdf, Box bounds, float edgeLength, float level,
+              bool canParallel) {
+  SerialScope serial(!canParallel);
+  const Grid grid = MakeGrid(bounds, edgeLength, level);
+  const bool parallel = grid.policy == ExecutionPolicy::Par;
+  const std::vector<Uint64> blocks = NarrowBandBlocks(
+      [&](VecView<const Box> boxes, VecView<glm::vec2> ranges) {
+        for_each_n(grid.policy, countAt(0), boxes.size(),
+                   [&](int i) { ranges[i] = sdf.Range(boxes[i]); });
+      },
+      grid, kBatchBits);
+  return MarchBlocks(
+      [&](VecView<const glm::vec3> points, VecView<float> values) {
+        sdf.Evaluate(points, values, parallel);
+      },
+      grid, blocks);
+}
 
-  int tableSize = glm::min(
-      2 * maxMorton, static_cast<Uint64>(10 * glm::pow(maxMorton, 0.667)));
-  HashTable<GridVert, identity> gridVerts(tableSize);
-  Vec<glm::vec3> vertPos(gridVerts.Size() * 7);
+/**
+ * Constructs a level-set Mesh of the same SDF at each of several levels, e.g.
+ * for graded shells. The SDF is sampled once for all of them, over padded
+ * blocks as in the batch LevelSet, so the grid points on the seams of blocks
+ * are sampled a few more times. See LevelSet for the remaining parameters.
+ *
+ * @param levels The levels to extract, see level in LevelSet.
+ * @return One Mesh per level, in the same order.
+ */
+std::vector<Mesh> LevelSets(std::function<float(glm::vec3)> sdf, Box bounds,
+                            float edgeLength, const std::vector<float>& levels,
+                            bool canParallel) {
+  SerialScope serial(!canParallel);
+  const Grid grid = MakeGrid(bounds, edgeLength, 0);
+  const Uint64 blockCodes = BlockCodes(kBatchBits);
+  const std::vector<Uint64> blocks = GridBlocks(grid);
+  const int numBlock = blocks.size();
+  const int numLevel = levels.size();
+  const int chunk = glm::max(1, kBatchPoints / kBatchPadded);
+
+  std::vector<GridVerts> found;
+  std::vector<Vec<int>> index;
+  for (int l = 0; l < numLevel; ++l) {
+    found.push_back({HashTable<GridVert, identity>(
+                         InitialTableSize(grid, numBlock * blockCodes)),
+                     {}});
+    found[l].vertPos = Vec<glm::vec3>(found[l].table.Size() * 7);
+    index.push_back(Vec<int>(1, 0));
+  }
 
-  while (1) {
-    Vec<int> index(1, 0);
-    for_each_n(pol, countAt(0), maxMorton + 1,
-               ComputeVerts({vertPos, index, gridVerts.D(), sdf, bounds.min,
-                             gridSize + 1, spacing, level}));
-
-    if (gridVerts.Full()) {  // Resize HashTable
-      const glm::vec3 lastVert = vertPos[index[0] - 1];
-      const Uint64 lastMorton =
-          MortonCode(glm::ivec4((lastVert - bounds.min) / spacing, 1));
-      const float ratio = static_cast<float>(maxMorton) / lastMorton;
-      if (ratio > 1000)  // do not trust the ratio if it is too large
-        tableSize *= 2;
-      else
-        tableSize *= ratio;
-      gridVerts = HashTable<GridVert, identity>(tableSize);
-      vertPos = Vec<glm::vec3>(gridVerts.Size() * 7);
-    } else {  // Success
-      vertPos.resize(index[0]);
-      break;
+  Vec<glm::vec3> points(glm::min(chunk, numBlock) * kBatchPadded);
+  Vec<float> values(points.size());
+  for (int start = 0; start < numBlock; start += chunk) {
+    if (Cancellation::Check()) return std::vector<Mesh>(numLevel);
+    const int numChunk = glm::min(chunk, numBlock - start);
+    BlockPoints(grid, blocks, start, numChunk, points);
+    for_each_n(grid.policy, countAt(0), numChunk * kBatchPadded,
+               [&](int i) { values[i] = sdf(points[i]); });
+    for (int l = 0; l < numLevel; ++l) {
+      MakeRoom(found[l], index[l][0], numChunk * blockCodes);
+      BlockVerts(grid, blocks, start, numChunk, values, levels[l],
+                 found[l].vertPos, index[l], found[l].table.D());
     }
   }
 
-  Vec<glm::ivec3> triVerts(gridVerts.Entries() * 12);  // worst case
-
-  Vec<int> index(1, 0);
-  for_each_n(pol, countAt(0), gridVerts.Size(),
-             BuildTris({triVerts, index, gridVerts.D()}));
-  triVerts.resize(index[0]);
+  std::vector<Mesh> meshes;
+  for (int l = 0; l < numLevel; ++l) {
+    found[l].vertPos.resize(index[l][0]);
+    meshes.push_back(BuildMesh(grid, found[l]));
+  }
+  return meshes;
+}
 
-  out.vertPos.insert(out.vertPos.end(), vertPos.begin(), vertPos.end());
-  out.triVerts.insert(out.triVerts.end(), triVerts.begin(), triVerts.end());
+/**
+ * Constructs a level-set Mesh like LevelSet, but one cubic tile of the grid
+ * at a time, so the grid's working memory is bounded by the size of a tile
+ * rather than of the whole grid. Each tile evaluates its own grid verts along
+ * with a seam one grid point wide of its neighbors', and emits the triangles
+ * of its own grid verts. Verts within a grid point of a tile's boundary are shared with
+ * its neighbors through a table keyed by the grid vert and edge that own
+ * them, so the tiles stitch into one manifold Mesh. An entry is dropped once
+ * the last tile that can reach it is done, so the table holds about one layer
+ * of tiles' seams rather than all of them. Seam grid points are evaluated once
+ * by each tile touching them. See LevelSet for the remaining parameters.
+ *
+ * @param tileLength The number of grid points along each side of a tile.
+ */
+Mesh LevelSetTiled(std::function<float(glm::vec3)> sdf, Box bounds,
+                   float edgeLength, float level, int tileLength,
+                   bool canParallel) {
+  SerialScope serial(!canParallel);
+  const Grid grid = MakeGrid(bounds, edgeLength, level);
+  const int tile = glm::max(tileLength, 1);
+  const int padded = tile + 2;
+  const Uint64 numCode = 2 * Uint64(padded) * padded * padded;
+
+  // tiles are visited in this order, x fastest
+  const glm::ivec3 numTiles = grid.gridSize / tile + 1;
+  auto tileIndex = [&numTiles](glm::ivec3 t) {
+    return (t.z * numTiles.y + t.y) * numTiles.x + t.x;
+  };
+
+  std::unordered_map<Uint64, std::array<int, 7>> seamVerts;
+  // keys of seamVerts, by the index of the last tile that can reach them
+  std::unordered_map<int, std::vector<Uint64>> expiring;
+  std::array<int, 7> noVerts;
+  noVerts.fill(-1);
+  Mesh out;
+  for (int z = 0; z <= grid.gridSize.z; z += tile) {
+    for (int y = 0; y <= grid.gridSize.y; y += tile) {
+      for (int x = 0; x <= grid.gridSize.x; x += tile) {
+        const glm::ivec3 lo(x, y, z);
+        const glm::ivec3 hi = glm::min(lo + tile - 1, grid.gridSize);
+        if (Cancellation::Check()) return Mesh();
+
+        // no tile from here on reaches the seam verts the previous tile was
+        // the last to reach
+        auto done = expiring.find(tileIndex(lo / tile) - 1);
+        if (done != expiring.end()) {
+          for (const Uint64 key : done->second) seamVerts.erase(key);
+          expiring.erase(done);
+        }
+        GridVerts found = FindGridVerts(
+            InitialTableSize(grid, numCode), numCode, kChunkCodes,
+            [&](VecView<glm::vec3> vertPos, VecView<int> index,
+                HashTableD<GridVert, identity> gridVerts, Uint64 start,
+                Uint64 end) {
+              ComputeVerts<PointSDF> computeVerts(
+                  {vertPos, index, gridVerts, {sdf}, grid.origin,
+                   grid.gridSize, grid.spacing, level});
+              for_each_n(grid.policy, countAt(start), end - start,
+                         [&](Uint64 i) {
+                           const int xyz = i / 2;
+                           const glm::ivec3 p =
+                               lo - 1 +
+                               glm::ivec3(xyz % padded, (xyz / padded) % padded,
+                                          xyz / padded / padded);
+                           if (glm::any(glm::lessThan(p, glm::ivec3(0))))
+                             return;
+                           computeVerts(MortonCode(glm::ivec4(p, i % 2)));
+                         });
+            });
+
+        Vec<glm::ivec3> triVerts(found.table.Entries() * 12);  // worst case
+        Vec<int> triIndex(1, 0);
+        for_each_n(grid.policy, countAt(0), found.table.Size(),
+                   BuildTris({triVerts, triIndex, found.table.D(), lo, hi}));
+        triVerts.resize(triIndex[0]);
+        if (triVerts.empty()) continue;
+
+        // the grid vert and edge that own each vert
+        HashTableD<GridVert, identity> gridVerts = found.table.D();
+        Vec<Uint64> owner(found.vertPos.size());
+        Vec<int> ownerEdge(found.vertPos.size());
+        for_each_n(grid.policy, countAt(0), found.table.Size(), [&](int i) {
+          const Uint64 key = gridVerts.KeyAt(i);
+          if (key == kOpen) return;
+          const GridVert& gridVert = gridVerts.At(i);
+          for (int edge = 0; edge < 7; ++edge) {
+            const int vert = gridVert.edgeVerts[edge];
+            if (vert < 0) continue;
+            owner[vert] = key;
+            ownerEdge[vert] = edge;
+          }
+        });
+
+        std::vector<int> local2global(found.vertPos.size(), -1);
+        for (const glm::ivec3& tri : triVerts) {
+          glm::ivec3 globalTri;
+          for (const int j : {0, 1, 2}) {
+            const int vert = tri[j];
+            int& global = local2global[vert];
+            if (global < 0) {
+              const glm::ivec3 p(DecodeMorton(owner[vert]));
+              // no other tile's seam reaches the interior
+              if (glm::all(glm::greaterThan(p, lo)) &&
+                  glm::all(glm::lessThan(p, hi))) {
+                global = out.vertPos.size();
+                out.vertPos.push_back(found.vertPos[vert]);
+              } else {
+                auto [entry, added] =
+                    seamVerts.try_emplace(owner[vert], noVerts);
+                if (added) {
+                  // a tile evaluates the grid points up to one past its own
+                  const glm::ivec3 last =
+                      glm::min((p + 1) / tile, numTiles - 1);
+                  expiring[tileIndex(last)].push_back(owner[vert]);
+                }
+                int& shared = entry->second[ownerEdge[vert]];
+                if (shared < 0) {
+                  shared = out.vertPos.size();
+                  out.vertPos.push_back(found.vertPos[vert]);
+                }
+                global = shared;
+              }
+            }
+            globalTri[j] = global;
+          }
+          out.triVerts.push_back(globalTri);
+        }
+      }
+    }
+  }
   return out;
 }
 /** @} */
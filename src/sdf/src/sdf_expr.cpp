@@ -0,0 +1,631 @@
+// Copyright 2024 The Manifold Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "sdf_expr.h"
+
+#include <mutex>
+#include <vector>
+
+#include "par.h"
+#include "utils.h"
+
+namespace manifold {
+
+enum class SDFOp {
+  // primitives, from a point register to a value register
+  Sphere,
+  Cube,
+  Cylinder,
+  Torus,
+  HalfSpace,
+  // domain transforms, from a point register to a point register
+  Translate,
+  Rotate,
+  Scale,
+  Repeat,
+  // from value registers to a value register
+  Union,
+  Intersect,
+  Subtract,
+  Offset,
+  Multiply,
+};
+
+/**
+ * One instruction of a compiled SDFExpr. Its parameters are read from the
+ * node it was compiled from.
+ */
+struct SDFInstr {
+  SDFOp op;
+  int out;
+  int a;
+  int b;
+  const SDFExpr::Node* node;
+};
+
+/**
+ * The flattened form of an expression graph: a list of instructions over
+ * numbered point and value registers, with the input point in point register
+ * zero.
+ */
+struct SDFTape {
+  std::vector<SDFInstr> instrs;
+  int numPoint = 1;
+  int numValue = 0;
+  int result = -1;
+};
+
+struct SDFExpr::Node {
+  SDFOp op;
+  // size, normal, translation or period
+  glm::vec3 vec = glm::vec3(0.0f);
+  // from the parent's frame to this node's
+  glm::mat3 rotation = glm::mat3(1.0f);
+  // radii, height, offset, smoothness or scale factor
+  float a = 0;
+  float b = 0;
+  std::shared_ptr<const Node> left;
+  std::shared_ptr<const Node> right;
+
+  const SDFTape& Tape() const {
+    std::call_once(compiled_, [this]() {
+      tape_.result = Compile(this, 0, tape_);
+    });
+    return tape_;
+  }
+
+ private:
+  mutable std::once_flag compiled_;
+  mutable SDFTape tape_;
+
+  static int Compile(const Node* node, int point, SDFTape& tape) {
+    switch (node->op) {
+      case SDFOp::Translate:
+      case SDFOp::Rotate:
+      case SDFOp::Scale:
+      case SDFOp::Repeat: {
+        const int local = tape.numPoint++;
+        tape.instrs.push_back({node->op, local, point, -1, node});
+        const int value = Compile(node->left.get(), local, tape);
+        if (node->op != SDFOp::Scale) return value;
+        const int out = tape.numValue++;
+        tape.instrs.push_back({SDFOp::Multiply, out, value, -1, node});
+        return out;
+      }
+      case SDFOp::Union:
+      case SDFOp::Intersect:
+      case SDFOp::Subtract: {
+        const int a = Compile(node->left.get(), point, tape);
+        const int b = Compile(node->right.get(), point, tape);
+        const int out = tape.numValue++;
+        tape.instrs.push_back({node->op, out, a, b, node});
+        return out;
+      }
+      case SDFOp::Offset: {
+        const int a = Compile(node->left.get(), point, tape);
+        const int out = tape.numValue++;
+        tape.instrs.push_back({node->op, out, a, -1, node});
+        return out;
+      }
+      default: {
+        const int out = tape.numValue++;
+        tape.instrs.push_back({node->op, out, point, -1, node});
+        return out;
+      }
+    }
+  }
+};
+
+}  // namespace manifold
+
+namespace {
+using namespace manifold;
+
+// points per batch of the evaluator, in structure-of-arrays registers, so the
+// loop over them in each instruction can be vectorized
+constexpr int kLanes = 64;
+// points per parallel task
+constexpr int kTaskPoints = 1 << 10;
+
+// The polynomial smooth max of Inigo Quilez, which exceeds max(a, b) by at
+// most k / 4.
+inline float SmoothMax(float a, float b, float k) {
+  const float h = glm::max(k - glm::abs(a - b), 0.0f) / k;
+  return glm::max(a, b) + h * h * k * 0.25f;
+}
+
+inline float SmoothMin(float a, float b, float k) {
+  return -SmoothMax(-a, -b, k);
+}
+
+/**
+ * Register storage for evaluating a tape over a batch of up to kLanes points.
+ */
+struct Lanes {
+  std::vector<float> points;
+  std::vector<float> values;
+
+  explicit Lanes(const SDFTape& tape)
+      : points(3 * kLanes * tape.numPoint), values(kLanes * tape.numValue) {}
+
+  float* P(int reg, int axis) {
+    return points.data() + (3 * reg + axis) * kLanes;
+  }
+  float* V(int reg) { return values.data() + reg * kLanes; }
+};
+
+void Run(const SDFTape& tape, Lanes& lanes, const int n) {
+  for (const SDFInstr& instr : tape.instrs) {
+    const SDFExpr::Node& node = *instr.node;
+    const glm::vec3 vec = node.vec;
+    const float a = node.a;
+    const float b = node.b;
+    switch (instr.op) {
+      case SDFOp::Translate:
+        for (int axis : {0, 1, 2}) {
+          const float* in = lanes.P(instr.a, axis);
+          float* out = lanes.P(instr.out, axis);
+          for (int i = 0; i < n; ++i) out[i] = in[i] - vec[axis];
+        }
+        break;
+      case SDFOp::Rotate: {
+        const glm::mat3 r = node.rotation;
+        const float* x = lanes.P(instr.a, 0);
+        const float* y = lanes.P(instr.a, 1);
+        const float* z = lanes.P(instr.a, 2);
+        for (int axis : {0, 1, 2}) {
+          float* out = lanes.P(instr.out, axis);
+          for (int i = 0; i < n; ++i)
+            out[i] = r[0][axis] * x[i] + r[1][axis] * y[i] + r[2][axis] * z[i];
+        }
+        break;
+      }
+      case SDFOp::Scale:
+        for (int axis : {0, 1, 2}) {
+          const float* in = lanes.P(instr.a, axis);
+          float* out = lanes.P(instr.out, axis);
+          for (int i = 0; i < n; ++i) out[i] = in[i] / a;
+        }
+        break;
+      case SDFOp::Repeat:
+        for (int axis : {0, 1, 2}) {
+          const float* in = lanes.P(instr.a, axis);
+          float* out = lanes.P(instr.out, axis);
+          const float period = vec[axis];
+          if (period > 0) {
+            for (int i = 0; i < n; ++i)
+              out[i] = in[i] - period * glm::floor(in[i] / period + 0.5f);
+          } else {
+            for (int i = 0; i < n; ++i) out[i] = in[i];
+          }
+        }
+        break;
+      case SDFOp::Sphere: {
+        const float* x = lanes.P(instr.a, 0);
+        const float* y = lanes.P(instr.a, 1);
+        const float* z = lanes.P(instr.a, 2);
+        float* out = lanes.V(instr.out);
+        for (int i = 0; i < n; ++i)
+          out[i] = a - glm::sqrt(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+        break;
+      }
+      case SDFOp::Cube: {
+        const float* x = lanes.P(instr.a, 0);
+        const float* y = lanes.P(instr.a, 1);
+        const float* z = lanes.P(instr.a, 2);
+        float* out = lanes.V(instr.out);
+        for (int i = 0; i < n; ++i) {
+          const float qx = glm::abs(x[i]) - vec.x;
+          const float qy = glm::abs(y[i]) - vec.y;
+          const float qz = glm::abs(z[i]) - vec.z;
+          const float ox = glm::max(qx, 0.0f);
+          const float oy = glm::max(qy, 0.0f);
+          const float oz = glm::max(qz, 0.0f);
+          out[i] = -glm::sqrt(ox * ox + oy * oy + oz * oz) -
+                   glm::min(glm::max(qx, glm::max(qy, qz)), 0.0f);
+        }
+        break;
+      }
+      case SDFOp::Cylinder: {
+        const float* x = lanes.P(instr.a, 0);
+        const float* y = lanes.P(instr.a, 1);
+        const float* z = lanes.P(instr.a, 2);
+        float* out = lanes.V(instr.out);
+        for (int i = 0; i < n; ++i) {
+          const float dr = glm::sqrt(x[i] * x[i] + y[i] * y[i]) - b;
+          const float dz = glm::abs(z[i]) - a;
+          const float rad = glm::max(dr, 0.0f);
+          const float oz = glm::max(dz, 0.0f);
+          out[i] = -glm::sqrt(rad * rad + oz * oz) -
+                   glm::min(glm::max(dr, dz), 0.0f);
+        }
+        break;
+      }
+      case SDFOp::Torus: {
+        const float* x = lanes.P(instr.a, 0);
+        const float* y = lanes.P(instr.a, 1);
+        const float* z = lanes.P(instr.a, 2);
+        float* out = lanes.V(instr.out);
+        for (int i = 0; i < n; ++i) {
+          const float dr = glm::sqrt(x[i] * x[i] + y[i] * y[i]) - a;
+          out[i] = b - glm::sqrt(dr * dr + z[i] * z[i]);
+        }
+        break;
+      }
+      case SDFOp::HalfSpace: {
+        const float* x = lanes.P(instr.a, 0);
+        const float* y = lanes.P(instr.a, 1);
+        const float* z = lanes.P(instr.a, 2);
+        float* out = lanes.V(instr.out);
+        for (int i = 0; i < n; ++i)
+          out[i] = a - (vec.x * x[i] + vec.y * y[i] + vec.z * z[i]);
+        break;
+      }
+      case SDFOp::Union:
+      case SDFOp::Intersect:
+      case SDFOp::Subtract: {
+        const float* l = lanes.V(instr.a);
+        const float* r = lanes.V(instr.b);
+        float* out = lanes.V(instr.out);
+        if (instr.op == SDFOp::Union) {
+          if (a > 0) {
+            for (int i = 0; i < n; ++i) out[i] = SmoothMax(l[i], r[i], a);
+          } else {
+            for (int i = 0; i < n; ++i) out[i] = glm::max(l[i], r[i]);
+          }
+        } else {
+          const float sign = instr.op == SDFOp::Subtract ? -1.0f : 1.0f;
+          if (a > 0) {
+            for (int i = 0; i < n; ++i)
+              out[i] = SmoothMin(l[i], sign * r[i], a);
+          } else {
+            for (int i = 0; i < n; ++i) out[i] = glm::min(l[i], sign * r[i]);
+          }
+        }
+        break;
+      }
+      case SDFOp::Offset: {
+        const float* in = lanes.V(instr.a);
+        float* out = lanes.V(instr.out);
+        for (int i = 0; i < n; ++i) out[i] = in[i] + a;
+        break;
+      }
+      case SDFOp::Multiply: {
+        const float* in = lanes.V(instr.a);
+        float* out = lanes.V(instr.out);
+        for (int i = 0; i < n; ++i) out[i] = in[i] * a;
+        break;
+      }
+    }
+  }
+}
+
+/**
+ * Interval arithmetic over the same tape: point registers hold boxes and
+ * value registers hold (min, max) ranges. Primitives are bounded by their
+ * value at the center of the box, give or take its half-diagonal, which holds
+ * for any 1-Lipschitz function.
+ */
+glm::vec2 RunRange(const SDFTape& tape, const Box& box) {
+  std::vector<Box> points(tape.numPoint);
+  std::vector<glm::vec2> values(tape.numValue);
+  points[0] = box;
+  for (const SDFInstr& instr : tape.instrs) {
+    const SDFExpr::Node& node = *instr.node;
+    const glm::vec3 vec = node.vec;
+    const float a = node.a;
+    switch (instr.op) {
+      case SDFOp::Translate: {
+        const Box& in = points[instr.a];
+        points[instr.out] = {in.min - vec, in.max - vec};
+        break;
+      }
+      case SDFOp::Rotate: {
+        const Box& in = points[instr.a];
+        const glm::vec3 center = node.rotation * in.Center();
+        glm::mat3 absRotation = node.rotation;
+        for (int i : {0, 1, 2}) absRotation[i] = glm::abs(absRotation[i]);
+        const glm::vec3 half = absRotation * (in.Size() / 2.0f);
+        points[instr.out] = {center - half, center + half};
+        break;
+      }
+      case SDFOp::Scale: {
+        const Box& in = points[instr.a];
+        points[instr.out] = {in.min / a, in.max / a};
+        break;
+      }
+      case SDFOp::Repeat: {
+        Box out = points[instr.a];
+        for (int axis : {0, 1, 2}) {
+          const float period = vec[axis];
+          if (period <= 0) continue;
+          const float cell = glm::floor(out.min[axis] / period + 0.5f);
+          if (cell == glm::floor(out.max[axis] / period + 0.5f)) {
+            out.min[axis] -= cell * period;
+            out.max[axis] -= cell * period;
+          } else {
+            out.min[axis] = -period / 2;
+            out.max[axis] = period / 2;
+          }
+        }
+        points[instr.out] = out;
+        break;
+      }
+      case SDFOp::Sphere:
+      case SDFOp::Cube:
+      case SDFOp::Cylinder:
+      case SDFOp::Torus:
+      case SDFOp::HalfSpace: {
+        const Box& in = points[instr.a];
+        SDFTape single;
+        single.instrs.push_back({instr.op, 0, 0, -1, instr.node});
+        single.numValue = 1;
+        Lanes lanes(single);
+        const glm::vec3 center = in.Center();
+        for (int axis : {0, 1, 2}) lanes.P(0, axis)[0] = center[axis];
+        Run(single, lanes, 1);
+        const float radius = glm::length(in.Size()) / 2;
+        values[instr.out] = {lanes.V(0)[0] - radius, lanes.V(0)[0] + radius};
+        break;
+      }
+      case SDFOp::Union: {
+        const glm::vec2 l = values[instr.a];
+        const glm::vec2 r = values[instr.b];
+        glm::vec2 out(glm::max(l[0], r[0]), glm::max(l[1], r[1]));
+        if (a > 0) out[1] += a / 4;
+        values[instr.out] = out;
+        break;
+      }
+      case SDFOp::Intersect:
+      case SDFOp::Subtract: {
+        const glm::vec2 l = values[instr.a];
+        glm::vec2 r = values[instr.b];
+        if (instr.op == SDFOp::Subtract) r = glm::vec2(-r[1], -r[0]);
+        glm::vec2 out(glm::min(l[0], r[0]), glm::min(l[1], r[1]));
+        if (a > 0) out[0] -= a / 4;
+        values[instr.out] = out;
+        break;
+      }
+      case SDFOp::Offset:
+        values[instr.out] = values[instr.a] + a;
+        break;
+      case SDFOp::Multiply:
+        values[instr.out] = values[instr.a] * a;
+        break;
+    }
+  }
+  return values[tape.result];
+}
+
+std::shared_ptr<SDFExpr::Node> NewNode(SDFOp op) {
+  auto node = std::make_shared<SDFExpr::Node>();
+  node->op = op;
+  return node;
+}
+}  // namespace
+
+namespace manifold {
+
+SDFExpr::SDFExpr(std::shared_ptr<const Node> node) : node_(node) {}
+
+/**
+ * A sphere of the given radius.
+ */
+SDFExpr SDFExpr::Sphere(float radius) {
+  auto node = NewNode(SDFOp::Sphere);
+  node->a = radius;
+  return SDFExpr(node);
+}
+
+/**
+ * An axis-aligned box of the given size.
+ */
+SDFExpr SDFExpr::Cube(glm::vec3 size) {
+  auto node = NewNode(SDFOp::Cube);
+  node->vec = size / 2.0f;
+  return SDFExpr(node);
+}
+
+/**
+ * A cylinder along the Z-axis, of the given height and radius.
+ */
+SDFExpr SDFExpr::Cylinder(float height, float radius) {
+  auto node = NewNode(SDFOp::Cylinder);
+  node->a = height / 2;
+  node->b = radius;
+  return SDFExpr(node);
+}
+
+/**
+ * A torus about the Z-axis, whose tube of minorRadius circles the axis at
+ * majorRadius.
+ */
+SDFExpr SDFExpr::Torus(float majorRadius, float minorRadius) {
+  auto node = NewNode(SDFOp::Torus);
+  node->a = majorRadius;
+  node->b = minorRadius;
+  return SDFExpr(node);
+}
+
+/**
+ * Everything behind the plane dot(normal, p) = offset, i.e. on the opposite
+ * side from where the normal points.
+ *
+ * @param normal The outward normal of the plane, need not be unit length.
+ * @param offset The distance of the plane from the origin along the normal.
+ */
+SDFExpr SDFExpr::HalfSpace(glm::vec3 normal, float offset) {
+  auto node = NewNode(SDFOp::HalfSpace);
+  node->vec = glm::normalize(normal);
+  node->a = offset;
+  return SDFExpr(node);
+}
+
+/**
+ * Move this shape in space.
+ */
+SDFExpr SDFExpr::Translate(glm::vec3 v) const {
+  auto node = NewNode(SDFOp::Translate);
+  node->vec = v;
+  node->left = node_;
+  return SDFExpr(node);
+}
+
+/**
+ * Rotate this shape about the origin, with the same convention as
+ * Manifold::Rotate: first about the X-axis, then Y, then Z, in degrees.
+ */
+SDFExpr SDFExpr::Rotate(float xDegrees, float yDegrees, float zDegrees) const {
+  glm::mat3 rX(1.0f, 0.0f, 0.0f,                      //
+               0.0f, cosd(xDegrees), sind(xDegrees),  //
+               0.0f, -sind(xDegrees), cosd(xDegrees));
+  glm::mat3 rY(cosd(yDegrees), 0.0f, -sind(yDegrees),  //
+               0.0f, 1.0f, 0.0f,                       //
+               sind(yDegrees), 0.0f, cosd(yDegrees));
+  glm::mat3 rZ(cosd(zDegrees), sind(zDegrees), 0.0f,   //
+               -sind(zDegrees), cosd(zDegrees), 0.0f,  //
+               0.0f, 0.0f, 1.0f);
+  auto node = NewNode(SDFOp::Rotate);
+  // the inverse, which takes points into the frame of the shape
+  node->rotation = glm::transpose(rZ * rY * rX);
+  node->left = node_;
+  return SDFExpr(node);
+}
+
+/**
+ * Scale this shape uniformly about the origin, which keeps it a distance
+ * function.
+ *
+ * @param factor Must be positive.
+ */
+SDFExpr SDFExpr::Scale(float factor) const {
+  ASSERT(factor > 0, userErr, "SDFExpr scale factor must be positive.");
+  auto node = NewNode(SDFOp::Scale);
+  node->a = factor;
+  node->left = node_;
+  return SDFExpr(node);
+}
+
+/**
+ * Repeat this shape infinitely on a grid of the given period, centered on the
+ * origin. The shape should fit within one cell, centered on the origin, or it
+ * will be clipped by the cell walls.
+ *
+ * @param period The spacing along each axis; zero or negative leaves that
+ * axis unrepeated.
+ */
+SDFExpr SDFExpr::Repeat(glm::vec3 period) const {
+  auto node = NewNode(SDFOp::Repeat);
+  node->vec = period;
+  node->left = node_;
+  return SDFExpr(node);
+}
+
+/**
+ * The union of this shape and other, i.e. the max of their distances.
+ */
+SDFExpr SDFExpr::Union(const SDFExpr& other, float smoothness) const {
+  auto node = NewNode(SDFOp::Union);
+  node->a = smoothness;
+  node->left = node_;
+  node->right = other.node_;
+  return SDFExpr(node);
+}
+
+/**
+ * The intersection of this shape and other, i.e. the min of their distances.
+ */
+SDFExpr SDFExpr::Intersect(const SDFExpr& other, float smoothness) const {
+  auto node = NewNode(SDFOp::Intersect);
+  node->a = smoothness;
+  node->left = node_;
+  node->right = other.node_;
+  return SDFExpr(node);
+}
+
+/**
+ * This shape with other removed.
+ */
+SDFExpr SDFExpr::Subtract(const SDFExpr& other, float smoothness) const {
+  auto node = NewNode(SDFOp::Subtract);
+  node->a = smoothness;
+  node->left = node_;
+  node->right = other.node_;
+  return SDFExpr(node);
+}
+
+/**
+ * Grow this shape by delta, or shrink it if negative.
+ */
+SDFExpr SDFExpr::Offset(float delta) const {
+  auto node = NewNode(SDFOp::Offset);
+  node->a = delta;
+  node->left = node_;
+  return SDFExpr(node);
+}
+
+/**
+ * The signed distance at a single point. For many points, Evaluate is much
+ * faster.
+ */
+float SDFExpr::operator()(glm::vec3 point) const {
+  float value;
+  Evaluate(VecView<const glm::vec3>(&point, 1), VecView<float>(&value, 1),
+           false);
+  return value;
+}
+
+/**
+ * The signed distance at each of the points. The expression graph is compiled
+ * into a flat list of instructions on first use, which are then run over
+ * batches of points at a time.
+ *
+ * @param points The points to evaluate.
+ * @param values Filled with one value per point.
+ * @param canParallel Set false to stay on the calling thread, e.g. when called
+ * back from a language runtime that can't take other threads.
+ */
+void SDFExpr::Evaluate(VecView<const glm::vec3> points, VecView<float> values,
+                       bool canParallel) const {
+  ASSERT(points.size() == values.size(), userErr,
+         "SDFExpr::Evaluate needs one value per point.");
+  const SDFTape& tape = node_->Tape();
+  const int numTask = (points.size() + kTaskPoints - 1) / kTaskPoints;
+  SerialScope serial(!canParallel);
+  const ExecutionPolicy policy = autoPolicy(points.size(), KernelCost::Heavy);
+  for_each_n(policy, countAt(0), numTask, [&](int task) {
+    Lanes lanes(tape);
+    const int end = glm::min(points.size(), (task + 1) * kTaskPoints);
+    for (int start = task * kTaskPoints; start < end; start += kLanes) {
+      const int n = glm::min(kLanes, end - start);
+      for (int i = 0; i < n; ++i)
+        for (int axis : {0, 1, 2})
+          lanes.P(0, axis)[i] = points[start + i][axis];
+      Run(tape, lanes, n);
+      const float* result = lanes.V(tape.result);
+      for (int i = 0; i < n; ++i) values[start + i] = result[i];
+    }
+  });
+}
+
+/**
+ * A conservative bound on the values over the given box: the true range is
+ * always within it, though it may be wider.
+ *
+ * @return The (min, max) of the bound.
+ */
+glm::vec2 SDFExpr::Range(const Box& box) const {
+  return RunRange(node_->Tape(), box);
+}
+}  // namespace manifold
@@ -0,0 +1,128 @@
+// Copyright 2024 The Manifold Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <stdlib.h>
+
+#include <algorithm>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace manifold {
+
+/** @addtogroup Private
+ *  @{
+ */
+
+/**
+ * Bump allocator for short-lived buffers. Memory is handed out from a list of
+ * growing blocks and only returned to the system when the arena is destroyed;
+ * freeing merely rolls back the most recent allocation. While an Arena::Scope
+ * is alive, every Vec allocated on that thread draws from its arena, and each
+ * Vec remembers where its buffer came from, so buffers may be freed from any
+ * thread - but never after the arena is gone.
+ */
+class Arena {
+ public:
+  Arena() {}
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  ~Arena() {
+    for (auto& block : blocks_) free(block.first);
+  }
+
+  void* Allocate(size_t bytes) {
+    bytes = Align(bytes);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (bytes > remaining_) {
+      const size_t blockSize = std::max(bytes, 2 * lastBlockSize_);
+      char* block = reinterpret_cast<char*>(malloc(blockSize));
+      if (block == nullptr) throw std::bad_alloc();
+      blocks_.push_back({block, blockSize});
+      lastBlockSize_ = blockSize;
+      reserved_ += blockSize;
+      next_ = block;
+      remaining_ = blockSize;
+    }
+    void* ptr = next_;
+    next_ += bytes;
+    remaining_ -= bytes;
+    inUse_ += bytes;
+    total_ += bytes;
+    peak_ = std::max(peak_, inUse_);
+    return ptr;
+  }
+
+  void Deallocate(void* ptr, size_t bytes) {
+    bytes = Align(bytes);
+    std::lock_guard<std::mutex> lock(mutex_);
+    inUse_ -= bytes;
+    // the last allocation can be reclaimed
+    if (reinterpret_cast<char*>(ptr) + bytes == next_) {
+      next_ -= bytes;
+      remaining_ += bytes;
+    }
+  }
+
+  /// Bytes currently allocated and not yet freed.
+  size_t InUse() const { return inUse_; }
+  /// Maximum of InUse() over the lifetime of the arena.
+  size_t Peak() const { return peak_; }
+  /// Sum of all allocations over the lifetime of the arena.
+  size_t Total() const { return total_; }
+  /// Bytes obtained from the system.
+  size_t Reserved() const { return reserved_; }
+
+  /// The arena of the innermost Scope on this thread, or nullptr.
+  static Arena* Current() { return current_; }
+
+  /**
+   * Makes the given arena current on this thread for the lifetime of the
+   * Scope. Scopes nest.
+   */
+  class Scope {
+   public:
+    Scope(Arena* arena) : previous_(current_) { current_ = arena; }
+    ~Scope() { current_ = previous_; }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    Arena* previous_;
+  };
+
+ private:
+  static constexpr size_t kAlignment = 16;
+  static constexpr size_t kFirstBlockSize = 1 << 16;
+
+  static size_t Align(size_t bytes) {
+    return (bytes + kAlignment - 1) & ~(kAlignment - 1);
+  }
+
+  std::mutex mutex_;
+  std::vector<std::pair<char*, size_t>> blocks_;
+  char* next_ = nullptr;
+  size_t remaining_ = 0;
+  size_t lastBlockSize_ = kFirstBlockSize / 2;
+  size_t inUse_ = 0;
+  size_t peak_ = 0;
+  size_t total_ = 0;
+  size_t reserved_ = 0;
+
+  static inline thread_local Arena* current_ = nullptr;
+};
+/** @} */
+}  // namespace manifold
@@ -0,0 +1,215 @@
+// Copyright 2024 The Manifold Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <stdlib.h>
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "public.h"
+
+namespace manifold {
+
+/** @addtogroup Private
+ *  @{
+ */
+
+/**
+ * Process-wide source of Vec buffers. Every buffer is obtained from the
+ * configured BufferAllocator (malloc/free by default) and carries a small
+ * header recording its true size and the allocator it came from, so it is
+ * always returned to that allocator even if another has been set since.
+ * Buffers of at least kMinPooled bytes can be recycled through size-class free
+ * lists when pooling is enabled, instead of going back to the system, which
+ * saves the repeated allocate/free/zero cycles of back-to-back Booleans.
+ *
+ * Size classes are spaced a quarter of a power of two apart, so a pooled
+ * buffer wastes at most 25% of its size.
+ */
+class BufferPool {
+ public:
+  static BufferPool& Get() {
+    // never destroyed, so buffers of static objects can still be freed at exit
+    static BufferPool* pool = new BufferPool();
+    return *pool;
+  }
+
+  BufferPool(const BufferPool&) = delete;
+  BufferPool& operator=(const BufferPool&) = delete;
+
+  /**
+   * Replaces the allocator; safe at any time. Outstanding buffers go back to
+   * the allocator they came from when they are freed, and pooled buffers are
+   * released to it right away. Each allocator that has been set stays
+   * allocated for the life of the process, since any block may refer to it.
+   */
+  void SetAllocator(const BufferAllocator& allocator) {
+    const BufferAllocator* next = new BufferAllocator(allocator);
+    std::vector<std::vector<char*>> blocks;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      blocks.swap(free_);
+      pooled_ = 0;
+      allocator_.store(next, std::memory_order_release);
+    }
+    Release(blocks);
+  }
+
+  BufferAllocator GetAllocator() {
+    return *allocator_.load(std::memory_order_acquire);
+  }
+
+  void* Allocate(size_t bytes) {
+    const BufferAllocator* allocator =
+        allocator_.load(std::memory_order_acquire);
+    size_t blockBytes = bytes + kHeader;
+    if (bytes >= kMinPooled && allocator->poolSize > 0) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      // the free lists only hold blocks of the allocator current under the
+      // lock
+      allocator = allocator_.load(std::memory_order_relaxed);
+      if (allocator->poolSize > 0) {
+        blockBytes = ClassBytes(blockBytes);
+        const size_t sizeClass = ClassIndex(blockBytes);
+        if (sizeClass < free_.size() && !free_[sizeClass].empty()) {
+          char* block = free_[sizeClass].back();
+          free_[sizeClass].pop_back();
+          pooled_ -= BlockBytes(block);
+          return block + kHeader;
+        }
+      }
+    }
+    char* block =
+        reinterpret_cast<char*>(SystemAllocate(*allocator, blockBytes));
+    *reinterpret_cast<size_t*>(block) = blockBytes;
+    *reinterpret_cast<const BufferAllocator**>(block + sizeof(size_t)) =
+        allocator;
+    return block + kHeader;
+  }
+
+  /// bytes must be the value that was passed to Allocate for this ptr.
+  void Deallocate(void* ptr, size_t bytes) {
+    char* block = reinterpret_cast<char*>(ptr) - kHeader;
+    const size_t blockBytes = BlockBytes(block);
+    const BufferAllocator* owner = BlockOwner(block);
+    if (bytes >= kMinPooled) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (owner == allocator_.load(std::memory_order_relaxed) &&
+          pooled_ + blockBytes <= owner->poolSize) {
+        // File the block under the largest class it can satisfy; blocks that
+        // were not rounded up on allocation land one class lower.
+        size_t classBytes = ClassBytes(blockBytes);
+        if (classBytes > blockBytes) classBytes = PreviousClass(classBytes);
+        const size_t sizeClass = ClassIndex(classBytes);
+        if (sizeClass >= free_.size()) free_.resize(sizeClass + 1);
+        free_[sizeClass].push_back(block);
+        pooled_ += blockBytes;
+        return;
+      }
+    }
+    SystemDeallocate(*owner, block, blockBytes);
+  }
+
+  /// Returns all pooled buffers to the allocator.
+  void Release() {
+    std::vector<std::vector<char*>> blocks;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      blocks.swap(free_);
+      pooled_ = 0;
+    }
+    Release(blocks);
+  }
+
+  /// Bytes currently held in the free lists.
+  size_t Pooled() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pooled_;
+  }
+
+ private:
+  static constexpr size_t kMinPooled = 1 << 12;
+  // the block size and owning allocator, keeping the payload 16-byte aligned
+  static constexpr size_t kHeader = 16;
+  static_assert(sizeof(size_t) + sizeof(BufferAllocator*) <= kHeader,
+                "block header overflow");
+
+  BufferPool() : allocator_(new BufferAllocator()) {}
+
+  static size_t BlockBytes(char* block) {
+    return *reinterpret_cast<size_t*>(block);
+  }
+
+  static const BufferAllocator* BlockOwner(char* block) {
+    return *reinterpret_cast<const BufferAllocator**>(block + sizeof(size_t));
+  }
+
+  static void Release(const std::vector<std::vector<char*>>& blocks) {
+    for (auto& list : blocks)
+      for (char* block : list)
+        SystemDeallocate(*BlockOwner(block), block, BlockBytes(block));
+  }
+
+  static int Log2(size_t bytes) {
+    int k = 0;
+    while ((bytes >> (k + 1)) != 0) ++k;
+    return k;
+  }
+
+  // Rounds up to the next multiple of a quarter of the leading power of two.
+  static size_t ClassBytes(size_t bytes) {
+    const size_t step = size_t(1) << (Log2(bytes) - 2);
+    return (bytes + step - 1) & ~(step - 1);
+  }
+
+  static size_t PreviousClass(size_t classBytes) {
+    const int k = Log2(classBytes);
+    const size_t step = size_t(1) << (k - 2);
+    // the class below 2^k is 7/8 of it, with the step of the lower octave
+    return classBytes == (size_t(1) << k) ? classBytes - step / 2
+                                          : classBytes - step;
+  }
+
+  static size_t ClassIndex(size_t classBytes) {
+    const int k = Log2(classBytes);
+    return (k - Log2(kMinPooled)) * 4 + (classBytes >> (k - 2)) - 4;
+  }
+
+  static void* SystemAllocate(const BufferAllocator& allocator, size_t bytes) {
+    void* ptr = allocator.allocate == nullptr
+                    ? malloc(bytes)
+                    : allocator.allocate(bytes, allocator.context);
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+  }
+
+  static void SystemDeallocate(const BufferAllocator& allocator, void* ptr,
+                               size_t bytes) {
+    if (allocator.deallocate == nullptr)
+      free(ptr);
+    else
+      allocator.deallocate(ptr, bytes, allocator.context);
+  }
+
+  std::mutex mutex_;
+  // guarded by mutex_ for writes; never freed, as blocks point to it
+  std::atomic<const BufferAllocator*> allocator_;
+  std::vector<std::vector<char*>> free_;
+  size_t pooled_ = 0;
+};
+/** @} */
+}  // namespace manifold
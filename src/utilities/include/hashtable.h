@@ -126,7 +126,8 @@ class HashTable {
   HashTable(uint32_t size, uint32_t step = 1)
       : keys_{1 << (int)ceil(log2(size)), kOpen},
         values_{1 << (int)ceil(log2(size)), {}},
-        table_{keys_, values_, used_, step} {}
+        table_{keys_, values_, used_, step},
+        step_{step} {}
 
   HashTableD<V, H> D() { return table_; }
 
@@ -142,6 +143,22 @@ class HashTable {
 
   Vec<V>& GetValueStore() { return values_; }
 
+  /**
+   * Grows the table to hold at least size slots, reinserting every entry in
+   * parallel. Must not run concurrently with inserts.
+   */
+  void Resize(uint32_t size) {
+    if (size <= static_cast<uint32_t>(Size())) return;
+    HashTable<V, H> bigger(size, step_);
+    HashTableD<V, H> from = table_;
+    HashTableD<V, H> to = bigger.D();
+    for_each_n(autoPolicy(Size()), countAt(0), Size(), [&](int i) {
+      const Uint64 key = from.KeyAt(i);
+      if (key != kOpen) to.Insert(key, from.At(i));
+    });
+    *this = std::move(bigger);
+  }
+
   static Uint64 Open() { return kOpen; }
 
  private:
@@ -149,6 +166,7 @@ class HashTable {
   Vec<V> values_;
   Vec<uint32_t> used_ = Vec<uint32_t>(1, 0);
   HashTableD<V, H> table_;
+  uint32_t step_;
 };
 
 /** @} */
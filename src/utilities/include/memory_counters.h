@@ -0,0 +1,114 @@
+// Copyright 2024 The Manifold Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <atomic>
+
+#include "public.h"
+
+namespace manifold {
+
+/** @addtogroup Private
+ *  @{
+ */
+
+/**
+ * Process-wide byte counters of live Vec buffers, one set per
+ * MemoryCategory plus a running total. Updated with relaxed atomics on every
+ * allocation and free, so they are cheap enough to stay always on: each set
+ * has a cache line of its own, so threads working on different categories
+ * don't contend, and the peak is only written when it is exceeded.
+ */
+class MemoryCounters {
+ public:
+  static MemoryCounters& Get() {
+    // never destroyed, so buffers of static objects can still be freed at exit
+    static MemoryCounters* counters = new MemoryCounters();
+    return *counters;
+  }
+
+  void Allocate(MemoryCategory category, size_t bytes) {
+    Add(counter_[Index(category)], bytes, true);
+    Add(counter_[kTotal], bytes, true);
+  }
+
+  void Free(MemoryCategory category, size_t bytes) {
+    counter_[Index(category)].bytes.fetch_sub(bytes, std::memory_order_relaxed);
+    counter_[kTotal].bytes.fetch_sub(bytes, std::memory_order_relaxed);
+  }
+
+  /// Moves the accounting of a live buffer to another category.
+  void Transfer(MemoryCategory from, MemoryCategory to, size_t bytes) {
+    if (from == to || bytes == 0) return;
+    counter_[Index(from)].bytes.fetch_sub(bytes, std::memory_order_relaxed);
+    Add(counter_[Index(to)], bytes, false);
+  }
+
+  MemoryStats Stats(MemoryCategory category) const {
+    return Stats(counter_[Index(category)]);
+  }
+
+  MemoryStats Total() const { return Stats(counter_[kTotal]); }
+
+  /// Sets each peak to the current usage and zeroes the allocation counts.
+  void Reset() {
+    for (Counter& counter : counter_) {
+      counter.peak.store(counter.bytes.load(std::memory_order_relaxed),
+                         std::memory_order_relaxed);
+      counter.allocations.store(0, std::memory_order_relaxed);
+    }
+  }
+
+ private:
+  static constexpr int kTotal = static_cast<int>(MemoryCategory::Count);
+  static constexpr size_t kCacheLine = 64;
+
+  struct alignas(kCacheLine) Counter {
+    std::atomic<size_t> bytes{0};
+    std::atomic<size_t> peak{0};
+    std::atomic<size_t> allocations{0};
+  };
+
+  MemoryCounters() {}
+
+  static int Index(MemoryCategory category) {
+    return static_cast<int>(category);
+  }
+
+  static void Add(Counter& counter, size_t bytes, bool isAllocation) {
+    const size_t current =
+        counter.bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    // a plain load in the common case; the compare-exchange only runs on a
+    // new peak
+    size_t peak = counter.peak.load(std::memory_order_relaxed);
+    while (current > peak &&
+           !counter.peak.compare_exchange_weak(peak, current,
+                                               std::memory_order_relaxed)) {
+    }
+    if (isAllocation)
+      counter.allocations.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  static MemoryStats Stats(const Counter& counter) {
+    MemoryStats stats;
+    stats.bytes = counter.bytes.load(std::memory_order_relaxed);
+    stats.peakBytes = counter.peak.load(std::memory_order_relaxed);
+    stats.allocations = counter.allocations.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+  Counter counter_[kTotal + 1];
+};
+/** @} */
+}  // namespace manifold
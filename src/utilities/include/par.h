@@ -25,7 +25,11 @@
 #include <thrust/uninitialized_copy.h>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <numeric>
+
+#include "public.h"
 #if MANIFOLD_PAR == 'T'
 #include <thrust/system/tbb/execution_policy.h>
 
@@ -47,13 +51,125 @@ enum class ExecutionPolicy {
   Seq,
 };
 
+// The work a kernel does per element, which sets the size at which it is
+// worth the overhead of running it in parallel.
+enum class KernelCost {
+  Trivial,
+  Light,
+  Heavy,
+};
+
+/**
+ * Process-wide serial cutoffs of autoPolicy(), one per KernelCost. They are
+ * read on every call, so they are relaxed atomics rather than behind a lock.
+ */
+class SerialCutoffs {
+ public:
+  // Defined in the manifold library rather than inline, so that every module
+  // sees the same instance even when it is a separate shared library.
+  static SerialCutoffs& Get();
+
+  int operator[](KernelCost cost) const {
+    return cutoff_[static_cast<int>(cost)].load(std::memory_order_relaxed);
+  }
+
+  ParallelThresholds Thresholds() const {
+    return {(*this)[KernelCost::Trivial], (*this)[KernelCost::Light],
+            (*this)[KernelCost::Heavy]};
+  }
+
+  void SetThresholds(const ParallelThresholds& thresholds) {
+    Set(KernelCost::Trivial, thresholds.trivial);
+    Set(KernelCost::Light, thresholds.light);
+    Set(KernelCost::Heavy, thresholds.heavy);
+  }
+
+ private:
+  std::atomic<int> cutoff_[3];
+
+  SerialCutoffs() { SetThresholds(ParallelThresholds()); }
+
+  void Set(KernelCost cost, int size) {
+    cutoff_[static_cast<int>(cost)].store(size, std::memory_order_relaxed);
+  }
+};
+
+/**
+ * While alive, makes all of the library's parallel work started from this
+ * thread run on it serially instead, see ExecutionContext::maxConcurrency.
+ * Scopes nest; an inner scope cannot turn parallelism back on.
+ */
+class SerialScope {
+ public:
+  explicit SerialScope(bool serial = true) : previous_(active_) {
+    active_ = active_ || serial;
+  }
+  ~SerialScope() { active_ = previous_; }
+  SerialScope(const SerialScope&) = delete;
+  SerialScope& operator=(const SerialScope&) = delete;
+
+  static bool Active() { return active_; }
+
+ private:
+  static inline thread_local bool active_ = false;
+  const bool previous_;
+};
+
+/**
+ * The cancellation flag and deadline of an ExecutionContext. RunInContext()
+ * installs one for the calling thread; work handed to other threads has to
+ * carry Current() along and install it there with a Scope.
+ */
+class Cancellation {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  Cancellation(const std::atomic<bool>* flag, Clock::time_point deadline)
+      : flag_(flag), deadline_(deadline) {}
+
+  bool Requested() const {
+    if (flag_ != nullptr && flag_->load(std::memory_order_relaxed)) return true;
+    return deadline_ != Clock::time_point::max() && Clock::now() >= deadline_;
+  }
+
+  static const Cancellation* Current() { return current_; }
+
+  /// True if the operation running on this thread should stop.
+  static bool Check() { return current_ != nullptr && current_->Requested(); }
+
+  class Scope {
+   public:
+    explicit Scope(const Cancellation* cancellation) : previous_(current_) {
+      if (cancellation != nullptr) current_ = cancellation;
+    }
+    ~Scope() { current_ = previous_; }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    const Cancellation* const previous_;
+  };
+
+ private:
+  static inline thread_local const Cancellation* current_ = nullptr;
+  const std::atomic<bool>* flag_;
+  Clock::time_point deadline_;
+};
+
+// The policy to dispatch with, after any SerialScope.
+inline ExecutionPolicy Resolve(ExecutionPolicy policy) {
+  return SerialScope::Active() ? ExecutionPolicy::Seq : policy;
+}
+
 // ExecutionPolicy:
 // - Sequential for small workload,
-// - Parallel (CPU) for medium workload,
-// - GPU for large workload if available.
-inline constexpr ExecutionPolicy autoPolicy(int size) {
-  // some random numbers
-  if (size <= (1 << 12)) {
+// - Parallel (CPU) for larger workload.
+// There is no device tier: the kernels are host lambdas over host memory, so
+// a GPU policy would need __device__ functors and device-resident Vec storage
+// throughout, which is why the CUDA backend was removed.
+inline ExecutionPolicy autoPolicy(int size,
+                                  KernelCost cost = KernelCost::Light) {
+  if (size <= SerialCutoffs::Get()[cost] || SerialScope::Active()) {
     return ExecutionPolicy::Seq;
   }
   return ExecutionPolicy::Par;
@@ -62,7 +178,7 @@ inline constexpr ExecutionPolicy autoPolicy(int size) {
 #define THRUST_DYNAMIC_BACKEND_VOID(NAME)                    \
   template <typename... Args>                                \
   void NAME(ExecutionPolicy policy, Args... args) {          \
-    switch (policy) {                                        \
+    switch (Resolve(policy)) {                               \
       case ExecutionPolicy::Par:                             \
         thrust::NAME(thrust::MANIFOLD_PAR_NS::par, args...); \
         break;                                               \
@@ -75,7 +191,7 @@ inline constexpr ExecutionPolicy autoPolicy(int size) {
 #define THRUST_DYNAMIC_BACKEND(NAME, RET)                           \
   template <typename Ret = RET, typename... Args>                   \
   Ret NAME(ExecutionPolicy policy, Args... args) {                  \
-    switch (policy) {                                               \
+    switch (Resolve(policy)) {                                      \
       case ExecutionPolicy::Par:                                    \
         return thrust::NAME(thrust::MANIFOLD_PAR_NS::par, args...); \
       case ExecutionPolicy::Seq:                                    \
@@ -90,7 +206,7 @@ inline constexpr ExecutionPolicy autoPolicy(int size) {
 #define STL_DYNAMIC_BACKEND(NAME, RET)                        \
   template <typename Ret = RET, typename... Args>             \
   Ret NAME(ExecutionPolicy policy, Args... args) {            \
-    switch (policy) {                                         \
+    switch (Resolve(policy)) {                                \
       case ExecutionPolicy::Par:                              \
         return std::NAME(std::execution::par_unseq, args...); \
       case ExecutionPolicy::Seq:                              \
@@ -101,7 +217,7 @@ inline constexpr ExecutionPolicy autoPolicy(int size) {
 #define STL_DYNAMIC_BACKEND_VOID(NAME)                 \
   template <typename... Args>                          \
   void NAME(ExecutionPolicy policy, Args... args) {    \
-    switch (policy) {                                  \
+    switch (Resolve(policy)) {                         \
       case ExecutionPolicy::Par:                       \
         std::NAME(std::execution::par_unseq, args...); \
         break;                                         \
@@ -133,7 +249,7 @@ template <typename DerivedPolicy, typename InputIterator1,
 OutputIterator copy_if(ExecutionPolicy policy, InputIterator1 first,
                        InputIterator1 last, InputIterator2 stencil,
                        OutputIterator result, Predicate pred) {
-  if (policy == ExecutionPolicy::Seq)
+  if (Resolve(policy) == ExecutionPolicy::Seq)
     return thrust::copy_if(thrust::cpp::par, first, last, stencil, result,
                            pred);
   else
@@ -147,7 +263,7 @@ OutputIterator copy_if(ExecutionPolicy policy, InputIterator1 first,
                        InputIterator1 last, OutputIterator result,
                        Predicate pred) {
 #if MANIFOLD_PAR == 'T'
-  if (policy == ExecutionPolicy::Seq)
+  if (Resolve(policy) == ExecutionPolicy::Seq)
     return std::copy_if(first, last, result, pred);
   else
     return std::copy_if(std::execution::par_unseq, first, last, result, pred);
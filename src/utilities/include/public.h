@@ -19,6 +19,9 @@
 #include <glm/gtc/constants.hpp>
 #include <glm/gtx/compatibility.hpp>
 #include <glm/gtx/rotate_vector.hpp>
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <limits>
 #include <memory>
 #include <unordered_map>
@@ -165,6 +168,33 @@ struct Properties {
   float surfaceArea, volume;
 };
 
+/**
+ * The first surface hit by a ray, created with Manifold.RayCast(). On a miss,
+ * distance is infinite and face is -1.
+ */
+struct RayHit {
+  /// Distance from the ray origin to position.
+  float distance = std::numeric_limits<float>::infinity();
+  /// Index of the triangle hit, as in Mesh.triVerts.
+  int face = -1;
+  glm::vec3 position = glm::vec3(0.0f);
+  /// Outward normal of the triangle hit.
+  glm::vec3 normal = glm::vec3(0.0f);
+};
+
+/**
+ * The closest point on a surface to a query point, created with
+ * Manifold.ClosestPoint(). On an empty manifold, distance is infinite and face
+ * is -1.
+ */
+struct SurfacePoint {
+  /// Distance from the query point to position.
+  float distance = std::numeric_limits<float>::infinity();
+  /// Index of the closest triangle, as in Mesh.triVerts.
+  int face = -1;
+  glm::vec3 position = glm::vec3(0.0f);
+};
+
 struct Box {
   glm::vec3 min = glm::vec3(std::numeric_limits<float>::infinity());
   glm::vec3 max = glm::vec3(-std::numeric_limits<float>::infinity());
@@ -594,6 +624,45 @@ using logicErr = std::logic_error;
 #endif
 /** @} */
 
+/**
+ * The largest element counts that the parallel kernels run serially, by the
+ * work each kernel does per element, see SetParallelThresholds().
+ */
+struct ParallelThresholds {
+  /// Copies, fills and other kernels bound by memory bandwidth.
+  int trivial = 1 << 14;
+  /// Most kernels, with a few dozen operations per element.
+  int light = 1 << 12;
+  /// Kernels with a search or a geometric test per element, such as the
+  /// Boolean intersection kernels and ray queries.
+  int heavy = 1 << 9;
+};
+
+/**
+ * Where the parallel work of an operation runs, see RunInContext().
+ */
+struct ExecutionContext {
+  /// The most threads that may work on the operation, the caller included.
+  /// Zero uses the whole process-wide pool. One keeps all work on the calling
+  /// thread, as language runtimes with locks that expect not to be called back
+  /// by unregistered threads need. With the TBB backend, other values run the
+  /// operation in a task arena of that many threads.
+  int maxConcurrency = 0;
+  /// Optional: runs the given function to completion, e.g. inside the
+  /// caller's own tbb::task_arena or on a thread of its own pool. Takes the
+  /// place of the arena made for maxConcurrency, though a maxConcurrency of
+  /// one still keeps that thread from handing work to others.
+  std::function<void(const std::function<void()>&)> executor;
+  /// Optional: set true from any thread to stop the operation. It is polled
+  /// between the phases of each Boolean, between the Booleans of a batch, per
+  /// cell in Fracture() and per chunk of the grid in LevelSet(). Booleans then
+  /// give status Cancelled, as do all results built from them.
+  const std::atomic<bool>* cancel = nullptr;
+  /// Optional: the operation stops as if cancelled once this time passes.
+  std::chrono::steady_clock::time_point deadline =
+      std::chrono::steady_clock::time_point::max();
+};
+
 /**
  * Global parameters that control debugging output. Only has an
  * effect when compiled with the MANIFOLD_DEBUG flag.
@@ -615,6 +684,129 @@ struct ExecutionParams {
   bool deterministic = false;
   /// Perform optional but recommended triangle cleanups in SimplifyTopology()
   bool cleanupTriangles = true;
+  /// Collapse the edges flagged by SimplifyTopology() concurrently, in rounds
+  /// of edges whose neighborhoods don't overlap, instead of one at a time.
+  /// The result is still manifold, but may differ from the serial order.
+  bool parallelSimplify = false;
+  /// Promises that the inputs of Booleans are already simplified, as any
+  /// result of this library is, so SimplifyTopology() after a Boolean only
+  /// visits the neighborhood of the intersection instead of the whole mesh.
+  /// Inputs with leftover short edges or duplicate edges then keep them
+  /// outside the cut.
+  bool cleanInputs = false;
+  /// Build mesh colliders by the surface area heuristic instead of as Morton
+  /// radix trees: slower to build, but fewer node visits per query on meshes
+  /// with very uneven triangle distributions.
+  bool sahCollider = false;
+  /// Sort and index mesh faces by 63-bit Morton codes instead of 30-bit ones.
+  /// Costs twice the key memory and a longer sort, but keeps the triangles of
+  /// a small detailed part inside a wide bounding box from sharing codes,
+  /// which would otherwise unbalance the collider.
+  bool mortonCode64 = false;
+  /// Also collapse mesh colliders into 4-wide nodes, which makes broad-phase
+  /// queries shallower and more cache-friendly on very large meshes at the
+  /// cost of extra collider memory.
+  bool wideCollider = false;
+  /// Run the Boolean intersection kernels on structure-of-arrays copies of
+  /// the input halfedges at half their size, which improves cache hit rates
+  /// on very large meshes at the cost of building the copies.
+  bool compactHalfedges = false;
+  /// Keep the verts and triangles of composed meshes in the sorted order of
+  /// each input, as consecutive blocks, instead of resorting the whole result.
+  /// This makes composing many instances faster, but the collider is then
+  /// built over the blocks, so queries may visit more nodes.
+  bool keepComposeOrder = false;
+  /// Byte budget of the process-wide cache of Boolean results, keyed on the
+  /// input meshes, their relative transform and the operation. Zero (the
+  /// default) disables the cache.
+  size_t booleanCacheSize = 0;
+};
+
+/**
+ * Where the internal buffers of all meshes come from. Any member left null
+ * falls back to malloc/free. allocate must return memory aligned to at least
+ * 16 bytes, or nullptr on failure; deallocate receives the same byte count
+ * that was requested.
+ */
+struct BufferAllocator {
+  void* (*allocate)(size_t bytes, void* context) = nullptr;
+  void (*deallocate)(void* ptr, size_t bytes, void* context) = nullptr;
+  /// Passed through to allocate and deallocate.
+  void* context = nullptr;
+  /// Byte budget of freed buffers kept in size-class free lists for reuse
+  /// across operations instead of being returned to deallocate. Zero (the
+  /// default) disables pooling.
+  size_t poolSize = 0;
+};
+
+/**
+ * Groups of internal buffers whose memory use is tracked separately, see
+ * GetMemoryStats().
+ */
+enum class MemoryCategory {
+  Other,
+  VertPos,
+  Halfedge,
+  SparseIndices,
+  Collider,
+  Count,
+};
+
+/**
+ * Live and peak bytes of internal buffers, and the number of allocations
+ * since the last ResetMemoryStats().
+ */
+struct MemoryStats {
+  size_t bytes = 0;
+  size_t peakBytes = 0;
+  size_t allocations = 0;
+};
+
+/**
+ * Counters of the process-wide Boolean result cache, see
+ * ExecutionParams::booleanCacheSize.
+ */
+struct BooleanCacheStats {
+  size_t hits = 0;
+  size_t misses = 0;
+  size_t entries = 0;
+  size_t bytes = 0;
+};
+
+/**
+ * Wall time in milliseconds of each phase of one Boolean operation, and the
+ * sizes of its main intermediates, see GetLastBooleanStats(). When one
+ * intersection is shared by several results, as in Split(), each result
+ * repeats the intersection phases.
+ */
+struct BooleanStats {
+  OpType op = OpType::Add;
+  /// Edge-face and vertex-face collisions of the colliders.
+  double broadPhase = 0;
+  double filter11 = 0;
+  double shadow11 = 0;
+  double shadow02 = 0;
+  double intersect12 = 0;
+  double winding03 = 0;
+  /// Inclusion numbers, output vertices and the output face sizes.
+  double sizeOutput = 0;
+  /// Partial, new and whole edges appended to the output faces.
+  double assembleEdges = 0;
+  double face2Tri = 0;
+  /// Properties, references and the topology cleanup.
+  double simplifyTopology = 0;
+  double finish = 0;
+  /// Edge-face overlaps of the broad phase, in both directions.
+  size_t edgeCollisions = 0;
+  /// Vertex-face overlaps in the Z-projection, in both directions.
+  size_t vertCollisions = 0;
+  /// Edge-edge pairs whose XY-projections overlap.
+  size_t edgeEdgePairs = 0;
+  /// Edge-face intersections, in both directions.
+  size_t intersections = 0;
+  size_t newVerts = 0;
+  size_t outputVerts = 0;
+  size_t outputTris = 0;
 };
 
 #ifdef MANIFOLD_DEBUG
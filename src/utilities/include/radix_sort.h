@@ -0,0 +1,152 @@
+// Copyright 2024 The Manifold Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <algorithm>
+#include <type_traits>
+
+#include "optional_assert.h"
+#include "par.h"
+#include "vec.h"
+
+namespace manifold {
+
+/** @addtogroup Private
+ *  @{
+ */
+
+/**
+ * The byte of key examined by the given radix pass, with the sign bit of
+ * signed keys flipped so they sort in numeric order.
+ */
+template <typename Key>
+inline int RadixDigit(Key key, int pass) {
+  using U = typename std::make_unsigned<Key>::type;
+  U bits = static_cast<U>(key);
+  if (std::is_signed<Key>::value) bits ^= U(1) << (8 * sizeof(Key) - 1);
+  return static_cast<int>((bits >> (8 * pass)) & 0xFF);
+}
+
+/**
+ * Stable least-significant-digit radix sort over bytes, optionally permuting
+ * a payload array alongside. The input is split into fixed blocks that are
+ * histogrammed and scattered in parallel; a prefix sum over (digit, block)
+ * keeps the scatter stable. Passes whose byte is the same for every key -
+ * e.g. the high bytes of Morton codes of a small mesh, or of packed index
+ * pairs - are skipped entirely.
+ */
+template <typename Key, typename Value>
+void RadixSort(Key* keys, Value* values, int n) {
+  static_assert(std::is_integral<Key>::value, "radix sort needs integer keys");
+  if (n < 2) return;
+  constexpr int kPasses = sizeof(Key);
+  constexpr int kRadix = 256;
+  constexpr int kBlockSize = 1 << 16;
+  const int numBlocks = (n + kBlockSize - 1) / kBlockSize;
+  const ExecutionPolicy policy = autoPolicy(n);
+
+  // The digit totals of every pass don't depend on order, so one read finds
+  // the passes that would leave the order unchanged.
+  Vec<int> blockTotals(numBlocks * kPasses * kRadix, 0);
+  for_each_n(policy, countAt(0), numBlocks, [&](int block) {
+    int* total = blockTotals.data() + block * kPasses * kRadix;
+    const int end = std::min(n, (block + 1) * kBlockSize);
+    for (int i = block * kBlockSize; i < end; ++i)
+      for (int pass = 0; pass < kPasses; ++pass)
+        ++total[pass * kRadix + RadixDigit(keys[i], pass)];
+  });
+  bool skip[kPasses];
+  for (int pass = 0; pass < kPasses; ++pass) {
+    skip[pass] = false;
+    for (int digit = 0; digit < kRadix && !skip[pass]; ++digit) {
+      int total = 0;
+      for (int block = 0; block < numBlocks; ++block)
+        total += blockTotals[(block * kPasses + pass) * kRadix + digit];
+      skip[pass] = total == n;
+    }
+  }
+
+  Vec<Key> keyTmp;
+  Vec<Value> valueTmp;
+  Key* keySrc = keys;
+  Value* valueSrc = values;
+  Key* keyDst = nullptr;
+  Value* valueDst = nullptr;
+  Vec<int> offsets(numBlocks * kRadix);
+  for (int pass = 0; pass < kPasses; ++pass) {
+    if (skip[pass]) continue;
+    if (keyDst == nullptr) {
+      keyTmp.resize(n);
+      keyDst = keyTmp.data();
+      if (values != nullptr) {
+        valueTmp.resize(n);
+        valueDst = valueTmp.data();
+      }
+    }
+
+    for_each_n(policy, countAt(0), numBlocks, [&](int block) {
+      int* count = offsets.data() + block * kRadix;
+      std::fill(count, count + kRadix, 0);
+      const int end = std::min(n, (block + 1) * kBlockSize);
+      for (int i = block * kBlockSize; i < end; ++i)
+        ++count[RadixDigit(keySrc[i], pass)];
+    });
+    // blocks in order within each digit keeps the sort stable
+    int sum = 0;
+    for (int digit = 0; digit < kRadix; ++digit) {
+      for (int block = 0; block < numBlocks; ++block) {
+        const int count = offsets[block * kRadix + digit];
+        offsets[block * kRadix + digit] = sum;
+        sum += count;
+      }
+    }
+    for_each_n(policy, countAt(0), numBlocks, [&](int block) {
+      int* offset = offsets.data() + block * kRadix;
+      const int end = std::min(n, (block + 1) * kBlockSize);
+      for (int i = block * kBlockSize; i < end; ++i) {
+        const int pos = offset[RadixDigit(keySrc[i], pass)]++;
+        keyDst[pos] = keySrc[i];
+        if (values != nullptr) valueDst[pos] = valueSrc[i];
+      }
+    });
+    std::swap(keySrc, keyDst);
+    std::swap(valueSrc, valueDst);
+  }
+
+  if (keySrc != keys) {
+    copy(policy, keySrc, keySrc + n, keys);
+    if (values != nullptr) copy(policy, valueSrc, valueSrc + n, values);
+  }
+}
+
+/**
+ * Stable radix sort of keys, applying the same permutation to values, which
+ * must be the same length.
+ */
+template <typename Key, typename Value>
+void RadixSort(VecView<Key> keys, VecView<Value> values) {
+  ASSERT(keys.size() == values.size(), logicErr,
+         "keys and values must be the same length");
+  RadixSort(keys.begin(), values.begin(), keys.size());
+}
+
+/**
+ * Radix sort of keys alone.
+ */
+template <typename Key>
+void RadixSort(VecView<Key> keys) {
+  RadixSort<Key, int>(keys.begin(), nullptr, keys.size());
+}
+/** @} */
+}  // namespace manifold
@@ -0,0 +1,100 @@
+// Copyright 2024 The Manifold Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+
+#include "vec.h"
+
+namespace manifold {
+
+/** @addtogroup Private
+ *  @{
+ */
+
+/**
+ * Builds the flat buffers of Manifold::Serialize(). Values and arrays are
+ * stored as raw bytes, with every item padded to an 8-byte boundary so that
+ * arrays stay aligned when read straight from a memory-mapped file.
+ */
+class SerialWriter {
+ public:
+  template <typename T>
+  void Pod(const T& value) {
+    Bytes(&value, sizeof(T));
+  }
+
+  template <typename T>
+  void Array(const Vec<T>& vec) {
+    Pod<uint64_t>(vec.size());
+    Bytes(vec.data(), vec.size() * sizeof(T));
+  }
+
+  void Bytes(const void* data, size_t size) {
+    const size_t start = buffer_.size();
+    buffer_.resize(start + ((size + 7) & ~size_t(7)), 0);
+    if (size > 0) memcpy(buffer_.data() + start, data, size);
+  }
+
+  std::vector<char>& Buffer() { return buffer_; }
+
+ private:
+  std::vector<char> buffer_;
+};
+
+/**
+ * Reads what SerialWriter wrote. Reading past the end fails rather than
+ * overrunning; once a read has failed, all further reads fail. Nothing else
+ * is checked, which is what makes loading fast.
+ */
+class SerialReader {
+ public:
+  SerialReader(const char* data, size_t size)
+      : ptr_(data), end_(data + size) {}
+
+  template <typename T>
+  bool Pod(T& value) {
+    return Bytes(&value, sizeof(T));
+  }
+
+  template <typename T>
+  bool Array(Vec<T>& vec) {
+    uint64_t size;
+    if (!Pod(size) || size > Remaining() / sizeof(T)) return ok_ = false;
+    vec.resize(size);
+    return Bytes(vec.data(), size * sizeof(T));
+  }
+
+  bool Bytes(void* data, size_t size) {
+    const size_t padded = (size + 7) & ~size_t(7);
+    if (!ok_ || padded > Remaining()) return ok_ = false;
+    if (size > 0) memcpy(data, ptr_, size);
+    ptr_ += padded;
+    return true;
+  }
+
+  bool Ok() const { return ok_; }
+
+ private:
+  const char* ptr_;
+  const char* end_;
+  bool ok_ = true;
+
+  size_t Remaining() const { return end_ - ptr_; }
+};
+/** @} */
+}  // namespace manifold
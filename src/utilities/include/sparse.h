@@ -18,6 +18,7 @@
 #include "optional_assert.h"
 #include "par.h"
 #include "public.h"
+#include "radix_sort.h"
 #include "utils.h"
 #include "vec.h"
 
@@ -61,15 +62,13 @@ class SparseIndices {
     int offset = pOffset;
     if (use_q) offset = 1 - offset;
     const int* p = ptr();
-    for_each(autoPolicy(out.size()), countAt(0), countAt((int)out.size()),
+    for_each(autoPolicy(out.size(), KernelCost::Trivial), countAt(0),
+             countAt((int)out.size()),
              [&](int i) { out[i] = p[i * 2 + offset]; });
     return out;
   }
 
-  void Sort() {
-    VecView<int64_t> view = AsVec64();
-    stable_sort(autoPolicy(size()), view.begin(), view.end());
-  }
+  void Sort() { RadixSort(AsVec64()); }
 
   void Resize(int size) { data_.resize(size * sizeof(int64_t), -1); }
 
@@ -195,7 +194,7 @@ class SparseIndices {
 #endif
 
  private:
-  Vec<char> data_;
+  Vec<char> data_{MemoryCategory::SparseIndices};
   inline int* ptr() { return reinterpret_cast<int32_t*>(data_.data()); }
   inline const int* ptr() const {
     return reinterpret_cast<const int32_t*>(data_.data());
@@ -105,6 +105,15 @@ inline int AtomicAdd(int& target, int add) {
   return old_val;
 }
 
+template <typename T>
+void AtomicMax(T& target, T value) {
+  std::atomic<T>& tar = reinterpret_cast<std::atomic<T>&>(target);
+  T old = tar.load(std::memory_order_relaxed);
+  while (old < value &&
+         !tar.compare_exchange_weak(old, value, std::memory_order_relaxed))
+    ;
+}
+
 // Copied from
 // https://github.com/thrust/thrust/blob/master/examples/strided_range.cu
 template <typename Iterator>
@@ -191,7 +200,8 @@ struct UnionFind {
   Vec<R> ranks;
 
   UnionFind(I numNodes) : parents(numNodes), ranks(numNodes, 0) {
-    sequence(autoPolicy(numNodes), parents.begin(), parents.end());
+    sequence(autoPolicy(numNodes, KernelCost::Trivial), parents.begin(),
+             parents.end());
   }
 
   I find(I x) {
@@ -22,6 +22,9 @@
 #endif
 
 // #include "optional_assert.h"
+#include "arena.h"
+#include "buffer_pool.h"
+#include "memory_counters.h"
 #include "par.h"
 #include "public.h"
 #include "vec_view.h"
@@ -47,6 +50,9 @@ class Vec : public VecView<T> {
  public:
   Vec() {}
 
+  // Empty vector whose buffers are accounted under the given category.
+  explicit Vec(MemoryCategory category) : category_(category) {}
+
   // Note that the vector constructed with this constructor will contain
   // uninitialized memory. Please specify `val` if you need to make sure that
   // the data is initialized.
@@ -57,14 +63,12 @@ class Vec : public VecView<T> {
 
   Vec(int size, T val) { resize(size, val); }
 
-  Vec(const Vec<T> &vec) {
+  Vec(const Vec<T> &vec) : category_(vec.category_) {
     this->size_ = vec.size();
     this->capacity_ = this->size_;
-    auto policy = autoPolicy(this->size_);
+    auto policy = autoPolicy(this->size_, KernelCost::Trivial);
     if (this->size_ != 0) {
-      this->ptr_ = reinterpret_cast<T *>(malloc(this->size_ * sizeof(T)));
-      if (this->ptr_ == nullptr) throw std::bad_alloc();
-      TracyAllocS(this->ptr_, this->size_ * sizeof(T), 3);
+      this->ptr_ = Allocate(this->size_, arena_);
       uninitialized_copy(policy, vec.begin(), vec.end(), this->ptr_);
     }
   }
@@ -72,19 +76,18 @@ class Vec : public VecView<T> {
   Vec(const std::vector<T> &vec) {
     this->size_ = vec.size();
     this->capacity_ = this->size_;
-    auto policy = autoPolicy(this->size_);
+    auto policy = autoPolicy(this->size_, KernelCost::Trivial);
     if (this->size_ != 0) {
-      this->ptr_ = reinterpret_cast<T *>(malloc(this->size_ * sizeof(T)));
-      if (this->ptr_ == nullptr) throw std::bad_alloc();
-      TracyAllocS(this->ptr_, this->size_ * sizeof(T), 3);
+      this->ptr_ = Allocate(this->size_, arena_);
       uninitialized_copy(policy, vec.begin(), vec.end(), this->ptr_);
     }
   }
 
-  Vec(Vec<T> &&vec) {
+  Vec(Vec<T> &&vec) : category_(vec.category_) {
     this->ptr_ = vec.ptr_;
     this->size_ = vec.size_;
     capacity_ = vec.capacity_;
+    arena_ = vec.arena_;
     vec.ptr_ = nullptr;
     vec.size_ = 0;
     vec.capacity_ = 0;
@@ -94,10 +97,7 @@ class Vec : public VecView<T> {
   operator VecView<const T>() const { return {this->ptr_, this->size_}; }
 
   ~Vec() {
-    if (this->ptr_ != nullptr) {
-      TracyFreeS(this->ptr_, 3);
-      free(this->ptr_);
-    }
+    if (this->ptr_ != nullptr) Free(this->ptr_, capacity_, arena_);
     this->ptr_ = nullptr;
     this->size_ = 0;
     capacity_ = 0;
@@ -105,17 +105,13 @@ class Vec : public VecView<T> {
 
   Vec<T> &operator=(const Vec<T> &other) {
     if (&other == this) return *this;
-    if (this->ptr_ != nullptr) {
-      TracyFreeS(this->ptr_, 3);
-      free(this->ptr_);
-    }
+    if (this->ptr_ != nullptr) Free(this->ptr_, capacity_, arena_);
+    this->ptr_ = nullptr;
     this->size_ = other.size_;
     capacity_ = other.size_;
-    auto policy = autoPolicy(this->size_);
+    auto policy = autoPolicy(this->size_, KernelCost::Trivial);
     if (this->size_ != 0) {
-      this->ptr_ = reinterpret_cast<T *>(malloc(this->size_ * sizeof(T)));
-      if (this->ptr_ == nullptr) throw std::bad_alloc();
-      TracyAllocS(this->ptr_, this->size_ * sizeof(T), 3);
+      this->ptr_ = Allocate(this->size_, arena_);
       uninitialized_copy(policy, other.begin(), other.end(), this->ptr_);
     }
     return *this;
@@ -123,12 +119,12 @@ class Vec : public VecView<T> {
 
   Vec<T> &operator=(Vec<T> &&other) {
     if (&other == this) return *this;
-    if (this->ptr_ != nullptr) {
-      TracyFreeS(this->ptr_, 3);
-      free(this->ptr_);
-    }
+    if (this->ptr_ != nullptr) Free(this->ptr_, capacity_, arena_);
+    MemoryCounters::Get().Transfer(other.category_, category_,
+                                   other.capacity_ * sizeof(T));
     this->size_ = other.size_;
     capacity_ = other.capacity_;
+    arena_ = other.arena_;
     this->ptr_ = other.ptr_;
     other.ptr_ = nullptr;
     other.size_ = 0;
@@ -139,9 +135,15 @@ class Vec : public VecView<T> {
   operator VecView<T>() const { return {this->ptr_, this->size_}; }
 
   void swap(Vec<T> &other) {
+    // categories stay with the vectors, so the buffers' bytes move
+    MemoryCounters::Get().Transfer(category_, other.category_,
+                                   capacity_ * sizeof(T));
+    MemoryCounters::Get().Transfer(other.category_, category_,
+                                   other.capacity_ * sizeof(T));
     std::swap(this->ptr_, other.ptr_);
     std::swap(this->size_, other.size_);
     std::swap(capacity_, other.capacity_);
+    std::swap(arena_, other.arena_);
   }
 
   inline void push_back(const T &val) {
@@ -157,17 +159,14 @@ class Vec : public VecView<T> {
 
   void reserve(int n) {
     if (n > capacity_) {
-      T *newBuffer = reinterpret_cast<T *>(malloc(n * sizeof(T)));
-      if (newBuffer == nullptr) throw std::bad_alloc();
-      TracyAllocS(newBuffer, n * sizeof(T), 3);
+      Arena *newArena;
+      T *newBuffer = Allocate(n, newArena);
       if (this->size_ > 0)
-        uninitialized_copy(autoPolicy(this->size_), this->ptr_,
-                           this->ptr_ + this->size_, newBuffer);
-      if (this->ptr_ != nullptr) {
-        TracyFreeS(this->ptr_, 3);
-        free(this->ptr_);
-      }
+        uninitialized_copy(autoPolicy(this->size_, KernelCost::Trivial),
+                           this->ptr_, this->ptr_ + this->size_, newBuffer);
+      if (this->ptr_ != nullptr) Free(this->ptr_, capacity_, arena_);
       this->ptr_ = newBuffer;
+      arena_ = newArena;
       capacity_ = n;
     }
   }
@@ -176,27 +175,27 @@ class Vec : public VecView<T> {
     bool shrink = this->size_ > 2 * newSize;
     reserve(newSize);
     if (this->size_ < newSize) {
-      uninitialized_fill(autoPolicy(newSize - this->size_),
-                         this->ptr_ + this->size_, this->ptr_ + newSize, val);
+      uninitialized_fill(
+          autoPolicy(newSize - this->size_, KernelCost::Trivial),
+          this->ptr_ + this->size_, this->ptr_ + newSize, val);
     }
     this->size_ = newSize;
     if (shrink) shrink_to_fit();
   }
 
   void shrink_to_fit() {
+    // not worth a copy for less than an eighth of slack
+    if (this->size_ > 0 && capacity_ - this->size_ <= capacity_ / 8) return;
     T *newBuffer = nullptr;
+    Arena *newArena = nullptr;
     if (this->size_ > 0) {
-      newBuffer = reinterpret_cast<T *>(malloc(this->size_ * sizeof(T)));
-      if (newBuffer == nullptr) throw std::bad_alloc();
-      TracyAllocS(newBuffer, this->size_ * sizeof(T), 3);
-      uninitialized_copy(autoPolicy(this->size_), this->ptr_,
-                         this->ptr_ + this->size_, newBuffer);
-    }
-    if (this->ptr_ != nullptr) {
-      TracyFreeS(this->ptr_, 3);
-      free(this->ptr_);
+      newBuffer = Allocate(this->size_, newArena);
+      uninitialized_copy(autoPolicy(this->size_, KernelCost::Trivial),
+                         this->ptr_, this->ptr_ + this->size_, newBuffer);
     }
+    if (this->ptr_ != nullptr) Free(this->ptr_, capacity_, arena_);
     this->ptr_ = newBuffer;
+    arena_ = newArena;
     capacity_ = this->size_;
   }
 
@@ -231,8 +230,39 @@ class Vec : public VecView<T> {
   T *data() { return this->ptr_; }
   const T *data() const { return this->ptr_; }
 
+  MemoryCategory category() const { return category_; }
+
+  void set_category(MemoryCategory category) {
+    MemoryCounters::Get().Transfer(category_, category, capacity_ * sizeof(T));
+    category_ = category;
+  }
+
  private:
   int capacity_ = 0;
+  // where ptr_ came from; nullptr means the system heap.
+  Arena *arena_ = nullptr;
+  MemoryCategory category_ = MemoryCategory::Other;
+
+  // Draws from the current thread's Arena if there is one.
+  T *Allocate(int n, Arena *&arena) const {
+    arena = Arena::Current();
+    const size_t bytes = n * sizeof(T);
+    T *ptr = reinterpret_cast<T *>(arena == nullptr
+                                       ? BufferPool::Get().Allocate(bytes)
+                                       : arena->Allocate(bytes));
+    TracyAllocS(ptr, bytes, 3);
+    MemoryCounters::Get().Allocate(category_, bytes);
+    return ptr;
+  }
+
+  void Free(T *ptr, int capacity, Arena *arena) const {
+    TracyFreeS(ptr, 3);
+    MemoryCounters::Get().Free(category_, capacity * sizeof(T));
+    if (arena == nullptr)
+      BufferPool::Get().Deallocate(ptr, capacity * sizeof(T));
+    else
+      arena->Deallocate(ptr, capacity * sizeof(T));
+  }
 };
 /** @} */
 }  // namespace manifold
@@ -262,6 +262,42 @@ TEST(Boolean, Split) {
   EXPECT_FLOAT_EQ(splits.first.GetProperties().volume +
                       splits.second.GetProperties().volume,
                   cube.GetProperties().volume);
+
+  // Both halves match the separate Booleans.
+  const Manifold inter = cube ^ oct;
+  const Manifold diff = cube - oct;
+  EXPECT_EQ(splits.first.NumTri(), inter.NumTri());
+  EXPECT_EQ(splits.second.NumTri(), diff.NumTri());
+  EXPECT_FLOAT_EQ(splits.first.GetProperties().volume,
+                  inter.GetProperties().volume);
+  EXPECT_FLOAT_EQ(splits.second.GetProperties().volume,
+                  diff.GetProperties().volume);
+}
+
+TEST(Boolean, Stats) {
+  int numReports = 0;
+  SetBooleanStatsCallback(
+      [&numReports](const BooleanStats&) { ++numReports; });
+
+  Manifold cube = Manifold::Cube(glm::vec3(2.0f), true);
+  Manifold sphere = Manifold::Sphere(1, 32).Translate(glm::vec3(1.0f));
+  Manifold result = cube - sphere;
+  EXPECT_FALSE(result.IsEmpty());
+  SetBooleanStatsCallback(nullptr);
+
+  const BooleanStats stats = GetLastBooleanStats();
+  EXPECT_EQ(numReports, 1);
+  EXPECT_EQ(stats.op, OpType::Subtract);
+  EXPECT_GT(stats.edgeCollisions, 0);
+  EXPECT_GT(stats.intersections, 0);
+  EXPECT_GT(stats.newVerts, 0);
+  EXPECT_EQ(stats.outputVerts, result.NumVert());
+  EXPECT_EQ(stats.outputTris, result.NumTri());
+  EXPECT_GE(stats.finish, 0);
+
+  Manifold other = cube ^ sphere;
+  EXPECT_FALSE(other.IsEmpty());
+  EXPECT_EQ(numReports, 1);
 }
 
 TEST(Boolean, SplitByPlane) {
@@ -659,6 +695,326 @@ TEST(Boolean, TreeTransforms) {
   EXPECT_FLOAT_EQ((a + b).GetProperties().volume, 2);
 }
 
+TEST(Boolean, ResultCache) {
+  ClearBooleanCache();
+  ManifoldParams().booleanCacheSize = 1 << 26;
+  const Manifold cube = Manifold::Cube(glm::vec3(2), true);
+  const Manifold sphere = Manifold::Sphere(1.2, 32);
+
+  const Manifold first =
+      cube.Translate({1, 2, 3}) - sphere.Translate({1, 2, 4});
+  EXPECT_LT(first.GetProperties().volume, 8);
+  EXPECT_GT(first.GetProperties().volume, 4);
+  BooleanCacheStats stats = GetBooleanCacheStats();
+  EXPECT_EQ(stats.hits, 0);
+  EXPECT_EQ(stats.misses, 1);
+  EXPECT_EQ(stats.entries, 1);
+  EXPECT_GT(stats.bytes, 0);
+
+  // Same relative placement, different absolute placement.
+  const Manifold second =
+      cube.Translate({-5, 0, 0}) - sphere.Translate({-5, 0, 1});
+  EXPECT_NEAR(second.GetProperties().volume, first.GetProperties().volume,
+              1e-5);
+  EXPECT_EQ(second.NumTri(), first.NumTri());
+  EXPECT_NEAR(second.BoundingBox().Center().x, -5, 1e-5);
+  stats = GetBooleanCacheStats();
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.entries, 1);
+
+  const Manifold third = cube - sphere.Translate({0, 0, 0.5});
+  third.NumTri();
+  EXPECT_EQ(GetBooleanCacheStats().misses, 2);
+
+  ManifoldParams().booleanCacheSize = 0;
+  ClearBooleanCache();
+  EXPECT_EQ(GetBooleanCacheStats().entries, 0);
+}
+
+TEST(Boolean, CsgEditor) {
+  CsgEditor editor;
+  const Manifold cube = Manifold::Cube(glm::vec3(10), true);
+  // five separate through-holes, each well inside the cube
+  const Manifold hole = Manifold::Cylinder(12, 0.5, 0.5, 16, true);
+  const int body = editor.AddLeaf(cube);
+  std::vector<int> holes;
+  for (int i = 0; i < 5; ++i) {
+    holes.push_back(editor.AddLeaf(hole.Translate({2 * i - 4.0f, 0, 0})));
+  }
+  std::vector<int> children = {body};
+  children.insert(children.end(), holes.begin(), holes.end());
+  const int root = editor.AddOp(OpType::Subtract, children);
+
+  const Manifold drilled = editor.Evaluate(root);
+  EXPECT_EQ(drilled.Genus(), 5);
+  const float volume = drilled.GetProperties().volume;
+  // only 10 of the 12 units of cylinder length lie inside the cube
+  EXPECT_NEAR(volume, 1000 - 5 * hole.GetProperties().volume * 10 / 12, 1e-2);
+
+  editor.SetLeaf(holes[2], hole.Translate({0, 3, 0}));
+  const Manifold edited = editor.Evaluate(root);
+  const Manifold expected =
+      cube - hole.Translate({-4, 0, 0}) - hole.Translate({-2, 0, 0}) -
+      hole.Translate({0, 3, 0}) - hole.Translate({2, 0, 0}) -
+      hole.Translate({4, 0, 0});
+  EXPECT_EQ(edited.Genus(), 5);
+  EXPECT_NEAR(edited.GetProperties().volume, expected.GetProperties().volume,
+              1e-3);
+  EXPECT_NEAR(edited.GetProperties().volume, volume, 1e-3);
+
+  editor.SetLeaf(holes[2], Manifold());
+  EXPECT_EQ(editor.Evaluate(root).Genus(), 4);
+}
+
+TEST(Boolean, BatchUnionOverlapChain) {
+  std::vector<Manifold> cubes;
+  for (int i = 0; i < 20; ++i) {
+    cubes.push_back(Manifold::Cube().Translate({0.5f * i, 0, 0}));
+  }
+  // a rotated child that overlaps the chain by 0.25 in its final position
+  cubes.push_back(Manifold::Cube({1, 1, 1}, true)
+                      .Translate({0, 0, 2})
+                      .Rotate(90, 0, 0)
+                      .Translate({5, 2.5, 1.25}));
+  const Manifold result = Manifold::BatchBoolean(cubes, OpType::Add);
+  EXPECT_EQ(result.Genus(), 0);
+  EXPECT_EQ(result.Decompose().size(), 1);
+  EXPECT_NEAR(result.GetProperties().volume, 10.5 + 1 - 0.25, 1e-4);
+}
+
+TEST(Boolean, BushyTree) {
+  const Manifold cube = Manifold::Cube(glm::vec3(2), true);
+  const Manifold sphere = Manifold::Sphere(1.3, 24);
+  const float roundedVolume = (cube ^ sphere).GetProperties().volume;
+  const float cornersVolume = (cube - sphere).GetProperties().volume;
+  std::vector<Manifold> parts;
+  for (int i = 0; i < 8; ++i) {
+    const glm::vec3 offset(4.0f * i, 0, 0);
+    parts.push_back((cube.Translate(offset) ^ sphere.Translate(offset)) +
+                    (cube - sphere).Translate(offset + glm::vec3(0, 4, 0)));
+  }
+  const Manifold result = Manifold::BatchBoolean(parts, OpType::Add);
+  EXPECT_NEAR(result.GetProperties().volume,
+              8 * (roundedVolume + cornersVolume), 1e-2);
+}
+
+TEST(Boolean, DeterministicBatch) {
+  ManifoldParams().deterministic = true;
+  auto build = []() {
+    std::vector<Manifold> spheres;
+    for (int i = 0; i < 9; ++i) {
+      spheres.push_back(
+          Manifold::Sphere(1, 16 + 4 * (i % 3)).Translate({1.2f * i, 0, 0}));
+    }
+    return Manifold::BatchBoolean(spheres, OpType::Add).GetMesh();
+  };
+  const Mesh first = build();
+  const Mesh second = build();
+  ManifoldParams().deterministic = false;
+  ASSERT_EQ(first.vertPos.size(), second.vertPos.size());
+  ASSERT_EQ(first.triVerts.size(), second.triVerts.size());
+  for (int i = 0; i < first.vertPos.size(); ++i) {
+    EXPECT_EQ(first.vertPos[i], second.vertPos[i]);
+  }
+  for (int i = 0; i < first.triVerts.size(); ++i) {
+    EXPECT_EQ(first.triVerts[i], second.triVerts[i]);
+  }
+}
+
+TEST(Boolean, Contained) {
+  const Manifold cube = Manifold::Cube(glm::vec3(4), true);
+  const Manifold sphere = Manifold::Sphere(1, 32);
+  const float cubeVol = cube.GetProperties().volume;
+  const float sphereVol = sphere.GetProperties().volume;
+
+  EXPECT_FLOAT_EQ((cube + sphere).GetProperties().volume, cubeVol);
+  EXPECT_EQ((cube + sphere).NumTri(), cube.NumTri());
+  EXPECT_FLOAT_EQ((sphere ^ cube).GetProperties().volume, sphereVol);
+  EXPECT_TRUE((sphere - cube).IsEmpty());
+  const Manifold hollow = cube - sphere;
+  EXPECT_NEAR(hollow.GetProperties().volume, cubeVol - sphereVol, 1e-4);
+  EXPECT_EQ(hollow.NumTri(), cube.NumTri() + sphere.NumTri());
+
+  // one part in the cavity of the shell and one far outside of it
+  const Manifold ring = cube - cube.Scale(glm::vec3(0.9));
+  const Manifold parts = sphere + sphere.Translate({0, 0, 10});
+  EXPECT_NEAR((ring ^ parts).GetProperties().volume, 0, 1e-5);
+  EXPECT_NEAR((cube ^ parts).GetProperties().volume, sphereVol, 1e-4);
+}
+
+TEST(Boolean, SmallCut) {
+  const Manifold part = Manifold::Sphere(10, 256);
+  const Manifold cutter =
+      Manifold::Cylinder(2, 0.5, 0.5, 16, true).Translate({0, 0, 10});
+  const Manifold result = part - cutter;
+  EXPECT_EQ(result.Status(), Manifold::Error::NoError);
+  EXPECT_EQ(result.Genus(), 0);
+  EXPECT_TRUE(result.MatchesTriNormals());
+  EXPECT_LE(result.NumDegenerateTris(), 0);
+  const float cutVolume = (part ^ cutter).GetProperties().volume;
+  EXPECT_NEAR(result.GetProperties().volume,
+              part.GetProperties().volume - cutVolume, 1e-2);
+
+  // both inputs are clean, so cleaning up only around the cut gives the same
+  // mesh
+  ManifoldParams().cleanInputs = true;
+  const Manifold local = part - cutter;
+  ManifoldParams().cleanInputs = false;
+  EXPECT_EQ(local.Status(), Manifold::Error::NoError);
+  EXPECT_EQ(local.NumTri(), result.NumTri());
+  EXPECT_EQ(local.NumVert(), result.NumVert());
+  EXPECT_FLOAT_EQ(local.GetProperties().volume,
+                  result.GetProperties().volume);
+}
+
+TEST(Boolean, MemoryStats) {
+  const MemoryStats before = GetMemoryStats(MemoryCategory::VertPos);
+  ResetMemoryStats();
+  {
+    const Manifold sphere = Manifold::Sphere(1, 64);
+    const Manifold result = sphere - sphere.Translate({0.5, 0, 0});
+    EXPECT_GT(result.NumTri(), 0);
+  }
+  const MemoryCategory categories[] = {
+      MemoryCategory::VertPos, MemoryCategory::Halfedge,
+      MemoryCategory::SparseIndices, MemoryCategory::Collider};
+  const MemoryStats total = GetMemoryStats();
+  for (const MemoryCategory category : categories) {
+    const MemoryStats stats = GetMemoryStats(category);
+    EXPECT_GT(stats.peakBytes, 0);
+    EXPECT_GT(stats.allocations, 0);
+    EXPECT_LE(stats.peakBytes, total.peakBytes);
+  }
+  EXPECT_EQ(GetMemoryStats(MemoryCategory::VertPos).bytes, before.bytes);
+}
+
+TEST(Boolean, SAHCollider) {
+  // a detailed part in a wide, sparse assembly
+  auto assembly = []() {
+    const Manifold detail = Manifold::Sphere(0.01, 128);
+    const Manifold far = Manifold::Cube(glm::vec3(1), true).Translate(
+        {1000, 1000, 1000});
+    const Manifold cutter = Manifold::Sphere(0.01, 64).Translate({0.005, 0, 0});
+    return ((detail + far) - cutter).GetProperties().volume;
+  };
+  const float expected = assembly();
+  ManifoldParams().sahCollider = true;
+  EXPECT_NEAR(assembly(), expected, 1e-6);
+  ManifoldParams().mortonCode64 = true;
+  EXPECT_NEAR(assembly(), expected, 1e-6);
+  ManifoldParams().sahCollider = false;
+  EXPECT_NEAR(assembly(), expected, 1e-6);
+  ManifoldParams().mortonCode64 = false;
+}
+
+TEST(Boolean, WideCollider) {
+  auto difference = []() {
+    const Manifold sphere = Manifold::Sphere(1, 128);
+    const Manifold result = sphere - sphere.Rotate(10, 20, 30).Translate(
+                                         {0.5, 0.2, 0});
+    EXPECT_EQ(result.Status(), Manifold::Error::NoError);
+    return std::make_pair(result.NumTri(), result.GetProperties().volume);
+  };
+  const auto expected = difference();
+  ManifoldParams().wideCollider = true;
+  const auto wide = difference();
+  ManifoldParams().wideCollider = false;
+  EXPECT_EQ(wide.first, expected.first);
+  EXPECT_NEAR(wide.second, expected.second, 1e-5);
+}
+
+TEST(Boolean, CompactHalfedges) {
+  auto difference = []() {
+    const Manifold sphere = Manifold::Sphere(1, 96);
+    const Manifold result =
+        sphere - Manifold::Cube(glm::vec3(1.5)).Rotate(10, 20, 30);
+    EXPECT_EQ(result.Status(), Manifold::Error::NoError);
+    return std::make_pair(result.NumTri(), result.GetProperties().volume);
+  };
+  const auto expected = difference();
+  ManifoldParams().compactHalfedges = true;
+  const auto compact = difference();
+  ManifoldParams().compactHalfedges = false;
+  EXPECT_EQ(compact.first, expected.first);
+  EXPECT_FLOAT_EQ(compact.second, expected.second);
+}
+
+TEST(Boolean, ReusedCutter) {
+  // A new cutter for every hole has no edge cache to reuse.
+  auto drill = [](bool reuse) {
+    const Manifold cutter =
+        Manifold::Cylinder(3, 0.3, -1, 24).Translate({0, 0, -1});
+    Manifold part = Manifold::Cube({10, 4, 1});
+    for (int i = 0; i < 8; ++i) {
+      const Manifold hole =
+          reuse ? cutter
+                : Manifold::Cylinder(3, 0.3, -1, 24).Translate({0, 0, -1});
+      // alternate between axis-aligned and rotated placements
+      part -= hole.Rotate(0, 0, 45 * (i % 2)).Translate({1 + i, 2, 0});
+    }
+    EXPECT_EQ(part.Status(), Manifold::Error::NoError);
+    EXPECT_EQ(part.Genus(), 8);
+    return std::make_pair(part.NumTri(), part.GetProperties().volume);
+  };
+  const auto fresh = drill(false);
+  const auto reused = drill(true);
+  EXPECT_EQ(reused.first, fresh.first);
+  EXPECT_FLOAT_EQ(reused.second, fresh.second);
+
+  // The cache of an untransformed operand outlives the Boolean that built it.
+  const Manifold plate = Manifold::Cube({4, 4, 1});
+  const Manifold hole =
+      Manifold::Cylinder(3, 0.3, -1, 24).Translate({2, 2, -1});
+  const Manifold first = plate - hole;
+  EXPECT_EQ(first.Status(), Manifold::Error::NoError);
+  const Manifold second = plate.Translate({0, 0, 0.1}) - hole;
+  EXPECT_EQ(second.Status(), Manifold::Error::NoError);
+  EXPECT_EQ(second.Genus(), 1);
+  EXPECT_FLOAT_EQ(second.GetProperties().volume,
+                  first.GetProperties().volume);
+
+  // Small meshes query the edge collider of the larger one instead.
+  const Manifold sphere = Manifold::Sphere(1, 64);
+  const Manifold tet = Manifold::Tetrahedron().Scale(glm::vec3(1.5));
+  EXPECT_GT(tet.NumOverlaps(sphere), 0);
+  const float inside = (tet ^ sphere).GetProperties().volume;
+  const float outside = (tet - sphere).GetProperties().volume;
+  EXPECT_NEAR(inside + outside, tet.GetProperties().volume, 1e-4);
+}
+
+TEST(Boolean, ParallelSimplify) {
+  auto difference = []() {
+    // near-coincident surfaces leave many short edges to collapse
+    const Manifold sphere = Manifold::Sphere(1, 128);
+    const Manifold result =
+        sphere - sphere.Scale(glm::vec3(1.0001)).Translate({0.3, 0, 0});
+    EXPECT_EQ(result.Status(), Manifold::Error::NoError);
+    return result;
+  };
+  const Manifold expected = difference();
+  ManifoldParams().parallelSimplify = true;
+  const Manifold parallel = difference();
+  ManifoldParams().parallelSimplify = false;
+  EXPECT_EQ(parallel.Genus(), expected.Genus());
+  EXPECT_NEAR(parallel.GetProperties().volume,
+              expected.GetProperties().volume, 1e-5);
+}
+
+TEST(Boolean, RotatedInstances) {
+  const Manifold part = Manifold::Cube(glm::vec3(2), true) -
+                        Manifold::Sphere(1.2, 64).Translate({1, 0, 0});
+  const Manifold cutter = Manifold::Cylinder(4, 0.5, 0.5, 32, true);
+  const float expected = (part - cutter).GetProperties().volume;
+  for (const float angle : {17.0f, 45.0f, 133.0f}) {
+    // rotating both keeps the result volume, while exercising the refit of
+    // each rotated collider
+    const Manifold result =
+        part.Rotate(angle, 2 * angle, 0) - cutter.Rotate(angle, 2 * angle, 0);
+    EXPECT_EQ(result.Status(), Manifold::Error::NoError);
+    EXPECT_NEAR(result.GetProperties().volume, expected, 1e-3);
+  }
+}
+
 TEST(Boolean, Spiral) {
   ManifoldParams().deterministic = true;
   const int d = 2;
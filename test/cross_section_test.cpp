@@ -191,3 +191,105 @@ TEST(CrossSection, Hull) {
       circ_area * 2.5,
       (CrossSection::BatchBoolean(circs, OpType::Add) - tri).Area());
 }
+
+TEST(CrossSection, BatchBooleanTree) {
+  // enough overlapping squares for a parallel union tree
+  const CrossSection square = CrossSection::Square({1, 1});
+  std::vector<CrossSection> squares;
+  for (int i = 0; i < 40; ++i)
+    for (int j = 0; j < 40; ++j)
+      squares.push_back(square.Translate({0.9f * i, 0.9f * j}));
+  const CrossSection sheet = CrossSection::BatchBoolean(squares, OpType::Add);
+  const float side = 0.9f * 39 + 1;
+  EXPECT_NEAR(sheet.Area(), side * side, 1e-2);
+  EXPECT_EQ(sheet.NumContour(), 1);
+
+  // punch a hole from each of a few hundred cells
+  std::vector<CrossSection> punched = {sheet};
+  for (int i = 0; i < 20; ++i)
+    for (int j = 0; j < 20; ++j)
+      punched.push_back(CrossSection::Square({0.5, 0.5})
+                            .Translate({1.8f * i + 0.4f, 1.8f * j + 0.4f}));
+  const CrossSection holes =
+      CrossSection::BatchBoolean(punched, OpType::Subtract);
+  EXPECT_NEAR(holes.Area(), side * side - 400 * 0.25, 1e-2);
+  EXPECT_EQ(holes.NumContour(), 401);
+}
+
+TEST(CrossSection, TranslateFixedPoint) {
+  const CrossSection square = CrossSection::Square({1, 1});
+  CrossSection moved = square;
+  for (int i = 0; i < 10; ++i) {
+    moved = moved.Translate({0.1, 0.3});
+    EXPECT_FLOAT_EQ(moved.Area(), 1);
+  }
+  for (int i = 0; i < 10; ++i) {
+    moved = moved.Translate({-0.1, -0.3});
+    EXPECT_FLOAT_EQ(moved.Area(), 1);
+  }
+  // the float offsets add up exactly in double, so the round trip is exact
+  EXPECT_EQ((moved - square).Area(), 0);
+  EXPECT_EQ((square - moved).Area(), 0);
+
+  // whole units of the fixed-point grid shift the fixed-point paths exactly
+  const CrossSection shifted = square.Translate({1, -2}).Translate({-1, 2});
+  EXPECT_EQ((shifted - square).Area(), 0);
+  EXPECT_EQ((square - shifted).Area(), 0);
+
+  // offsets below the grid are not snapped away
+  CrossSection nudged = square;
+  for (int i = 0; i < 10; ++i) {
+    nudged = nudged.Translate({4e-9, 0});
+    EXPECT_FLOAT_EQ(nudged.Area(), 1);
+  }
+  EXPECT_NEAR(nudged.Bounds().min.x, 4e-8, 1e-12);
+  EXPECT_GT(square.Translate({1e-9, 0}).Bounds().min.x, 0);
+}
+
+TEST(CrossSection, Offsets) {
+  const CrossSection square = CrossSection::Square({10, 10}, true);
+  const std::vector<double> deltas = {1, -1, -2, -4.5, -6, -8};
+  const std::vector<CrossSection> rings =
+      square.Offsets(deltas, CrossSection::JoinType::Miter);
+  ASSERT_EQ(rings.size(), deltas.size());
+  for (int i = 0; i < 4; ++i) {
+    const float side = 10 + 2 * deltas[i];
+    EXPECT_NEAR(rings[i].Area(), side * side, 1e-4);
+    EXPECT_NEAR(
+        rings[i].Area(),
+        square.Offset(deltas[i], CrossSection::JoinType::Miter).Area(), 1e-6);
+  }
+  // past the center, the insets vanish
+  EXPECT_TRUE(rings[4].IsEmpty());
+  EXPECT_TRUE(rings[5].IsEmpty());
+}
+
+TEST(CrossSection, Contains) {
+  // a square ring, built from overlapping contours with NonZero, so the
+  // containment must follow the cleaned-up result
+  const CrossSection ring(
+      Polygons{{{0, 0}, {4, 0}, {4, 4}, {0, 4}},
+               {{1, 1}, {1, 3}, {3, 3}, {3, 1}},
+               {{0, 0}, {2, 0}, {2, 2}, {0, 2}}},
+      CrossSection::FillRule::NonZero);
+  const std::vector<glm::vec2> points = {
+      {0.5, 0.5}, {3.5, 3.5}, {2.5, 2.5}, {1.5, 1.5}, {5, 2}, {-1, 2},
+      {2, 0.5},   {0.5, 2},   {3.5, 2},   {2, 3.5}};
+  const std::vector<char> inside = ring.Contains(
+      {points.data(), static_cast<int>(points.size())});
+  const std::vector<char> expected = {1, 1, 0, 1, 0, 0, 1, 1, 1, 1};
+  ASSERT_EQ(inside.size(), expected.size());
+  for (int i = 0; i < points.size(); ++i)
+    EXPECT_EQ(inside[i], expected[i]) << points[i].x << ", " << points[i].y;
+
+  // agrees with Area on a dense grid over a circle
+  const CrossSection circle = CrossSection::Circle(1, 64);
+  std::vector<glm::vec2> grid;
+  for (int i = 0; i < 200; ++i)
+    for (int j = 0; j < 200; ++j)
+      grid.push_back({-1 + (i + 0.5f) / 100, -1 + (j + 0.5f) / 100});
+  int count = 0;
+  for (char in : circle.Contains({grid.data(), static_cast<int>(grid.size())}))
+    count += in;
+  EXPECT_NEAR(count / 10000.0, circle.Area(), 0.02);
+}
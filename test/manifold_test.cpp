@@ -15,6 +15,12 @@
 #include "manifold.h"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <set>
+#include <thread>
 
 #include "cross_section.h"
 #include "test.h"
@@ -67,6 +73,284 @@ TEST(Manifold, GetMeshGL) {
   }
 }
 
+TEST(Manifold, EvaluateAsync) {
+  const Manifold sphere = Manifold::Sphere(1, 64);
+  const Manifold tree = sphere + sphere.Translate({0.5, 0, 0}) -
+                        sphere.Translate({0, 0.5, 0});
+  std::shared_future<void> future = tree.EvaluateAsync();
+  future.wait();
+  EXPECT_EQ(future.wait_for(std::chrono::seconds(0)),
+            std::future_status::ready);
+  future.get();
+
+  const Manifold expected = (sphere + sphere.Translate({0.5, 0, 0})) -
+                            sphere.Translate({0, 0.5, 0});
+  EXPECT_EQ(tree.NumTri(), expected.NumTri());
+  EXPECT_FLOAT_EQ(tree.GetProperties().volume,
+                  expected.GetProperties().volume);
+}
+
+TEST(Manifold, ConcurrentQueries) {
+  const Manifold sphere = Manifold::Sphere(1, 64);
+  const Manifold shared = sphere - sphere.Translate({0, 0.5, 0});
+  const Manifold tree = (shared + shared.Translate({0.5, 0, 0})) ^
+                        shared.Scale({1.2, 1.2, 1.2});
+  const Manifold separate = sphere - sphere.Translate({0, 0.5, 0});
+  const float expected = ((separate + separate.Translate({0.5, 0, 0})) ^
+                          separate.Scale({1.2, 1.2, 1.2}))
+                             .GetProperties()
+                             .volume;
+
+  // copies share the lazy tree, so these threads race to evaluate it, its
+  // shared subtree and the transformed leaves
+  const Manifold copy = tree;
+  std::shared_future<void> future = tree.EvaluateAsync();
+  std::vector<float> volumes(4);
+  std::vector<int> numTri(4);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&, i]() {
+      const Manifold &m = i % 2 == 0 ? tree : copy;
+      volumes[i] = m.GetProperties().volume;
+      numTri[i] = m.NumTri();
+    });
+  }
+  for (auto &thread : threads) thread.join();
+  future.get();
+
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_FLOAT_EQ(volumes[i], expected);
+    EXPECT_EQ(numTri[i], tree.NumTri());
+  }
+}
+
+TEST(Manifold, ParallelThresholds) {
+  const ParallelThresholds defaults = GetParallelThresholds();
+  const Manifold sphere = Manifold::Sphere(1, 128);
+  const Manifold tree = sphere - sphere.Translate({0.5, 0.5, 0.5});
+  const float volume = tree.GetProperties().volume;
+
+  // everything serial
+  SetParallelThresholds({1 << 30, 1 << 30, 1 << 30});
+  EXPECT_EQ(GetParallelThresholds().heavy, 1 << 30);
+  const Manifold serial = sphere - sphere.Translate({0.5, 0.5, 0.5});
+  EXPECT_EQ(serial.NumTri(), tree.NumTri());
+  EXPECT_FLOAT_EQ(serial.GetProperties().volume, volume);
+
+  const ParallelThresholds calibrated = CalibrateParallelThresholds();
+  EXPECT_GT(calibrated.trivial, 0);
+  EXPECT_GT(calibrated.light, 0);
+  EXPECT_GT(calibrated.heavy, 0);
+  EXPECT_EQ(GetParallelThresholds().light, calibrated.light);
+
+  SetParallelThresholds(defaults);
+}
+
+TEST(Manifold, RunInContext) {
+  const Manifold sphere = Manifold::Sphere(1, 256);
+  std::mutex mutex;
+  std::set<std::thread::id> threads;
+  auto record = [&](glm::vec3&) {
+    std::lock_guard<std::mutex> lock(mutex);
+    threads.insert(std::this_thread::get_id());
+  };
+
+  ExecutionContext serial;
+  serial.maxConcurrency = 1;
+  RunInContext(serial, [&]() { sphere.Warp(record).NumTri(); });
+  ASSERT_EQ(threads.size(), 1);
+  EXPECT_EQ(*threads.begin(), std::this_thread::get_id());
+
+  int calls = 0;
+  ExecutionContext custom;
+  custom.executor = [&calls](const std::function<void()>& f) {
+    ++calls;
+    f();
+  };
+  Manifold result;
+  RunInContext(custom, [&]() {
+    result = sphere - sphere.Translate({0.5, 0, 0});
+    result.NumTri();
+  });
+  EXPECT_EQ(calls, 1);
+  EXPECT_FALSE(result.IsEmpty());
+}
+
+TEST(Manifold, Cancel) {
+  const Manifold sphere = Manifold::Sphere(1, 64);
+  std::atomic<bool> cancel(true);
+  ExecutionContext context;
+  context.cancel = &cancel;
+  Manifold result;
+  RunInContext(context, [&]() {
+    result = sphere - sphere.Translate({0.5, 0, 0});
+    result.NumTri();
+  });
+  EXPECT_EQ(result.Status(), Manifold::Error::Cancelled);
+  EXPECT_TRUE(result.IsEmpty());
+
+  // a deadline that has already passed acts the same
+  context.cancel = nullptr;
+  context.deadline = std::chrono::steady_clock::now();
+  const std::vector<glm::dvec3> pts = {glm::dvec3(0.2), glm::dvec3(0.8)};
+  std::vector<Manifold> parts;
+  RunInContext(context, [&]() {
+    parts = Manifold::Cube(glm::vec3(1)).Fracture(pts, {0, 0});
+  });
+  ASSERT_EQ(parts.size(), 1);
+  EXPECT_EQ(parts[0].Status(), Manifold::Error::Cancelled);
+
+  cancel = false;
+  context.cancel = &cancel;
+  context.deadline = std::chrono::steady_clock::time_point::max();
+  RunInContext(context, [&]() {
+    result = sphere - sphere.Translate({0.5, 0, 0});
+    result.NumTri();
+  });
+  EXPECT_EQ(result.Status(), Manifold::Error::NoError);
+  EXPECT_FALSE(result.IsEmpty());
+
+  // a cancelled evaluation is not kept, so a lazy Manifold shared with
+  // another operation evaluates in full outside the context
+  const Manifold lazy = sphere - sphere.Translate({0.5, 0, 0});
+  const Manifold shared = lazy.Translate({0, 0, 3});
+  cancel = true;
+  RunInContext(context, [&]() {
+    EXPECT_EQ(shared.Status(), Manifold::Error::Cancelled);
+    EXPECT_EQ(lazy.Status(), Manifold::Error::Cancelled);
+  });
+  EXPECT_EQ(lazy.Status(), Manifold::Error::NoError);
+  EXPECT_FALSE(lazy.IsEmpty());
+  EXPECT_EQ(shared.Status(), Manifold::Error::NoError);
+  EXPECT_EQ(shared.NumTri(), lazy.NumTri());
+}
+
+TEST(Manifold, MeshGLView) {
+  // a tetrahedron in caller-owned arrays
+  const float vertProperties[] = {-1, -1, 1, -1, 1, -1, 1, -1, -1, 1, 1, 1};
+  const uint32_t triVerts[] = {2, 0, 1, 0, 3, 1, 2, 3, 0, 3, 2, 1};
+  MeshGLView view;
+  view.vertProperties = {vertProperties, 12};
+  view.triVerts = {triVerts, 12};
+  const Manifold tet(view);
+  EXPECT_EQ(tet.Status(), Manifold::Error::NoError);
+  EXPECT_EQ(tet.NumTri(), 4);
+  EXPECT_FLOAT_EQ(tet.GetProperties().volume,
+                  Manifold::Tetrahedron().GetProperties().volume);
+
+  const Manifold part =
+      Manifold::Sphere(1, 16).SetProperties(
+          4, [](float* newProp, glm::vec3 pos, const float* oldProp) {
+            newProp[3] = pos.z;
+          }) -
+      Manifold::Cube(glm::vec3(1));
+  std::vector<float> props(4 * part.NumPropVert());
+  std::vector<uint32_t> tris(3 * part.NumTri());
+  EXPECT_FALSE(part.GetMeshGL({props.data(), 4}, {tris.data(), 3}));
+  ASSERT_TRUE(part.GetMeshGL({props.data(), static_cast<int>(props.size())},
+                             {tris.data(), static_cast<int>(tris.size())}));
+  const Mesh mesh = part.GetMesh();
+  for (int tri = 0; tri < part.NumTri(); ++tri) {
+    for (const int i : {0, 1, 2}) {
+      const float* prop = props.data() + 4 * tris[3 * tri + i];
+      const glm::vec3 pos = mesh.vertPos[mesh.triVerts[tri][i]];
+      EXPECT_EQ(glm::vec3(prop[0], prop[1], prop[2]), pos);
+      EXPECT_NEAR(prop[3], pos.z, 1e-5);
+    }
+  }
+}
+
+TEST(Manifold, StreamMesh) {
+  struct Collect : public MeshSink {
+    int numVert = 0;
+    std::vector<uint32_t> triVerts;
+    std::vector<uint32_t> runOriginalID;
+    void Begin(VecView<const glm::vec3> vertPos, int numTri) override {
+      numVert = vertPos.size();
+    }
+    void Tris(int firstTri, VecView<const glm::ivec3> tris,
+              int originalID) override {
+      EXPECT_EQ(firstTri, triVerts.size() / 3);
+      EXPECT_LE(tris.size(), 100);
+      for (const glm::ivec3& tri : tris)
+        for (const int i : {0, 1, 2}) triVerts.push_back(tri[i]);
+      if (runOriginalID.empty() || runOriginalID.back() != originalID)
+        runOriginalID.push_back(originalID);
+    }
+  };
+
+  const Manifold spheres = Manifold::Sphere(1, 32) +
+                           Manifold::Cube(glm::vec3(1)).Translate({1, 0, 0});
+  const MeshGL meshGL = spheres.GetMeshGL();
+  Collect sink;
+  spheres.StreamMesh(sink, 100);
+  EXPECT_EQ(sink.numVert, meshGL.NumVert());
+  EXPECT_EQ(sink.triVerts, meshGL.triVerts);
+  EXPECT_EQ(sink.runOriginalID, meshGL.runOriginalID);
+}
+
+TEST(Manifold, Serialize) {
+  const Manifold sphere = Manifold::Sphere(1, 32).SetProperties(
+      4, [](float* newProp, glm::vec3 pos, const float* oldProp) {
+        newProp[3] = pos.z;
+      });
+  const Manifold part = sphere - Manifold::Cube(glm::vec3(1));
+  const std::vector<char> buffer = part.Serialize();
+
+  const Manifold loaded = Manifold::Deserialize(buffer.data(), buffer.size());
+  EXPECT_EQ(loaded.Status(), Manifold::Error::NoError);
+  EXPECT_EQ(loaded.NumVert(), part.NumVert());
+  EXPECT_EQ(loaded.NumTri(), part.NumTri());
+  EXPECT_EQ(loaded.NumPropVert(), part.NumPropVert());
+  EXPECT_FLOAT_EQ(loaded.GetProperties().volume, part.GetProperties().volume);
+  EXPECT_TRUE((loaded - part).IsEmpty());
+
+  const Manifold truncated =
+      Manifold::Deserialize(buffer.data(), buffer.size() / 2);
+  EXPECT_TRUE(truncated.IsEmpty());
+  EXPECT_EQ(truncated.Status(), Manifold::Error::InvalidConstruction);
+}
+
+#ifdef MANIFOLD_EXPORT
+TEST(Manifold, NativeBinaryIO) {
+  const Manifold sphere = Manifold::Sphere(1, 32);
+  for (const std::string filename : {"nativeSphere.stl", "nativeSphere.ply"}) {
+    ExportMesh(filename, sphere.GetMeshGL(), {});
+    const Manifold imported(ImportMeshGL(filename));
+    EXPECT_EQ(imported.Status(), Manifold::Error::NoError);
+    EXPECT_EQ(imported.NumVert(), sphere.NumVert());
+    EXPECT_EQ(imported.NumTri(), sphere.NumTri());
+    EXPECT_NEAR(imported.GetProperties().volume,
+                sphere.GetProperties().volume, 1e-5);
+  }
+}
+
+TEST(Manifold, ExportManifold) {
+  const Manifold part = Manifold::Sphere(1, 32) - Manifold::Cube(glm::vec3(1));
+  ExportManifold("part.manifold", part);
+  const Manifold loaded = ImportManifold("part.manifold");
+  EXPECT_EQ(loaded.Status(), Manifold::Error::NoError);
+  EXPECT_EQ(loaded.NumTri(), part.NumTri());
+  EXPECT_FLOAT_EQ(loaded.GetProperties().volume, part.GetProperties().volume);
+}
+
+TEST(Manifold, StreamExport) {
+  const Manifold spheres = Manifold::Sphere(1, 32) +
+                           Manifold::Sphere(1, 32).Translate({1, 0, 0});
+  for (const std::string filename :
+       {"streamSpheres.stl", "streamSpheres.ply"}) {
+    // a small chunk size exercises the chunk and run boundaries
+    StreamExportMesh(filename, spheres, 100);
+    const Manifold imported(ImportMeshGL(filename));
+    EXPECT_EQ(imported.Status(), Manifold::Error::NoError);
+    EXPECT_EQ(imported.NumVert(), spheres.NumVert());
+    EXPECT_EQ(imported.NumTri(), spheres.NumTri());
+    EXPECT_NEAR(imported.GetProperties().volume,
+                spheres.GetProperties().volume, 1e-5);
+  }
+}
+#endif
+
 TEST(Manifold, Empty) {
   Mesh emptyMesh;
   Manifold empty(emptyMesh);
@@ -162,6 +446,144 @@ TEST(Manifold, Decompose) {
   RelatedGL(manifolds, input);
 }
 
+TEST(Manifold, DecomposeMany) {
+  const Manifold sphere = Manifold::Sphere(1, 8).SetProperties(
+      4, [](float* newProp, glm::vec3 pos, const float* oldProp) {
+        newProp[3] = pos.z;
+      });
+  std::vector<Manifold> spheres;
+  for (int i = 0; i < 500; ++i) {
+    spheres.push_back(sphere.Translate({3 * (i % 25), 3 * (i / 25), 0}));
+  }
+  const std::vector<Manifold> parts = Manifold::Compose(spheres).Decompose();
+  ASSERT_EQ(parts.size(), spheres.size());
+  for (const Manifold& part : parts) {
+    EXPECT_EQ(part.Status(), Manifold::Error::NoError);
+    EXPECT_EQ(part.NumVert(), sphere.NumVert());
+    EXPECT_EQ(part.NumTri(), sphere.NumTri());
+    EXPECT_EQ(part.NumProp(), sphere.NumProp());
+    EXPECT_EQ(part.NumPropVert(), sphere.NumPropVert());
+  }
+}
+
+TEST(Manifold, ComposeInstances) {
+  const Manifold sphere =
+      Manifold::Sphere(1, 8)
+          .SetProperties(4,
+                         [](float* newProp, glm::vec3 pos,
+                            const float* oldProp) { newProp[3] = pos.z; })
+          .AsOriginal();
+  const std::vector<Manifold> instances = {
+      sphere, sphere.Translate({3, 0, 0}),
+      sphere.Mirror({1, 0, 0}).Translate({-3, 0, 0}),
+      sphere.Scale({1, -1, 2}).Translate({0, 3, 0})};
+  const Manifold composed = Manifold::Compose(instances);
+  EXPECT_EQ(composed.Status(), Manifold::Error::NoError);
+  EXPECT_EQ(composed.NumTri(), 4 * sphere.NumTri());
+  EXPECT_EQ(composed.Decompose().size(), instances.size());
+  RelatedGL(composed, {sphere.GetMeshGL()});
+
+  // Each instance keeps its own meshID.
+  const MeshGL out = composed.GetMeshGL();
+  EXPECT_EQ(out.runOriginalID.size(), instances.size());
+
+  // The property follows its corner, including on the mirrored instances.
+  for (int vert = 0; vert < out.NumVert(); ++vert) {
+    const float* prop = &out.vertProperties[out.numProp * vert];
+    const float z = prop[2] / (prop[1] > 1.5f ? 2 : 1);
+    EXPECT_NEAR(prop[3], z, 1e-5);
+  }
+
+  // Tangents are dropped unless every instance has them.
+  const Manifold smooth = Manifold::Smooth(sphere.GetMesh());
+  EXPECT_FALSE(smooth.GetMeshGL().halfedgeTangent.empty());
+  EXPECT_TRUE(Manifold::Compose({smooth, sphere.Translate({3, 0, 0})})
+                  .GetMeshGL()
+                  .halfedgeTangent.empty());
+  EXPECT_FALSE(Manifold::Compose({smooth, smooth.Translate({3, 0, 0})})
+                   .GetMeshGL()
+                   .halfedgeTangent.empty());
+}
+
+TEST(Manifold, ComposeKeepOrder) {
+  const Manifold sphere = Manifold::Sphere(1, 32);
+  std::vector<Manifold> instances;
+  for (int i = 0; i < 16; ++i)
+    instances.push_back(sphere.Rotate(0, 0, 10 * i).Translate(
+        glm::vec3(3 * (i % 4), 3 * (i / 4), 0)));
+  const Manifold cutter = Manifold::Cube(glm::vec3(12, 1, 2), true);
+  auto composeAndCut = [&]() {
+    const Manifold composed = Manifold::Compose(instances);
+    EXPECT_EQ(composed.Status(), Manifold::Error::NoError);
+    const Manifold cut = composed - cutter.Translate({4.5, 4.5, 0});
+    EXPECT_EQ(cut.Status(), Manifold::Error::NoError);
+    return std::make_pair(composed, cut.GetProperties().volume);
+  };
+  const auto expected = composeAndCut();
+  ManifoldParams().keepComposeOrder = true;
+  const auto blocks = composeAndCut();
+  ManifoldParams().keepComposeOrder = false;
+  EXPECT_EQ(blocks.first.NumTri(), expected.first.NumTri());
+  EXPECT_FLOAT_EQ(blocks.first.GetProperties().volume,
+                  expected.first.GetProperties().volume);
+  EXPECT_FLOAT_EQ(blocks.second, expected.second);
+
+  // Each instance is a block in its own sorted order.
+  const Mesh first = instances[0].GetMesh();
+  const Mesh composed = blocks.first.GetMesh();
+  for (int vert = 0; vert < first.vertPos.size(); ++vert)
+    EXPECT_EQ(composed.vertPos[vert], first.vertPos[vert]);
+}
+
+TEST(Manifold, GetInstances) {
+  const Manifold bolt = Manifold::Cylinder(2, 0.3f, -1, 16);
+  const Manifold nut = Manifold::Cube(glm::vec3(0.5f));
+  std::vector<Manifold> parts;
+  for (int i = 0; i < 100; ++i) {
+    parts.push_back(bolt.Translate(glm::vec3(i, 0, 0)));
+    parts.push_back(nut.Translate(glm::vec3(i, 5, 0)));
+  }
+  const Manifold assembly = Manifold::BatchBoolean(parts, OpType::Add);
+
+  std::vector<MeshInstances> instances = assembly.GetInstances();
+  ASSERT_EQ(instances.size(), 2);
+  for (const MeshInstances& instance : instances) {
+    EXPECT_EQ(instance.transforms.size(), 100);
+    float sumX = 0;
+    for (const glm::mat4x3& transform : instance.transforms)
+      sumX += transform[3].x;
+    EXPECT_FLOAT_EQ(sumX, 4950);
+  }
+  EXPECT_EQ(instances[0].mesh.NumTri() + instances[1].mesh.NumTri(),
+            bolt.NumTri() + nut.NumTri());
+  EXPECT_EQ(assembly.NumTri(), 100 * (bolt.NumTri() + nut.NumTri()));
+
+  // Overlapping copies are evaluated into a single mesh.
+  const Manifold overlap = bolt + bolt.Translate({0.1f, 0, 0});
+  instances = overlap.GetInstances();
+  ASSERT_EQ(instances.size(), 1);
+  ASSERT_EQ(instances[0].transforms.size(), 1);
+  EXPECT_EQ(instances[0].transforms[0], glm::mat4x3(1.0f));
+  EXPECT_EQ(instances[0].mesh.NumTri(), overlap.NumTri());
+}
+
+TEST(Manifold, Fracture) {
+  const Manifold cube = Manifold::Cube(glm::vec3(4), true);
+  std::vector<glm::dvec3> pts;
+  for (int i = 0; i < 64; ++i) {
+    pts.push_back({i % 4 - 1.5, (i / 4) % 4 - 1.5, i / 16 - 1.5});
+  }
+  const std::vector<Manifold> chunks = cube.Fracture(pts, {});
+  ASSERT_EQ(chunks.size(), pts.size());
+  float volume = 0;
+  for (const Manifold& chunk : chunks) {
+    EXPECT_EQ(chunk.Status(), Manifold::Error::NoError);
+    EXPECT_NEAR(chunk.GetProperties().volume, 1, 1e-3);
+    volume += chunk.GetProperties().volume;
+  }
+  EXPECT_NEAR(volume, cube.GetProperties().volume, 1e-2);
+}
+
 /**
  * These tests check the various manifold constructors.
  */
@@ -199,6 +621,24 @@ TEST(Manifold, ExtrudeCone) {
   EXPECT_FLOAT_EQ(donut.GetProperties().volume, 4.0f);
 }
 
+TEST(Manifold, ExtrudeRepeated) {
+  const CrossSection washer =
+      CrossSection::Circle(2, 32) - CrossSection::Square({1, 1}, true);
+  const Manifold first = Manifold::Extrude(washer, 2, 4, 90, {0.5, 0.5});
+  // the second reuses the cached cap
+  const Manifold second = Manifold::Extrude(washer, 2, 4, 90, {0.5, 0.5});
+  EXPECT_EQ(first.Status(), Manifold::Error::NoError);
+  EXPECT_EQ(first.Genus(), 1);
+  Identical(first.GetMesh(), second.GetMesh());
+
+  // the same as building the halfedges from scratch
+  const Manifold rebuilt(first.GetMesh());
+  EXPECT_EQ(rebuilt.NumTri(), first.NumTri());
+  EXPECT_EQ(rebuilt.Genus(), first.Genus());
+  EXPECT_FLOAT_EQ(rebuilt.GetProperties().volume,
+                  first.GetProperties().volume);
+}
+
 Polygons RotatePolygons(Polygons polys, const int index) {
   Polygons rotatedPolys;
   for (auto& polygon : polys) {
@@ -328,6 +768,31 @@ TEST(Manifold, WarpBatch) {
   EXPECT_EQ(prop1.surfaceArea, prop2.surfaceArea);
 }
 
+TEST(Manifold, SetPropertiesBatch) {
+  const Manifold sphere = Manifold::Sphere(1, 32);
+  auto propFunc = [](float* newProp, glm::vec3 pos, const float* oldProp) {
+    newProp[0] = pos.x + pos.y;
+    newProp[1] = pos.z;
+  };
+  const std::function<void(float*, glm::vec3, const float*)> wrapped =
+      propFunc;
+  const MeshGL perVert = sphere.SetProperties(2, wrapped).GetMeshGL();
+  const MeshGL inlined = sphere.SetProperties(2, propFunc).GetMeshGL();
+  auto batchFunc = [](VecView<float> newProp,
+                      VecView<const glm::vec3> position,
+                      VecView<const float> oldProp) {
+    for (int i = 0; i < position.size(); ++i) {
+      newProp[2 * i] = position[i].x + position[i].y;
+      newProp[2 * i + 1] = position[i].z;
+    }
+  };
+  const MeshGL batch = sphere.SetPropertiesBatch(2, batchFunc).GetMeshGL();
+
+  EXPECT_EQ(perVert.numProp, 5);
+  EXPECT_EQ(perVert.vertProperties, inlined.vertProperties);
+  EXPECT_EQ(perVert.vertProperties, batch.vertProperties);
+}
+
 TEST(Manifold, Smooth) {
   Manifold tet = Manifold::Tetrahedron();
   Manifold smooth = Manifold::Smooth(tet.GetMesh());
@@ -362,6 +827,71 @@ TEST(Manifold, SmoothSphere) {
   }
 }
 
+TEST(Manifold, RefineToLength) {
+  const Manifold box = Manifold::Cube({10, 1, 1});
+  const Manifold refined = box.RefineToLength(1);
+  EXPECT_EQ(refined.Status(), Manifold::Error::NoError);
+  EXPECT_NEAR(refined.GetProperties().volume, 10, 1e-4);
+  // the end faces are barely split, unlike with uniform refinement
+  EXPECT_GT(refined.NumTri(), box.NumTri());
+  EXPECT_LT(refined.NumTri(), box.Refine(10).NumTri());
+
+  const Mesh mesh = refined.GetMesh();
+  for (const glm::ivec3& tri : mesh.triVerts) {
+    for (const int i : {0, 1, 2}) {
+      const float length = glm::length(mesh.vertPos[tri[(i + 1) % 3]] -
+                                       mesh.vertPos[tri[i]]);
+      EXPECT_LE(length, 1.5f);
+    }
+  }
+}
+
+TEST(Manifold, RefineToLengthClamped) {
+  // asks for far more than INT_MAX pieces per edge
+  const Manifold tet = Manifold::Tetrahedron();
+  const Manifold refined = tet.RefineToLength(1e-30);
+  EXPECT_EQ(refined.Status(), Manifold::Error::NoError);
+  EXPECT_EQ(refined.NumTri(), tet.NumTri() * 512 * 512);
+  EXPECT_NEAR(refined.GetProperties().volume, tet.GetProperties().volume,
+              1e-4);
+}
+
+TEST(Manifold, RefineToPrecision) {
+  const Manifold smooth = Manifold::Smooth(Manifold::Sphere(1, 16).GetMesh());
+  const Manifold refined = smooth.RefineToPrecision(0.001);
+  EXPECT_EQ(refined.Status(), Manifold::Error::NoError);
+  EXPECT_GT(refined.NumTri(), smooth.NumTri());
+  for (const glm::vec3& v : refined.GetMesh().vertPos)
+    EXPECT_NEAR(glm::length(v), 1, 0.005);
+  // without tangents there is nothing to refine
+  EXPECT_EQ(Manifold::Sphere(1, 16).RefineToPrecision(0.001).NumTri(),
+            Manifold::Sphere(1, 16).NumTri());
+}
+
+TEST(Manifold, Simplify) {
+  const Manifold sphere = Manifold::Sphere(1, 128);
+  const int target = sphere.NumTri() / 10;
+  const Manifold simple = sphere.Simplify(target);
+  EXPECT_EQ(simple.Status(), Manifold::Error::NoError);
+  EXPECT_LE(simple.NumTri(), target);
+  EXPECT_GT(simple.NumTri(), target / 2);
+  EXPECT_EQ(simple.Genus(), 0);
+  EXPECT_NEAR(simple.GetProperties().volume, sphere.GetProperties().volume,
+              0.05);
+
+  // coplanar triangles collapse for free, but the corners cannot move
+  const Manifold box = Manifold::Cube().Refine(4);
+  const Manifold flat = box.Simplify(0, 1e-5);
+  EXPECT_LT(flat.NumTri(), box.NumTri() / 4);
+  EXPECT_NEAR(flat.GetProperties().volume, 1, 1e-5);
+
+  // the boundary between the runs of the two inputs is kept
+  const Manifold diff =
+      Manifold::Cube(glm::vec3(2), true) - Manifold::Sphere(1.2, 64);
+  const MeshGL diffGL = diff.Simplify(0).GetMeshGL();
+  EXPECT_EQ(diffGL.runOriginalID.size(), 2);
+}
+
 TEST(Manifold, ManualSmooth) {
   // Unit Octahedron
   const Mesh oct = Manifold::Sphere(1, 4).GetMesh();
@@ -560,6 +1090,36 @@ TEST(Manifold, Slice) {
   EXPECT_EQ(top.Area(), 0);
 }
 
+TEST(Manifold, Slices) {
+  const Manifold sphere = Manifold::Sphere(1, 64);
+  const std::vector<float> heights = {0.5, -0.9, 0, 1, 0.25, -2, 0};
+  const std::vector<CrossSection> slices = sphere.Slices(heights);
+  ASSERT_EQ(slices.size(), heights.size());
+  for (int i = 0; i < heights.size(); ++i) {
+    const CrossSection single = sphere.Slice(heights[i]);
+    EXPECT_NEAR(slices[i].Area(), single.Area(), 1e-5) << heights[i];
+    EXPECT_EQ(slices[i].NumContour(), single.NumContour()) << heights[i];
+  }
+  EXPECT_EQ(slices[5].Area(), 0);
+  EXPECT_GT(slices[2].Area(), slices[0].Area());
+}
+
+TEST(Manifold, ProjectTiled) {
+  // Enough silhouette verts that the outline is unioned in parallel tiles,
+  // with tile borders cutting through the cylinders.
+  const Manifold cylinder = Manifold::Cylinder(1, 0.7, -1, 64);
+  std::vector<Manifold> cylinders;
+  for (int i = 0; i < 18; ++i) {
+    for (int j = 0; j < 18; ++j) {
+      cylinders.push_back(cylinder.Translate({2 * i, 2 * j, 0}));
+    }
+  }
+  const CrossSection projection = Manifold::Compose(cylinders).Project();
+  EXPECT_EQ(projection.NumContour(), cylinders.size());
+  EXPECT_NEAR(projection.Area(),
+              cylinders.size() * cylinder.Project().Area(), 1e-2);
+}
+
 TEST(Manifold, MeshRelation) {
   Mesh gyroidMesh = Gyroid();
   MeshGL gyroidMeshGL = WithIndexColors(gyroidMesh);
@@ -640,6 +1200,42 @@ TEST(Manifold, Merge) {
   CheckCube(cubeSTL);
 }
 
+TEST(Manifold, MergeSoup) {
+  const Manifold sphere = Manifold::Sphere(1, 128);
+  const MeshGL in = sphere.GetMeshGL();
+  MeshGL soup;
+  for (const uint32_t vert : in.triVerts) {
+    soup.triVerts.push_back(soup.triVerts.size());
+    for (const int j : {0, 1, 2})
+      soup.vertProperties.push_back(in.vertProperties[3 * vert + j]);
+  }
+  EXPECT_TRUE(soup.Merge());
+  EXPECT_EQ(soup.mergeFromVert.size(), soup.NumVert() - sphere.NumVert());
+
+  const Manifold welded(soup);
+  EXPECT_EQ(welded.Status(), Manifold::Error::NoError);
+  EXPECT_EQ(welded.NumVert(), sphere.NumVert());
+  EXPECT_EQ(welded.Genus(), 0);
+  EXPECT_FLOAT_EQ(welded.GetProperties().volume,
+                  sphere.GetProperties().volume);
+}
+
+TEST(Manifold, MergeDegenerateEdge) {
+  MeshGL cube = Manifold::Cube().GetMeshGL();
+  EXPECT_FALSE(cube.Merge());
+  // two new copies of vert 0, each only in a triangle with an edge from the
+  // copy to itself, which counts as open
+  const uint32_t copy = cube.NumVert();
+  for (const uint32_t vert : {copy, copy + 1}) {
+    for (const int j : {0, 1, 2})
+      cube.vertProperties.push_back(cube.vertProperties[j]);
+    cube.triVerts.insert(cube.triVerts.end(), {vert, vert, 0});
+  }
+  EXPECT_TRUE(cube.Merge());
+  ASSERT_EQ(cube.mergeFromVert.size(), 1);
+  EXPECT_EQ(cube.mergeFromVert[0] + cube.mergeToVert[0], 2 * copy + 1);
+}
+
 TEST(Manifold, FaceIDRoundTrip) {
   const Manifold cube = Manifold::Cube();
   ASSERT_GE(cube.OriginalID(), 0);
@@ -784,6 +1380,29 @@ TEST(Manifold, CubeHull) {
   EXPECT_FLOAT_EQ(cube.GetProperties().volume, 1);
 }
 
+TEST(Manifold, BatchHull) {
+  // enough interior points to be prefiltered
+  std::mt19937 gen(12345);
+  std::uniform_real_distribution<float> dist(0.1, 0.9);
+  std::vector<glm::vec3> pts;
+  for (int i = 0; i < 10000; ++i)
+    pts.push_back({dist(gen), dist(gen), dist(gen)});
+  for (int i = 0; i < 8; ++i)
+    pts.push_back(glm::vec3(i & 1, (i >> 1) & 1, i >> 2));
+  EXPECT_FLOAT_EQ(Manifold::Hull(pts).GetProperties().volume, 1);
+
+  const Manifold sphere = Manifold::Sphere(1, 64);
+  const std::vector<Manifold> hulls = Manifold::BatchHull(
+      {{sphere, sphere.Translate({2, 0, 0})},
+       {sphere},
+       {sphere.Translate({0, 3, 0}), sphere}});
+  ASSERT_EQ(hulls.size(), 3);
+  EXPECT_FLOAT_EQ(hulls[1].GetProperties().volume,
+                  sphere.GetProperties().volume);
+  EXPECT_FLOAT_EQ(hulls[0].BoundingBox().max.x, 3);
+  EXPECT_FLOAT_EQ(hulls[2].BoundingBox().max.y, 4);
+}
+
 TEST(Manifold, EmptyHull) {
   const std::vector<glm::vec3> tooFew{{0, 0, 0}, {1, 0, 0}, {0, 1, 0}};
   EXPECT_TRUE(Manifold::Hull(tooFew).IsEmpty());
@@ -793,6 +1412,19 @@ TEST(Manifold, EmptyHull) {
   EXPECT_TRUE(Manifold::Hull(coplanar).IsEmpty());
 }
 
+TEST(Manifold, ReflexFaces) {
+  const Manifold cube = Manifold::Cube({2, 2, 2});
+  EXPECT_TRUE(cube.ReflexFaces().empty());
+
+  // the faces along the notch's inside edge
+  const Manifold notched =
+      cube - Manifold::Cube({1, 1, 3}).Translate({1, 1, -0.5});
+  const std::vector<int> reflex = notched.ReflexFaces();
+  EXPECT_FALSE(reflex.empty());
+  EXPECT_TRUE(std::is_sorted(reflex.begin(), reflex.end()));
+  EXPECT_TRUE(std::adjacent_find(reflex.begin(), reflex.end()) == reflex.end());
+}
+
 TEST(Manifold, ConvexDecomposition) {
   Manifold sphere = Manifold::Sphere(0.6, 20);
   Manifold cube = Manifold::Cube({1.0, 1.0, 1.0}, true);
@@ -810,3 +1442,221 @@ TEST(Manifold, ConvexDecomposition) {
   float union_volume = manifold_union.GetProperties().volume;
   EXPECT_NEAR(originalVolume, union_volume, 1e-6);
 }
+
+TEST(Manifold, ApproxConvexDecomposition) {
+  const Manifold notched =
+      Manifold::Cube({2, 2, 2}) -
+      Manifold::Cube({1, 1, 3}).Translate({1, 1, -0.5});
+  // a single cut through the middle leaves two boxes
+  const std::vector<Manifold> parts =
+      notched.ApproxConvexDecomposition(0.01, 8);
+  EXPECT_EQ(parts.size(), 2);
+  float volume = 0;
+  for (const Manifold& part : parts) {
+    EXPECT_TRUE(part.ReflexFaces().empty());
+    volume += part.GetProperties().volume;
+  }
+  EXPECT_NEAR(volume, 6, 1e-5);
+
+  const std::vector<Manifold> hull = notched.ApproxConvexDecomposition(0, 1);
+  ASSERT_EQ(hull.size(), 1);
+  EXPECT_NEAR(hull[0].GetProperties().volume, 8, 1e-5);
+}
+
+TEST(Manifold, Offset) {
+  const Manifold cube = Manifold::Cube({2, 2, 2}, true);
+  const Manifold grown = cube.Offset(0.5, 0.1);
+  EXPECT_EQ(grown.Status(), Manifold::Error::NoError);
+  EXPECT_EQ(grown.Genus(), 0);
+  EXPECT_NEAR(grown.BoundingBox().max.x, 1.5, 0.05);
+  // the cube, slabs on its faces, quarter cylinders on its edges and eighths
+  // of a sphere on its corners
+  const float rounded = 8 + 12 + 1.5f * glm::pi<float>() + glm::pi<float>() / 6;
+  EXPECT_NEAR(grown.GetProperties().volume, rounded, 0.2);
+
+  const Manifold shrunk = cube.Offset(-0.5, 0.1);
+  EXPECT_NEAR(shrunk.BoundingBox().max.x, 0.5, 0.05);
+  EXPECT_NEAR(shrunk.GetProperties().volume, 1, 0.05);
+}
+
+TEST(Manifold, MinkowskiConvex) {
+  const Manifold cube = Manifold::Cube({1, 1, 1}, true);
+  const Manifold sphere = Manifold::Sphere(0.5, 64);
+  for (const bool naive : {true, false}) {
+    const Manifold sum = Manifold::Minkowski(cube, cube, naive);
+    EXPECT_NEAR(sum.GetProperties().volume, 8, 1e-5);
+
+    const Manifold rounded = Manifold::Minkowski(cube, sphere, naive);
+    const Box box = rounded.BoundingBox();
+    EXPECT_NEAR(box.max.x, 1, 1e-5);
+    EXPECT_NEAR(box.min.z, -1, 1e-5);
+    EXPECT_GT(rounded.GetProperties().volume, 1 + 6 * 0.9);
+  }
+}
+
+TEST(Manifold, MinkowskiNonConvex) {
+  const Manifold notched =
+      Manifold::Cube({2, 2, 2}) -
+      Manifold::Cube({1, 1, 3}).Translate({1, 1, -0.5});
+  const Manifold small = notched.Scale(glm::vec3(0.25));
+  const Manifold sum = Manifold::Minkowski(notched, small, true);
+  EXPECT_EQ(sum.Status(), Manifold::Error::NoError);
+  EXPECT_EQ(sum.Genus(), 0);
+  const Box box = sum.BoundingBox();
+  EXPECT_NEAR(box.max.x, 2.5, 1e-5);
+  EXPECT_NEAR(box.max.z, 2.5, 1e-5);
+  // both are prisms, so the sum is the sum of their L-shaped profiles,
+  // extruded
+  EXPECT_NEAR(sum.GetProperties().volume, 5.125 * 2.5, 1e-3);
+}
+
+TEST(Manifold, MinkowskiConvexParts) {
+  const Manifold notched =
+      Manifold::Cube({2, 2, 2}) -
+      Manifold::Cube({1, 1, 3}).Translate({1, 1, -0.5});
+  const Manifold cube = Manifold::Cube({0.5, 0.5, 0.5}, true);
+  const ConvexParts notchedParts(notched);
+  const ConvexParts cubeParts(cube);
+  EXPECT_GT(notchedParts.NumParts(), 1);
+  EXPECT_NEAR(notchedParts.ToManifold().GetProperties().volume, 6, 1e-5);
+
+  const double volume =
+      Manifold::Minkowski(notched, cube).GetProperties().volume;
+  EXPECT_NEAR(Manifold::Minkowski(notchedParts, cubeParts)
+                  .GetProperties()
+                  .volume,
+              volume, 1e-4);
+  // reusing the decomposition under a transform
+  const Manifold moved =
+      Manifold::Minkowski(notchedParts, cubeParts.Translate({5, 0, 0}));
+  EXPECT_NEAR(moved.GetProperties().volume, volume, 1e-4);
+  EXPECT_NEAR(moved.BoundingBox().min.x, 4.75, 1e-5);
+}
+
+TEST(Manifold, BufferPool) {
+  static std::atomic<int> numAlloc(0);
+  BufferAllocator allocator;
+  allocator.allocate = [](size_t bytes, void*) {
+    ++numAlloc;
+    return malloc(bytes);
+  };
+  allocator.deallocate = [](void* ptr, size_t, void*) { free(ptr); };
+  allocator.poolSize = 1 << 26;
+  SetBufferAllocator(allocator);
+
+  auto difference = []() {
+    Manifold sphere = Manifold::Sphere(1, 64);
+    return (sphere - sphere.Translate({0.5, 0, 0})).GetProperties().volume;
+  };
+  const float volume = difference();
+  const int firstAlloc = numAlloc;
+  numAlloc = 0;
+  EXPECT_FLOAT_EQ(difference(), volume);
+  EXPECT_LT(numAlloc, firstAlloc);
+
+  SetBufferAllocator(BufferAllocator());
+}
+
+TEST(Manifold, BufferPoolSwapWhileLive) {
+  struct Counts {
+    std::atomic<int> numAlloc{0};
+    std::atomic<int> numFree{0};
+  };
+  auto counting = [](Counts* counts) {
+    BufferAllocator allocator;
+    allocator.allocate = [](size_t bytes, void* context) {
+      ++static_cast<Counts*>(context)->numAlloc;
+      return malloc(bytes);
+    };
+    allocator.deallocate = [](void* ptr, size_t, void* context) {
+      ++static_cast<Counts*>(context)->numFree;
+      free(ptr);
+    };
+    allocator.context = counts;
+    allocator.poolSize = 1 << 26;
+    return allocator;
+  };
+  static Counts first, second;
+
+  SetBufferAllocator(counting(&first));
+  {
+    const Manifold sphere = Manifold::Sphere(1, 64);
+    const float volume = sphere.GetProperties().volume;
+    // swap while the sphere's buffers are outstanding
+    SetBufferAllocator(counting(&second));
+    const Manifold difference = sphere - sphere.Translate({0.5, 0, 0});
+    EXPECT_LT(difference.GetProperties().volume, volume);
+    EXPECT_GT(second.numAlloc, 0);
+  }
+  SetBufferAllocator(BufferAllocator());
+
+  // every buffer went back to the allocator it came from
+  EXPECT_GT(first.numAlloc, 0);
+  EXPECT_EQ(first.numFree, first.numAlloc);
+  EXPECT_EQ(second.numFree, second.numAlloc);
+}
+
+TEST(Manifold, RayCast) {
+  const Manifold cube = Manifold::Cube(glm::vec3(2), true).Translate({0, 0, 1});
+  const std::vector<glm::vec3> origins = {
+      {-5, 0.1, 1.2}, {0.2, 0.3, 1}, {5, 5, 5}, {0.3, -0.2, 10}};
+  const std::vector<glm::vec3> directions = {
+      {2, 0, 0}, {0, 0, -1}, {1, 0, 0}, {0, 0, -3}};
+  const std::vector<RayHit> hits = cube.RayCast(origins, directions);
+  ASSERT_EQ(hits.size(), 4);
+
+  EXPECT_FLOAT_EQ(hits[0].distance, 4);
+  EXPECT_NEAR(hits[0].position.x, -1, 1e-6);
+  EXPECT_NEAR(hits[0].normal.x, -1, 1e-6);
+  // from inside
+  EXPECT_FLOAT_EQ(hits[1].distance, 1);
+  EXPECT_NEAR(hits[1].normal.z, -1, 1e-6);
+  // miss
+  EXPECT_EQ(hits[2].face, -1);
+  EXPECT_FLOAT_EQ(hits[3].distance, 8);
+  EXPECT_GE(hits[3].face, 0);
+  EXPECT_LT(hits[3].face, cube.NumTri());
+
+  // parallel to, and lying on, the plane of the side x = 1
+  const std::vector<RayHit> grazing = cube.RayCast({{1, 0.3, 5}}, {{0, 0, -1}});
+  EXPECT_FLOAT_EQ(grazing[0].distance, 3);
+}
+
+TEST(Manifold, ClosestPoint) {
+  const Manifold sphere = Manifold::Sphere(1, 128);
+  const std::vector<glm::vec3> points = {{3, 0, 0}, {0, 0.2, 0}, {0, 0, -2}};
+  const std::vector<SurfacePoint> closest = sphere.ClosestPoint(points);
+  ASSERT_EQ(closest.size(), 3);
+  EXPECT_NEAR(closest[0].distance, 2, 1e-3);
+  EXPECT_NEAR(closest[0].position.x, 1, 1e-3);
+  EXPECT_NEAR(closest[1].distance, 0.8, 1e-3);
+  EXPECT_NEAR(closest[2].position.z, -1, 1e-3);
+  for (const SurfacePoint& point : closest) EXPECT_GE(point.face, 0);
+
+  EXPECT_EQ(Manifold().ClosestPoint(points)[0].face, -1);
+}
+
+TEST(Manifold, Contains) {
+  // the rays from these points run exactly along the diagonals of the
+  // cube's top and bottom faces
+  const Manifold cube = Manifold::Cube(glm::vec3(2), true);
+  const std::vector<glm::vec3> onDiagonal = {
+      {0, 0, 0}, {0.5, 0.5, 0}, {-0.5, 0.5, 0}, {0, 0, -5}, {0, 0, 5}};
+  const std::vector<char> cubeInside =
+      cube.Contains({onDiagonal.data(), static_cast<int>(onDiagonal.size())});
+  EXPECT_EQ(cubeInside, std::vector<char>({1, 1, 1, 0, 0}));
+
+  const Manifold sphere = Manifold::Sphere(1, 64);
+  std::vector<glm::vec3> grid;
+  for (int i = -6; i <= 6; ++i)
+    for (int j = -6; j <= 6; ++j)
+      for (int k = -6; k <= 6; ++k) grid.push_back(glm::vec3(i, j, k) / 5.0f);
+  const std::vector<char> inside =
+      sphere.Contains({grid.data(), static_cast<int>(grid.size())});
+  ASSERT_EQ(inside.size(), grid.size());
+  for (int i = 0; i < grid.size(); ++i) {
+    const float r = glm::length(grid[i]);
+    if (glm::abs(r - 1) < 0.01) continue;
+    EXPECT_EQ(inside[i], r < 1) << "point " << i;
+  }
+}
@@ -130,6 +130,52 @@ TEST(CBIND, compose_decompose) {
   manifold_delete_manifold_vec(decomposed);
 }
 
+TEST(CBIND, batch) {
+  size_t sz = manifold_manifold_size();
+  const int n = 4;
+
+  ManifoldManifold *cube = manifold_cube(malloc(sz), 1, 1, 1, 0);
+  float transforms[12 * n];
+  for (int i = 0; i < n; ++i) {
+    float *t = transforms + 12 * i;
+    for (int j = 0; j < 12; ++j) t[j] = j % 4 == 0 ? 1 : 0;
+    t[9] = 2 * i;
+  }
+  ManifoldManifoldVec *instances = manifold_instances(
+      malloc(manifold_manifold_vec_size()), cube, transforms, n);
+  EXPECT_EQ(manifold_manifold_vec_length(instances), n);
+  ManifoldManifold *composed = manifold_compose(malloc(sz), instances);
+  EXPECT_NEAR(manifold_get_properties(composed).volume, n, 0.0001);
+
+  ManifoldManifold *parts[n];
+  for (int i = 0; i < n; ++i)
+    parts[i] = manifold_manifold_vec_get(malloc(sz), instances, i);
+  ManifoldManifold *unioned =
+      manifold_batch_boolean_array(malloc(sz), parts, n, MANIFOLD_ADD);
+  EXPECT_NEAR(manifold_get_properties(unioned).volume, n, 0.0001);
+
+  const int numProp = 3 + manifold_num_prop(unioned);
+  const int numVert = manifold_num_prop_vert(unioned);
+  const int numTri = manifold_num_tri(unioned);
+  EXPECT_EQ(numProp, 3);
+  EXPECT_EQ(numTri, 12 * n);
+  std::vector<float> vertProps(numProp * numVert);
+  std::vector<uint32_t> triVerts(3 * numTri);
+  EXPECT_FALSE(manifold_get_meshgl_buffers(unioned, vertProps.data(),
+                                           vertProps.size(), triVerts.data(),
+                                           triVerts.size() - 1));
+  EXPECT_TRUE(manifold_get_meshgl_buffers(unioned, vertProps.data(),
+                                          vertProps.size(), triVerts.data(),
+                                          triVerts.size()));
+  for (uint32_t vert : triVerts) EXPECT_LT(vert, numVert);
+
+  manifold_delete_manifolds(parts, n);
+  manifold_delete_manifold(cube);
+  manifold_delete_manifold_vec(instances);
+  manifold_delete_manifold(composed);
+  manifold_delete_manifold(unioned);
+}
+
 TEST(CBIND, polygons) {
   ManifoldVec2 vs[] = {{0, 0}, {1, 1}, {2, 2}};
   ManifoldSimplePolygon *sp =
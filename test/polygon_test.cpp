@@ -74,3 +74,32 @@ void TestPoly(const Polygons &polys, int expectedNumTri,
 }  // namespace
 
 #include "polygon_corpus.cpp"
+
+TEST(Polygon, LargeStar) {
+  // Enough verts that the ear checks go through the spatial grid.
+  const int n = 10000;
+  SimplePolygon star;
+  for (int i = 0; i < n; ++i) {
+    const float angle = glm::two_pi<float>() * i / n;
+    const float radius = i % 2 == 0 ? 10 : 9;
+    star.push_back(radius * glm::vec2(glm::cos(angle), glm::sin(angle)));
+  }
+  const SimplePolygon hole = {{-1, -1}, {-1, 1}, {1, 1}, {1, -1}};
+  TestPoly({star, hole}, n + 4);
+}
+
+TEST(Polygon, Monotone) {
+  Polygons polys;
+  polys.push_back({
+      {0, 0},    //
+      {2, 0},    //
+      {1, 1},    //
+      {2, 2},    //
+      {1.5, 3},  //
+      {2, 4},    //
+      {0, 4},    //
+      {0.5, 3},  //
+      {0, 2},    //
+  });
+  TestPoly(polys, 7);
+}
@@ -14,6 +14,9 @@
 
 #include "sdf.h"
 
+#include <atomic>
+#include <thread>
+
 #include "manifold.h"
 #include "test.h"
 
@@ -116,6 +119,138 @@ TEST(SDF, Resize) {
   EXPECT_EQ(layers.Genus(), -8);
 }
 
+TEST(SDF, NarrowBand) {
+  std::atomic<int> numCall(0);
+  auto sphere = [&numCall](glm::vec3 p) {
+    ++numCall;
+    return 2 - glm::length(p);
+  };
+  const Box bounds = {glm::vec3(-8), glm::vec3(8)};
+
+  const Manifold dense(LevelSet(sphere, bounds, 0.25));
+  const int numDense = numCall.exchange(0);
+  const Manifold band(LevelSet(sphere, bounds, 0.25, 0, true, 1));
+  const int numBand = numCall.load();
+
+  EXPECT_EQ(band.Status(), Manifold::Error::NoError);
+  EXPECT_EQ(band.Genus(), 0);
+  EXPECT_EQ(band.NumTri(), dense.NumTri());
+  EXPECT_NEAR(band.GetProperties().volume, dense.GetProperties().volume, 1e-3);
+  EXPECT_LT(numBand, numDense / 4);
+}
+
+TEST(SDF, Batch) {
+  auto sphere = [](glm::vec3 p) { return 2 - glm::length(p); };
+  const std::thread::id caller = std::this_thread::get_id();
+  bool sameThread = true;
+  auto batch = [&](VecView<const glm::vec3> points, VecView<float> values) {
+    sameThread &= std::this_thread::get_id() == caller;
+    for (int i = 0; i < points.size(); ++i) values[i] = sphere(points[i]);
+  };
+  const Box bounds = {glm::vec3(-3), glm::vec3(3)};
+
+  const Manifold point(LevelSet(sphere, bounds, 0.2));
+  for (const float lipschitz : {0.0f, 1.0f}) {
+    const Manifold batched(LevelSet(batch, bounds, 0.2, 0, lipschitz));
+    EXPECT_EQ(batched.Status(), Manifold::Error::NoError);
+    EXPECT_EQ(batched.Genus(), 0);
+    EXPECT_EQ(batched.NumTri(), point.NumTri());
+    EXPECT_NEAR(batched.GetProperties().volume, point.GetProperties().volume,
+                1e-3);
+  }
+  EXPECT_TRUE(sameThread);
+}
+
+TEST(SDF, EvaluatedOnce) {
+  // many layers overflow the first guess of the hash table
+  std::atomic<int> numCall(0);
+  auto layers = [&numCall](glm::vec3 p) {
+    ++numCall;
+    return Layers()(p);
+  };
+  Manifold layered(LevelSet(layers, {glm::vec3(0), glm::vec3(20)}, 1));
+  EXPECT_EQ(layered.Genus(), -8);
+  // each of the 22^3 points of both grids, and its seven edges
+  EXPECT_EQ(numCall.load(), 8 * 2 * 22 * 22 * 22);
+}
+
+TEST(SDF, Tiled) {
+  auto gyroid = [](glm::vec3 p) {
+    return glm::sin(p.x) * glm::cos(p.y) + glm::sin(p.y) * glm::cos(p.z) +
+           glm::sin(p.z) * glm::cos(p.x);
+  };
+  const Box bounds = {glm::vec3(-5), glm::vec3(5)};
+  const Manifold whole(LevelSet(gyroid, bounds, 0.3));
+  // small tiles, so most triangles touch a seam
+  const Manifold tiled(LevelSetTiled(gyroid, bounds, 0.3, 0, 7));
+
+  EXPECT_EQ(tiled.Status(), Manifold::Error::NoError);
+  EXPECT_EQ(tiled.Genus(), whole.Genus());
+  EXPECT_EQ(tiled.NumTri(), whole.NumTri());
+  EXPECT_NEAR(tiled.GetProperties().volume, whole.GetProperties().volume,
+              1e-3);
+}
+
+TEST(SDF, LevelSets) {
+  auto gyroid = [](glm::vec3 p) {
+    return glm::sin(p.x) * glm::cos(p.y) + glm::sin(p.y) * glm::cos(p.z) +
+           glm::sin(p.z) * glm::cos(p.x);
+  };
+  const Box bounds = {glm::vec3(-5), glm::vec3(5)};
+  const std::vector<float> levels = {-0.4, 0, 0.4};
+  std::atomic<int> numCall(0);
+  const std::vector<Mesh> meshes = LevelSets(
+      [&](glm::vec3 p) {
+        ++numCall;
+        return gyroid(p);
+      },
+      bounds, 0.3, levels);
+
+  ASSERT_EQ(meshes.size(), levels.size());
+  for (size_t i = 0; i < levels.size(); ++i) {
+    const Manifold shell(meshes[i]);
+    const Manifold single(LevelSet(gyroid, bounds, 0.3, levels[i]));
+    EXPECT_EQ(shell.Status(), Manifold::Error::NoError);
+    EXPECT_EQ(shell.NumTri(), single.NumTri());
+  }
+  // fewer calls than a single pointwise LevelSet, which makes 8 per code
+  EXPECT_LT(numCall.load(), 8 * 2 * 35 * 35 * 35);
+}
+
+TEST(SDF, Expr) {
+  const SDFExpr expr =
+      SDFExpr::Sphere(1)
+          .Union(SDFExpr::Cube(glm::vec3(1.5)).Rotate(0, 0, 45).Translate(
+                     {1, 0, 0}),
+                 0.2)
+          .Subtract(SDFExpr::Cylinder(3, 0.3));
+  const Box bounds = {glm::vec3(-2), glm::vec3(3)};
+
+  EXPECT_NEAR(SDFExpr::Sphere(0.4).Repeat({1, 0, 0})({3, 0, 0}), 0.4, 1e-5);
+  EXPECT_NEAR(expr({0, 0, 0}), -0.3, 1e-5);
+
+  // the ranges hold every sample of their boxes
+  for (float x = -2; x < 3; x += 0.5) {
+    for (float y = -2; y < 3; y += 0.5) {
+      const Box box = {{x, y, -0.25}, {x + 0.5, y + 0.5, 0.25}};
+      const glm::vec2 range = expr.Range(box);
+      for (int i = 0; i < 27; ++i) {
+        const glm::vec3 t(i % 3, (i / 3) % 3, i / 9);
+        const float d = expr(box.min + box.Size() * t / 2.0f);
+        EXPECT_LE(range[0], d);
+        EXPECT_GE(range[1], d);
+      }
+    }
+  }
+
+  const Manifold native(LevelSet(expr, bounds, 0.1));
+  const Manifold pointwise(
+      LevelSet([&](glm::vec3 p) { return expr(p); }, bounds, 0.1));
+  EXPECT_EQ(native.Status(), Manifold::Error::NoError);
+  EXPECT_EQ(native.Genus(), 1);
+  EXPECT_EQ(native.NumTri(), pointwise.NumTri());
+}
+
 TEST(SDF, SineSurface) {
   Mesh surface(LevelSet(
       [](glm::vec3 p) {